@@ -0,0 +1,86 @@
+// *******************************
+// BlockCompressBench.cpp
+//
+// Measures the BC1 and BC3 encoders of BlockCompress.h: throughput (in
+//    megapixels per second) of the SSE2 and the plain C++ encoders,
+//    and quality, as the PSNR of the decoded image against the original.
+//    The two encoders must produce the same blocks.
+//
+// Build (from the project directory), for instance:
+//    cl /O2 /EHsc /Iinclude /DRGBIMAGE_DONT_USE_OPENGL bench\BlockCompressBench.cpp src\BlockCompress.cpp src\RgbImage.cpp
+//    g++ -O2 -Iinclude -DRGBIMAGE_DONT_USE_OPENGL bench/BlockCompressBench.cpp src/BlockCompress.cpp src/RgbImage.cpp
+// Run:
+//    BlockCompressBench [numRepeats] [file.bmp ...]
+//    The default is the textures in the data directory.
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#include "BlockCompress.h"
+#include "RgbImage.h"
+
+static double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    static const char* defaultFiles[] = {
+        "data/sky.bmp", "data/grassland.bmp", "data/RoughWood.bmp", "data/gold.bmp"
+    };
+    int numRepeats = (argc > 1) ? atoi(argv[1]) : 10;
+    if (numRepeats < 1) {
+        numRepeats = 1;
+    }
+    const char** files = (argc > 2) ? (const char**)(argv + 2) : defaultFiles;
+    int numFiles = (argc > 2) ? argc - 2 : (int)(sizeof(defaultFiles) / sizeof(defaultFiles[0]));
+
+    printf("%-24s %6s %13s %13s %8s %10s\n", "File", "Format", "Scalar MP/s", "SIMD MP/s", "Speedup", "PSNR (dB)");
+    for (int f = 0; f < numFiles; f++) {
+        RgbImage image;
+        if (!image.LoadBmpFile(files[f])) {
+            continue;
+        }
+        double megapixels = image.GetNumRows() * image.GetNumCols() / 1.0e6;
+        for (int format = BlockBC1; format <= BlockBC3; format++) {
+            BlockFormat fmt = (BlockFormat)format;
+            long size = BlockCompressedSize(fmt, image.GetNumCols(), image.GetNumRows());
+            std::vector<unsigned char> blocks(size), reference(size);
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (int i = 0; i < numRepeats; i++) {
+                EncodeBlocksScalar(fmt, (const unsigned char*)image.ImageData(), image.GetNumCols(),
+                                   image.GetNumRows(), image.GetNumBytesPerRow(), 3, reference.data());
+            }
+            double scalarSeconds = SecondsSince(start);
+
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < numRepeats; i++) {
+                EncodeBlocks(fmt, image, blocks.data());
+            }
+            double simdSeconds = SecondsSince(start);
+
+            if (blocks != reference) {
+                printf("%-24s MISMATCH between the two encoders!\n", files[f]);
+                return 1;
+            }
+            RgbImage decoded(image.GetNumRows(), image.GetNumCols());
+            DecodeBlocks(fmt, blocks.data(), decoded);
+
+            double scalarRate = megapixels * numRepeats / scalarSeconds;
+            double simdRate = megapixels * numRepeats / simdSeconds;
+            printf("%-24s %6s %13.1f %13.1f %7.1fx %10.2f\n", files[f], fmt == BlockBC1 ? "BC1" : "BC3",
+                   scalarRate, simdRate, simdRate / scalarRate, ImagePSNR(image, decoded));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+// *******************************
+// BmpLoadBench.cpp
+//
+// Compares the speed of RgbImage::LoadBmpFile against the original
+//    loader, which read every byte with fgetc().  Both loaders must
+//    produce the same image.  Throughput is reported in MB/s of
+//    BMP pixel data.
+//
+// Build (from the project directory), for instance:
+//    cl /O2 /EHsc /Iinclude /DRGBIMAGE_DONT_USE_OPENGL bench\BmpLoadBench.cpp src\RgbImage.cpp
+//    g++ -O2 -Iinclude -DRGBIMAGE_DONT_USE_OPENGL bench/BmpLoadBench.cpp src/RgbImage.cpp
+// Run:
+//    BmpLoadBench [numRepeats] [file.bmp ...]
+//    The default is the textures in the data directory.
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+// Allow the use of deprecated fopen() instead of fopen_s()
+#define _CRT_SECURE_NO_DEPRECATE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "RgbImage.h"
+
+// The original loader, reading one byte at a time.
+//    Returns the image data (rows padded to four bytes), or 0 on failure.
+static unsigned char* LoadBmpFileByBytes(const char* filename, long* numRows, long* numCols)
+{
+    FILE* infile = fopen(filename, "rb");
+    if (!infile) {
+        return 0;
+    }
+    unsigned char header[54];
+    for (int i = 0; i < 54; i++) {
+        header[i] = fgetc(infile);
+    }
+    long offset = header[10] | (header[11] << 8) | (header[12] << 16) | (header[13] << 24);
+    *numCols = header[18] | (header[19] << 8) | (header[20] << 16) | (header[21] << 24);
+    *numRows = header[22] | (header[23] << 8) | (header[24] << 16) | (header[25] << 24);
+    for (long i = 54; i < offset; i++) {
+        fgetc(infile);
+    }
+    long bytesPerRow = ((3 * (*numCols) + 3) >> 2) << 2;
+    unsigned char* image = new unsigned char[(*numRows) * bytesPerRow];
+    unsigned char* cPtr = image;
+    for (long i = 0; i < *numRows; i++) {
+        for (long j = 0; j < *numCols; j++) {
+            *(cPtr + 2) = fgetc(infile);    // Blue color value
+            *(cPtr + 1) = fgetc(infile);    // Green color value
+            *cPtr = fgetc(infile);          // Red color value
+            cPtr += 3;
+        }
+        for (long k = 3 * (*numCols); k < bytesPerRow; k++) {
+            fgetc(infile);                  // Read and ignore padding;
+            *(cPtr++) = 0;
+        }
+    }
+    fclose(infile);
+    return image;
+}
+
+static double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv)
+{
+    static const char* defaultFiles[] = {
+        "data/sky.bmp", "data/grassland.bmp", "data/RoughWood.bmp", "data/gold.bmp"
+    };
+    int numRepeats = (argc > 1) ? atoi(argv[1]) : 20;
+    if (numRepeats < 1) {
+        numRepeats = 1;
+    }
+    const char** files = (argc > 2) ? (const char**)(argv + 2) : defaultFiles;
+    int numFiles = (argc > 2) ? argc - 2 : (int)(sizeof(defaultFiles) / sizeof(defaultFiles[0]));
+
+    printf("%-24s %11s %12s %12s %8s\n", "File", "Pixel MB", "fgetc MB/s", "fread MB/s", "Speedup");
+    for (int f = 0; f < numFiles; f++) {
+        RgbImage image;
+        if (!image.LoadBmpFile(files[f])) {
+            continue;
+        }
+        double megabytes = image.GetNumRows() * image.GetNumBytesPerRow() / 1.0e6;
+
+        long numRows, numCols;
+        unsigned char* reference = LoadBmpFileByBytes(files[f], &numRows, &numCols);
+        if (reference == 0 || numRows != image.GetNumRows() || numCols != image.GetNumCols()
+            || memcmp(reference, image.ImageData(), numRows * image.GetNumBytesPerRow()) != 0) {
+            printf("%-24s MISMATCH between the two loaders!\n", files[f]);
+            delete[] reference;
+            return 1;
+        }
+        delete[] reference;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < numRepeats; i++) {
+            delete[] LoadBmpFileByBytes(files[f], &numRows, &numCols);
+        }
+        double oldSeconds = SecondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < numRepeats; i++) {
+            image.LoadBmpFile(files[f]);
+        }
+        double newSeconds = SecondsSince(start);
+
+        double oldRate = megabytes * numRepeats / oldSeconds;
+        double newRate = megabytes * numRepeats / newSeconds;
+        printf("%-24s %11.2f %12.1f %12.1f %7.1fx\n", files[f], megabytes, oldRate, newRate, newRate / oldRate);
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+// *******************************
+// ImageCodecBench.cpp
+//
+// Compares writing and reading images as BMP and as QOI files with
+//    RgbImage: the speed (in MB/s of RGB pixel data) and the file sizes.
+//    Every QOI file is read back and must be identical to the image.
+//
+// Build (from the project directory), for instance:
+//    cl /O2 /EHsc /Iinclude /DRGBIMAGE_DONT_USE_OPENGL bench\ImageCodecBench.cpp src\RgbImage.cpp
+//    g++ -O2 -pthread -Iinclude -DRGBIMAGE_DONT_USE_OPENGL bench/ImageCodecBench.cpp src/RgbImage.cpp
+// Run:
+//    ImageCodecBench [numRepeats] [file.bmp ...]
+//    The default is the textures in the data directory.  Files named
+//    ImageCodecBench.bmp and ImageCodecBench.qoi are written in the
+//    current directory.
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+// Allow the use of deprecated fopen() instead of fopen_s()
+#define _CRT_SECURE_NO_DEPRECATE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "RgbImage.h"
+
+static double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static long FileSize(const char* filename)
+{
+    FILE* f = fopen(filename, "rb");
+    if (!f) {
+        return 0;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    return size;
+}
+
+static bool SameImage(const RgbImage& a, const RgbImage& b)
+{
+    return a.GetNumRows() == b.GetNumRows() && a.GetNumCols() == b.GetNumCols()
+        && memcmp(a.ImageData(), b.ImageData(), a.GetNumRows() * a.GetNumBytesPerRow()) == 0;
+}
+
+int main(int argc, char** argv)
+{
+    static const char* defaultFiles[] = {
+        "data/sky.bmp", "data/grassland.bmp", "data/RoughWood.bmp", "data/gold.bmp"
+    };
+    int numRepeats = (argc > 1) ? atoi(argv[1]) : 10;
+    if (numRepeats < 1) {
+        numRepeats = 1;
+    }
+    const char** files = (argc > 2) ? (const char**)(argv + 2) : defaultFiles;
+    int numFiles = (argc > 2) ? argc - 2 : (int)(sizeof(defaultFiles) / sizeof(defaultFiles[0]));
+    const char* bmpName = "ImageCodecBench.bmp";
+    const char* qoiName = "ImageCodecBench.qoi";
+
+    printf("%-24s %9s %9s %6s %10s %10s %10s %10s\n", "File", "BMP KB", "QOI KB", "Ratio",
+           "BMP wr MB/s", "QOI wr MB/s", "BMP rd MB/s", "QOI rd MB/s");
+    for (int f = 0; f < numFiles; f++) {
+        RgbImage image;
+        if (!image.LoadBmpFile(files[f])) {
+            continue;
+        }
+        double megabytes = 3.0 * image.GetNumRows() * image.GetNumCols() / 1.0e6;
+
+        RgbImage readBack;
+        if (!image.WriteQoiFile(qoiName) || !readBack.LoadQoiFile(qoiName) || !SameImage(image, readBack)) {
+            printf("%-24s MISMATCH after writing and reading QOI!\n", files[f]);
+            return 1;
+        }
+
+        double seconds[4];
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < numRepeats; i++) {
+            image.WriteBmpFile(bmpName);
+        }
+        seconds[0] = SecondsSince(start);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < numRepeats; i++) {
+            image.WriteQoiFile(qoiName);
+        }
+        seconds[1] = SecondsSince(start);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < numRepeats; i++) {
+            readBack.LoadBmpFile(bmpName);
+        }
+        seconds[2] = SecondsSince(start);
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < numRepeats; i++) {
+            readBack.LoadQoiFile(qoiName);
+        }
+        seconds[3] = SecondsSince(start);
+
+        long bmpSize = FileSize(bmpName);
+        long qoiSize = FileSize(qoiName);
+        printf("%-24s %9ld %9ld %5.1fx %10.1f %10.1f %10.1f %10.1f\n", files[f], bmpSize / 1024, qoiSize / 1024,
+               (double)bmpSize / qoiSize, megabytes * numRepeats / seconds[0], megabytes * numRepeats / seconds[1],
+               megabytes * numRepeats / seconds[2], megabytes * numRepeats / seconds[3]);
+    }
+    remove(bmpName);
+    remove(qoiName);
+    return 0;
+}
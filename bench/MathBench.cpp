@@ -0,0 +1,633 @@
+// *******************************
+// MathBench.cpp
+//
+// Microbenchmarks for the math kernels of LinearR3.h, LinearR4.h and
+//    LinearR4f.h and Quaternion.h: matrix products, Mult_glRotate, inverses,
+//    vector products, DumpByColumns, and the rotations and quaternions.
+//
+// Each kernel runs over a small working set of random inputs (so the
+//    data stays in the L1 cache) and folds its results into a checksum,
+//    so that the compiler cannot drop the work.  A kernel is first run
+//    for a warmup period, which also sets the number of operations per
+//    repetition; then it is timed for a number of repetitions, and the
+//    minimum, median, mean and standard deviation of the time per
+//    operation are reported.  The thread is pinned to one CPU.
+// The JSON output has one line per kernel, in a fixed order, so that
+//    the results of two commits can be compared with diff.
+//
+// Build (from the project directory), for instance:
+//    cl /O2 /EHsc /Iinclude bench\MathBench.cpp src\LinearR3.cpp src\LinearR4.cpp src\LinearR4f.cpp src\Quaternion.cpp
+//    g++ -O2 -Iinclude bench/MathBench.cpp src/LinearR3.cpp src/LinearR4.cpp src/LinearR4f.cpp src/Quaternion.cpp
+// Run:
+//    MathBench [-reps N] [-cpu K] [-filter TEXT] [-json FILE]
+//    The defaults are 15 repetitions, CPU 0, all kernels and no JSON file.
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+// Allow the use of deprecated fopen() instead of fopen_s()
+#define _CRT_SECURE_NO_DEPRECATE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <sched.h>
+#endif
+
+#include "LinearR3.h"
+#include "LinearR4.h"
+#include "LinearR4f.h"
+#include "Quaternion.h"
+
+namespace {
+
+const int WorkingSetSize = 64;          // A power of two
+const double WarmupSeconds = 0.1;
+const double RepetitionSeconds = 0.02;
+
+// The inputs.  Two of each, so the binary operations have distinct operands.
+VectorR3 vec3A[WorkingSetSize], vec3B[WorkingSetSize];
+VectorR4 vec4A[WorkingSetSize], vec4B[WorkingSetSize];
+LinearMapR3 mat3A[WorkingSetSize], mat3B[WorkingSetSize];
+LinearMapR3 mat3PosDef[WorkingSetSize];
+RotationMapR3 rot3[WorkingSetSize];
+LinearMapR4 mat4A[WorkingSetSize], mat4B[WorkingSetSize];
+LinearMapR4f mat4fA[WorkingSetSize], mat4fB[WorkingSetSize];
+AffineMapR4f affine4f[WorkingSetSize];
+double angles[WorkingSetSize];
+float pointsX[WorkingSetSize], pointsY[WorkingSetSize], pointsZ[WorkingSetSize];
+Quaternion quatA[WorkingSetSize], quatB[WorkingSetSize];
+
+double Random()
+{
+    return rand() / (double)RAND_MAX * 2.0 - 1.0;
+}
+
+VectorR3 RandomUnitVectorR3()
+{
+    VectorR3 u(Random(), Random(), Random() + 2.0);
+    return u.MakeUnit();
+}
+
+void SetupWorkingSet()
+{
+    srand(155);
+    for (int i = 0; i < WorkingSetSize; i++) {
+        vec3A[i].Set(Random(), Random(), Random());
+        vec3B[i] = RandomUnitVectorR3();
+        vec4A[i].Set(Random(), Random(), Random(), Random());
+        vec4B[i].Set(Random(), Random(), Random(), Random());
+        mat3A[i] = LinearMapR3(vec3A[i], vec3B[i], RandomUnitVectorR3());
+        mat3A[i] += LinearMapR3(2.0, 0.0, 0.0, 0.0, 2.0, 0.0, 0.0, 0.0, 2.0);   // Keep it invertible
+        mat3B[i] = LinearMapR3(RandomUnitVectorR3(), RandomUnitVectorR3(), vec3A[i]);
+        mat3PosDef[i] = mat3A[i].Transpose();
+        mat3PosDef[i] *= mat3A[i];
+        angles[i] = Random() * PI;
+        rot3[i] = VrRotate(angles[i], vec3B[i]);
+        mat4A[i].SetIdentity();
+        mat4A[i].Mult_glTranslate(Random(), Random(), Random());
+        mat4A[i].Mult_glRotate(angles[i], vec3B[i]);
+        mat4A[i].Mult_glScale(1.5 + Random());
+        mat4B[i].SetIdentity();
+        mat4B[i].Mult_glRotate(Random(), RandomUnitVectorR3());
+        mat4B[i].Mult_glTranslate(vec3A[i]);
+        mat4fA[i].Set(mat4A[i]);
+        mat4fB[i].Set(mat4B[i]);
+        affine4f[i].Set(mat4A[i]);
+        pointsX[i] = (float)Random();
+        pointsY[i] = (float)Random();
+        pointsZ[i] = (float)Random();
+        quatA[i].Set(vec3B[i], angles[i]);
+        quatB[i].Set(RandomUnitVectorR3(), Random() * PI);
+    }
+}
+
+// ********
+// The kernels.  Each one performs n operations and returns a checksum.
+// ********
+
+double MultiplyR3(long n)
+{
+    double sum = 0.0;
+    for (long i = 0; i < n; i++) {
+        LinearMapR3 C = mat3A[i & (WorkingSetSize - 1)] * mat3B[(i + 1) & (WorkingSetSize - 1)];
+        sum += C.m11 + C.m32;
+    }
+    return sum;
+}
+
+double MultiplyR4(long n)
+{
+    double sum = 0.0;
+    for (long i = 0; i < n; i++) {
+        LinearMapR4 C = mat4A[i & (WorkingSetSize - 1)];
+        C *= mat4B[(i + 1) & (WorkingSetSize - 1)];
+        sum += C.m11 + C.m34;
+    }
+    return sum;
+}
+
+double MultiplyR4f(long n)
+{
+    double sum = 0.0;
+    for (long i = 0; i < n; i++) {
+        LinearMapR4f C = mat4fA[i & (WorkingSetSize - 1)] * mat4fB[(i + 1) & (WorkingSetSize - 1)];
+        sum += C.m[0] + C.m[14];
+    }
+    return sum;
+}
+
+double MultiplyAffineR4f(long n)
+{
+    double sum = 0.0;
+    for (long i = 0; i < n; i++) {
+        AffineMapR4f C = affine4f[i & (WorkingSetSize - 1)] * affine4f[(i + 1) & (WorkingSetSize - 1)];
+        sum += C(0, 0) + C(2, 3);
+    }
+    return sum;
+}
+
+double MultGlRotateR4(long n)
+{
+    double sum = 0.0;
+    for (long i = 0; i < n; i++) {
+        LinearMapR4 C = mat4A[i & (WorkingSetSize - 1)];
+        C.Mult_glRotate(angles[i & (WorkingSetSize - 1)], vec3B[(i + 1) & (WorkingSetSize - 1)]);
+        sum += C.m11 + C.m23;
+    }
+    return sum;
+}
+
+double MultGlRotateR4f(long n)
+{
+    double sum = 0.0;
+    for (long i = 0; i < n; i++) {
+        const VectorR3& axis = vec3B[(i + 1) & (WorkingSetSize - 1)];
+        LinearMapR4f C = mat4fA[i & (WorkingSetSize - 1)];
+        C.Mult_glRotate(angles[i & (WorkingSetSize - 1)], (float)axis.x, (float)axis.y, (float)axis.z);
+        sum += C.m[0] + C.m[9];
+    }
+    return sum;
+}
+
+double MultGlRotateYAffineR4f(long n)
+{
+    double sum = 0.0;
+    for (long i = 0; i < n; i++) {
+        AffineMapR4f C = affine4f[i & (WorkingSetSize - 1)];
+        C.Mult_glRotateY(angles[i & (WorkingSetSize - 1)]);
+        sum += C(0, 0) + C(2, 1);
+    }
+    return sum;
+}
+
+double InverseR3(long n)
+{
+    double sum = 0.0;
+    for (long i = 0; i < n; i++) {
+        LinearMapR3 C = mat3A[i & (WorkingSetSize - 1)].Inverse();
+        sum += C.m11 + C.m32;
+    }
+    return sum;
+}
+
+double InversePosDefR3(long n)
+{
+    double sum = 0.0;
+    for (long i = 0; i < n; i++) {
+        LinearMapR3 C = mat3PosDef[i & (WorkingSetSize - 1)].InversePosDef();
+        sum += C.m11 + C.m32;
+    }
+    return sum;
+}
+
+double InverseR4(long n)
+{
+    double sum = 0.0;
+    for (long i = 0; i < n; i++) {
+        LinearMapR4 C = mat4A[i & (WorkingSetSize - 1)].Inverse();
+        sum += C.m11 + C.m34;
+    }
+    return sum;
+}
+
+double InverseR4f(long n)
+{
+    double sum = 0.0;
+    for (long i = 0; i < n; i++) {
+        LinearMapR4f C = mat4fA[i & (WorkingSetSize - 1)].Inverse();
+        sum += C.m[0] + C.m[14];
+    }
+    return sum;
+}
+
+double InverseAffineR4f(long n)
+{
+    double sum = 0.0;
+    for (long i = 0; i < n; i++) {
+        LinearMapR4f C = mat4fA[i & (WorkingSetSize - 1)].InverseAffine();
+        sum += C.m[0] + C.m[14];
+    }
+    return sum;
+}
+
+double RigidInverseAffineR4f(long n)
+{
+    double sum = 0.0;
+    for (long i = 0; i < n; i++) {
+        AffineMapR4f C = affine4f[i & (WorkingSetSize - 1)].RigidInverse();
+        sum += C(0, 0) + C(2, 3);
+    }
+    return sum;
+}
+
+double CrossProductR3(long n)
+{
+    VectorR3 sum;
+    for (long i = 0; i < n; i++) {
+        sum += vec3A[i & (WorkingSetSize - 1)] * vec3B[(i + 1) & (WorkingSetSize - 1)];
+    }
+    return sum.x + sum.y + sum.z;
+}
+
+double DotProductR3(long n)
+{
+    double sum = 0.0;
+    for (long i = 0; i < n; i++) {
+        sum += vec3A[i & (WorkingSetSize - 1)] ^ vec3B[(i + 1) & (WorkingSetSize - 1)];
+    }
+    return sum;
+}
+
+double DotProductR4(long n)
+{
+    double sum = 0.0;
+    for (long i = 0; i < n; i++) {
+        sum += vec4A[i & (WorkingSetSize - 1)] ^ vec4B[(i + 1) & (WorkingSetSize - 1)];
+    }
+    return sum;
+}
+
+double MatrixTimesVectorR4(long n)
+{
+    VectorR4 sum;
+    for (long i = 0; i < n; i++) {
+        sum += mat4A[i & (WorkingSetSize - 1)] * vec4A[(i + 1) & (WorkingSetSize - 1)];
+    }
+    return sum.x + sum.y + sum.z + sum.w;
+}
+
+double DumpByColumnsR4(long n)
+{
+    float floats[16];
+    double sum = 0.0;
+    for (long i = 0; i < n; i++) {
+        mat4A[i & (WorkingSetSize - 1)].DumpByColumns(floats);
+        sum += floats[0] + floats[13];
+    }
+    return sum;
+}
+
+double SetR4f(long n)
+{
+    double sum = 0.0;
+    for (long i = 0; i < n; i++) {
+        LinearMapR4f C(mat4A[i & (WorkingSetSize - 1)]);
+        sum += C.m[0] + C.m[13];
+    }
+    return sum;
+}
+
+// Rotation of a vector about an axis
+double RotateVectorR3(long n)
+{
+    VectorR3 sum;
+    for (long i = 0; i < n; i++) {
+        VectorR3 v = vec3A[i & (WorkingSetSize - 1)];
+        v.Rotate(angles[i & (WorkingSetSize - 1)], vec3B[(i + 1) & (WorkingSetSize - 1)]);
+        sum += v;
+    }
+    return sum.x + sum.y + sum.z;
+}
+
+// Axis and angle to a rotation matrix
+double VrRotateR3(long n)
+{
+    double sum = 0.0;
+    for (long i = 0; i < n; i++) {
+        RotationMapR3 R = VrRotate(angles[i & (WorkingSetSize - 1)], vec3B[(i + 1) & (WorkingSetSize - 1)]);
+        sum += R.m11 + R.m32;
+    }
+    return sum;
+}
+
+// One operation is one point
+double TransformPointsSoAR4f(long n)
+{
+    float outX[WorkingSetSize], outY[WorkingSetSize], outZ[WorkingSetSize];
+    double sum = 0.0;
+    for (long i = 0; i < n; i += WorkingSetSize) {
+        mat4fA[(i / WorkingSetSize) & (WorkingSetSize - 1)].TransformPointsSoA(pointsX, pointsY, pointsZ,
+                                                                               outX, outY, outZ, WorkingSetSize);
+        sum += outX[0] + outZ[WorkingSetSize - 1];
+    }
+    return sum;
+}
+
+double MultiplyQuaternion(long n)
+{
+    Quaternion sum(0.0, 0.0, 0.0, 0.0);
+    for (long i = 0; i < n; i++) {
+        sum += quatA[i & (WorkingSetSize - 1)] * quatB[(i + 1) & (WorkingSetSize - 1)];
+    }
+    return sum.x + sum.y + sum.z + sum.w;
+}
+
+double RotateVectorQuaternion(long n)
+{
+    VectorR3 sum;
+    for (long i = 0; i < n; i++) {
+        VectorR3 v = vec3A[i & (WorkingSetSize - 1)];
+        v.Rotate(quatA[(i + 1) & (WorkingSetSize - 1)]);
+        sum += v;
+    }
+    return sum.x + sum.y + sum.z;
+}
+
+double QuaternionToRotationMapR3(long n)
+{
+    double sum = 0.0;
+    for (long i = 0; i < n; i++) {
+        RotationMapR3 R;
+        R.Set(quatA[i & (WorkingSetSize - 1)]);
+        sum += R.m11 + R.m32;
+    }
+    return sum;
+}
+
+double QuaternionToLinearMapR4(long n)
+{
+    double sum = 0.0;
+    for (long i = 0; i < n; i++) {
+        LinearMapR4 C;
+        C.Set_glRotate(quatA[i & (WorkingSetSize - 1)]);
+        sum += C.m11 + C.m23;
+    }
+    return sum;
+}
+
+double RotationMapR3ToQuaternion(long n)
+{
+    double sum = 0.0;
+    for (long i = 0; i < n; i++) {
+        Quaternion q;
+        q.Set(rot3[i & (WorkingSetSize - 1)]);
+        sum += q.x + q.w;
+    }
+    return sum;
+}
+
+double ExpLogQuaternion(long n)
+{
+    Quaternion sum(0.0, 0.0, 0.0, 0.0);
+    for (long i = 0; i < n; i++) {
+        sum += Exp(0.5 * Log(quatA[i & (WorkingSetSize - 1)]));
+    }
+    return sum.x + sum.y + sum.z + sum.w;
+}
+
+// One operation is one quaternion
+double SlerpQuaternions(long n)
+{
+    Quaternion out[WorkingSetSize];
+    double sum = 0.0;
+    for (long i = 0; i < n; i += WorkingSetSize) {
+        Slerp(quatA, quatB, angles[(i / WorkingSetSize) & (WorkingSetSize - 1)] * 0.1 + 0.5, out, WorkingSetSize);
+        sum += out[0].x + out[WorkingSetSize - 1].w;
+    }
+    return sum;
+}
+
+double NlerpQuaternions(long n)
+{
+    Quaternion out[WorkingSetSize];
+    double sum = 0.0;
+    for (long i = 0; i < n; i += WorkingSetSize) {
+        Nlerp(quatA, quatB, angles[(i / WorkingSetSize) & (WorkingSetSize - 1)] * 0.1 + 0.5, out, WorkingSetSize);
+        sum += out[0].x + out[WorkingSetSize - 1].w;
+    }
+    return sum;
+}
+
+struct Kernel {
+    const char* Name;
+    double (*Run)(long n);
+};
+
+const Kernel kernels[] = {
+    { "LinearMapR3 multiply", MultiplyR3 },
+    { "LinearMapR4 multiply", MultiplyR4 },
+    { "LinearMapR4f multiply", MultiplyR4f },
+    { "AffineMapR4f multiply", MultiplyAffineR4f },
+    { "LinearMapR4 Mult_glRotate", MultGlRotateR4 },
+    { "LinearMapR4f Mult_glRotate", MultGlRotateR4f },
+    { "AffineMapR4f Mult_glRotateY", MultGlRotateYAffineR4f },
+    { "LinearMapR3 Inverse", InverseR3 },
+    { "LinearMapR3 InversePosDef", InversePosDefR3 },
+    { "LinearMapR4 Inverse", InverseR4 },
+    { "LinearMapR4f Inverse", InverseR4f },
+    { "LinearMapR4f InverseAffine", InverseAffineR4f },
+    { "AffineMapR4f RigidInverse", RigidInverseAffineR4f },
+    { "VectorR3 cross product", CrossProductR3 },
+    { "VectorR3 dot product", DotProductR3 },
+    { "VectorR4 dot product", DotProductR4 },
+    { "LinearMapR4 times VectorR4", MatrixTimesVectorR4 },
+    { "LinearMapR4 DumpByColumns", DumpByColumnsR4 },
+    { "LinearMapR4f Set", SetR4f },
+    { "VectorR3 Rotate", RotateVectorR3 },
+    { "VrRotate", VrRotateR3 },
+    { "LinearMapR4f TransformPointsSoA", TransformPointsSoAR4f },
+    { "Quaternion multiply", MultiplyQuaternion },
+    { "VectorR3 Rotate by Quaternion", RotateVectorQuaternion },
+    { "Quaternion to RotationMapR3", QuaternionToRotationMapR3 },
+    { "Quaternion to LinearMapR4", QuaternionToLinearMapR4 },
+    { "RotationMapR3 to Quaternion", RotationMapR3ToQuaternion },
+    { "Quaternion Exp and Log", ExpLogQuaternion },
+    { "Quaternion Slerp (batch)", SlerpQuaternions },
+    { "Quaternion Nlerp (batch)", NlerpQuaternions },
+};
+
+struct KernelResult {
+    const char* Name;
+    long OpsPerRepetition;
+    double Min, Median, Mean, StdDev;   // Nanoseconds per operation
+    double Checksum;
+};
+
+double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+volatile double checksumSink;
+
+// Warm up (caches, branch predictors, clock frequency) while doubling the
+//    number of operations, until one call takes RepetitionSeconds.
+//    Then time numReps calls of that size.
+KernelResult RunKernel(const Kernel& kernel, int numReps)
+{
+    KernelResult result;
+    result.Name = kernel.Name;
+    result.Checksum = 0.0;
+    long ops = WorkingSetSize;
+    std::chrono::steady_clock::time_point warmupStart = std::chrono::steady_clock::now();
+    for (;;) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        checksumSink = kernel.Run(ops);
+        if (SecondsSince(start) < RepetitionSeconds) {
+            ops *= 2;
+        }
+        else if (SecondsSince(warmupStart) >= WarmupSeconds) {
+            break;
+        }
+    }
+    result.OpsPerRepetition = ops;
+
+    std::vector<double> nanos(numReps);
+    for (int r = 0; r < numReps; r++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        result.Checksum = kernel.Run(ops);
+        nanos[r] = SecondsSince(start) * 1.0e9 / ops;
+    }
+    std::sort(nanos.begin(), nanos.end());
+    result.Min = nanos[0];
+    result.Median = (numReps & 1) ? nanos[numReps / 2] : 0.5 * (nanos[numReps / 2 - 1] + nanos[numReps / 2]);
+    double sum = 0.0, sumSq = 0.0;
+    for (int r = 0; r < numReps; r++) {
+        sum += nanos[r];
+        sumSq += nanos[r] * nanos[r];
+    }
+    result.Mean = sum / numReps;
+    result.StdDev = sqrt(std::max(0.0, sumSq / numReps - result.Mean * result.Mean));
+    return result;
+}
+
+// Run on one CPU only, at a raised priority, to reduce the noise from
+//    migrations and other processes.  Returns false if it is not possible.
+bool PinToCpu(int cpu)
+{
+#ifdef _WIN32
+    SetPriorityClass(GetCurrentProcess(), HIGH_PRIORITY_CLASS);
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+    return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu) != 0;
+#elif defined(__linux__)
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    return sched_setaffinity(0, sizeof(cpus), &cpus) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+const char* CompilerName()
+{
+#if defined(_MSC_VER)
+    return "msvc";
+#elif defined(__clang__)
+    return "clang";
+#elif defined(__GNUC__)
+    return "gcc";
+#else
+    return "unknown";
+#endif
+}
+
+void WriteJson(FILE* out, const std::vector<KernelResult>& results, int numReps, int cpu, bool pinned)
+{
+    fprintf(out, "{\n  \"benchmark\": \"MathBench\",\n  \"compiler\": \"%s\",\n", CompilerName());
+#ifdef LINEAR_R4F_SSE
+    fprintf(out, "  \"simd\": \"sse\",\n");
+#else
+    fprintf(out, "  \"simd\": \"none\",\n");
+#endif
+    fprintf(out, "  \"repetitions\": %d,\n  \"cpu\": %d,\n  \"pinned\": %s,\n", numReps, cpu, pinned ? "true" : "false");
+    fprintf(out, "  \"unit\": \"ns/op\",\n  \"kernels\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        const KernelResult& r = results[i];
+        fprintf(out, "    { \"name\": \"%s\", \"min\": %.3f, \"median\": %.3f, \"mean\": %.3f, \"stddev\": %.3f, "
+                "\"ops\": %ld, \"checksum\": %.9g }%s\n", r.Name, r.Min, r.Median, r.Mean, r.StdDev,
+                r.OpsPerRepetition, r.Checksum, (i + 1 < results.size()) ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int numReps = 15;
+    int cpu = 0;
+    const char* filter = 0;
+    const char* jsonFileName = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-reps") == 0 && i + 1 < argc) {
+            numReps = std::max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-cpu") == 0 && i + 1 < argc) {
+            cpu = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-filter") == 0 && i + 1 < argc) {
+            filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "-json") == 0 && i + 1 < argc) {
+            jsonFileName = argv[++i];
+        }
+        else {
+            printf("Usage: MathBench [-reps N] [-cpu K] [-filter TEXT] [-json FILE]\n");
+            return 1;
+        }
+    }
+
+    bool pinned = PinToCpu(cpu);
+    if (!pinned) {
+        printf("Warning: unable to pin the thread to CPU %d; timings may be noisy.\n", cpu);
+    }
+    SetupWorkingSet();
+
+    std::vector<KernelResult> results;
+    printf("%-34s %10s %10s %10s %8s\n", "Kernel (ns/op)", "Min", "Median", "Mean", "StdDev");
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        if (filter && !strstr(kernels[k].Name, filter)) {
+            continue;
+        }
+        KernelResult r = RunKernel(kernels[k], numReps);
+        printf("%-34s %10.2f %10.2f %10.2f %7.1f%%\n", r.Name, r.Min, r.Median, r.Mean,
+               r.Mean > 0.0 ? 100.0 * r.StdDev / r.Mean : 0.0);
+        results.push_back(r);
+    }
+
+    if (jsonFileName) {
+        FILE* jsonFile = fopen(jsonFileName, "w");
+        if (!jsonFile) {
+            printf("Unable to write %s\n", jsonFileName);
+            return 1;
+        }
+        WriteJson(jsonFile, results, numReps, cpu, pinned);
+        fclose(jsonFile);
+        printf("Results written to %s\n", jsonFileName);
+    }
+    return 0;
+}
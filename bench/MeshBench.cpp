@@ -0,0 +1,277 @@
+// *******************************
+// MeshBench.cpp
+//
+// Compares the two mesh formats of GlGeomSphere and GlGeomCylinder:
+//    the float vertices with triangle strips, and the compact format
+//    (packed vertices with Tipsify-ordered triangle lists, see MeshOptimize.h).
+//
+// For each shape and resolution it reports the bytes per vertex, the size
+//    of the index buffer, the average cache miss ratio (ACMR: vertices
+//    transformed per triangle, with a FIFO post-transform cache of
+//    MeshVertexCacheSize entries), the vertex data fetched to draw the mesh
+//    once (ACMR times the number of triangles times the bytes per vertex),
+//    and the time to build the mesh.
+// The meshes are read back from the buffer objects, so this needs an
+//    OpenGL context: it makes one with CreateOffscreenContext().
+// It first checks that the compact cylinder has the same triangles as the
+//    strips, including shapes with more rings than stacks, whose end faces
+//    are larger than the side.  Build with -fsanitize=address (g++) or
+//    /fsanitize=address (cl) to also check the mesh builders for overruns.
+//    The exit code is 1 if a check fails.
+//
+// Build (from the project directory), for instance:
+//    cl /O2 /EHsc /Iinclude bench\MeshBench.cpp src\GlGeomSphere.cpp src\GlGeomCylinder.cpp src\MeshOptimize.cpp src\Offscreen.cpp glew32s.lib glfw3.lib opengl32.lib
+//    g++ -O2 -pthread -Iinclude bench/MeshBench.cpp src/GlGeomSphere.cpp src/GlGeomCylinder.cpp src/MeshOptimize.cpp src/Offscreen.cpp -lGLEW -lEGL -lGL
+// Run:
+//    MeshBench [numRepeats] [resolution ...]
+//    The defaults are 10 repeats, and the resolutions 16, 80 and 255
+//    (slices, stacks and rings all set to the resolution).
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <vector>
+
+#define GLEW_STATIC
+#include <GL/glew.h>
+
+#include "GlGeomSphere.h"
+#include "GlGeomCylinder.h"
+#include "MeshOptimize.h"
+#include "Offscreen.h"
+
+// Defined in FinalProj.cpp, which the benchmark does not link
+unsigned long renderDrawCalls = 0;
+bool check_for_opengl_errors() { return false; }
+
+namespace {
+
+const unsigned int VertPosLoc = 0;      // Any three attribute locations will do
+const unsigned int VertNormalLoc = 1;
+const unsigned int VertTexCoordsLoc = 2;
+
+// A mesh read back from its buffer objects, with its triangles in drawing order.
+struct MeshInfo {
+    long VertexBytes;
+    long ElementBytes;
+    long NumVertices;
+    std::vector<unsigned int> Triangles;
+};
+
+std::vector<unsigned char> ReadBuffer(GLenum target, unsigned int buffer)
+{
+    GLint size = 0;
+    glBindBuffer(target, buffer);
+    glGetBufferParameteriv(target, GL_BUFFER_SIZE, &size);
+    std::vector<unsigned char> data(size);
+    glGetBufferSubData(target, 0, size, data.data());
+    glBindBuffer(target, 0);
+    return data;
+}
+
+template<class T>
+void AddStrip(const T* strip, long length, std::vector<unsigned int>& triangles)
+{
+    if (length < 3) {
+        return;
+    }
+    size_t n = triangles.size();
+    triangles.resize(n + 3 * (length - 2));
+    triangles.resize(n + StripToTriangles(strip, length, triangles.data() + n));
+}
+
+// Strips are split at the primitive restart index; triangle lists are copied.
+MeshInfo ReadSphere(const GlGeomSphere& sphere)
+{
+    MeshInfo info;
+    std::vector<unsigned char> vertices = ReadBuffer(GL_ARRAY_BUFFER, sphere.GetVBO());
+    std::vector<unsigned char> elements = ReadBuffer(GL_ELEMENT_ARRAY_BUFFER, sphere.GetEBO());
+    info.VertexBytes = (long)vertices.size();
+    info.ElementBytes = (long)elements.size();
+    info.NumVertices = sphere.GetNumVertices();
+    const unsigned short* indices = (const unsigned short*)elements.data();
+    long numIndices = (long)elements.size() / sizeof(unsigned short);
+    if (sphere.IsCompactFormat()) {
+        info.Triangles.assign(indices, indices + numIndices);
+        return info;
+    }
+    long start = 0;
+    for (long i = 0; i <= numIndices; i++) {
+        if (i == numIndices || indices[i] == USHRT_MAX) {
+            AddStrip(indices + start, i - start, info.Triangles);
+            start = i + 1;
+        }
+    }
+    return info;
+}
+
+// The strips are those of glMultiDrawElements: numSlices for each face, then numSlices for the side.
+MeshInfo ReadCylinder(const GlGeomCylinder& cylinder)
+{
+    MeshInfo info;
+    std::vector<unsigned char> vertices = ReadBuffer(GL_ARRAY_BUFFER, cylinder.GetVBO());
+    std::vector<unsigned char> elements = ReadBuffer(GL_ELEMENT_ARRAY_BUFFER, cylinder.GetEBO());
+    info.VertexBytes = (long)vertices.size();
+    info.ElementBytes = (long)elements.size();
+    info.NumVertices = cylinder.GetNumVertices();
+    long numIndices = cylinder.GetNumElements();
+    if (cylinder.IsCompactFormat()) {
+        if ((long)elements.size() == numIndices * (long)sizeof(unsigned short)) {
+            const unsigned short* indices = (const unsigned short*)elements.data();
+            info.Triangles.assign(indices, indices + numIndices);
+        }
+        else {
+            const unsigned int* indices = (const unsigned int*)elements.data();
+            info.Triangles.assign(indices, indices + numIndices);
+        }
+        return info;
+    }
+    const unsigned int* strip = (const unsigned int*)elements.data();
+    for (int part = 0; part < 3; part++) {
+        long length = (part < 2) ? 2 * cylinder.GetNumRings() + 1 : 2 * cylinder.GetNumStacks() + 2;
+        for (int i = 0; i < cylinder.GetNumSlices(); i++, strip += length) {
+            AddStrip(strip, length, info.Triangles);
+        }
+    }
+    return info;
+}
+
+// Each triangle rotated to start at its smallest index, so that the triangles
+//    of two meshes can be compared regardless of their order.
+std::vector<std::array<unsigned int, 3>> SortedTriangles(const std::vector<unsigned int>& indices)
+{
+    std::vector<std::array<unsigned int, 3>> triangles;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        const unsigned int* t = indices.data() + i;
+        int first = (t[1] < t[0] && t[1] < t[2]) ? 1 : ((t[2] < t[0] && t[2] < t[1]) ? 2 : 0);
+        triangles.push_back({ t[first], t[(first + 1) % 3], t[(first + 2) % 3] });
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+// The compact mesh is built by a remesh, the strips by the constructor, to check both paths.
+bool CheckCompactCylinder(int slices, int stacks, int rings)
+{
+    GlGeomCylinder strips(slices, stacks, rings);
+    GlGeomCylinder compact;
+    compact.SetCompactFormat(true);
+    strips.InitializeAttribLocations(VertPosLoc, VertNormalLoc, VertTexCoordsLoc);
+    compact.InitializeAttribLocations(VertPosLoc, VertNormalLoc, VertTexCoordsLoc);
+    compact.Remesh(slices, stacks, rings);
+    compact.WaitForRemesh();
+    MeshInfo stripInfo = ReadCylinder(strips);
+    MeshInfo compactInfo = ReadCylinder(compact);
+    bool ok = compactInfo.VertexBytes == compactInfo.NumVertices * PackedVertexStride(true, true)
+        && SortedTriangles(stripInfo.Triangles) == SortedTriangles(compactInfo.Triangles);
+    for (unsigned int v : compactInfo.Triangles) {
+        ok = ok && v < (unsigned int)compactInfo.NumVertices;
+    }
+    printf("Compact cylinder, %d slices, %d stacks, %d rings: %s\n", slices, stacks, rings, ok ? "OK" : "FAILED");
+    return ok;
+}
+
+void PrintMesh(const char* shape, int resolution, bool compact, const MeshInfo& info, double buildMs)
+{
+    long numIndices = (long)info.Triangles.size();
+    double acmr = AverageCacheMissRatio(info.Triangles.data(), numIndices, MeshVertexCacheSize);
+    double bytesPerVertex = (double)info.VertexBytes / (double)info.NumVertices;
+    double fetchKB = acmr * (numIndices / 3) * bytesPerVertex / 1024.0;
+    printf("%-8s %5d  %-7s %8ld %9ld %6.0f %10ld %7.3f %11.1f %9.3f\n",
+           shape, resolution, compact ? "compact" : "strips", info.NumVertices, numIndices / 3,
+           bytesPerVertex, info.ElementBytes, acmr, fetchKB, buildMs);
+}
+
+// Build the meshes at resolution.  The build time is per remesh, averaged over
+//    numRepeats remeshes to the next resolution and back.
+void BenchShapes(int resolution, bool compact, int numRepeats)
+{
+    GlGeomSphere sphere(resolution, resolution);
+    GlGeomCylinder cylinder(resolution, resolution, resolution);
+    sphere.SetCompactFormat(compact);
+    cylinder.SetCompactFormat(compact);
+    sphere.InitializeAttribLocations(VertPosLoc, VertNormalLoc, VertTexCoordsLoc);
+    cylinder.InitializeAttribLocations(VertPosLoc, VertNormalLoc, VertTexCoordsLoc);
+    int other = (resolution < 255) ? resolution + 1 : resolution - 1;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numRepeats; i++) {
+        sphere.Remesh(other, other);
+        sphere.WaitForRemesh();
+        sphere.Remesh(resolution, resolution);
+        sphere.WaitForRemesh();
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (int i = 0; i < numRepeats; i++) {
+        cylinder.Remesh(other, other, other);
+        cylinder.WaitForRemesh();
+        cylinder.Remesh(resolution, resolution, resolution);
+        cylinder.WaitForRemesh();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double sphereMs = std::chrono::duration<double, std::milli>(middle - start).count() / (2 * numRepeats);
+    double cylinderMs = std::chrono::duration<double, std::milli>(end - middle).count() / (2 * numRepeats);
+
+    PrintMesh("sphere", resolution, compact, ReadSphere(sphere), sphereMs);
+    PrintMesh("cylinder", resolution, compact, ReadCylinder(cylinder), cylinderMs);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    int numRepeats = (argc > 1) ? atoi(argv[1]) : 10;
+    if (numRepeats < 1) {
+        numRepeats = 1;
+    }
+    std::vector<int> resolutions;
+    for (int i = 2; i < argc; i++) {
+        resolutions.push_back(atoi(argv[i]));
+    }
+    if (resolutions.empty()) {
+        resolutions = { 16, 80, 255 };
+    }
+
+    if (!CreateOffscreenContext()) {
+        return 1;
+    }
+    glewExperimental = GL_TRUE;
+    GLenum glewStatus = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    if (glewStatus == GLEW_ERROR_NO_GLX_DISPLAY) {
+        glewStatus = GLEW_OK;       // EGL context: the OpenGL entry points are loaded, only GLX is missing
+    }
+#endif
+    if (glewStatus != GLEW_OK) {
+        fprintf(stderr, "MeshBench: glewInit failed.\n");
+        DestroyOffscreenContext();
+        return 1;
+    }
+
+    bool checksOK = CheckCompactCylinder(8, 1, 4)
+        & CheckCompactCylinder(16, 2, 40)
+        & CheckCompactCylinder(3, 1, 255)
+        & CheckCompactCylinder(40, 40, 40);
+
+    printf("Vertex cache size %d\n", MeshVertexCacheSize);
+    printf("%-8s %5s  %-7s %8s %9s %6s %10s %7s %11s %9s\n", "shape", "res", "format", "vertices",
+           "triangles", "B/vert", "index B", "ACMR", "fetch KB", "build ms");
+    for (int resolution : resolutions) {
+        if (resolution < 3 || resolution > 255) {
+            fprintf(stderr, "MeshBench: resolution %d is not in 3..255.\n", resolution);
+            continue;
+        }
+        BenchShapes(resolution, false, numRepeats);
+        BenchShapes(resolution, true, numRepeats);
+    }
+    DestroyOffscreenContext();
+    return checksOK ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+// *******************************
+// AsyncLog.h
+//
+// A small asynchronous logger for messages printed from the
+//    render thread and the input callbacks.
+//
+// LogMessage() does not format anything and does not touch the console.
+//    It copies the format string pointer and the raw argument values
+//    into a slot of a lock-free ring buffer, and returns.
+//    A background writer thread formats the records and writes them out.
+// If the ring buffer is full the message is dropped (and counted),
+//    so the render thread never blocks on a slow terminal.
+//
+// The format string must be a string literal (only its pointer is kept).
+//    String arguments are copied, up to LogMaxInlineText bytes in total.
+//    Supported conversions are those of printf() for integers, floating
+//    point values, characters, strings and pointers.
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+#pragma once
+
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+
+enum LogLevel {
+    LogDebug = 0,           // Diagnostic information (mouse positions, etc.)
+    LogInfo = 1,            // Normal messages
+    LogWarning = 2,
+    LogError = 3,
+};
+
+constexpr int LogMaxArgs = 6;               // Max number of arguments to a single message
+constexpr int LogMaxInlineText = 96;        // Bytes available for copies of string arguments
+constexpr int LogQueueSize = 1024;          // Number of records in the ring buffer (a power of two)
+
+extern LogLevel logMinLevel;                // Messages below this level are discarded immediately.
+
+// One argument, stored in binary form until the writer thread formats it.
+struct LogArg {
+    enum ArgType : unsigned char { Int, UInt, Double, Text, Pointer };
+    ArgType Type;
+    union {
+        long long i;
+        unsigned long long u;
+        double d;
+        const char* s;      // Only valid before the argument is queued; then copied into the record
+        const void* p;
+    };
+};
+
+inline LogArg MakeLogArg(int v) { LogArg a; a.Type = LogArg::Int; a.i = v; return a; }
+inline LogArg MakeLogArg(long v) { LogArg a; a.Type = LogArg::Int; a.i = v; return a; }
+inline LogArg MakeLogArg(long long v) { LogArg a; a.Type = LogArg::Int; a.i = v; return a; }
+inline LogArg MakeLogArg(bool v) { LogArg a; a.Type = LogArg::Int; a.i = v ? 1 : 0; return a; }
+inline LogArg MakeLogArg(char v) { LogArg a; a.Type = LogArg::Int; a.i = v; return a; }
+inline LogArg MakeLogArg(unsigned int v) { LogArg a; a.Type = LogArg::UInt; a.u = v; return a; }
+inline LogArg MakeLogArg(unsigned long v) { LogArg a; a.Type = LogArg::UInt; a.u = v; return a; }
+inline LogArg MakeLogArg(unsigned long long v) { LogArg a; a.Type = LogArg::UInt; a.u = v; return a; }
+inline LogArg MakeLogArg(float v) { LogArg a; a.Type = LogArg::Double; a.d = v; return a; }
+inline LogArg MakeLogArg(double v) { LogArg a; a.Type = LogArg::Double; a.d = v; return a; }
+inline LogArg MakeLogArg(const char* v) { LogArg a; a.Type = LogArg::Text; a.s = v; return a; }
+inline LogArg MakeLogArg(const unsigned char* v) { return MakeLogArg((const char*)v); }
+inline LogArg MakeLogArg(const void* v) { LogArg a; a.Type = LogArg::Pointer; a.p = v; return a; }
+
+// ********
+// LogSite -
+//   Per call site rate limiting.  A static LogSite is declared by the
+//   LOG_RATE_LIMITED macro at each place it is used.  At most one message
+//   per minInterval seconds gets through; the others are counted, and the
+//   count is reported with the next message that is let through.
+// ********
+class LogSite {
+public:
+    explicit LogSite(double minIntervalSeconds);
+
+    bool Allow();                   // True if a message may be logged now
+    unsigned int TakeSuppressed()  { return Suppressed.exchange(0, std::memory_order_relaxed); }
+
+private:
+    long long MinIntervalTicks;
+    std::atomic<long long> NextAllowedTick;
+    std::atomic<unsigned int> Suppressed;
+};
+
+// Start and stop the background writer thread.
+//   StopAsyncLog() writes out all queued messages before returning.
+void StartAsyncLog(FILE* outStream = stdout);
+void StopAsyncLog();
+unsigned int LogNumDropped();       // Number of messages lost because the queue was full
+
+// Log one event of the startup timeline: the milliseconds since StartAsyncLog()
+//   and since the previous timeline event, followed by the label.
+void LogTimelineEvent(const char* label);
+
+// Internal: queue one record. Returns false if the ring buffer is full.
+bool LogPush(LogLevel level, const char* fmt, const LogArg* args, int numArgs, LogSite* site);
+
+// Log a message. Like printf(), except that a newline is added at the end.
+template<typename... Args>
+inline void LogMessage(LogLevel level, const char* fmt, const Args&... args)
+{
+    static_assert(sizeof...(Args) <= LogMaxArgs, "Too many arguments to LogMessage");
+    if (level < logMinLevel) {
+        return;
+    }
+    const LogArg argv[sizeof...(Args) + 1] = { MakeLogArg(args)... };  // The extra entry avoids a zero-length array
+    LogPush(level, fmt, argv, (int)sizeof...(Args), nullptr);
+}
+
+template<typename... Args>
+inline void LogMessageSite(LogSite& site, LogLevel level, const char* fmt, const Args&... args)
+{
+    static_assert(sizeof...(Args) <= LogMaxArgs, "Too many arguments to LogMessage");
+    if (level < logMinLevel || !site.Allow()) {
+        return;
+    }
+    const LogArg argv[sizeof...(Args) + 1] = { MakeLogArg(args)... };
+    LogPush(level, fmt, argv, (int)sizeof...(Args), &site);
+}
+
+// Log at most one message per "interval" seconds from this call site.
+#define LOG_RATE_LIMITED(interval, level, ...)                      \
+    do {                                                            \
+        static LogSite logSite_(interval);                          \
+        LogMessageSite(logSite_, level, __VA_ARGS__);               \
+    } while (0)
+
+// *************************************
+// Inlined functions
+// *************************************
+
+inline LogSite::LogSite(double minIntervalSeconds) :
+    MinIntervalTicks((long long)(minIntervalSeconds * std::chrono::steady_clock::period::den
+                                 / std::chrono::steady_clock::period::num)),
+    NextAllowedTick(0),
+    Suppressed(0)
+{}
+
+inline bool LogSite::Allow()
+{
+    long long now = std::chrono::steady_clock::now().time_since_epoch().count();
+    long long next = NextAllowedTick.load(std::memory_order_relaxed);
+    if (now < next
+        || !NextAllowedTick.compare_exchange_strong(next, now + MinIntervalTicks, std::memory_order_relaxed)) {
+        Suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+#endif // ASYNC_LOG_H
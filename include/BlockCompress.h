@@ -0,0 +1,63 @@
+// *******************************
+// BlockCompress.h
+//
+// Encoder and decoder for the BC1 (DXT1) and BC3 (DXT5) block compressed
+//    texture formats, which OpenGL exposes through EXT_texture_compression_s3tc
+//    as GL_COMPRESSED_RGB_S3TC_DXT1_EXT and GL_COMPRESSED_RGBA_S3TC_DXT5_EXT.
+// A BC1 block stores 4x4 pixels in 8 bytes (6:1 for RGB); a BC3 block adds
+//    8 bytes of alpha.  The compressed data is sampled directly by the GPU.
+//
+// The encoder is a fast "range fit": the endpoints are the (slightly inset)
+//    corners of the bounding box of the block's colors, and each pixel takes
+//    the palette entry closest along the box diagonal.  It uses SSE2 when
+//    available, and plain C++ otherwise; both give identical output.
+// It is fast enough to use when textures are loaded, and is also used by
+//    the offline texture packer (tools/TexturePack.cpp).
+//
+// Images need not be a multiple of 4 in size: the edge blocks repeat the
+//    last row and column.  Compressed blocks are in row order, from the first row.
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+#pragma once
+
+#ifndef BLOCK_COMPRESS_H
+#define BLOCK_COMPRESS_H
+
+class RgbImage;
+
+enum BlockFormat {
+    BlockBC1 = 0,           // 8 bytes per block, RGB
+    BlockBC3 = 1,           // 16 bytes per block, RGBA
+};
+
+// Number of bytes of compressed data for a width x height image
+inline long BlockCompressedSize(BlockFormat format, long width, long height)
+{
+    return ((width + 3) / 4) * ((height + 3) / 4) * (format == BlockBC1 ? 8 : 16);
+}
+
+// Compress an image.  The pixels have bytesPerPixel bytes (3 for RGB or 4 for RGBA),
+//    and consecutive rows start bytesPerRow bytes apart.  For BC3, RGB pixels are opaque.
+//    "out" must hold BlockCompressedSize() bytes.
+void EncodeBlocks(BlockFormat format, const unsigned char* pixels, long width, long height,
+                  long bytesPerRow, int bytesPerPixel, unsigned char* out);
+void EncodeBlocks(BlockFormat format, const RgbImage& image, unsigned char* out);
+
+// The same, without SIMD instructions.  (For testing and benchmarking.)
+void EncodeBlocksScalar(BlockFormat format, const unsigned char* pixels, long width, long height,
+                        long bytesPerRow, int bytesPerPixel, unsigned char* out);
+
+// Decompress into RGB pixels (3 bytes each), with rows bytesPerRow bytes apart.
+//    Alpha is dropped.  Used when the driver cannot sample compressed textures.
+void DecodeBlocks(BlockFormat format, const unsigned char* blocks, long width, long height,
+                  long bytesPerRow, unsigned char* rgbOut);
+void DecodeBlocks(BlockFormat format, const unsigned char* blocks, RgbImage& image);  // image must be allocated
+
+// Peak signal to noise ratio (in dB) of the RGB values of two images of the same size.
+double ImagePSNR(const RgbImage& a, const RgbImage& b);
+
+#endif // BLOCK_COMPRESS_H
@@ -11,7 +11,8 @@
 #include <GL/glew.h> 
 #include <GLFW/glfw3.h>
 
-class LinearMapR4;      // Used in the function prototypes, declared in LinearMapR4.h
+template<class T> class LinearMapR4T;    // Used in the function prototypes, declared in LinearR4.h
+typedef LinearMapR4T<double> LinearMapR4;
 
 //
 // External variables.  Can be be used by other .cpp files.
@@ -109,9 +109,6 @@ public:
 // Externals for Phong lighting -- and Phong lighting or Gouraud shading.
 // ***********************************************************
 
-extern unsigned int phShaderPhongPhong;     // Shader program: Phuong lighting with Phong shading
-extern unsigned int phShaderPhongGouraud;   // Shader program: Phuong lighting with Gouraud shading
-
 // The next values are used when setting vertex attribute pointers,
 //     and when loading generic vertex attributes
 extern const unsigned int phVertPos_loc;                   // Corresponds to "location = 0" in the vertex shader definition
@@ -121,15 +118,45 @@ extern const unsigned int AmbientColor_loc;                // Corresponds to "lo
 extern const unsigned int DiffuseColor_loc;                // Corresponds to "location = 5" in the vertex shader definition
 extern const unsigned int SpecularColor_loc;               // Corresponds to "location = 6" in the vertex shader definition
 extern const unsigned int SpecularExponent_loc;            // Corresponds to "location = 7" in the vertex shader definition
-
-extern unsigned int projMatLocationPP;				    // Location of the projectionMatrix in the Phong-Phong shader program.
-extern unsigned int projMatLocationPG;				    // Location of the projectionMatrix in the Phong-Gouraud shader program.
-extern unsigned int modelviewMatLocationPP;			    // Location of the modelviewMatrix in the Phong-Phong shader program.
-extern unsigned int modelviewMatLocationPG;			    // Location of the modelviewMatrix in the Phong-Gouraud shader program.
-extern unsigned int applyTextureLocationPP;			    // Location of applyTexture in the Phong-Phong shader program.
-extern unsigned int applyTextureLocationPG;			    // Location of applyTexture in the Phong-Gouraud shader program.
-
-void setup_phong_shaders();                 // Compiles and links the two shader programs
+extern const unsigned int phTextureLayer_loc;              // Corresponds to "location = 8" in the vertex shader definition
+
+// Shader variants.
+//   The shader programs are specialized with #define's for the features in use,
+//   instead of testing the phGlobal flags, the spotlight and attenuation flags,
+//   and whether to apply a texture at run time.  A variant is compiled the
+//   first time it is needed, and is then kept (and cached on disk).
+//   The variant is chosen from the values last loaded with phGlobal::LoadIntoShaders
+//   and phLight::LoadIntoShaders, so it is fixed before the frame starts.
+enum phVariantFlags {
+    phVariantTexture = 0x001,               // Apply the texture map
+    phVariantEmissive = 0x002,              // phGlobal::EnableEmissive
+    phVariantAmbient = 0x004,               // phGlobal::EnableAmbient
+    phVariantDiffuse = 0x008,               // phGlobal::EnableDiffuse
+    phVariantSpecular = 0x010,              // phGlobal::EnableSpecular
+    phVariantLocalViewer = 0x020,           // phGlobal::LocalViewer
+    phVariantSpotLights = 0x040,            // Some light is an enabled spotlight
+    phVariantAttenuation = 0x080,           // Some light is enabled and attenuated
+    phVariantGouraud = 0x100,               // Gouraud shading (otherwise Phong shading)
+};
+constexpr int phNumVariantBits = 9;
+constexpr int phNumVariants = 1 << phNumVariantBits;
+
+void setup_phong_shaders();                 // Sets up the uniform buffer, and compiles the first shader program
+void phSetShadingModel(bool useGouraud);    // Choose Gouraud or Phong shading for the following phUseProgram's
+void phSetExactShaders(bool exact);         // If true, phUseProgram waits for a variant still being built,
+                                            //   instead of using the closest ready one (reproducible images)
+void phSetProjectionMatrix(const float* entries);   // Projection matrix (16 floats, by columns) for all the programs
+
+// Bind the shader program for the current lighting state, compiling it if needed.
+//   Sets projMatLocation and modelviewMatLocation for the bound program;
+//   the modelview matrix must be loaded after this is called.
+void phUseProgram(bool applyTexture);
+
+// The textured programs sample a 2D texture array (bound to GL_TEXTURE0).
+//   The layer is a generic vertex attribute, like the material colors: set it
+//   before each draw, with no rebinding of textures.  For instanced draws it
+//   may instead come from a buffer, with glVertexAttribDivisor(phTextureLayer_loc, 1).
+void phSetTextureLayer(int layer);
 
 // *************************************
 // Constructors: Set default values.
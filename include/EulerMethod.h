@@ -1,5 +1,5 @@
 #pragma once
 
-const double gravityAcceleration = 9.8;
+constexpr double gravityAcceleration = 9.8;
 
 void EulerMethod(LinearMapR4 &droneMatrix, VectorR3 &currentVelocity, VectorR3 &currentAngularVelocity, double deltaTime);
@@ -11,7 +11,9 @@
 #include <GL/glew.h> 
 #include <GLFW/glfw3.h>
 
-class LinearMapR4;      // Used in the function prototypes, declared in LinearMapR4.h
+template<class T> class LinearMapR4T;    // Used in the function prototypes, declared in LinearR4.h
+typedef LinearMapR4T<double> LinearMapR4;
+struct FlyThroughKey;   // Declared in FlyThrough.h
 
 //
 // External variables.  Can be be used by other .cpp files.
@@ -52,6 +54,19 @@ void MyRenderScene();
 void my_setup_SceneData();
 void my_setup_OpenGL();
 void setProjectionMatrix();
+void SetViewAndRotors(const FlyThroughKey& key);
+FlyThroughKey GetViewAndRotors(int frame);
+
+// Options for the headless mode, from the command line
+struct HeadlessOptions {
+    int Width, Height;
+    int NumFrames;                  // Not used by benchmarks: the camera path sets the number of frames
+    const char* FileNamePattern;    // Frame files (see StartFrameCapture); "" for none
+    const char* BenchmarkPath;      // Camera path file, "" for the built-in path, or null if not a benchmark
+    const char* JsonFileName;       // Where the benchmark results are written
+    const char* ProfileFileName;    // Chrome trace of the frames (see Profiler.h), or null for no profiling
+};
+int RunHeadless(const HeadlessOptions& options);
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods);
 void window_size_callback(GLFWwindow* window, int width, int height);
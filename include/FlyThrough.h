@@ -0,0 +1,75 @@
+// *******************************
+// FlyThrough.h
+//
+// Scripted camera paths, and the results of a benchmark run along one.
+//
+// A FlyThroughPath is a list of keys: at a given frame number, the view
+//    (viewAzimuth, viewDirection, ZextraDistance) and the rotor speeds
+//    (spinVelocity).  Between keys the values are interpolated linearly;
+//    viewDirection takes the shorter way around the circle.
+// A path is read from, and written to, a text file with one key per line:
+//       frame  azimuth  direction  zExtra  spin0  spin1  spin2  spin3
+//    Blank lines and lines starting with '#' are ignored.
+//
+// FlyThroughResults holds the frame times, draw calls and triangle counts
+//    of each frame, and writes them out as JSON: the average, median,
+//    95th and 99th percentile frame times, and the draw calls and
+//    triangles per frame.
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+#pragma once
+
+#ifndef FLY_THROUGH_H
+#define FLY_THROUGH_H
+
+#include <stdio.h>
+#include <vector>
+
+struct FlyThroughKey {
+    int Frame;
+    double ViewAzimuth;
+    double ViewDirection;
+    double ZextraDistance;
+    double SpinVelocity[4];
+};
+
+class FlyThroughPath {
+public:
+    bool Load(const char* filename);        // Prints an error and returns false on failure
+    bool Save(const char* filename) const;
+    void SetDefault();                      // One orbit around the scene, while the rotors speed up and stop
+
+    // Add a key after the last one.  Keys repeating the previous key's values
+    //   extend it instead, so a recording of a still camera stays short.
+    void AddKey(const FlyThroughKey& key);
+
+    int NumFrames() const { return Keys.empty() ? 0 : Keys.back().Frame + 1; }
+    FlyThroughKey Evaluate(int frame) const;
+
+private:
+    std::vector<FlyThroughKey> Keys;        // In increasing order of Frame
+};
+
+class FlyThroughResults {
+public:
+    void Reset(int numFrames);
+    void SetFrameTime(int frame, double milliseconds) { FrameTimes[frame] = milliseconds; }
+    void SetFrameCounts(int frame, unsigned long drawCalls, unsigned long long triangles);
+
+    double FrameTimePercentile(double percent) const;   // Nearest rank, in milliseconds
+    double AverageFrameTime() const;
+
+    // pathName and renderer are written out as strings.
+    void WriteJson(FILE* out, const char* pathName, const char* renderer, int width, int height) const;
+
+private:
+    std::vector<double> FrameTimes;         // Milliseconds
+    std::vector<unsigned long> DrawCalls;
+    std::vector<unsigned long long> Triangles;
+};
+
+#endif // FLY_THROUGH_H
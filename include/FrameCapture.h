@@ -0,0 +1,47 @@
+// *******************************
+// FrameCapture.h
+//
+// Records the rendered frames to image files, without stalling the render thread.
+//
+// CaptureFrame() starts an asynchronous glReadPixels of the back buffer
+//    into one of a ring of pixel buffer objects, and puts a fence after it.
+//    The pixels are only mapped FrameCaptureLatency frames later, when the
+//    GPU has long finished the copy, so the render thread does not wait.
+//    The images are then handed to writer threads, which write the files.
+// If the writers fall behind, frames are dropped (and counted) rather than
+//    letting the queue grow without bound.
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+#pragma once
+
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+constexpr int FrameCaptureLatency = 3;          // Frames between the readback and mapping its buffer
+constexpr int FrameCaptureMaxQueued = 32;       // Frames waiting for a writer thread before frames are dropped
+
+// Start recording frames of width x height pixels.  fileNamePattern is a
+//    printf() format for the frame number, e.g., "frame%05d.qoi".
+//    Files ending in ".qoi" are written in the (lossless) QOI format, which
+//    is several times smaller than BMP; any other name gets a BMP file.
+//    Does nothing (except log an error) unless IsFrameFileNamePattern(fileNamePattern).
+void StartFrameCapture(const char* fileNamePattern, int width, int height);
+
+// Whether the pattern is safe to use as the printf() format: exactly one %d
+//    or %i (with optional flags, width and precision), and no other % except %%.
+bool IsFrameFileNamePattern(const char* fileNamePattern);
+
+// Read back the current frame buffer (call it just before swapping buffers).
+//    Does nothing unless capture is started.
+void CaptureFrame();
+
+// Finish reading back, wait for the writer threads to write every frame, and stop.
+void StopFrameCapture();
+
+bool FrameCaptureRunning();
+
+#endif // FRAME_CAPTURE_H
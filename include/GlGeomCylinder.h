@@ -27,6 +27,9 @@
 #define GLEW_STATIC
 #include <GL/glew.h> 
 #include <GLFW/glfw3.h>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 class GlGeomCylinder
 {
@@ -48,7 +51,17 @@ public:
 	// Re-mesh to change the number slices and stacks and rings.
 	// Can be called either before or after InitAttribLocations(), but it is
 	//    more efficient if Remesh() is called first, or if the constructor sets the mesh resolution.
+	// Once InitAttribLocations() has been called, the new mesh is built on a worker
+	//    thread, and the old mesh is rendered until it is ready.
 	void Remesh(int slices, int stacks, int rings);
+	void PollRemesh();          // Swap in the new mesh if it is ready (the Render routines call this)
+	void WaitForRemesh();       // Finish a remesh in progress
+
+	// The compact format: Tipsify-ordered triangle lists, with unsigned short indices
+	//    when there are few enough vertices, and packed vertices (see MeshOptimize.h).
+	//    Best called before InitializeAttribLocations(); otherwise the mesh is rebuilt.
+	void SetCompactFormat(bool compact);
+	bool IsCompactFormat() const { return compactFormat; }
 
     void Render();          // Render: renders entire cylinder
     void RenderTop();
@@ -63,7 +76,10 @@ public:
     int GetNumSlices() const { return numSlices; }
     int GetNumStacks() const { return numStacks; }
     int GetNumRings() const { return numRings; }
-    int GetNumElements() const { return numSlices*(2*(2 * numRings + 1) + 2 * (numStacks + 1)); }
+    int GetNumElements() const {
+        return compactFormat ? 2 * NumFaceElements() + NumSideElements()
+                             : numSlices*(2*(2 * numRings + 1) + 2 * (numStacks + 1));
+    }
     int GetNumVertices() const { return 2 * ((numSlices+1)*numRings + 1) + (numSlices+1) * (numStacks + 1); }
     int GetNumDrawsFace() const { return numSlices; }
     int GetNumDraws() const { return 3 * numSlices; }
@@ -81,6 +97,15 @@ public:
 
 private: 
     void LoadBufferData();
+    void UpdateTrigTables();
+    void BuildBufferData(void* vertexData, void* elementData) const;
+    void FillBufferData(float* vertexData, unsigned int* elementData) const;
+    void FillCompactBufferData(void* vertexData, void* elementData) const;
+    void FillSlices(float* vertexData, unsigned int* elementData, int firstSlice, int endSlice) const;
+    void StartRemesh();
+    void BeginBuild();
+    void EndBuild();
+    bool UnmapBackBuffers();
     bool AssertReadyToRender();
 
     // Stride value, and offset values for the data in the VBO.
@@ -92,12 +117,21 @@ private:
     }
     int NormalOffset() const { return 3; }
     int TexOffset() const { return 3 + (UseNormals() ? 3 : 0); }
+
+    // In the compact format: the triangle list elements of one end face, and of the side
+    int NumFaceElements() const { return 3 * numSlices*(2 * numRings - 1); }
+    int NumSideElements() const { return 6 * numSlices*numStacks; }
+    bool ShortIndices() const { return compactFormat && GetNumVertices() <= USHRT_MAX + 1; }
+    long VertexBytes() const;
+    long ElementBytes() const { return GetNumElements() * (ShortIndices() ? sizeof(unsigned short) : sizeof(unsigned int)); }
  
 private:
     unsigned int theVAO = 0;        // Vertex Array Object
     unsigned int theVBO = 0;        // Vertex Buffer Object
     unsigned int theEBO = 0;        // Element Buffer Object;
     unsigned int theIBO = 0;        // Draw Indirect Buffer Object
+    unsigned int backVBO = 0;       // The next mesh is built in these,
+    unsigned int backEBO = 0;       //    then swapped with theVBO and theEBO
 
 	unsigned int posLoc;            // location of vertex position x,y,z data in the shader program
 	unsigned int normalLoc;         // location of vertex normal data in the shader program
@@ -106,6 +140,28 @@ private:
     int numSlices;          // Number of radial slices (like cake slices
     int numStacks;          // Number of stacks between the two end faces
     int numRings;           // Number of concentric rings on two end faces
+    bool compactFormat = false;
+
+    std::vector<float> sliceCos, sliceSin;      // Cosine and sine of each slice angle theta
+
+    // Remeshing in the background.  numSlices, numStacks and numRings describe the
+    //    mesh being built (the worker thread reads them); StartRemesh() sets them.
+    int requestedSlices, requestedStacks, requestedRings;   // From the last Remesh()
+    int drawnNumSlices = 0;         // Of the mesh in theVBO and theEBO
+    int drawnFaceElements = 0;      // For the compact format
+    int drawnSideElements = 0;
+    GLenum drawnIndexType = GL_UNSIGNED_INT;
+    void* IndexOffset(int numElements) const {
+        return (void*)(numElements * (drawnIndexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int)));
+    }
+    bool remeshing = false;
+    std::atomic<bool> remeshDone;
+    std::thread remeshThread;
+    bool backMapped = false;
+    void* backVertexData = 0;       // The mapped back buffers, or vertexStore and elementStore
+    void* backElementData = 0;
+    std::vector<unsigned char> vertexStore;
+    std::vector<unsigned char> elementStore;
 
 private:
     struct multiDrawData {
@@ -126,14 +182,25 @@ inline GlGeomCylinder::GlGeomCylinder(int slices, int stacks, int rings)
 	numSlices = slices;
 	numStacks = stacks;
     numRings = rings;
+    requestedSlices = slices;
+    requestedStacks = stacks;
+    requestedRings = rings;
+    remeshDone = false;
 }
 
 inline GlGeomCylinder::~GlGeomCylinder()
 {
+    if (remeshThread.joinable()) {
+        remeshThread.join();
+    }
     int numToDelete = MultiDrawIndirectUsed() ? 4 : 3;
     glDeleteBuffers(numToDelete, &theVAO);  // The buffer id's are contigous in memory! 
 
+    glDeleteBuffers(2, &backVBO);
+
     delete[] mdDataPtr;
+    delete[] mdCounts;
+    delete[] mdIndices;
 }
 
 bool check_for_opengl_errors();
@@ -26,6 +26,15 @@
 #define GLEW_STATIC
 #include <GL/glew.h> 
 #include <GLFW/glfw3.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// The range of numbers of slices and stacks, for both InitializeAttribLocations() and Remesh().
+//    At most 255 allows unsigned shorts for the elements.
+constexpr int GlGeomSphereMinSlices = 3;
+constexpr int GlGeomSphereMinStacks = 2;
+constexpr int GlGeomSphereMaxSlicesStacks = 255;
 
 class GlGeomSphere
 {
@@ -47,7 +56,17 @@ public:
 	// Remesh: re-mesh to change the number slices and stacks.
 	// Can be called either before or after InitAttribLocations(), but it is
 	//    more efficient if Remesh() is called first, or if the constructor sets the mesh resolution.
+	// After InitAttribLocations(), the new mesh is built on a worker thread into a second
+	//    VBO and EBO, and the sphere is drawn with the old mesh until then.
 	void Remesh(int slices, int stacks);
+	void PollRemesh();          // Swap in the new mesh if it is ready.  Render() calls this.
+	void WaitForRemesh();       // Finish the remesh now
+
+	// The compact format: Tipsify-ordered triangle lists instead of triangle strips,
+	//    and packed vertices (see MeshOptimize.h), half the size of the float ones.
+	//    Best called before InitializeAttribLocations(); otherwise the mesh is rebuilt.
+	void SetCompactFormat(bool compact);
+	bool IsCompactFormat() const { return compactFormat; }
 
 	void Render();
  
@@ -57,7 +76,9 @@ public:
 
     int GetNumSlices() const { return numSlices; }
     int GetNumStacks() const { return numStacks; }
-    int GetNumElements() const { return numSlices*(2*numStacks+1); }
+    int GetNumElements() const {
+        return compactFormat ? 6*numSlices*(numStacks-1) : numSlices*(2*numStacks+1);
+    }
     int GetNumVertices() const { return (numSlices+1)*(numStacks-1)+2; }
 
 	// Disable all copy and assignment operators.
@@ -71,12 +92,23 @@ public:
 
 private: 
     void LoadBufferData();
+    void UpdateTrigTables();
+    void BuildBufferData(void* vertexData, void* elementData) const;
+    void FillBufferData(float* vertexData, unsigned short* elementData) const;
+    void FillCompactBufferData(void* vertexData, void* elementData) const;
+    void FillSlices(float* vertexData, unsigned short* elementData, int firstSlice, int endSlice) const;
+    void StartRemesh();
+    void BeginBuild();
+    void EndBuild();
+    bool UnmapBackBuffers();
     unsigned short PrimRestartIndex = USHRT_MAX;        // Use for primitive restarts (starting new triangle strips)
 
 private:
     unsigned int theVAO = 0;        // Vertex Array Object
     unsigned int theVBO = 0;        // Vertex Buffer Object
     unsigned int theEBO = 0;        // Element Buffer Object;
+    unsigned int backVBO = 0;       // The next mesh is built into these two
+    unsigned int backEBO = 0;
 
     // Stride value, and offset values for the data in the VBO.
     // These take into account whether normals and texture coordinates are used.
@@ -87,6 +119,8 @@ private:
     }
     int NormalOffset() const { return 3; }
     int TexOffset() const { return 3 + (UseNormals() ? 3 : 0); }
+    long VertexBytes() const;
+    long ElementBytes() const { return GetNumElements()*sizeof(unsigned short); }
 
     unsigned int posLoc;            // location of vertex position x,y,z data in the shader program
     unsigned int normalLoc;         // location of vertex normal data in the shader program
@@ -94,17 +128,43 @@ private:
 
     int numSlices;              // Number of radial slices (like case slices)
     int numStacks;              // Number of levels separating the north pole from the south pole.
+    bool compactFormat = false;
+
+    // Sines and cosines of the slice angles theta and the stack angles phi
+    std::vector<float> sliceCos, sliceSin;
+    std::vector<float> stackCos, stackSin;
+
+    // Remeshing in the background.  numSlices and numStacks are those of the mesh
+    //    being built, which the worker thread reads: only StartRemesh() changes them.
+    int requestedSlices = 0;        // From the last call to Remesh()
+    int requestedStacks = 0;
+    int drawnNumElements = 0;       // Of the mesh in theVBO and theEBO
+    bool remeshing = false;
+    std::atomic<bool> remeshDone;
+    std::thread remeshThread;
+    bool backMapped = false;
+    void* backVertexData = 0;       // Mapped back buffers, or client memory if mapping failed
+    void* backElementData = 0;
+    std::vector<unsigned char> vertexStore;
+    std::vector<unsigned char> elementStore;
 };
 
 inline GlGeomSphere::GlGeomSphere(int slices, int stacks)
 {
 	numSlices = slices;
 	numStacks = stacks;
+	requestedSlices = slices;
+	requestedStacks = stacks;
+	remeshDone = false;
 }
 
 inline GlGeomSphere::~GlGeomSphere() 
 {
+    if (remeshThread.joinable()) {
+        remeshThread.join();
+    }
     glDeleteBuffers(3, &theVAO);  // The three buffer id's are contigous in memory!
+    glDeleteBuffers(2, &backVBO);
 }
 
 
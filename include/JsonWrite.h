@@ -0,0 +1,39 @@
+// *******************************
+// JsonWrite.h
+//
+// Writing JSON output: shared by the benchmark results (FlyThrough.cpp)
+//    and the Chrome trace files (Profiler.cpp).
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+#pragma once
+
+#ifndef JSON_WRITE_H
+#define JSON_WRITE_H
+
+#include <stdio.h>
+
+// Write a string as a JSON string literal.  Quotes and backslashes are escaped,
+//    and control characters are written as \u00XX.
+inline void WriteJsonString(FILE* out, const char* s)
+{
+    fputc('"', out);
+    for (; *s != 0; s++) {
+        if (*s == '"' || *s == '\\') {
+            fputc('\\', out);
+            fputc(*s, out);
+        }
+        else if ((unsigned char)*s < 0x20) {
+            fprintf(out, "\\u%04x", (unsigned char)*s);
+        }
+        else {
+            fputc(*s, out);
+        }
+    }
+    fputc('"', out);
+}
+
+#endif // JSON_WRITE_H
@@ -41,6 +41,11 @@
 //
 //	  B.4 RigidMapR3 - RotationMapR3 plus displacement  
 //
+// VectorR3, Matrix3x3 and LinearMapR3 are the double precision versions
+//    of the templates VectorR3T, Matrix3x3T and LinearMapR3T.  The templates
+//    may be used with any scalar type with the usual arithmetic operators
+//    and sqrt(), such as float.
+//
 
 #ifndef LINEAR_R3_H
 #define LINEAR_R3_H
@@ -51,31 +56,41 @@
 #include "MathMisc.h"
 using namespace std;
 
-class VectorR3;				// Space Vector (length 3)
+template<class T> class VectorR3T;	// Space Vector (length 3), over the scalar type T
+template<class T> class VectorR4T;	// Space Vector (length 4)
+template<class T> class Matrix3x3T;
+template<class T> class LinearMapR3T;	// Linear Map (3x3 Matrix)
+typedef VectorR3T<double> VectorR3;
+typedef VectorR4T<double> VectorR4;
+typedef Matrix3x3T<double> Matrix3x3;
+typedef LinearMapR3T<double> LinearMapR3;
+
 class VectorHgR3;			// Homogenous Space Vector
-class VectorR4;				// Space Vector (length 4)
 
-class LinearMapR3;			// Linear Map (3x3 Matrix)
 class AffineMapR3;			// Affine Map (3x4 Matrix)
 class RotationMapR3;		// Rotation (3x3 orthonormal matrix)
 class RigidMapR3;			// 3x4 matrix, first 3 columns orthonormal
 
 // Most for internal use:
-class Matrix3x3;
 class Matrix3x4;
 
 class Quaternion;
 
+// Scalar arguments of the templated operators are kept out of template
+//   argument deduction, so that  u*2  works for every scalar type.
+template<class T> struct LinearScalar { typedef T Type; };
+
 // **************************************
 // VectorR3 class                       *
 // * * * * * * * * * * * * * * * * * * **
 
-class VectorR3 {
+template<class T>
+class VectorR3T {
 
 public:
-	double x, y, z;		// The x & y & z coordinates.
+	T x, y, z;		// The x & y & z coordinates.
 
-	static const VectorR3 Zero;
+	static const VectorR3T Zero;
 	// Deprecated due to unsafeness of global initialization
 	//static const VectorR3 UnitX;
 	//static const VectorR3 UnitY;
@@ -85,98 +100,96 @@ public:
 	//static const VectorR3 NegUnitZ;
 
 public:
-	VectorR3( ) : x(0.0), y(0.0), z(0.0) {}
-	VectorR3( double xVal, double yVal, double zVal )
+	constexpr VectorR3T( ) : x(0.0), y(0.0), z(0.0) {}
+	constexpr VectorR3T( T xVal, T yVal, T zVal )
 		: x(xVal), y(yVal), z(zVal) {}
-	VectorR3( const VectorHgR3& uH );
+	VectorR3T( const VectorHgR3& uH );
 
-	VectorR3& Set( const Quaternion& );	// Convert quat to rotation vector
-	VectorR3& Set( double xx, double yy, double zz ) 
+	VectorR3T& Set( const Quaternion& );	// Convert quat to rotation vector (Quaternion.h)
+	VectorR3T& Set( T xx, T yy, T zz ) 
 				{ x=xx; y=yy; z=zz; return *this; }
-	VectorR3& SetFromHg( const VectorR4& );	// Convert homogeneous VectorR4 to VectorR3
-	VectorR3& SetZero() { x=0.0; y=0.0; z=0.0;  return *this;}
-	VectorR3& SetUnitX() { x=1.0; y=0.0; z=0.0;  return *this;}
-	VectorR3& SetUnitY() { x=0.0; y=1.0; z=0.0;  return *this;}
-	VectorR3& SetUnitZ() { x=0.0; y=0.0; z=1.0;  return *this;}
-	VectorR3& SetNegUnitX() { x=-1.0; y=0.0; z=0.0;  return *this;}
-	VectorR3& SetNegUnitY() { x=0.0; y=-1.0; z=0.0;  return *this;}
-	VectorR3& SetNegUnitZ() { x=0.0; y=0.0; z=-1.0;  return *this;}
-	VectorR3& Load( const double* v );
-	VectorR3& Load( const float* v );
+	VectorR3T& SetFromHg( const VectorR4T<T>& );	// Convert homogeneous VectorR4 to VectorR3
+	VectorR3T& SetZero() { x=0.0; y=0.0; z=0.0;  return *this;}
+	VectorR3T& SetUnitX() { x=1.0; y=0.0; z=0.0;  return *this;}
+	VectorR3T& SetUnitY() { x=0.0; y=1.0; z=0.0;  return *this;}
+	VectorR3T& SetUnitZ() { x=0.0; y=0.0; z=1.0;  return *this;}
+	VectorR3T& SetNegUnitX() { x=-1.0; y=0.0; z=0.0;  return *this;}
+	VectorR3T& SetNegUnitY() { x=0.0; y=-1.0; z=0.0;  return *this;}
+	VectorR3T& SetNegUnitZ() { x=0.0; y=0.0; z=-1.0;  return *this;}
+	VectorR3T& Load( const double* v );
+	VectorR3T& Load( const float* v );
 	void Dump( double* v ) const;
 	void Dump( float* v ) const;
 
-	inline double operator[]( int i ) const;
+	inline T operator[]( int i ) const;
 
-	VectorR3& operator= ( const VectorR3& v ) 
+	constexpr VectorR3T& operator= ( const VectorR3T& v ) 
 		{ x=v.x; y=v.y; z=v.z; return(*this);}
-	VectorR3& operator+= ( const VectorR3& v ) 
+	constexpr VectorR3T& operator+= ( const VectorR3T& v ) 
 		{ x+=v.x; y+=v.y; z+=v.z; return(*this); } 
-	VectorR3& operator-= ( const VectorR3& v ) 
+	constexpr VectorR3T& operator-= ( const VectorR3T& v ) 
 		{ x-=v.x; y-=v.y; z-=v.z; return(*this); }
-	VectorR3& operator*= ( double m ) 
+	constexpr VectorR3T& operator*= ( T m ) 
 		{ x*=m; y*=m; z*=m; return(*this); }
-	VectorR3& operator/= ( double m ) 
-			{ register double mInv = 1.0/m; 
+	constexpr VectorR3T& operator/= ( T m ) 
+			{ T mInv = 1.0/m; 
 			  x*=mInv; y*=mInv; z*=mInv; 
 			  return(*this); }
-	VectorR3 operator- () const { return ( VectorR3(-x, -y, -z) ); }
-	VectorR3& operator*= (const VectorR3& v);	// Cross Product
-	VectorR3& CrossProductLeft (const VectorR3& v);	// Cross Product on left
-	VectorR3& ArrayProd(const VectorR3&);		// Component-wise product
+	constexpr VectorR3T operator- () const { return ( VectorR3T(-x, -y, -z) ); }
+	VectorR3T& operator*= (const VectorR3T& v);	// Cross Product
+	VectorR3T& CrossProductLeft (const VectorR3T& v);	// Cross Product on left
+	VectorR3T& ArrayProd(const VectorR3T&);		// Component-wise product
 
-	VectorR3& AddScaled( const VectorR3& u, double s );
-	VectorR3& SubtractFrom( const VectorR3& u );	
-	VectorR3& AddCrossProduct( const VectorR3& u, const VectorR3& v );
+	VectorR3T& AddScaled( const VectorR3T& u, T s );
+	VectorR3T& SubtractFrom( const VectorR3T& u );	
+	VectorR3T& AddCrossProduct( const VectorR3T& u, const VectorR3T& v );
 
 	bool IsZero() const { return ( x==0.0 && y==0.0 && z==0.0 ); }
-	double Norm() const { return ( (double)sqrt( x*x + y*y + z*z ) ); }
-	double NormSq() const { return ( x*x + y*y + z*z ); }
-	double MaxAbs() const;
-	double Dist( const VectorR3& u ) const;	// Distance from u
-	double DistSq( const VectorR3& u ) const;	// Distance from u squared
-	VectorR3& Negate() { x = -x; y = -y; z = -z; return *this;}	
-	VectorR3& Normalize () { *this /= Norm(); return *this;}	// No error checking
-	inline VectorR3& MakeUnit();		// Normalize() with error checking
-	inline VectorR3& ReNormalize();
+	T Norm() const { return ( (T)sqrt( x*x + y*y + z*z ) ); }
+	constexpr T NormSq() const { return ( x*x + y*y + z*z ); }
+	T MaxAbs() const;
+	T Dist( const VectorR3T& u ) const;	// Distance from u
+	T DistSq( const VectorR3T& u ) const;	// Distance from u squared
+	VectorR3T& Negate() { x = -x; y = -y; z = -z; return *this;}	
+	VectorR3T& Normalize () { *this /= Norm(); return *this;}	// No error checking
+	inline VectorR3T& MakeUnit();		// Normalize() with error checking
+	inline VectorR3T& ReNormalize();
 	bool IsUnit( ) const
-		{ register double norm = Norm();
+		{ T norm = Norm();
 		  return ( 1.000001>=norm && norm>=0.999999 ); }
-	bool IsUnit( double tolerance ) const
-		{ register double norm = Norm();
+	bool IsUnit( T tolerance ) const
+		{ T norm = Norm();
 		  return ( 1.0+tolerance>=norm && norm>=1.0-tolerance ); }
-	bool NearZero(double tolerance) const { return( MaxAbs()<=tolerance );}
+	bool NearZero(T tolerance) const { return( MaxAbs()<=tolerance );}
 							// tolerance should be non-negative
-	inline bool operator==(const VectorR3& u) const { return (x==u.x && y==u.y && z==u.z); }
-	inline bool operator!=(const VectorR3& u) const { return (x!=u.x || y!=u.y || z!=u.z); }
+	inline bool operator==(const VectorR3T& u) const { return (x==u.x && y==u.y && z==u.z); }
+	inline bool operator!=(const VectorR3T& u) const { return (x!=u.x || y!=u.y || z!=u.z); }
 
-	double YaxisDistSq() const { return (x*x+z*z); }
-	double YaxisDist() const { return sqrt(x*x+z*z); }
+	T YaxisDistSq() const { return (x*x+z*z); }
+	T YaxisDist() const { return sqrt(x*x+z*z); }
 
-	VectorR3& Rotate( double theta, const VectorR3& u); // rotate around u.
-	VectorR3& RotateUnitInDirection ( const VectorR3& dir);	// rotate in direction dir
-	VectorR3& Rotate( const Quaternion& );	// Rotate according to quaternion
-											// Defined in Quaternion.cpp
-
-	friend ostream& operator<< ( ostream& os, const VectorR3& u );
+	VectorR3T& Rotate( T theta, const VectorR3T& u); // rotate around u.
+	VectorR3T& RotateUnitInDirection ( const VectorR3T& dir);	// rotate in direction dir
+	VectorR3T& Rotate( const Quaternion& );	// Rotate according to quaternion
+											// Defined in Quaternion.h
 
 };
 
-inline VectorR3 operator+( const VectorR3& u, const VectorR3& v );
-inline VectorR3 operator-( const VectorR3& u, const VectorR3& v ); 
-inline VectorR3 operator*( const VectorR3& u, double m); 
-inline VectorR3 operator*( double m, const VectorR3& u); 
-inline VectorR3 operator/( const VectorR3& u, double m); 
-
-inline double operator^ (const VectorR3& u, const VectorR3& v ); // Dot Product
-inline double InnerProduct(const VectorR3& u, const VectorR3& v ) { return (u^v); }
-inline VectorR3 operator* (const VectorR3& u, const VectorR3& v);	 // Cross Product
-inline VectorR3 ArrayProd ( const VectorR3& u, const VectorR3& v );
-
-inline double Mag(const VectorR3& u) { return u.Norm(); }
-inline double Dist(const VectorR3& u, const VectorR3& v) { return u.Dist(v); }
-inline double DistSq(const VectorR3& u, const VectorR3& v) { return u.DistSq(v); }
-inline double NormalizeError (const VectorR3& u);
+template<class T> constexpr VectorR3T<T> operator+( const VectorR3T<T>& u, const VectorR3T<T>& v );
+template<class T> constexpr VectorR3T<T> operator-( const VectorR3T<T>& u, const VectorR3T<T>& v ); 
+template<class T> constexpr VectorR3T<T> operator*( const VectorR3T<T>& u, typename LinearScalar<T>::Type m); 
+template<class T> constexpr VectorR3T<T> operator*( typename LinearScalar<T>::Type m, const VectorR3T<T>& u); 
+template<class T> constexpr VectorR3T<T> operator/( const VectorR3T<T>& u, typename LinearScalar<T>::Type m); 
+
+template<class T> constexpr T operator^ (const VectorR3T<T>& u, const VectorR3T<T>& v ); // Dot Product
+template<class T> constexpr T InnerProduct(const VectorR3T<T>& u, const VectorR3T<T>& v ) { return (u^v); }
+template<class T> constexpr VectorR3T<T> operator* (const VectorR3T<T>& u, const VectorR3T<T>& v);	 // Cross Product
+template<class T> constexpr VectorR3T<T> ArrayProd ( const VectorR3T<T>& u, const VectorR3T<T>& v );
+
+template<class T> inline T Mag(const VectorR3T<T>& u) { return u.Norm(); }
+template<class T> inline T Dist(const VectorR3T<T>& u, const VectorR3T<T>& v) { return u.Dist(v); }
+template<class T> inline T DistSq(const VectorR3T<T>& u, const VectorR3T<T>& v) { return u.DistSq(v); }
+template<class T> inline T NormalizeError (const VectorR3T<T>& u);
  
 // Deprecated due to unsafeness of global initialization
 //extern const VectorR3 UnitVecIR3;
@@ -209,16 +222,17 @@ public:
 // Advanced vector and position functions (prototypes)
 //
 
-VectorR3 Interpolate( const VectorR3& start, const VectorR3& end, double a);
+template<class T> VectorR3T<T> Interpolate( const VectorR3T<T>& start, const VectorR3T<T>& end, double a);
 
 // *****************************************
 // Matrix3x3 class                         *
 // * * * * * * * * * * * * * * * * * * * * *
 
-class Matrix3x3 {
+template<class T>
+class Matrix3x3T {
 public:
 
-	double m11, m21, m31, m12, m22, m32, m13, m23, m33;	
+	T m11, m21, m31, m12, m22, m32, m13, m23, m33;	
 									
 	// Implements a 3x3 matrix: m_i_j - row-i and column-j entry
 
@@ -226,77 +240,80 @@ public:
 	//static const Matrix3x3 Identity;
 
 public:
-	inline Matrix3x3();
-	inline Matrix3x3(const VectorR3&, const VectorR3&, const VectorR3&); // Sets by columns!
-	inline Matrix3x3(double, double, double, double, double, double,
-					 double, double, double );	// Sets by columns
+	inline Matrix3x3T();
+	constexpr Matrix3x3T(const VectorR3T<T>&, const VectorR3T<T>&, const VectorR3T<T>&); // Sets by columns!
+	constexpr Matrix3x3T(T, T, T, T, T, T,
+					 T, T, T );	// Sets by columns
 
 	inline void SetIdentity ();		// Set to the identity map
-	inline void Set ( const Matrix3x3& );	// Set to the matrix.
+	inline void Set ( const Matrix3x3T& );	// Set to the matrix.
 	inline void Set3x3 ( const Matrix3x4& );	// Set to the 3x3 part of the matrix.
-	inline void Set( const VectorR3&, const VectorR3&, const VectorR3& );
-	inline void Set( double, double, double,
-					 double, double, double,
-					 double, double, double );
-	inline void SetByRows( double, double, double, double, double, double,
-							double, double, double );
-	inline void SetByRows( const VectorR3&, const VectorR3&, const VectorR3& );
+	inline void Set( const VectorR3T<T>&, const VectorR3T<T>&, const VectorR3T<T>& );
+	inline void Set( T, T, T,
+					 T, T, T,
+					 T, T, T );
+	inline void SetByRows( T, T, T, T, T, T,
+							T, T, T );
+	inline void SetByRows( const VectorR3T<T>&, const VectorR3T<T>&, const VectorR3T<T>& );
 	inline void LoadByRows( const double* );
 	
-	inline void SetColumn1 ( double, double, double );
-	inline void SetColumn2 ( double, double, double );
-	inline void SetColumn3 ( double, double, double );
-	inline void SetColumn1 ( const VectorR3& );
-	inline void SetColumn2 ( const VectorR3& );
-	inline void SetColumn3 ( const VectorR3& );
-	inline VectorR3 Column1() const;
-	inline VectorR3 Column2() const;
-	inline VectorR3 Column3() const;
-
-	inline void SetRow1 ( double, double, double );
-	inline void SetRow2 ( double, double, double );
-	inline void SetRow3 ( double, double, double );
-	inline void SetRow1 ( const VectorR3& );
-	inline void SetRow2 ( const VectorR3& );
-	inline void SetRow3 ( const VectorR3& );
-	inline VectorR3 Row1() const;
-	inline VectorR3 Row2() const;
-	inline VectorR3 Row3() const;
-
-	inline void SetDiagonal( double, double, double );
-	inline void SetDiagonal( const VectorR3& );
-	inline double Diagonal( int ) const;
+	inline void SetColumn1 ( T, T, T );
+	inline void SetColumn2 ( T, T, T );
+	inline void SetColumn3 ( T, T, T );
+	inline void SetColumn1 ( const VectorR3T<T>& );
+	inline void SetColumn2 ( const VectorR3T<T>& );
+	inline void SetColumn3 ( const VectorR3T<T>& );
+	inline VectorR3T<T> Column1() const;
+	inline VectorR3T<T> Column2() const;
+	inline VectorR3T<T> Column3() const;
+
+	inline void SetRow1 ( T, T, T );
+	inline void SetRow2 ( T, T, T );
+	inline void SetRow3 ( T, T, T );
+	inline void SetRow1 ( const VectorR3T<T>& );
+	inline void SetRow2 ( const VectorR3T<T>& );
+	inline void SetRow3 ( const VectorR3T<T>& );
+	inline VectorR3T<T> Row1() const;
+	inline VectorR3T<T> Row2() const;
+	inline VectorR3T<T> Row3() const;
+
+	inline void SetDiagonal( T, T, T );
+	inline void SetDiagonal( const VectorR3T<T>& );
+	inline T Diagonal( int ) const;
 
 	// Set this so that  (this)v  =  u*v   where * is vector cross product
-	inline void SetCrossProductMatrix( const VectorR3& u );
+	inline void SetCrossProductMatrix( const VectorR3T<T>& u );
 
 	// Set this = u * v^T.
-	inline void SetOuterProduct( const VectorR3& u, const VectorR3& v );
+	inline void SetOuterProduct( const VectorR3T<T>& u, const VectorR3T<T>& v );
 
 	inline void MakeTranspose();					// Transposes it.
-	Matrix3x3& ReNormalize();
-	VectorR3 Solve(const VectorR3&) const;	// Returns solution
+	Matrix3x3T& ReNormalize();
+	VectorR3T<T> Solve(const VectorR3T<T>&) const;	// Returns solution
 
-	inline void Transform( VectorR3* ) const;
-	inline void Transform( const VectorR3& src, VectorR3* dest) const;
-	inline void TransformTranspose( VectorR3* ) const;
-	inline void TransformTranspose( const VectorR3& src, VectorR3* dest) const;
+	inline void Transform( VectorR3T<T>* ) const;
+	inline void Transform( const VectorR3T<T>& src, VectorR3T<T>* dest) const;
+	inline void TransformTranspose( VectorR3T<T>* ) const;
+	inline void TransformTranspose( const VectorR3T<T>& src, VectorR3T<T>* dest) const;
+	// Transform count vectors stored as separate x, y and z arrays (structure of arrays).
+	//   The output arrays may be the input arrays.
+	void Transform( const T* x, const T* y, const T* z, T* outX, T* outY, T* outZ, long count ) const;
 
-	double Trace() const { return m11+m22+m33; }
-	double SumSquaresNorm() const;		// Returns sum of squares of entries
+	T Trace() const { return m11+m22+m33; }
+	T SumSquaresNorm() const;		// Returns sum of squares of entries
 
 protected:
-	void OperatorTimesEquals( const Matrix3x3& ); // Internal use only
-	void RightMultiplyByTranspose( const Matrix3x3& );	  // Internal use only. Set this = this * M^T
-	void LeftMultiplyBy( const Matrix3x3& );	  // Internal use only. Set this = M * this
-	void LeftMultiplyByTranspose( const Matrix3x3& );	  // Internal use only.  Set this = M^T * this
+	void OperatorTimesEquals( const Matrix3x3T& ); // Internal use only
+	void RightMultiplyByTranspose( const Matrix3x3T& );	  // Internal use only. Set this = this * M^T
+	void LeftMultiplyBy( const Matrix3x3T& );	  // Internal use only. Set this = M * this
+	void LeftMultiplyByTranspose( const Matrix3x3T& );	  // Internal use only.  Set this = M^T * this
 	void SetZero ();							  // Set to the zero map
 
 };
 
-inline VectorR3 operator* ( const Matrix3x3&, const VectorR3& );
+template<class T> constexpr VectorR3T<T> operator* ( const Matrix3x3T<T>&, const VectorR3T<T>& );
 
-ostream& operator<< ( ostream& os, const Matrix3x3& A );
+template<class T> ostream& operator<< ( ostream& os, const Matrix3x3T<T>& A );
 
 
 // *****************************************
@@ -387,57 +404,61 @@ ostream& operator<< ( ostream& os, const Matrix3x4& A );
 // LinearMapR3 class                       *
 // * * * * * * * * * * * * * * * * * * * * *
 
-class LinearMapR3 : public Matrix3x3 {
+template<class T>
+class LinearMapR3T : public Matrix3x3T<T> {
 
 public:
+	using Matrix3x3T<T>::m11; using Matrix3x3T<T>::m12; using Matrix3x3T<T>::m13;
+	using Matrix3x3T<T>::m21; using Matrix3x3T<T>::m22; using Matrix3x3T<T>::m23;
+	using Matrix3x3T<T>::m31; using Matrix3x3T<T>::m32; using Matrix3x3T<T>::m33;
 
-	LinearMapR3();
-	LinearMapR3( const VectorR3&, const VectorR3&, const VectorR3& );
-	LinearMapR3( double, double, double, double, double, double,
-					 double, double, double );		// Sets by columns
-	LinearMapR3 ( const Matrix3x3& );
+	constexpr LinearMapR3T();
+	constexpr LinearMapR3T( const VectorR3T<T>&, const VectorR3T<T>&, const VectorR3T<T>& );
+	constexpr LinearMapR3T( T, T, T, T, T, T,
+					 T, T, T );		// Sets by columns
+	constexpr LinearMapR3T ( const Matrix3x3T<T>& );
 
 	void SetZero ();			// Set to the zero map
 	inline void Negate();
 
-	inline LinearMapR3& operator+= (const Matrix3x3& );
-	inline LinearMapR3& operator-= (const Matrix3x3& );
-	inline LinearMapR3& operator*= (double);
-	inline LinearMapR3& operator/= (double);
-	inline void SubtractFrom( const Matrix3x3& m);	// Sets this = (m - this).
-	LinearMapR3& operator*= (const Matrix3x3& );	// Matrix product
-	void RightMultiplyByTranspose( const Matrix3x3& M ) { Matrix3x3::RightMultiplyByTranspose(M); }
-	void LeftMultiplyBy( const Matrix3x3& M ) { Matrix3x3::LeftMultiplyBy(M); }
-	void LeftMultiplyByTranspose( const Matrix3x3& M ) { Matrix3x3::LeftMultiplyByTranspose(M); }
-
-	inline LinearMapR3 Transpose() const;	// Returns the transpose
-	double Determinant () const;			// Returns the determinant
-	LinearMapR3 Inverse() const;			// Returns inverse
-	LinearMapR3& Invert();					// Converts into inverse.
-	VectorR3 Solve(const VectorR3&) const;	// Returns solution
-	LinearMapR3 InverseSym() const;			// Get inverse of symmetric matrix
-	LinearMapR3 InversePosDef() const;		// Get inverse of symmetric positive definite matrix
-	void InverseSym( LinearMapR3* inverse ) const;	// Get inverse of symmetric matrix
-	void InversePosDef( LinearMapR3* inverse ) const;	// Get inverse of symmetric positive-definite matrix
-	LinearMapR3& InvertSym();		// Converts to inverse of symmetric matrix
-	LinearMapR3& InvertPosDef();		// Converts to inverse of symmetric positive-definite matrix
-	LinearMapR3& InvertPosDefSafe();		// Converts to inverse of symmetric positive-definite matrix
-	LinearMapR3 PseudoInverse() const;	// Returns pseudo-inverse TO DO
-	VectorR3 PseudoSolve(const VectorR3&);	// Finds least squares solution TO DO
+	inline LinearMapR3T& operator+= (const Matrix3x3T<T>& );
+	inline LinearMapR3T& operator-= (const Matrix3x3T<T>& );
+	inline LinearMapR3T& operator*= (T);
+	inline LinearMapR3T& operator/= (T);
+	inline void SubtractFrom( const Matrix3x3T<T>& m);	// Sets this = (m - this).
+	LinearMapR3T& operator*= (const Matrix3x3T<T>& );	// Matrix product
+	void RightMultiplyByTranspose( const Matrix3x3T<T>& M ) { Matrix3x3T<T>::RightMultiplyByTranspose(M); }
+	void LeftMultiplyBy( const Matrix3x3T<T>& M ) { Matrix3x3T<T>::LeftMultiplyBy(M); }
+	void LeftMultiplyByTranspose( const Matrix3x3T<T>& M ) { Matrix3x3T<T>::LeftMultiplyByTranspose(M); }
+
+	constexpr LinearMapR3T Transpose() const;	// Returns the transpose
+	constexpr T Determinant () const;			// Returns the determinant
+	constexpr LinearMapR3T Inverse() const;			// Returns inverse
+	LinearMapR3T& Invert();					// Converts into inverse.
+	VectorR3T<T> Solve(const VectorR3T<T>&) const;	// Returns solution
+	LinearMapR3T InverseSym() const;			// Get inverse of symmetric matrix
+	LinearMapR3T InversePosDef() const;		// Get inverse of symmetric positive definite matrix
+	void InverseSym( LinearMapR3T* inverse ) const;	// Get inverse of symmetric matrix
+	void InversePosDef( LinearMapR3T* inverse ) const;	// Get inverse of symmetric positive-definite matrix
+	LinearMapR3T& InvertSym();		// Converts to inverse of symmetric matrix
+	LinearMapR3T& InvertPosDef();		// Converts to inverse of symmetric positive-definite matrix
+	LinearMapR3T& InvertPosDefSafe();		// Converts to inverse of symmetric positive-definite matrix
+	LinearMapR3T PseudoInverse() const;	// Returns pseudo-inverse TO DO
+	VectorR3T<T> PseudoSolve(const VectorR3T<T>&);	// Finds least squares solution TO DO
 
 };
 	
-inline LinearMapR3 operator+ (const LinearMapR3&, const LinearMapR3&);
-inline LinearMapR3 operator+ (const LinearMapR3&, const Matrix3x3&);
-inline LinearMapR3 operator+ (const Matrix3x3&, const LinearMapR3&);
-inline LinearMapR3 operator- (const LinearMapR3&);
-inline LinearMapR3 operator- (const LinearMapR3&, const LinearMapR3&);
-inline LinearMapR3 operator- (const LinearMapR3&, const Matrix3x3&);
-inline LinearMapR3 operator- (const Matrix3x3&, const LinearMapR3&);
-inline LinearMapR3 operator* ( const LinearMapR3&, double);
-inline LinearMapR3 operator* ( double, const LinearMapR3& );
-inline LinearMapR3 operator/ ( const LinearMapR3&, double );
-LinearMapR3 operator* ( const LinearMapR3&, const LinearMapR3& ); 
+template<class T> constexpr LinearMapR3T<T> operator+ (const LinearMapR3T<T>&, const LinearMapR3T<T>&);
+template<class T> constexpr LinearMapR3T<T> operator+ (const LinearMapR3T<T>&, const Matrix3x3T<T>&);
+template<class T> constexpr LinearMapR3T<T> operator+ (const Matrix3x3T<T>&, const LinearMapR3T<T>&);
+template<class T> constexpr LinearMapR3T<T> operator- (const LinearMapR3T<T>&);
+template<class T> constexpr LinearMapR3T<T> operator- (const LinearMapR3T<T>&, const LinearMapR3T<T>&);
+template<class T> constexpr LinearMapR3T<T> operator- (const LinearMapR3T<T>&, const Matrix3x3T<T>&);
+template<class T> constexpr LinearMapR3T<T> operator- (const Matrix3x3T<T>&, const LinearMapR3T<T>&);
+template<class T> constexpr LinearMapR3T<T> operator* ( const LinearMapR3T<T>&, typename LinearScalar<T>::Type);
+template<class T> constexpr LinearMapR3T<T> operator* ( typename LinearScalar<T>::Type, const LinearMapR3T<T>& );
+template<class T> constexpr LinearMapR3T<T> operator/ ( const LinearMapR3T<T>&, typename LinearScalar<T>::Type );
+template<class T> constexpr LinearMapR3T<T> operator* ( const LinearMapR3T<T>&, const LinearMapR3T<T>& ); 
 								// Matrix product (composition)
 
 
@@ -566,7 +587,7 @@ public:
 	RigidMapR3& SetTranslationPart( const VectorR3& );		// Set the translation part
 	RigidMapR3& SetTranslationPart( double, double, double );	// Set the translation part
 	RigidMapR3& SetRotationPart( const Matrix3x3& );		// Set the rotation part
-	RigidMapR3& SetRotationPart( const Quaternion& );		// Still needs to be written (See RotationMapR3.Set.)
+	RigidMapR3& SetRotationPart( const Quaternion& );		// Defined in Quaternion.cpp
 	RigidMapR3& SetRotationPart( const VectorR3&, double theta ); // Set rotation axis and angle
 	RigidMapR3& SetRotationPart( const VectorR3&, double sintheta, double costheta ); 
 
@@ -605,7 +626,11 @@ public:
 // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
 // Returns the solid angle between vectors v and w.
-inline double SolidAngle( const VectorR3& v, const VectorR3& w);
+template<class T> inline T SolidAngle( const VectorR3T<T>& v, const VectorR3T<T>& w);
+
+// Transforms vector i by A[i], for count vectors stored as x, y and z arrays.
+template<class T> void Transform( const Matrix3x3T<T>* A, const T* x, const T* y, const T* z,
+								  T* outX, T* outY, T* outZ, long count );
 
 // Returns a righthanded orthonormal basis to complement unit vector x
 void GetOrtho( const VectorR3& x,  VectorR3& y, VectorR3& z);
@@ -622,9 +647,9 @@ void GetOrtho( const VectorR3& x,  VectorR3& y );
 
 // Projection maps (LinearMapR3s)
 
-inline LinearMapR3 VectorProjectMap( const VectorR3& u );
-inline LinearMapR3 PlaneProjectMap ( const VectorR3& w );
-inline LinearMapR3 PlaneProjectMap ( const VectorR3& u, const VectorR3 &v );
+template<class T> inline LinearMapR3T<T> VectorProjectMap( const VectorR3T<T>& u );
+template<class T> inline LinearMapR3T<T> PlaneProjectMap ( const VectorR3T<T>& w );
+template<class T> inline LinearMapR3T<T> PlaneProjectMap ( const VectorR3T<T>& u, const VectorR3T<T> &v );
 // u,v,w - must be unit vector.  u and v must be orthonormal and
 // specify the plane they are parallel to.  w specifies the plane
 // it is orthogonal to.
@@ -641,14 +666,17 @@ RotationMapR3 RotateToMap( const VectorR3& fromVec, const VectorR3& toVec);
 // * Stream Output Routines	(Prototypes)						 *
 // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
-ostream& operator<< ( ostream& os, const VectorR3& u );
+template<class T> ostream& operator<< ( ostream& os, const VectorR3T<T>& u );
 
 
 // *****************************************************
 // * VectorR3 class - inlined functions				   *
 // * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
-inline VectorR3& VectorR3::Load( const double* v ) 
+template<class T> const VectorR3T<T> VectorR3T<T>::Zero(0.0, 0.0, 0.0);
+
+template<class T>
+inline VectorR3T<T>& VectorR3T<T>::Load( const double* v ) 
 {
 	x = *v; 
 	y = *(v+1);
@@ -656,7 +684,8 @@ inline VectorR3& VectorR3::Load( const double* v )
 	return *this;
 }
 
-inline VectorR3& VectorR3::Load( const float* v ) 
+template<class T>
+inline VectorR3T<T>& VectorR3T<T>::Load( const float* v ) 
 {
 	x = *v; 
 	y = *(v+1);
@@ -664,21 +693,24 @@ inline VectorR3& VectorR3::Load( const float* v )
 	return *this;
 }
 
-inline 	void VectorR3::Dump( double* v ) const
+template<class T>
+inline 	void VectorR3T<T>::Dump( double* v ) const
 {
 	*v = x; 
 	*(v+1) = y;
 	*(v+2) = z;
 }
 
-inline 	void VectorR3::Dump( float* v ) const
+template<class T>
+inline 	void VectorR3T<T>::Dump( float* v ) const
 {
 	*v = (float)x; 
 	*(v+1) = (float)y;
 	*(v+2) = (float)z;
 }
 
-inline double VectorR3::operator[]( int i ) const
+template<class T>
+inline T VectorR3T<T>::operator[]( int i ) const
 {
 	switch (i) {
 	case 0:
@@ -693,57 +725,67 @@ inline double VectorR3::operator[]( int i ) const
 	}
 }
 
-inline VectorR3& VectorR3::MakeUnit ()			// Convert to unit vector (or leave zero).
+template<class T>
+inline VectorR3T<T>& VectorR3T<T>::MakeUnit ()			// Convert to unit vector (or leave zero).
 {
-	double nSq = NormSq();
+	T nSq = NormSq();
 	if (nSq != 0.0) {
 		*this /= sqrt(nSq);
 	}
 	return *this;
 }
 
-inline VectorR3 operator+( const VectorR3& u, const VectorR3& v ) 
+template<class T>
+constexpr VectorR3T<T> operator+( const VectorR3T<T>& u, const VectorR3T<T>& v ) 
 { 
-	return VectorR3(u.x+v.x, u.y+v.y, u.z+v.z); 
+	return VectorR3T<T>(u.x+v.x, u.y+v.y, u.z+v.z); 
 }
-inline VectorR3 operator-( const VectorR3& u, const VectorR3& v ) 
+template<class T>
+constexpr VectorR3T<T> operator-( const VectorR3T<T>& u, const VectorR3T<T>& v ) 
 { 
-	return VectorR3(u.x-v.x, u.y-v.y, u.z-v.z); 
+	return VectorR3T<T>(u.x-v.x, u.y-v.y, u.z-v.z); 
 }
-inline VectorR3 operator*( const VectorR3& u, register double m) 
+template<class T>
+constexpr VectorR3T<T> operator*( const VectorR3T<T>& u, typename LinearScalar<T>::Type m) 
 { 
-	return VectorR3( u.x*m, u.y*m, u.z*m); 
+	return VectorR3T<T>( u.x*m, u.y*m, u.z*m); 
 }
-inline VectorR3 operator*( register double m, const VectorR3& u) 
+template<class T>
+constexpr VectorR3T<T> operator*( typename LinearScalar<T>::Type m, const VectorR3T<T>& u) 
 { 
-	return VectorR3( u.x*m, u.y*m, u.z*m); 
+	return VectorR3T<T>( u.x*m, u.y*m, u.z*m); 
 }
-inline VectorR3 operator/( const VectorR3& u, double m) 
+template<class T>
+constexpr VectorR3T<T> operator/( const VectorR3T<T>& u, typename LinearScalar<T>::Type m) 
 { 
-	register double mInv = 1.0/m;
-	return VectorR3( u.x*mInv, u.y*mInv, u.z*mInv); 
+	T mInv = 1.0/m;
+	return VectorR3T<T>( u.x*mInv, u.y*mInv, u.z*mInv); 
 }
 
-inline double operator^ ( const VectorR3& u, const VectorR3& v ) // Dot Product
+template<class T>
+constexpr T operator^ ( const VectorR3T<T>& u, const VectorR3T<T>& v ) // Dot Product
 { 
 	return ( u.x*v.x + u.y*v.y + u.z*v.z ); 
 }
 
-inline VectorR3 operator* (const VectorR3& u, const VectorR3& v)	// Cross Product
+template<class T>
+constexpr VectorR3T<T> operator* (const VectorR3T<T>& u, const VectorR3T<T>& v)	// Cross Product
 {
-	return (VectorR3(	u.y*v.z - u.z*v.y,
+	return (VectorR3T<T>(	u.y*v.z - u.z*v.y,
 					u.z*v.x - u.x*v.z,
 					u.x*v.y - u.y*v.x  ) );
 }
 
-inline VectorR3 ArrayProd ( const VectorR3& u, const VectorR3& v )
+template<class T>
+constexpr VectorR3T<T> ArrayProd ( const VectorR3T<T>& u, const VectorR3T<T>& v )
 {
-	return ( VectorR3( u.x*v.x, u.y*v.y, u.z*v.z ) );
+	return ( VectorR3T<T>( u.x*v.x, u.y*v.y, u.z*v.z ) );
 }
 
-inline VectorR3& VectorR3::operator*= (const VectorR3& v)		// Cross Product
+template<class T>
+inline VectorR3T<T>& VectorR3T<T>::operator*= (const VectorR3T<T>& v)		// Cross Product
 {
-	double tx=x, ty=y;
+	T tx=x, ty=y;
 	x =  y*v.z -  z*v.y;
 	y =  z*v.x - tx*v.z;
 	z = tx*v.y - ty*v.x;
@@ -752,9 +794,10 @@ inline VectorR3& VectorR3::operator*= (const VectorR3& v)		// Cross Product
 
 // Cross Product on left
 //  Set   this := v*this;
-inline VectorR3& VectorR3::CrossProductLeft (const VectorR3& v)
+template<class T>
+inline VectorR3T<T>& VectorR3T<T>::CrossProductLeft (const VectorR3T<T>& v)
 {
-	double tx=x, ty=y;
+	T tx=x, ty=y;
 	x =  z*v.y - y*v.z;
 	y = tx*v.z - z*v.x;
 	z = ty*v.x - tx*v.y;
@@ -762,7 +805,8 @@ inline VectorR3& VectorR3::CrossProductLeft (const VectorR3& v)
 }
 
 // (*this) += u*v;    
-inline VectorR3& VectorR3::AddCrossProduct( const VectorR3& u, const VectorR3& v )
+template<class T>
+inline VectorR3T<T>& VectorR3T<T>::AddCrossProduct( const VectorR3T<T>& u, const VectorR3T<T>& v )
 {
 	x += u.y*v.z - u.z*v.y;
 	y += u.z*v.x - u.x*v.z;
@@ -770,7 +814,8 @@ inline VectorR3& VectorR3::AddCrossProduct( const VectorR3& u, const VectorR3& v
 	return *this;
 }
 
-inline VectorR3& VectorR3::ArrayProd (const VectorR3& v)		// Component-wise Product
+template<class T>
+inline VectorR3T<T>& VectorR3T<T>::ArrayProd (const VectorR3T<T>& v)		// Component-wise Product
 {
 	x *= v.x;
 	y *= v.y;
@@ -778,7 +823,8 @@ inline VectorR3& VectorR3::ArrayProd (const VectorR3& v)		// Component-wise Prod
 	return ( *this );
 }
 
-inline VectorR3& VectorR3::AddScaled( const VectorR3& u, double s ) 
+template<class T>
+inline VectorR3T<T>& VectorR3T<T>::AddScaled( const VectorR3T<T>& u, T s ) 
 {
 	x += s*u.x;
 	y += s*u.y;
@@ -786,7 +832,8 @@ inline VectorR3& VectorR3::AddScaled( const VectorR3& u, double s )
 	return(*this);
 }
 
-inline VectorR3& VectorR3::SubtractFrom( const VectorR3& u  ) 
+template<class T>
+inline VectorR3T<T>& VectorR3T<T>::SubtractFrom( const VectorR3T<T>& u  ) 
 {
 	x = u.x - x;;
 	y = u.y - y;;
@@ -794,23 +841,26 @@ inline VectorR3& VectorR3::SubtractFrom( const VectorR3& u  )
 	return(*this);
 }
 
-inline VectorR3::VectorR3( const VectorHgR3& uH ) 
+template<class T>
+inline VectorR3T<T>::VectorR3T( const VectorHgR3& uH ) 
 : x(uH.x), y(uH.y), z(uH.z)
 { 
 	*this /= uH.w; 
 }
 
-inline VectorR3& VectorR3::ReNormalize()			// Convert near unit back to unit
+template<class T>
+inline VectorR3T<T>& VectorR3T<T>::ReNormalize()			// Convert near unit back to unit
 {
-	double nSq = NormSq();
-	register double mFact = 1.0-0.5*(nSq-1.0);	// Multiplicative factor
+	T nSq = NormSq();
+	T mFact = 1.0-0.5*(nSq-1.0);	// Multiplicative factor
 	*this *= mFact;
 	return *this;
 }
 
-inline double NormalizeError (const VectorR3& u)
+template<class T>
+inline T NormalizeError (const VectorR3T<T>& u)
 {
-	register double discrepancy;
+	T discrepancy;
 	discrepancy = u.x*u.x + u.y*u.y + u.z*u.z - 1.0;
 	if ( discrepancy < 0.0 ) {
 		discrepancy = -discrepancy;
@@ -818,12 +868,14 @@ inline double NormalizeError (const VectorR3& u)
 	return discrepancy;
 }
 
-inline double VectorR3::Dist( const VectorR3& u ) const 	// Distance from u
+template<class T>
+inline T VectorR3T<T>::Dist( const VectorR3T<T>& u ) const 	// Distance from u
 {
 	return sqrt( DistSq(u) );
 }
 
-inline double VectorR3::DistSq( const VectorR3& u ) const	// Distance from u
+template<class T>
+inline T VectorR3T<T>::DistSq( const VectorR3T<T>& u ) const	// Distance from u
 {
 	return ( (x-u.x)*(x-u.x) + (y-u.y)*(y-u.y) + (z-u.z)*(z-u.z) );
 }
@@ -834,62 +886,115 @@ inline double VectorR3::DistSq( const VectorR3& u ) const	// Distance from u
 
 // Interpolate(start,end,frac) - linear interpolation
 //		- allows overshooting the end points
-inline VectorR3 Interpolate( const VectorR3& start, const VectorR3& end, double a)
+template<class T>
+inline VectorR3T<T> Interpolate( const VectorR3T<T>& start, const VectorR3T<T>& end, double a)
 {
-	VectorR3 ret;
+	VectorR3T<T> ret;
 	Lerp( start, end, a, ret );
 	return ret;
 }
 
+template<class T>
+T VectorR3T<T>::MaxAbs() const
+{
+	T m;
+	m = (x>0.0) ? x : -x;
+	if ( y>m ) m=y;
+	else if ( -y >m ) m = -y;
+	if ( z>m ) m=z;
+	else if ( -z>m ) m = -z;
+	return m;
+}
+
+
+// *********************************************************************
+// Rotation routines												   *
+// *********************************************************************
+
+// s.Rotate(theta, u) rotates s and returns s 
+//        rotated theta degrees around unit vector w.
+template<class T>
+VectorR3T<T>& VectorR3T<T>::Rotate( T theta, const VectorR3T<T>& w) 
+{
+	T c = cos(theta);
+	T s = sin(theta);
+	T dotw = (x*w.x + y*w.y + z*w.z);
+	T v0x = dotw*w.x;
+	T v0y = dotw*w.y;		// v0 = provjection onto w
+	T v0z = dotw*w.z;
+	T v1x = x-v0x;
+	T v1y = y-v0y;			// v1 = projection onto plane normal to w
+	T v1z = z-v0z;
+	T v2x = w.y*v1z - w.z*v1y;
+	T v2y = w.z*v1x - w.x*v1z;	// v2 = w * v1 (cross product)
+	T v2z = w.x*v1y - w.y*v1x;
+	
+	x = v0x + c*v1x + s*v2x;
+	y = v0y + c*v1y + s*v2y;
+	z = v0z	+ c*v1z + s*v2z;
+
+	return ( *this );
+}
+
+// Rotate unit vector x in the direction of "dir": length of dir is rotation angle.
+//		x must be a unit vector.  dir must be perpindicular to x.
+template<class T>
+VectorR3T<T>& VectorR3T<T>::RotateUnitInDirection ( const VectorR3T<T>& dir)
+{	
+	T theta = dir.NormSq();
+	if ( theta==0.0 ) {
+		return *this;
+	}
+	else {
+		theta = sqrt(theta);
+		T costheta = cos(theta);
+		T sintheta = sin(theta);
+		VectorR3T<T> dirUnit = dir/theta;
+		*this = costheta*(*this) + sintheta*dirUnit;
+		return ( *this );
+	}
+}
+
 
 // ******************************************************
 // * Matrix3x3  class - inlined functions				*
 // * * * * * * * * * * * * * * * * * * * * * * * * * * **
 
-inline Matrix3x3::Matrix3x3() {}
+template<class T> inline Matrix3x3T<T>::Matrix3x3T() {}
 
-inline Matrix3x3::Matrix3x3( const VectorR3& u, const VectorR3& v, 
-							 const VectorR3& s )
-{
-	m11 = u.x;		// Column 1
-	m21 = u.y;
-	m31 = u.z;
-	m12 = v.x;		// Column 2
-	m22 = v.y;
-	m32 = v.z;
-	m13 = s.x;		// Column 3
-	m23 = s.y;
-	m33 = s.z;
-}
+template<class T>
+constexpr Matrix3x3T<T>::Matrix3x3T( const VectorR3T<T>& u, const VectorR3T<T>& v, 
+							 const VectorR3T<T>& s )
+: m11(u.x), m21(u.y), m31(u.z),		// Column 1
+  m12(v.x), m22(v.y), m32(v.z),		// Column 2
+  m13(s.x), m23(s.y), m33(s.z)		// Column 3
+{ }
 
-inline Matrix3x3::Matrix3x3( double a11, double a21, double a31,
-							 double a12, double a22, double a32,
-							 double a13, double a23, double a33)
+template<class T>
+constexpr Matrix3x3T<T>::Matrix3x3T( T a11, T a21, T a31,
+							 T a12, T a22, T a32,
+							 T a13, T a23, T a33)
 					// Values specified in column order!!!
-{
-	m11 = a11;		// Row 1
-	m12 = a12;
-	m13 = a13;
-	m21 = a21;		// Row 2
-	m22 = a22;
-	m23 = a23;
-	m31 = a31;		// Row 3
-	m32 = a32;
-	m33 = a33;
-}
+: m11(a11), m21(a21), m31(a31),
+  m12(a12), m22(a22), m32(a32),
+  m13(a13), m23(a23), m33(a33)
+{ }
 	
-inline void Matrix3x3::SetIdentity ( )
+template<class T>
+inline void Matrix3x3T<T>::SetIdentity ( )
 {
 	m11 = m22 = m33 = 1.0;
 	m12 = m13 = m21 = m23 = m31 = m32 = 0.0;
 }
 
-inline void Matrix3x3::SetZero( ) 
+template<class T>
+inline void Matrix3x3T<T>::SetZero( ) 
 {
 	m11 = m12 = m13 = m21 = m22 = m23 = m31 = m32 = m33 = 0.0;
 }
 
-inline void Matrix3x3::Set ( const Matrix3x3& A )	// Set to the matrix.
+template<class T>
+inline void Matrix3x3T<T>::Set ( const Matrix3x3T<T>& A )	// Set to the matrix.
 {
 	m11 = A.m11;
 	m21 = A.m21;
@@ -902,7 +1007,8 @@ inline void Matrix3x3::Set ( const Matrix3x3& A )	// Set to the matrix.
 	m33 = A.m33;
 }
 
-inline void Matrix3x3::Set3x3 ( const Matrix3x4& A )	// Set to the 3x3 part of the matrix.
+template<class T>
+inline void Matrix3x3T<T>::Set3x3 ( const Matrix3x4& A )	// Set to the 3x3 part of the matrix.
 {
 	m11 = A.m11;
 	m21 = A.m21;
@@ -915,8 +1021,9 @@ inline void Matrix3x3::Set3x3 ( const Matrix3x4& A )	// Set to the 3x3 part of t
 	m33 = A.m33;
 }
 
-inline void Matrix3x3::Set( const VectorR3& u, const VectorR3& v, 
-							 const VectorR3& w)
+template<class T>
+inline void Matrix3x3T<T>::Set( const VectorR3T<T>& u, const VectorR3T<T>& v, 
+							 const VectorR3T<T>& w)
 {
 	m11 = u.x;		// Column 1
 	m21 = u.y;
@@ -929,9 +1036,10 @@ inline void Matrix3x3::Set( const VectorR3& u, const VectorR3& v,
 	m33 = w.z;
 }
 
-inline void Matrix3x3::Set( double a11, double a21, double a31, 
-							 double a12, double a22, double a32,
-							 double a13, double a23, double a33)
+template<class T>
+inline void Matrix3x3T<T>::Set( T a11, T a21, T a31, 
+							 T a12, T a22, T a32,
+							 T a13, T a23, T a33)
 					// Values specified in column order!!!
 {
 	m11 = a11;		// Row 1
@@ -945,9 +1053,10 @@ inline void Matrix3x3::Set( double a11, double a21, double a31,
 	m33 = a33;
 }
 
-inline void Matrix3x3::SetByRows( double a11, double a12, double a13, 
-							 double a21, double a22, double a23,
-							 double a31, double a32, double a33)
+template<class T>
+inline void Matrix3x3T<T>::SetByRows( T a11, T a12, T a13, 
+							 T a21, T a22, T a23,
+							 T a31, T a32, T a33)
 					// Values specified in row order!!!
 {
 	m11 = a11;		// Row 1
@@ -961,7 +1070,8 @@ inline void Matrix3x3::SetByRows( double a11, double a12, double a13,
 	m33 = a33;
 }
 
-inline void Matrix3x3::LoadByRows( const double* a)
+template<class T>
+inline void Matrix3x3T<T>::LoadByRows( const double* a)
 {
 	// Values in ROW order
 	m11 = *(a++);		// Row 1
@@ -976,8 +1086,9 @@ inline void Matrix3x3::LoadByRows( const double* a)
 }
 
 
-inline void Matrix3x3::SetByRows( const VectorR3& u, const VectorR3& v, 
-									const VectorR3& s )
+template<class T>
+inline void Matrix3x3T<T>::SetByRows( const VectorR3T<T>& u, const VectorR3T<T>& v, 
+									const VectorR3T<T>& s )
 {
 	m11 = u.x;		// Row 1
 	m12 = u.y;
@@ -990,51 +1101,60 @@ inline void Matrix3x3::SetByRows( const VectorR3& u, const VectorR3& v,
 	m33 = s.z;
 }
 
-inline void Matrix3x3::SetColumn1 ( double x, double y, double z)
+template<class T>
+inline void Matrix3x3T<T>::SetColumn1 ( T x, T y, T z)
 {
 	m11 = x; m21 = y; m31= z;
 }
 
-inline void Matrix3x3::SetColumn2 ( double x, double y, double z)
+template<class T>
+inline void Matrix3x3T<T>::SetColumn2 ( T x, T y, T z)
 {
 	m12 = x; m22 = y; m32= z;
 }
 
-inline void Matrix3x3::SetColumn3 ( double x, double y, double z)
+template<class T>
+inline void Matrix3x3T<T>::SetColumn3 ( T x, T y, T z)
 {
 	m13 = x; m23 = y; m33= z;
 }
 
-inline void Matrix3x3::SetColumn1 ( const VectorR3& u )
+template<class T>
+inline void Matrix3x3T<T>::SetColumn1 ( const VectorR3T<T>& u )
 {
 	m11 = u.x; m21 = u.y; m31 = u.z;
 }
 
-inline void Matrix3x3::SetColumn2 ( const VectorR3& u )
+template<class T>
+inline void Matrix3x3T<T>::SetColumn2 ( const VectorR3T<T>& u )
 {
 	m12 = u.x; m22 = u.y; m32 = u.z;
 }
 
-inline void Matrix3x3::SetColumn3 ( const VectorR3& u )
+template<class T>
+inline void Matrix3x3T<T>::SetColumn3 ( const VectorR3T<T>& u )
 {
 	m13 = u.x; m23 = u.y; m33 = u.z;
 }
 
-inline void Matrix3x3::SetRow1 ( double x, double y, double z )
+template<class T>
+inline void Matrix3x3T<T>::SetRow1 ( T x, T y, T z )
 {
 	m11 = x;
 	m12 = y;
 	m13 = z;
 }
 
-inline void Matrix3x3::SetRow2 ( double x, double y, double z )
+template<class T>
+inline void Matrix3x3T<T>::SetRow2 ( T x, T y, T z )
 {
 	m21 = x;
 	m22 = y;
 	m23 = z;
 }
 
-inline void Matrix3x3::SetRow3 ( double x, double y, double z )
+template<class T>
+inline void Matrix3x3T<T>::SetRow3 ( T x, T y, T z )
 {
 	m31 = x;
 	m32 = y;
@@ -1043,49 +1163,58 @@ inline void Matrix3x3::SetRow3 ( double x, double y, double z )
 
 
 
-inline VectorR3 Matrix3x3::Column1() const
+template<class T>
+inline VectorR3T<T> Matrix3x3T<T>::Column1() const
 {
-	return ( VectorR3(m11, m21, m31) );
+	return ( VectorR3T<T>(m11, m21, m31) );
 }
 
-inline VectorR3 Matrix3x3::Column2() const
+template<class T>
+inline VectorR3T<T> Matrix3x3T<T>::Column2() const
 {
-	return ( VectorR3(m12, m22, m32) );
+	return ( VectorR3T<T>(m12, m22, m32) );
 }
 
-inline VectorR3 Matrix3x3::Column3() const
+template<class T>
+inline VectorR3T<T> Matrix3x3T<T>::Column3() const
 {
-	return ( VectorR3(m13, m23, m33) );
+	return ( VectorR3T<T>(m13, m23, m33) );
 }
 
-inline VectorR3 Matrix3x3::Row1() const
+template<class T>
+inline VectorR3T<T> Matrix3x3T<T>::Row1() const
 {
-	return ( VectorR3(m11, m12, m13) );
+	return ( VectorR3T<T>(m11, m12, m13) );
 }
 
-inline VectorR3 Matrix3x3::Row2() const
+template<class T>
+inline VectorR3T<T> Matrix3x3T<T>::Row2() const
 {
-	return ( VectorR3(m21, m22, m23) );
+	return ( VectorR3T<T>(m21, m22, m23) );
 }
 
-inline VectorR3 Matrix3x3::Row3() const
+template<class T>
+inline VectorR3T<T> Matrix3x3T<T>::Row3() const
 {
-	return ( VectorR3(m31, m32, m33) );
+	return ( VectorR3T<T>(m31, m32, m33) );
 }
 
-inline void Matrix3x3::SetDiagonal( double x, double y, double z )
+template<class T>
+inline void Matrix3x3T<T>::SetDiagonal( T x, T y, T z )
 {
 	m11 = x;
 	m22 = y;
 	m33 = z;
 }
 
-inline void Matrix3x3::SetDiagonal( const VectorR3& u )
+template<class T>
+inline void Matrix3x3T<T>::SetDiagonal( const VectorR3T<T>& u )
 {
 	SetDiagonal ( u.x, u.y, u.z );
 }
 
-inline double Matrix3x3::Diagonal( int i ) const 
+template<class T>
+inline T Matrix3x3T<T>::Diagonal( int i ) const 
 {
 	switch (i) {
 	case 0:
@@ -1101,7 +1230,8 @@ inline double Matrix3x3::Diagonal( int i ) const
 }
 
 // Set this so that  (this)v  =  u*v   where * is vector cross product
-inline void Matrix3x3::SetCrossProductMatrix( const VectorR3& u )
+template<class T>
+inline void Matrix3x3T<T>::SetCrossProductMatrix( const VectorR3T<T>& u )
 {
 	m11 = m22 = m33 = 0.0;
 	m21 = u.z;
@@ -1114,7 +1244,8 @@ inline void Matrix3x3::SetCrossProductMatrix( const VectorR3& u )
 
 
 // Set this = u * v^T
-inline void Matrix3x3::SetOuterProduct( const VectorR3& u, const VectorR3& v )
+template<class T>
+inline void Matrix3x3T<T>::SetOuterProduct( const VectorR3T<T>& u, const VectorR3T<T>& v )
 {
 	m11 = u.x*v.x;
 	m12 = u.x*v.y;
@@ -1127,9 +1258,10 @@ inline void Matrix3x3::SetOuterProduct( const VectorR3& u, const VectorR3& v )
 	m33 = u.z*v.z;
 }
 
-inline void Matrix3x3::MakeTranspose()	// Transposes it.
+template<class T>
+inline void Matrix3x3T<T>::MakeTranspose()	// Transposes it.
 {
-	register double temp;
+	T temp;
 	temp = m12;
 	m12 = m21;
 	m21=temp;
@@ -1141,9 +1273,10 @@ inline void Matrix3x3::MakeTranspose()	// Transposes it.
 	m32 = temp;
 }
 
-inline VectorR3 operator* ( const Matrix3x3& A, const VectorR3& u)
+template<class T>
+constexpr VectorR3T<T> operator* ( const Matrix3x3T<T>& A, const VectorR3T<T>& u)
 {
-	return( VectorR3( A.m11*u.x + A.m12*u.y + A.m13*u.z,
+	return( VectorR3T<T>( A.m11*u.x + A.m12*u.y + A.m13*u.z,
 					  A.m21*u.x + A.m22*u.y + A.m23*u.z,
 					  A.m31*u.x + A.m32*u.y + A.m33*u.z ) ); 
 }
@@ -1151,8 +1284,9 @@ inline VectorR3 operator* ( const Matrix3x3& A, const VectorR3& u)
 
 // See LinearR4.h for the code for the VectorR4 versions of the next two functions.
 
-inline void Matrix3x3::Transform( VectorR3* u ) const {
-	double newX, newY;
+template<class T>
+inline void Matrix3x3T<T>::Transform( VectorR3T<T>* u ) const {
+	T newX, newY;
 	newX = m11*u->x + m12*u->y + m13*u->z;
 	newY = m21*u->x + m22*u->y + m23*u->z;
 	u->z = m31*u->x + m32*u->y + m33*u->z;
@@ -1160,14 +1294,16 @@ inline void Matrix3x3::Transform( VectorR3* u ) const {
 	u->y = newY;
 }
 
-inline void Matrix3x3::Transform( const VectorR3& src, VectorR3* dest ) const {
+template<class T>
+inline void Matrix3x3T<T>::Transform( const VectorR3T<T>& src, VectorR3T<T>* dest ) const {
 	dest->x = m11*src.x + m12*src.y + m13*src.z;
 	dest->y = m21*src.x + m22*src.y + m23*src.z;
 	dest->z = m31*src.x + m32*src.y + m33*src.z;
 }
 
-inline void Matrix3x3::TransformTranspose( VectorR3* u ) const {
-	double newX, newY;
+template<class T>
+inline void Matrix3x3T<T>::TransformTranspose( VectorR3T<T>* u ) const {
+	T newX, newY;
 	newX = m11*u->x + m21*u->y + m31*u->z;
 	newY = m12*u->x + m22*u->y + m32*u->z;
 	u->z = m13*u->x + m23*u->y + m33*u->z;
@@ -1175,12 +1311,206 @@ inline void Matrix3x3::TransformTranspose( VectorR3* u ) const {
 	u->y = newY;
 }
 
-inline void Matrix3x3::TransformTranspose( const VectorR3& src, VectorR3* dest ) const {
+template<class T>
+inline void Matrix3x3T<T>::TransformTranspose( const VectorR3T<T>& src, VectorR3T<T>* dest ) const {
 	dest->x = m11*src.x + m21*src.y + m31*src.z;
 	dest->y = m12*src.x + m22*src.y + m32*src.z;
 	dest->z = m13*src.x + m23*src.y + m33*src.z;
 }
 
+// The entries are copied to locals, so the compiler can keep them in registers
+//   and vectorize the loop over the arrays.  GlGeomSphere and GlGeomCylinder
+//   use this to rotate the profile of each slice of their meshes.
+template<class T>
+void Matrix3x3T<T>::Transform( const T* x, const T* y, const T* z, T* outX, T* outY, T* outZ, long count ) const
+{
+	const T a11 = m11, a12 = m12, a13 = m13;
+	const T a21 = m21, a22 = m22, a23 = m23;
+	const T a31 = m31, a32 = m32, a33 = m33;
+	for ( long i=0; i<count; i++ ) {
+		T px = x[i], py = y[i], pz = z[i];
+		outX[i] = a11*px + a12*py + a13*pz;
+		outY[i] = a21*px + a22*py + a23*pz;
+		outZ[i] = a31*px + a32*py + a33*pz;
+	}
+}
+
+template<class T>
+Matrix3x3T<T>& Matrix3x3T<T>::ReNormalize()	// Re-normalizes nearly orthonormal matrix
+{
+	T alpha = m11*m11+m21*m21+m31*m31;	// First column's norm squared
+	T beta  = m12*m12+m22*m22+m32*m32;	// Second column's norm squared
+	T gamma = m13*m13+m23*m23+m33*m33;	// Third column's norm squared
+	alpha = 1.0 - 0.5*(alpha-1.0);				// Get mult. factor
+	beta  = 1.0 - 0.5*(beta-1.0);
+	gamma = 1.0 - 0.5*(gamma-1.0);
+	m11 *= alpha;								// Renormalize first column
+	m21 *= alpha;
+	m31 *= alpha;
+	m12 *= beta;								// Renormalize second column
+	m22 *= beta;
+	m32 *= beta;
+	m13 *= gamma;
+	m23 *= gamma;
+	m33 *= gamma;
+	alpha = m11*m12+m21*m22+m31*m32;		// First and second column dot product
+	beta  = m11*m13+m21*m23+m31*m33;		// First and third column dot product
+	gamma = m12*m13+m22*m23+m32*m33;		// Second and third column dot product
+	alpha *= 0.5;
+	beta *= 0.5;
+	gamma *= 0.5;
+	T temp1, temp2;
+	temp1 = m11-alpha*m12-beta*m13;			// Update row1
+	temp2 = m12-alpha*m11-gamma*m13;
+	m13 -= beta*m11+gamma*m12;
+	m11 = temp1;
+	m12 = temp2;
+	temp1 = m21-alpha*m22-beta*m23;			// Update row2
+	temp2 = m22-alpha*m21-gamma*m23;
+	m23 -= beta*m21+gamma*m22;
+	m21 = temp1;
+	m22 = temp2;
+	temp1 = m31-alpha*m32-beta*m33;			// Update row3
+	temp2 = m32-alpha*m31-gamma*m33;
+	m33 -= beta*m31+gamma*m32;
+	m31 = temp1;
+	m32 = temp2;
+	return *this;
+}
+
+template<class T>
+void Matrix3x3T<T>::OperatorTimesEquals(const Matrix3x3T<T>& B)	 // Matrix product
+{
+	T t1, t2;		// temporary values
+	t1 =  m11*B.m11 + m12*B.m21 + m13*B.m31;
+	t2 =  m11*B.m12 + m12*B.m22 + m13*B.m32;
+	m13 = m11*B.m13 + m12*B.m23 + m13*B.m33;
+	m11 = t1;
+	m12 = t2;
+
+	t1 =  m21*B.m11 + m22*B.m21 + m23*B.m31;
+	t2 =  m21*B.m12 + m22*B.m22 + m23*B.m32;
+	m23 = m21*B.m13 + m22*B.m23 + m23*B.m33;
+	m21 = t1;
+	m22 = t2;
+
+	t1 =  m31*B.m11 + m32*B.m21 + m33*B.m31;
+	t2 =  m31*B.m12 + m32*B.m22 + m33*B.m32;
+	m33 = m31*B.m13 + m32*B.m23 + m33*B.m33;
+	m31 = t1;
+	m32 = t2;
+	return;
+}
+
+// Set  this = this * B^T
+template<class T>
+void Matrix3x3T<T>::RightMultiplyByTranspose(const Matrix3x3T<T>& B)	 // Matrix product
+{
+	T t1, t2;		// temporary values
+	t1 =  m11*B.m11 + m12*B.m12 + m13*B.m13;	// New m11 value
+	t2 =  m11*B.m21 + m12*B.m22 + m13*B.m23;	// New m12 value
+	m13 = m11*B.m31 + m12*B.m32 + m13*B.m33;	// New m13 value
+	m11 = t1;
+	m12 = t2;
+
+	t1 =  m21*B.m11 + m22*B.m12 + m23*B.m13;	// New m21 value
+	t2 =  m21*B.m21 + m22*B.m22 + m23*B.m23;	// New m22 value
+	m23 = m21*B.m31 + m22*B.m32 + m23*B.m33;	// New m23 value
+	m21 = t1;
+	m22 = t2;
+
+	t1 =  m31*B.m11 + m32*B.m12 + m33*B.m13;	// New m31 value
+	t2 =  m31*B.m21 + m32*B.m22 + m33*B.m23;	// New m32 value
+	m33 = m31*B.m31 + m32*B.m32 + m33*B.m33;	// New m33 value
+	m31 = t1;
+	m32 = t2;
+	return;
+}
+
+// Set this = M * this
+template<class T>
+void Matrix3x3T<T>::LeftMultiplyBy (const Matrix3x3T<T>& M)	// Composition
+{	
+	T t1, t2;		// temporary values
+
+	t1 =  M.m11*m11 + M.m12*m21 + M.m13*m31;		// New m11
+	t2 =  M.m21*m11 + M.m22*m21 + M.m23*m31;		// New m21
+	m31 = M.m31*m11 + M.m32*m21 + M.m33*m31;		// New m31
+	m11 = t1;
+	m21 = t2;
+
+	t1 =  M.m11*m12 + M.m12*m22 + M.m13*m32;		// New m12
+	t2 =  M.m21*m12 + M.m22*m22 + M.m23*m32;		// New m22
+	m32 = M.m31*m12 + M.m32*m22 + M.m33*m32;		// New m32
+	m12 = t1;
+	m22 = t2;
+
+
+	t1  = M.m11*m13 + M.m12*m23 + M.m13*m33;		// New m13
+	t2  = M.m21*m13 + M.m22*m23 + M.m23*m33;		// New m23
+	m33 = M.m31*m13 + M.m32*m23 + M.m33*m33;		// New m33
+	m13 = t1;
+	m23 = t2;
+}
+
+// Set this = M^T * this
+template<class T>
+void Matrix3x3T<T>::LeftMultiplyByTranspose (const Matrix3x3T<T>& M)	// Composition
+{	
+	T t1, t2;		// temporary values
+
+	t1 =  M.m11*m11 + M.m21*m21 + M.m31*m31;		// New m11
+	t2 =  M.m12*m11 + M.m22*m21 + M.m32*m31;		// New m21
+	m31 = M.m13*m11 + M.m23*m21 + M.m33*m31;		// New m31
+	m11 = t1;
+	m21 = t2;
+
+	t1 =  M.m11*m12 + M.m21*m22 + M.m31*m32;		// New m12
+	t2 =  M.m12*m12 + M.m22*m22 + M.m32*m32;		// New m22
+	m32 = M.m13*m12 + M.m23*m22 + M.m33*m32;		// New m32
+	m12 = t1;
+	m22 = t2;
+
+
+	t1  = M.m11*m13 + M.m21*m23 + M.m31*m33;		// New m13
+	t2  = M.m12*m13 + M.m22*m23 + M.m32*m33;		// New m23
+	m33 = M.m13*m13 + M.m23*m23 + M.m33*m33;		// New m33
+	m13 = t1;
+	m23 = t2;
+}
+
+template<class T>
+VectorR3T<T> Matrix3x3T<T>::Solve(const VectorR3T<T>& u) const	// Returns solution
+{												// based on Cramer's rule
+	T sd11 = m22*m33-m23*m32;
+	T sd21 = m32*m13-m12*m33;
+	T sd31 = m12*m23-m22*m13;
+	T sd12 = m31*m23-m21*m33;
+	T sd22 = m11*m33-m31*m13;
+	T sd32 = m21*m13-m11*m23;
+	T sd13 = m21*m32-m31*m22;
+	T sd23 = m31*m12-m11*m32;
+	T sd33 = m11*m22-m21*m12;
+
+	T detInv = 1.0/(m11*sd11 + m12*sd12 + m13*sd13);
+
+	T rx = (u.x*sd11 + u.y*sd21 + u.z*sd31)*detInv;
+	T ry = (u.x*sd12 + u.y*sd22 + u.z*sd32)*detInv;
+	T rz = (u.x*sd13 + u.y*sd23 + u.z*sd33)*detInv;
+
+	return ( VectorR3T<T>( rx, ry, rz ) );
+}
+
+// Returns sum of squares of entries
+template<class T>
+T Matrix3x3T<T>::SumSquaresNorm() const
+{
+	return ( m11*m11 + m12*m12 + m13*m13 + 
+			 m21*m21 + m22*m22 + m23*m23 +
+			 m31*m31 + m32*m32 + m33*m33   );
+} 
+
+
 
 // ******************************************************
 // * Matrix3x4  class - inlined functions				*
@@ -1618,35 +1948,39 @@ inline VectorR3 operator* ( const Matrix3x4& A, const VectorR3& u )
 // * LinearMapR3 class - inlined functions				*
 // * * * * * * * * * * * * * * * * * * * * * * * * * * **
 
-inline LinearMapR3::LinearMapR3()
-{
-	SetZero();
-	return;
-}	
+template<class T>
+constexpr LinearMapR3T<T>::LinearMapR3T()
+:Matrix3x3T<T> ( 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 )
+{ }
 
-inline LinearMapR3::LinearMapR3( const VectorR3& u, const VectorR3& v, 
-							 const VectorR3& s )
-:Matrix3x3 ( u, v, s )
+template<class T>
+constexpr LinearMapR3T<T>::LinearMapR3T( const VectorR3T<T>& u, const VectorR3T<T>& v, 
+							 const VectorR3T<T>& s )
+:Matrix3x3T<T> ( u, v, s )
 { }
 
-inline LinearMapR3::LinearMapR3( 
-							 double a11, double a21, double a31,
-							 double a12, double a22, double a32,
-							 double a13, double a23, double a33)
+template<class T>
+constexpr LinearMapR3T<T>::LinearMapR3T( 
+							 T a11, T a21, T a31,
+							 T a12, T a22, T a32,
+							 T a13, T a23, T a33)
 					// Values specified in column order!!!
-:Matrix3x3 ( a11, a21, a31, a12, a22, a32, a13, a23, a33)
+:Matrix3x3T<T> ( a11, a21, a31, a12, a22, a32, a13, a23, a33)
 { }
 
-inline LinearMapR3::LinearMapR3 ( const Matrix3x3& A )
-: Matrix3x3 (A) 
+template<class T>
+constexpr LinearMapR3T<T>::LinearMapR3T ( const Matrix3x3T<T>& A )
+: Matrix3x3T<T> (A) 
 {}
 
-inline void LinearMapR3::SetZero( ) 
+template<class T>
+inline void LinearMapR3T<T>::SetZero( ) 
 {
-	Matrix3x3::SetZero();
+	Matrix3x3T<T>::SetZero();
 }
 
-inline void LinearMapR3::Negate() 
+template<class T>
+inline void LinearMapR3T<T>::Negate() 
 {
 	m11 = -m11;		// Row 1
 	m12 = -m12;
@@ -1660,7 +1994,8 @@ inline void LinearMapR3::Negate()
 }
 
 	
-inline LinearMapR3& LinearMapR3::operator+= (const Matrix3x3& B)
+template<class T>
+inline LinearMapR3T<T>& LinearMapR3T<T>::operator+= (const Matrix3x3T<T>& B)
 {
 	m11 += B.m11;
 	m12 += B.m12;
@@ -1674,7 +2009,8 @@ inline LinearMapR3& LinearMapR3::operator+= (const Matrix3x3& B)
 	return ( *this );
 }
 
-inline LinearMapR3& LinearMapR3::operator-= (const Matrix3x3& B)
+template<class T>
+inline LinearMapR3T<T>& LinearMapR3T<T>::operator-= (const Matrix3x3T<T>& B)
 {
 	m11 -= B.m11;
 	m12 -= B.m12;
@@ -1688,56 +2024,64 @@ inline LinearMapR3& LinearMapR3::operator-= (const Matrix3x3& B)
 	return( *this );
 }
 
-inline LinearMapR3 operator+ (const LinearMapR3& A, const LinearMapR3& B)
+template<class T>
+constexpr LinearMapR3T<T> operator+ (const LinearMapR3T<T>& A, const LinearMapR3T<T>& B)
 {
-	return (LinearMapR3( A.m11+B.m11, A.m21+B.m21, A.m31+B.m31,
+	return (LinearMapR3T<T>( A.m11+B.m11, A.m21+B.m21, A.m31+B.m31,
 						 A.m12+B.m12, A.m22+B.m22, A.m32+B.m32,
 						 A.m13+B.m13, A.m23+B.m23, A.m33+B.m33 ) );
 }
 
-inline LinearMapR3 operator+ (const LinearMapR3& A, const Matrix3x3& B)
+template<class T>
+constexpr LinearMapR3T<T> operator+ (const LinearMapR3T<T>& A, const Matrix3x3T<T>& B)
 {
-	return (LinearMapR3( A.m11+B.m11, A.m21+B.m21, A.m31+B.m31,
+	return (LinearMapR3T<T>( A.m11+B.m11, A.m21+B.m21, A.m31+B.m31,
 						 A.m12+B.m12, A.m22+B.m22, A.m32+B.m32,
 						 A.m13+B.m13, A.m23+B.m23, A.m33+B.m33 ) );
 }
 
-inline LinearMapR3 operator+ (const Matrix3x3& A, const LinearMapR3& B)
+template<class T>
+constexpr LinearMapR3T<T> operator+ (const Matrix3x3T<T>& A, const LinearMapR3T<T>& B)
 {
-	return (LinearMapR3( A.m11+B.m11, A.m21+B.m21, A.m31+B.m31,
+	return (LinearMapR3T<T>( A.m11+B.m11, A.m21+B.m21, A.m31+B.m31,
 						 A.m12+B.m12, A.m22+B.m22, A.m32+B.m32,
 						 A.m13+B.m13, A.m23+B.m23, A.m33+B.m33 ) );
 }
 
-inline LinearMapR3 operator- (const LinearMapR3& A) 
+template<class T>
+constexpr LinearMapR3T<T> operator- (const LinearMapR3T<T>& A) 
 {
-	return( LinearMapR3( -A.m11, -A.m21, -A.m31,
+	return( LinearMapR3T<T>( -A.m11, -A.m21, -A.m31,
 						 -A.m12, -A.m22, -A.m32,
 						 -A.m13, -A.m23, -A.m33 ) );
 }
 
-inline LinearMapR3 operator- (const LinearMapR3& A, const LinearMapR3& B)
+template<class T>
+constexpr LinearMapR3T<T> operator- (const LinearMapR3T<T>& A, const LinearMapR3T<T>& B)
 {
-	return( LinearMapR3( A.m11-B.m11, A.m21-B.m21, A.m31-B.m31,
+	return( LinearMapR3T<T>( A.m11-B.m11, A.m21-B.m21, A.m31-B.m31,
 						 A.m12-B.m12, A.m22-B.m22, A.m32-B.m32,
 						 A.m13-B.m13, A.m23-B.m23, A.m33-B.m33 ) );
 }
 
-inline LinearMapR3 operator- (const Matrix3x3& A, const LinearMapR3& B)
+template<class T>
+constexpr LinearMapR3T<T> operator- (const Matrix3x3T<T>& A, const LinearMapR3T<T>& B)
 {
-	return( LinearMapR3( A.m11-B.m11, A.m21-B.m21, A.m31-B.m31,
+	return( LinearMapR3T<T>( A.m11-B.m11, A.m21-B.m21, A.m31-B.m31,
 						 A.m12-B.m12, A.m22-B.m22, A.m32-B.m32,
 						 A.m13-B.m13, A.m23-B.m23, A.m33-B.m33 ) );
 }
 
-inline LinearMapR3 operator- (const LinearMapR3& A, const Matrix3x3& B)
+template<class T>
+constexpr LinearMapR3T<T> operator- (const LinearMapR3T<T>& A, const Matrix3x3T<T>& B)
 {
-	return( LinearMapR3( A.m11-B.m11, A.m21-B.m21, A.m31-B.m31,
+	return( LinearMapR3T<T>( A.m11-B.m11, A.m21-B.m21, A.m31-B.m31,
 						 A.m12-B.m12, A.m22-B.m22, A.m32-B.m32,
 						 A.m13-B.m13, A.m23-B.m23, A.m33-B.m33 ) );
 }
 
-inline LinearMapR3& LinearMapR3::operator*= (register double b)
+template<class T>
+inline LinearMapR3T<T>& LinearMapR3T<T>::operator*= (T b)
 {
 	m11 *= b;
 	m12 *= b;
@@ -1751,36 +2095,41 @@ inline LinearMapR3& LinearMapR3::operator*= (register double b)
 	return ( *this);
 }
 
-inline LinearMapR3 operator* ( const LinearMapR3& A, register double b)
+template<class T>
+constexpr LinearMapR3T<T> operator* ( const LinearMapR3T<T>& A, typename LinearScalar<T>::Type b)
 {
-	return( LinearMapR3( A.m11*b, A.m21*b, A.m31*b,
+	return( LinearMapR3T<T>( A.m11*b, A.m21*b, A.m31*b,
 						 A.m12*b, A.m22*b, A.m32*b,
 						 A.m13*b, A.m23*b, A.m33*b ) );
 }
 
-inline LinearMapR3 operator* ( register double b, const LinearMapR3& A)
+template<class T>
+constexpr LinearMapR3T<T> operator* ( typename LinearScalar<T>::Type b, const LinearMapR3T<T>& A)
 {
-	return( LinearMapR3( A.m11*b, A.m21*b, A.m31*b,
+	return( LinearMapR3T<T>( A.m11*b, A.m21*b, A.m31*b,
 						 A.m12*b, A.m22*b, A.m32*b,
 						 A.m13*b, A.m23*b, A.m33*b ) );
 }
 
-inline LinearMapR3 operator/ ( const LinearMapR3& A, double b)
+template<class T>
+constexpr LinearMapR3T<T> operator/ ( const LinearMapR3T<T>& A, typename LinearScalar<T>::Type b)
 {
-	register double bInv = 1.0/b;
-	return( LinearMapR3( A.m11*bInv, A.m21*bInv, A.m31*bInv,
+	T bInv = 1.0/b;
+	return( LinearMapR3T<T>( A.m11*bInv, A.m21*bInv, A.m31*bInv,
 						 A.m12*bInv, A.m22*bInv, A.m32*bInv,
 						 A.m13*bInv, A.m23*bInv, A.m33*bInv ) );
 }
 
-inline LinearMapR3& LinearMapR3::operator/= (register double b)
+template<class T>
+inline LinearMapR3T<T>& LinearMapR3T<T>::operator/= (T b)
 {
-	register double bInv = 1.0/b;
+	T bInv = 1.0/b;
 	return ( *this *= bInv );
 }
 
 // Sets this = (m - this).
-inline void LinearMapR3::SubtractFrom( const Matrix3x3& m)
+template<class T>
+inline void LinearMapR3T<T>::SubtractFrom( const Matrix3x3T<T>& m)
 {
 	m11 = m.m11 - m11;
 	m12 = m.m12 - m12;
@@ -1793,20 +2142,286 @@ inline void LinearMapR3::SubtractFrom( const Matrix3x3& m)
 	m33 = m.m33 - m33;
 }
 
-inline LinearMapR3& LinearMapR3::operator*= (const Matrix3x3& B)	// Matrix product
+template<class T>
+inline LinearMapR3T<T>& LinearMapR3T<T>::operator*= (const Matrix3x3T<T>& B)	// Matrix product
 {
-	OperatorTimesEquals( B );
+	Matrix3x3T<T>::OperatorTimesEquals( B );
 	return( *this );
 }
 
-inline VectorR3 LinearMapR3::Solve(const VectorR3& u) const	// Returns solution
+template<class T>
+inline VectorR3T<T> LinearMapR3T<T>::Solve(const VectorR3T<T>& u) const	// Returns solution
 {
-	return ( Matrix3x3::Solve( u ) );
+	return ( Matrix3x3T<T>::Solve( u ) );
 }
 	
-inline LinearMapR3 LinearMapR3::Transpose() const	// Returns the transpose
+template<class T>
+constexpr LinearMapR3T<T> LinearMapR3T<T>::Transpose() const	// Returns the transpose
 {
-	return ( LinearMapR3 ( m11, m12, m13, m21, m22, m23, m31, m32, m33) );
+	return ( LinearMapR3T<T> ( m11, m12, m13, m21, m22, m23, m31, m32, m33) );
+}
+
+template<class T>
+constexpr LinearMapR3T<T> operator* ( const LinearMapR3T<T>& A, const LinearMapR3T<T>& B)
+{
+	return( LinearMapR3T<T>( A.m11*B.m11 + A.m12*B.m21 + A.m13*B.m31,
+							A.m21*B.m11 + A.m22*B.m21 + A.m23*B.m31,
+							A.m31*B.m11 + A.m32*B.m21 + A.m33*B.m31,
+						 A.m11*B.m12 + A.m12*B.m22 + A.m13*B.m32,
+							A.m21*B.m12 + A.m22*B.m22 + A.m23*B.m32,
+							A.m31*B.m12 + A.m32*B.m22 + A.m33*B.m32,
+						 A.m11*B.m13 + A.m12*B.m23 + A.m13*B.m33,
+							A.m21*B.m13 + A.m22*B.m23 + A.m23*B.m33,
+							A.m31*B.m13 + A.m32*B.m23 + A.m33*B.m33 ) );
+}
+
+template<class T>
+constexpr T LinearMapR3T<T>::Determinant () const		// Returns the determinant
+{
+	return ( m11*(m22*m33-m23*m32) 
+				- m12*(m21*m33-m31*m23)
+				+ m13*(m21*m23-m31*m22) );
+}
+
+template<class T>
+constexpr LinearMapR3T<T> LinearMapR3T<T>::Inverse() const			// Returns inverse
+{
+	T sd11 = m22*m33-m23*m32;
+	T sd21 = m32*m13-m12*m33;
+	T sd31 = m12*m23-m22*m13;
+	T sd12 = m31*m23-m21*m33;
+	T sd22 = m11*m33-m31*m13;
+	T sd32 = m21*m13-m11*m23;
+	T sd13 = m21*m32-m31*m22;
+	T sd23 = m31*m12-m11*m32;
+	T sd33 = m11*m22-m21*m12;
+
+	T detInv = 1.0/(m11*sd11 + m12*sd12 + m13*sd13);
+
+	return( LinearMapR3T<T>( sd11*detInv, sd12*detInv, sd13*detInv,
+						 sd21*detInv, sd22*detInv, sd23*detInv,
+						 sd31*detInv, sd32*detInv, sd33*detInv ) );
+}
+
+template<class T>
+LinearMapR3T<T>& LinearMapR3T<T>::Invert() 			// Converts into inverse.
+{
+	// Compute the nine subdeterminants
+	T sd11 = m22*m33-m23*m32;
+	T sd21 = m32*m13-m12*m33;
+	T sd31 = m12*m23-m22*m13;
+	T sd12 = m31*m23-m21*m33;
+	T sd22 = m11*m33-m31*m13;
+	T sd32 = m21*m13-m11*m23;
+	T sd13 = m21*m32-m31*m22;
+	T sd23 = m31*m12-m11*m32;
+	T sd33 = m11*m22-m21*m12;
+
+	T detInv = 1.0/(m11*sd11 + m12*sd12 + m13*sd13);
+
+	m11 = sd11*detInv;
+	m12 = sd21*detInv;
+	m13 = sd31*detInv;
+	m21 = sd12*detInv;
+	m22 = sd22*detInv;
+	m23 = sd32*detInv;
+	m31 = sd13*detInv;
+	m32 = sd23*detInv;
+	m33 = sd33*detInv;
+
+	return ( *this );
+}
+
+// Calculate inverse under assumption matrix is symmetric
+// Only uses lower part of the matrix.  No checking done for symmetry
+template<class T>
+LinearMapR3T<T> LinearMapR3T<T>::InverseSym() const
+{
+	LinearMapR3T<T> ret;
+	InverseSym( &ret );
+	return ret;
+}
+
+// Calculate inverse under assumption matrix is symmetric
+// Only uses lower part of the matrix.  No checking done for symmetry
+template<class T>
+void LinearMapR3T<T>::InverseSym( LinearMapR3T<T>* inverse ) const			
+{
+	// Compute the six distinct subdeterminants
+	T sd11 = m22*m33-m32*m32;
+	T sd12 = m31*m32-m21*m33;
+	T sd22 = m11*m33-m31*m31;
+	T sd13 = m21*m32-m31*m22;
+	T sd23 = m31*m21-m11*m32;
+	T sd33 = m11*m22-m21*m21;
+
+	T detInv = 1.0/(m11*sd11 + m21*sd12 + m31*sd13);
+
+	inverse->m11 = sd11*detInv;
+	inverse->m12 = inverse->m21 = sd12*detInv;
+	inverse->m13 = inverse->m31 = sd13*detInv;
+	inverse->m22 = sd22*detInv;
+	inverse->m23 = inverse->m32 = sd23*detInv;
+	inverse->m33 = sd33*detInv;
+}
+
+// Replace a matrix by its inverse under assumption matrix is symmetric
+// Only uses lower part of the matrix for the calculation of the
+//    inverse.  No checking done for symmetry
+template<class T>
+LinearMapR3T<T>& LinearMapR3T<T>::InvertSym()			
+{
+	// Compute the six distinct subdeterminants
+	T sd11 = m22*m33-m32*m32;
+	T sd12 = m31*m32-m21*m33;
+	T sd22 = m11*m33-m31*m31;
+	T sd13 = m21*m32-m31*m22;
+	T sd23 = m31*m21-m11*m32;
+	T sd33 = m11*m22-m21*m21;
+
+	T detInv = 1.0/(m11*sd11 + m21*sd12 + m31*sd13);
+
+	m11 = sd11*detInv;
+	m12 = m21 = sd12*detInv;
+	m13 = m31 = sd13*detInv;
+	m22 = sd22*detInv;
+	m23 = m32 = sd23*detInv;
+	m33 = sd33*detInv;
+
+	return *this;
+}
+
+// Calculate inverse under assumption matrix is symmetric and positive definite
+// Only uses lower part of the matrix.  No checking done for symmetry
+template<class T>
+LinearMapR3T<T> LinearMapR3T<T>::InversePosDef() const
+{
+	LinearMapR3T<T> ret;
+	InversePosDef( &ret );
+	return ret;
+}
+
+// Calculate inverse under assumption matrix is symmetric and positive definite
+// Only uses lower part of the matrix.  No checking done for symmetry
+// Positive definiteness is only partially checked with asserts.
+template<class T>
+void LinearMapR3T<T>::InversePosDef( LinearMapR3T<T>* inverse ) const			
+{
+
+	// Form a L*D*L^T representation.
+	//   L = ( (1 0 0)(a 0 0)(b 0 0) * * ( (1 0 0)(0 1 0)(0 c 1) ).
+	//	 D is diagonal. - d1, d2, d3 are *inverses* of the diagonal entries.
+	assert ( m11>0.0 );
+	T d1 = 1.0/m11;
+	T a = m12*d1;
+	T b = m13*d1;
+	T u22star = m22 - m12*a;
+	T u23star = m23 - m13*a;
+	T u33star = m33 - m13*b;
+	assert ( u22star>0.0 );
+	T d2 = 1.0/u22star;
+	T c = u23star*d2;
+	T u33starstar = u33star - u23star*c;
+	assert ( u33starstar>0.0 );
+	T d3 = 1.0/u33starstar;
+
+	// Compute the inverse
+	// Compute the inverse
+	inverse->m33 = d3;
+	inverse->m23 = inverse->m32 = -c*d3;
+	inverse->m22 = d2 - c*(inverse->m23);
+	T acminusb = a*c - b;
+	inverse->m13 = inverse->m31 = acminusb*d3;
+	T ad2 = a*d2;
+	inverse->m12 = inverse->m21 = -c*(inverse->m13) - ad2;
+	inverse->m11 = d1 + a*ad2 + acminusb*(inverse->m13);
+
+}
+
+// Invert the matrix under assumption matrix is symmetric and positive definite
+// Only uses lower part of the matrix.  No checking done for symmetry
+// Positive definiteness is only partially checked with asserts.
+template<class T>
+LinearMapR3T<T>& LinearMapR3T<T>::InvertPosDef()		
+{
+
+	// Form a L * D * L^T representation.
+	//   L = ( (1 0 0)(a 0 0)(b 0 0) * * ( (1 0 0)(0 1 0)(0 c 1) ).
+	//	 D is diagonal. - d1, d2, d3 are *inverses* of the diagonal entries.
+	assert ( m11>0.0 );
+	T d1 = 1.0/m11;
+	T a = m12*d1;
+	T b = m13*d1;
+	T u22star = m22 - m12*a;
+	T u23star = m23 - m12*b;
+	T u33star = m33 - m13*b;
+	assert ( u22star>0.0 );
+	T d2 = 1.0/u22star;
+	T c = u23star*d2;
+	T u33starstar = u33star - u23star*c;
+	assert ( u33starstar>0.0 );
+	T d3 = 1.0/u33starstar;
+
+	// Compute the inverse
+	m33 = d3;
+	m23 = m32 = -c*d3;
+	m22 = d2 - c*m23;
+	T acminusb = a*c - b;
+	m13 = m31 = acminusb*d3;
+	T ad2 = a*d2;
+	m12 = m21 = -c*m13 - ad2;
+	m11 = d1 + a*ad2 + acminusb*m13;
+	
+	return *this;
+}
+
+// Invert the matrix under assumption matrix is symmetric and positive definite
+// Only uses lower part of the matrix.  No checking done for symmetry
+// Positive definiteness is only partially guarded against.
+//  If the eigenvalues are all positive and not too different in magnitude,
+//	will compute the correct inverse.   If one or more eigenvalues are
+//	too close to zero, will compute the inverse of a slightly modified matrix.
+// A better solution would re-start the calculation, but the present method
+//	is faster and should work acceptably.
+template<class T>
+LinearMapR3T<T>& LinearMapR3T<T>::InvertPosDefSafe()		
+{
+
+	T trace = m11+m22+m33;
+	assert ( trace>=0.0 );				// Every element on diagonal should be positive!
+	T epsilon = 1.0e-5*trace;		// Threshold for being positive
+
+	// Form a L * D * L^T representation.
+	//   L = ( (1 0 0)(a 0 0)(b 0 0) * * ( (1 0 0)(0 1 0)(0 c 1) ).
+	//	 D is diagonal. - d1, d2, d3 are *inverses* of the diagonal entries.
+	assert ( m11 > -epsilon );		// Check for nearly non-negative definite
+	m11 = Max( epsilon, m11 );		// Force divide only by positive number
+	T d1 = 1.0/m11;
+	T a = m12*d1;
+	T b = m13*d1;
+	T u22star = m22 - m12*a;
+	T u23star = m23 - m12*b;
+	T u33star = m33 - m13*b;
+	assert ( u22star > -epsilon );		// Check for nearly non-negative definite
+	u22star = Max( epsilon, u22star );	// Force divide only by positive number
+	T d2 = 1.0/u22star;
+	T c = u23star*d2;
+	T u33starstar = u33star - u23star*c;
+	assert ( u33starstar > - epsilon );		// Check for nearly non-negative definite
+	u33starstar = Max( epsilon, u33starstar );	// Force divide only by positive number
+	T d3 = 1.0/u33starstar;
+
+	// Compute the inverse
+	m33 = d3;
+	m23 = m32 = -c*d3;
+	m22 = d2 - c*m23;
+	T acminusb = a*c - b;
+	m13 = m31 = acminusb*d3;
+	T ad2 = a*d2;
+	m12 = m21 = -c*m13 - ad2;
+	m11 = d1 + a*ad2 + acminusb*m13;
+	
+	return *this;
 }
 
 // ******************************************************
@@ -2188,22 +2803,25 @@ inline RigidMapR3& RigidMapR3::Invert()			// Converts into inverse.
 // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
 // Returns the projection of u onto unit v
-inline VectorR3 ProjectToUnit ( const VectorR3& u, const VectorR3& v)
+template<class T>
+inline VectorR3T<T> ProjectToUnit ( const VectorR3T<T>& u, const VectorR3T<T>& v)
 {
 	return (u^v)*v;
 }
 
 // Returns the projection of u onto the plane perpindicular to the unit vector v
-inline VectorR3 ProjectPerpUnit ( const VectorR3& u, const VectorR3& v)
+template<class T>
+inline VectorR3T<T> ProjectPerpUnit ( const VectorR3T<T>& u, const VectorR3T<T>& v)
 {
 	return ( u - ((u^v)*v) );
 }
 
 // Returns the projection of u onto the plane perpindicular to the unit vector v
 //    This one is more stable when u and v are nearly equal.
-inline VectorR3 ProjectPerpUnitDiff ( const VectorR3& u, const VectorR3& v)
+template<class T>
+inline VectorR3T<T> ProjectPerpUnitDiff ( const VectorR3T<T>& u, const VectorR3T<T>& v)
 {
-	VectorR3 ans = u;
+	VectorR3T<T> ans = u;
 	ans -= v;
 	ans -= ((ans^v)*v);
 	return ans;				// ans = (u-v) - ((u-v)^v)*v
@@ -2212,12 +2830,13 @@ inline VectorR3 ProjectPerpUnitDiff ( const VectorR3& u, const VectorR3& v)
 // VectorProjectMap returns map projecting onto a given vector u.
 //		u should be a unit vector (otherwise the returned map is
 //		scaled according to the magnitude of u.
-inline LinearMapR3 VectorProjectMap( const VectorR3& u )
+template<class T>
+inline LinearMapR3T<T> VectorProjectMap( const VectorR3T<T>& u )
 {
-	double a = u.x*u.y;
-	double b = u.x*u.z;
-	double c = u.y*u.z;
-	return( LinearMapR3( u.x*u.x,     a,     b,
+	T a = u.x*u.y;
+	T b = u.x*u.z;
+	T c = u.y*u.z;
+	return( LinearMapR3T<T>( u.x*u.x,     a,     b,
 						    a,    u.y*u.y,   c,
 							b,        c,   u.z*u.z ) );
 }
@@ -2226,12 +2845,13 @@ inline LinearMapR3 VectorProjectMap( const VectorR3& u )
 //		The plane is the plane orthognal to w.
 //		w must be a unit vector (otherwise the returned map is
 //		garbage).
-inline LinearMapR3 PlaneProjectMap ( const VectorR3& w )
+template<class T>
+inline LinearMapR3T<T> PlaneProjectMap ( const VectorR3T<T>& w )
 {
-	double a = -w.x*w.y;
-	double b = -w.x*w.z;
-	double c = -w.y*w.z;
-	return( LinearMapR3( 1.0-w.x*w.x,     a,         b,
+	T a = -w.x*w.y;
+	T b = -w.x*w.z;
+	T c = -w.y*w.z;
+	return( LinearMapR3T<T>( 1.0-w.x*w.x,     a,         b,
 						    a,        1.0-w.y*w.y,   c,
 							b,            c,       1.0-w.z*w.z ) );
 }
@@ -2241,22 +2861,56 @@ inline LinearMapR3 PlaneProjectMap ( const VectorR3& w )
 //		If u, v are orthonormal, this is a projection with scaling.
 //		If they are not orthonormal, the results are more difficult
 //		to interpret.
-inline LinearMapR3 PlaneProjectMap ( const VectorR3& u, const VectorR3 &v )
+template<class T>
+inline LinearMapR3T<T> PlaneProjectMap ( const VectorR3T<T>& u, const VectorR3T<T> &v )
 {
-	double a = u.x*u.y + v.x*v.y;
-	double b = u.x*u.z + v.x*v.z;
-	double c = u.y*u.z + v.y*v.z;
-	return( LinearMapR3( u.x*u.x+v.x*v.x,     a,            b,
+	T a = u.x*u.y + v.x*v.y;
+	T b = u.x*u.z + v.x*v.z;
+	T c = u.y*u.z + v.y*v.z;
+	return( LinearMapR3T<T>( u.x*u.x+v.x*v.x,     a,            b,
 						    a,           u.y*u.y+u.y*u.y,   c,
 							b,                c,         u.z*u.z+v.z*v.z ) );
 }  
 
 // Returns the solid angle between unit vectors v and w.
-inline double SolidAngle( const VectorR3& v, const VectorR3& w)
+template<class T>
+inline T SolidAngle( const VectorR3T<T>& v, const VectorR3T<T>& w)
 {
 	return atan2 ( (v*w).Norm(), v^w );
 }
 
+// Transforms vector i by A[i]; the vectors are in x, y and z arrays.
+template<class T>
+void Transform( const Matrix3x3T<T>* A, const T* x, const T* y, const T* z,
+				T* outX, T* outY, T* outZ, long count )
+{
+	for ( long i=0; i<count; i++ ) {
+		T px = x[i], py = y[i], pz = z[i];
+		outX[i] = A[i].m11*px + A[i].m12*py + A[i].m13*pz;
+		outY[i] = A[i].m21*px + A[i].m22*py + A[i].m23*pz;
+		outZ[i] = A[i].m31*px + A[i].m32*py + A[i].m33*pz;
+	}
+}
+
+// ***************************************************************
+// * Stream Output Routines										 *
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+template<class T>
+ostream& operator<< ( ostream& os, const VectorR3T<T>& u )
+{
+	return (os << "<" << u.x << "," << u.y << "," << u.z << ">");
+}
+
+template<class T>
+ostream& operator<< ( ostream& os, const Matrix3x3T<T>& A )
+{
+	os << " <" << A.m11 << ", " << A.m12 << ", " << A.m13  << ">\n"
+	   << " <" << A.m21 << ", " << A.m22 << ", " << A.m23  << ">\n"
+	   << " <" << A.m31 << ", " << A.m32 << ", " << A.m33  << ">\n" ;
+	return (os);
+}
+
 
 #endif
 
@@ -34,6 +34,9 @@
 //
 //	  B.2 RotationMapR4 - orthonormal 4x4 matrix
 //
+// VectorR4, Matrix4x4 and LinearMapR4 are the double precision versions
+//    of the templates VectorR4T, Matrix4x4T and LinearMapR4T.
+//
 
 #ifndef LINEAR_R4_H
 #define LINEAR_R4_H
@@ -44,20 +47,25 @@
 #include "LinearR3.h"
 using namespace std;
 
-class VectorR4;				// R4 Vector
-class LinearMapR4;			// 4x4 real matrix
+template<class T> class VectorR4T;		// R4 Vector, over the scalar type T
+template<class T> class Matrix4x4T;
+template<class T> class LinearMapR4T;	// 4x4 real matrix
+typedef VectorR4T<double> VectorR4;
+typedef Matrix4x4T<double> Matrix4x4;
+typedef LinearMapR4T<double> LinearMapR4;
 class RotationMapR4;		// 4x4 rotation map
 
 // **************************************
 // VectorR4 class                       *
 // * * * * * * * * * * * * * * * * * * **
 
-class VectorR4 {
+template<class T>
+class VectorR4T {
 
 public:
-	double x, y, z, w;		// The x & y & z & w coordinates.
+	T x, y, z, w;		// The x & y & z & w coordinates.
 
-	static const VectorR4 Zero;
+	static const VectorR4T Zero;
 	// Deprecated due to unsafeness of global initialization
 	//static const VectorR4 UnitX;
 	//static const VectorR4 UnitY;
@@ -69,221 +77,234 @@ public:
 	//static const VectorR4 NegUnitW;
 
 public:
-	VectorR4( ) : x(0.0), y(0.0), z(0.0), w(0.0) {}
-	VectorR4( double xVal, double yVal, double zVal, double wVal )
+	VectorR4T( ) : x(0.0), y(0.0), z(0.0), w(0.0) {}
+	VectorR4T( T xVal, T yVal, T zVal, T wVal )
 		: x(xVal), y(yVal), z(zVal), w(wVal) {}
 	// VectorR4( const Quaternion& q);			// Definition with Quaternion routines
 	
-	VectorR4& SetZero() { x=0.0; y=0.0; z=0.0; w=0.0; return *this;}
-	VectorR4& SetUnitX() { x=1.0; y=0.0; z=0.0; w=0.0; return *this;}
-	VectorR4& SetUnitY() { x=0.0; y=1.0; z=0.0; w=0.0; return *this;}
-	VectorR4& SetUnitZ() { x=0.0; y=0.0; z=1.0; w=0.0; return *this;}
-	VectorR4& SetUnitW() { x=0.0; y=0.0; z=0.0; w=1.0; return *this;}
-	VectorR4& SetNegUnitX() { x=-1.0; y=0.0; z=0.0; w=0.0; return *this;}
-	VectorR4& SetNegUnitY() { x=0.0; y=-1.0; z=0.0; w=0.0; return *this;}
-	VectorR4& SetNegUnitZ() { x=0.0; y=0.0; z=-1.0; w=0.0; return *this;}
-	VectorR4& SetNegUnitW() { x=0.0; y=0.0; z=0.0; w=-1.0; return *this;}
-	VectorR4& Set( double xx, double yy, double zz, double ww ) 
+	VectorR4T& SetZero() { x=0.0; y=0.0; z=0.0; w=0.0; return *this;}
+	VectorR4T& SetUnitX() { x=1.0; y=0.0; z=0.0; w=0.0; return *this;}
+	VectorR4T& SetUnitY() { x=0.0; y=1.0; z=0.0; w=0.0; return *this;}
+	VectorR4T& SetUnitZ() { x=0.0; y=0.0; z=1.0; w=0.0; return *this;}
+	VectorR4T& SetUnitW() { x=0.0; y=0.0; z=0.0; w=1.0; return *this;}
+	VectorR4T& SetNegUnitX() { x=-1.0; y=0.0; z=0.0; w=0.0; return *this;}
+	VectorR4T& SetNegUnitY() { x=0.0; y=-1.0; z=0.0; w=0.0; return *this;}
+	VectorR4T& SetNegUnitZ() { x=0.0; y=0.0; z=-1.0; w=0.0; return *this;}
+	VectorR4T& SetNegUnitW() { x=0.0; y=0.0; z=0.0; w=-1.0; return *this;}
+	VectorR4T& Set( T xx, T yy, T zz, T ww ) 
 			{ x=xx; y=yy; z=zz; w=ww; return *this;}
-	VectorR4& Set ( const Quaternion& );		// Defined with Quaternion
-	VectorR4& Set ( const VectorHgR3& h ) {x=h.x; y=h.y; z=h.z; w=h.w; return *this; }
-	VectorR4& Load( const double* v );
-	VectorR4& Load( const float* v );
+	VectorR4T& Set ( const Quaternion& );		// Defined with Quaternion
+	VectorR4T& Set ( const VectorHgR3& h ) {x=h.x; y=h.y; z=h.z; w=h.w; return *this; }
+	VectorR4T& Load( const double* v );
+	VectorR4T& Load( const float* v );
 	void Dump( double* v ) const;
 	void Dump( float* v ) const;
 
-	VectorR4& operator+= ( const VectorR4& v ) 
+	VectorR4T& operator+= ( const VectorR4T& v ) 
 		{ x+=v.x; y+=v.y; z+=v.z; w+=v.w;  return(*this); } 
-	VectorR4& operator-= ( const VectorR4& v ) 
+	VectorR4T& operator-= ( const VectorR4T& v ) 
 		{ x-=v.x; y-=v.y; z-=v.z; w-=v.w;  return(*this); }
-	VectorR4& operator*= ( double m ) 
+	VectorR4T& operator*= ( T m ) 
 		{ x*=m; y*=m; z*=m; w*=m;  return(*this); }
-	VectorR4& operator/= ( double m ) 
-			{ register double mInv = 1.0/m; 
+	VectorR4T& operator/= ( T m ) 
+			{ T mInv = 1.0/m; 
 			  x*=mInv; y*=mInv; z*=mInv; w*=mInv;
 			  return(*this); }
-	VectorR4 operator- () const { return ( VectorR4(-x, -y, -z, -w) ); }
-	VectorR4& ArrayProd(const VectorR4&);		// Component-wise product
-	VectorR4& ArrayProd3(const VectorR3&);		// Component-wise product
-
-	VectorR4& AddScaled( const VectorR4& u, double s );
-
-	double Norm() const { return ( (double)sqrt( x*x + y*y + z*z +w*w) ); }
-	double NormSq() const { return ( x*x + y*y + z*z + w*w ); }
-	double Dist( const VectorR4& u ) const;	// Distance from u
-	double DistSq( const VectorR4& u ) const;	// Distance from u
-	double MaxAbs() const;
-	VectorR4& Normalize () { *this /= Norm(); return *this; }	// No error checking
-	inline VectorR4& MakeUnit();		// Normalize() with error checking
-	inline VectorR4& ReNormalize();
+	VectorR4T operator- () const { return ( VectorR4T(-x, -y, -z, -w) ); }
+	VectorR4T& ArrayProd(const VectorR4T&);		// Component-wise product
+	VectorR4T& ArrayProd3(const VectorR3T<T>&);		// Component-wise product
+
+	VectorR4T& AddScaled( const VectorR4T& u, T s );
+
+	T Norm() const { return ( (T)sqrt( x*x + y*y + z*z +w*w) ); }
+	T NormSq() const { return ( x*x + y*y + z*z + w*w ); }
+	T Dist( const VectorR4T& u ) const;	// Distance from u
+	T DistSq( const VectorR4T& u ) const;	// Distance from u
+	T MaxAbs() const;
+	VectorR4T& Normalize () { *this /= Norm(); return *this; }	// No error checking
+	inline VectorR4T& MakeUnit();		// Normalize() with error checking
+	inline VectorR4T& ReNormalize();
 	bool IsUnit( ) const
-		{ register double norm = Norm();
+		{ T norm = Norm();
 		  return ( 1.000001>=norm && norm>=0.999999 ); }
-	bool IsUnit( double tolerance ) const
-		{ register double norm = Norm();
+	bool IsUnit( T tolerance ) const
+		{ T norm = Norm();
 		  return ( 1.0+tolerance>=norm && norm>=1.0-tolerance ); }
 	bool IsZero() const { return ( x==0.0 && y==0.0 && z==0.0 && w==0.0); }
-	bool NearZero(double tolerance) const { return( MaxAbs()<=tolerance );}
+	bool NearZero(T tolerance) const { return( MaxAbs()<=tolerance );}
 							// tolerance should be non-negative
 
-	VectorR4& RotateUnitInDirection ( const VectorR4& dir);	// rotate in direction dir
+	VectorR4T& RotateUnitInDirection ( const VectorR4T& dir);	// rotate in direction dir
 
 };
 
-inline VectorR4 operator+( const VectorR4& u, const VectorR4& v );
-inline VectorR4 operator-( const VectorR4& u, const VectorR4& v ); 
-inline VectorR4 operator*( const VectorR4& u, double m); 
-inline VectorR4 operator*( double m, const VectorR4& u); 
-inline VectorR4 operator/( const VectorR4& u, double m); 
-inline bool operator==( const VectorR4& u, const VectorR4& v ); 
+template<class T> inline VectorR4T<T> operator+( const VectorR4T<T>& u, const VectorR4T<T>& v );
+template<class T> inline VectorR4T<T> operator-( const VectorR4T<T>& u, const VectorR4T<T>& v ); 
+template<class T> inline VectorR4T<T> operator*( const VectorR4T<T>& u, typename LinearScalar<T>::Type m); 
+template<class T> inline VectorR4T<T> operator*( typename LinearScalar<T>::Type m, const VectorR4T<T>& u); 
+template<class T> inline VectorR4T<T> operator/( const VectorR4T<T>& u, typename LinearScalar<T>::Type m); 
+template<class T> inline bool operator==( const VectorR4T<T>& u, const VectorR4T<T>& v ); 
 
-inline double operator^ (const VectorR4& u, const VectorR4& v ); // Dot Product
-inline double InnerProduct(const VectorR4& u, const VectorR4& v ) { return (u^v); }
-inline VectorR4 ArrayProd(const VectorR4& u, const VectorR4& v );
+template<class T> inline T operator^ (const VectorR4T<T>& u, const VectorR4T<T>& v ); // Dot Product
+template<class T> inline T InnerProduct(const VectorR4T<T>& u, const VectorR4T<T>& v ) { return (u^v); }
+template<class T> inline VectorR4T<T> ArrayProd(const VectorR4T<T>& u, const VectorR4T<T>& v );
 
-inline double Mag(const VectorR4& u) { return u.Norm(); }
-inline double Dist(const VectorR4& u, const VectorR4& v) { return u.Dist(v); }
-inline double DistSq(const VectorR4& u, const VectorR4& v) { return u.DistSq(v); }
-inline double NormalizeError (const VectorR4& u);
+template<class T> inline T Mag(const VectorR4T<T>& u) { return u.Norm(); }
+template<class T> inline T Dist(const VectorR4T<T>& u, const VectorR4T<T>& v) { return u.Dist(v); }
+template<class T> inline T DistSq(const VectorR4T<T>& u, const VectorR4T<T>& v) { return u.DistSq(v); }
+template<class T> inline T NormalizeError (const VectorR4T<T>& u);
 
 // ********************************************************************
 // Matrix4x4     - base class for 4x4 matrices                        *
 // * * * * * * * * * * * * * * * * * * * * * **************************
 
-class Matrix4x4 {
+template<class T>
+class Matrix4x4T {
 
 public:
-	double m11, m21, m31, m41, m12, m22, m32, m42,
+	T m11, m21, m31, m41, m12, m22, m32, m42,
 		   m13, m23, m33, m43, m14, m24, m34, m44;
 									
 	// Implements a 4x4 matrix: m_i_j - row-i and column-j entry
 
-	static const Matrix4x4 Identity;
+	static const Matrix4x4T Identity;
 
 
 public:
 
-	Matrix4x4();
-	Matrix4x4( const VectorR4&, const VectorR4&, 
-					const VectorR4&, const VectorR4& );	// Sets by columns!
-	Matrix4x4( double, double, double, double, 
-					 double, double, double, double,
-					 double, double, double, double,
-					 double, double, double, double );	// Sets by columns
+	Matrix4x4T();
+	Matrix4x4T( const VectorR4T<T>&, const VectorR4T<T>&, 
+					const VectorR4T<T>&, const VectorR4T<T>& );	// Sets by columns!
+	Matrix4x4T( T, T, T, T, 
+					 T, T, T, T,
+					 T, T, T, T,
+					 T, T, T, T );	// Sets by columns
 
 	inline void SetIdentity ();		// Set to the identity map
 	inline void SetZero ();			// Set to the zero map
-	inline void Set ( const Matrix4x4& );	// Set to the matrix.
-	inline void Set( const VectorR4&, const VectorR4&, 
-						const VectorR4&, const VectorR4& );
-	inline void Set( double, double, double, double,
-					 double, double, double, double,
-					 double, double, double, double,
-					 double, double, double, double );
-	inline void SetByRows( const VectorR4&, const VectorR4&, 
-						const VectorR4&, const VectorR4& );
-	inline void SetByRows( double, double, double, double,
-							double, double, double, double,
-							double, double, double, double,
-							double, double, double, double );
-	inline void SetColumn1 ( double, double, double, double );
-	inline void SetColumn2 ( double, double, double, double );
-	inline void SetColumn3 ( double, double, double, double );
-	inline void SetColumn4 ( double, double, double, double );
-	inline void SetColumn1 ( const VectorR4& );
-	inline void SetColumn2 ( const VectorR4& );
-	inline void SetColumn3 ( const VectorR4& );
-	inline void SetColumn4 ( const VectorR4& );
-	inline VectorR4 Column1() const;
-	inline VectorR4 Column2() const;
-	inline VectorR4 Column3() const;
-	inline VectorR4 Column4() const;
+	inline void Set ( const Matrix4x4T& );	// Set to the matrix.
+	inline void Set( const VectorR4T<T>&, const VectorR4T<T>&, 
+						const VectorR4T<T>&, const VectorR4T<T>& );
+	inline void Set( T, T, T, T,
+					 T, T, T, T,
+					 T, T, T, T,
+					 T, T, T, T );
+	inline void SetByRows( const VectorR4T<T>&, const VectorR4T<T>&, 
+						const VectorR4T<T>&, const VectorR4T<T>& );
+	inline void SetByRows( T, T, T, T,
+							T, T, T, T,
+							T, T, T, T,
+							T, T, T, T );
+	inline void SetColumn1 ( T, T, T, T );
+	inline void SetColumn2 ( T, T, T, T );
+	inline void SetColumn3 ( T, T, T, T );
+	inline void SetColumn4 ( T, T, T, T );
+	inline void SetColumn1 ( const VectorR4T<T>& );
+	inline void SetColumn2 ( const VectorR4T<T>& );
+	inline void SetColumn3 ( const VectorR4T<T>& );
+	inline void SetColumn4 ( const VectorR4T<T>& );
+	inline VectorR4T<T> Column1() const;
+	inline VectorR4T<T> Column2() const;
+	inline VectorR4T<T> Column3() const;
+	inline VectorR4T<T> Column4() const;
 	inline void DumpByColumns( float*) const;
 
-	inline void SetDiagonal( double, double, double, double );
-	inline void SetDiagonal( const VectorR4& );
-	inline double Diagonal( int );
+	inline void SetDiagonal( T, T, T, T );
+	inline void SetDiagonal( const VectorR4T<T>& );
+	inline T Diagonal( int );
 
 	inline void MakeTranspose();					// Transposes it.
-	void operator*= (const Matrix4x4& B); // Matrix product	
+	void operator*= (const Matrix4x4T& B); // Matrix product	
 
-	Matrix4x4& ReNormalize();
+	Matrix4x4T& ReNormalize();
 
-	double Trace() const { return m11+m22+m33+m44; }
+	T Trace() const { return m11+m22+m33+m44; }
 
 };
 
-inline VectorR4 operator* ( const Matrix4x4&, const VectorR4& );
+template<class T> inline VectorR4T<T> operator* ( const Matrix4x4T<T>&, const VectorR4T<T>& );
 
-ostream& operator<< ( ostream& os, const Matrix4x4& A );
+template<class T> ostream& operator<< ( ostream& os, const Matrix4x4T<T>& A );
 
 
 // *****************************************
 // LinearMapR4 class                       *
 // * * * * * * * * * * * * * * * * * * * * *
 
-class LinearMapR4 : public Matrix4x4 {
+template<class T>
+class LinearMapR4T : public Matrix4x4T<T> {
 
 public:
-
-	LinearMapR4();
-	LinearMapR4( const VectorR4&, const VectorR4&, 
-					const VectorR4&, const VectorR4& );	// Sets by columns!
-	LinearMapR4( double, double, double, double, 
-					 double, double, double, double,
-					 double, double, double, double,
-					 double, double, double, double );	// Sets by columns
-	LinearMapR4 ( const Matrix4x4& );
-
-	inline LinearMapR4& operator+= (const LinearMapR4& );
-	inline LinearMapR4& operator-= (const LinearMapR4& );
-	inline LinearMapR4& operator*= (double);
-	inline LinearMapR4& operator/= (double);
-	inline LinearMapR4& operator*= (const Matrix4x4& );	// Matrix product
-
-	inline LinearMapR4 Transpose() const;
-	double Determinant () const;			// Returns the determinant
-	LinearMapR4 Inverse() const;			// Returns inverse
-	LinearMapR4& Invert();					// Converts into inverse.
-	VectorR4 Solve(const VectorR4&) const;	// Returns solution
-	LinearMapR4 PseudoInverse() const;		// Returns pseudo-inverse TO DO
-	VectorR4 PseudoSolve(const VectorR4&);	// Finds least squares solution TO DO
+	using Matrix4x4T<T>::m11; using Matrix4x4T<T>::m12; using Matrix4x4T<T>::m13; using Matrix4x4T<T>::m14;
+	using Matrix4x4T<T>::m21; using Matrix4x4T<T>::m22; using Matrix4x4T<T>::m23; using Matrix4x4T<T>::m24;
+	using Matrix4x4T<T>::m31; using Matrix4x4T<T>::m32; using Matrix4x4T<T>::m33; using Matrix4x4T<T>::m34;
+	using Matrix4x4T<T>::m41; using Matrix4x4T<T>::m42; using Matrix4x4T<T>::m43; using Matrix4x4T<T>::m44;
+
+	LinearMapR4T();
+	LinearMapR4T( const VectorR4T<T>&, const VectorR4T<T>&, 
+					const VectorR4T<T>&, const VectorR4T<T>& );	// Sets by columns!
+	LinearMapR4T( T, T, T, T, 
+					 T, T, T, T,
+					 T, T, T, T,
+					 T, T, T, T );	// Sets by columns
+	LinearMapR4T ( const Matrix4x4T<T>& );
+
+	inline LinearMapR4T& operator+= (const LinearMapR4T& );
+	inline LinearMapR4T& operator-= (const LinearMapR4T& );
+	inline LinearMapR4T& operator*= (T);
+	inline LinearMapR4T& operator/= (T);
+	inline LinearMapR4T& operator*= (const Matrix4x4T<T>& );	// Matrix product
+
+	inline LinearMapR4T Transpose() const;
+	T Determinant () const;			// Returns the determinant
+	LinearMapR4T Inverse() const;			// Returns inverse
+	LinearMapR4T& Invert();					// Converts into inverse.
+	VectorR4T<T> Solve(const VectorR4T<T>&) const;	// Returns solution
+	LinearMapR4T PseudoInverse() const;		// Returns pseudo-inverse TO DO
+	VectorR4T<T> PseudoSolve(const VectorR4T<T>&);	// Finds least squares solution TO DO
 
     bool IsAffine() const;           // Check if represents affine transformation
-    void AffineTransformPosition(VectorR3& dest) const;
-    void AffineTransformDirection(VectorR3& dest) const;
+    void AffineTransformPosition(VectorR3T<T>& dest) const;
+    void AffineTransformDirection(VectorR3T<T>& dest) const;
+    // The same for count positions or directions stored as separate x, y and z
+    //   arrays (structure of arrays).  The output arrays may be the input arrays.
+    //   Nothing uses these yet: the mesh generators only rotate, with Matrix3x3T::Transform().
+    void AffineTransformPositions(const T* x, const T* y, const T* z, T* outX, T* outY, T* outZ, long count) const;
+    void AffineTransformDirections(const T* x, const T* y, const T* z, T* outX, T* outY, T* outZ, long count) const;
 
 	// Reproduce OpenGL Projection and Modelview Matrix operations.
 	//  EXCEPT: these routines use radians, not degrees.  (!)
-	LinearMapR4& Set_glOrtho(double left, double right, double bottom, double top, double near, double far);
-	LinearMapR4& Set_glScale(double xyzScale);
-	LinearMapR4& Mult_glScale(double xyzScale);
-	LinearMapR4& Set_glScale(double xScale, double yScale, double zScale);
-	LinearMapR4& Mult_glScale(double xScale, double yScale, double zScale);
-	LinearMapR4& Set_glTranslate(double xTranslation, double yTranslation, double zTranslation);
-	LinearMapR4& Mult_glTranslate(double xTranslation, double yTranslation, double zTranslation);
-	LinearMapR4& Set_glTranslate(const VectorR3& translation);
-	LinearMapR4& Mult_glTranslate(const VectorR3& translation);
-	LinearMapR4& Set_glRotate(double radians, double x, double y, double z);
-	LinearMapR4& Mult_glRotate(double radians, double x, double y, double z);
-	LinearMapR4& Set_glRotate(double radians, const VectorR3& axis);
-	LinearMapR4& Mult_glRotate(double radians, const VectorR3& axis);
-	LinearMapR4& Set_glRotate(double costheta, double sintheta, double x, double y, double z);
-	LinearMapR4& Mult_glRotate(double costheta, double sintheta, double x, double y, double z);
-	LinearMapR4& Set_glRotate(double costheta, double sintheta, const VectorR3& axis);
-	LinearMapR4& Mult_glRotate(double costheta, double sintheta, const VectorR3& axis);
-	LinearMapR4& Set_glFrustum(double left, double right, double bottom, double top, double near, double far);
-	LinearMapR4& Set_gluPerspective(double fieldofview_y_Radians, double aspectRatio, double zNear, double zFar);
+	LinearMapR4T& Set_glOrtho(T left, T right, T bottom, T top, T near, T far);
+	LinearMapR4T& Set_glScale(T xyzScale);
+	LinearMapR4T& Mult_glScale(T xyzScale);
+	LinearMapR4T& Set_glScale(T xScale, T yScale, T zScale);
+	LinearMapR4T& Mult_glScale(T xScale, T yScale, T zScale);
+	LinearMapR4T& Set_glTranslate(T xTranslation, T yTranslation, T zTranslation);
+	LinearMapR4T& Mult_glTranslate(T xTranslation, T yTranslation, T zTranslation);
+	LinearMapR4T& Set_glTranslate(const VectorR3T<T>& translation);
+	LinearMapR4T& Mult_glTranslate(const VectorR3T<T>& translation);
+	LinearMapR4T& Set_glRotate(T radians, T x, T y, T z);
+	LinearMapR4T& Mult_glRotate(T radians, T x, T y, T z);
+	LinearMapR4T& Set_glRotate(T radians, const VectorR3T<T>& axis);
+	LinearMapR4T& Mult_glRotate(T radians, const VectorR3T<T>& axis);
+	LinearMapR4T& Set_glRotate(T costheta, T sintheta, T x, T y, T z);
+	LinearMapR4T& Mult_glRotate(T costheta, T sintheta, T x, T y, T z);
+	LinearMapR4T& Set_glRotate(T costheta, T sintheta, const VectorR3T<T>& axis);
+	LinearMapR4T& Mult_glRotate(T costheta, T sintheta, const VectorR3T<T>& axis);
+	LinearMapR4T& Set_glRotate(const Quaternion& q);		// Defined in Quaternion.h
+	LinearMapR4T& Mult_glRotate(const Quaternion& q);
+	LinearMapR4T& Set_glFrustum(T left, T right, T bottom, T top, T near, T far);
+	LinearMapR4T& Set_gluPerspective(T fieldofview_y_Radians, T aspectRatio, T zNear, T zFar);
 };
 
-inline LinearMapR4 operator+ (const LinearMapR4&, const LinearMapR4&);
-inline LinearMapR4 operator- (const LinearMapR4&);
-inline LinearMapR4 operator- (const LinearMapR4&, const LinearMapR4&);
-inline LinearMapR4 operator* ( const LinearMapR4&, double);
-inline LinearMapR4 operator* ( double, const LinearMapR4& );
-inline LinearMapR4 operator/ ( const LinearMapR4&, double );
-inline LinearMapR4 operator* ( const Matrix4x4&, const LinearMapR4& ); 
-inline LinearMapR4 operator* ( const LinearMapR4&, const Matrix4x4& ); 
+template<class T> inline LinearMapR4T<T> operator+ (const LinearMapR4T<T>&, const LinearMapR4T<T>&);
+template<class T> inline LinearMapR4T<T> operator- (const LinearMapR4T<T>&);
+template<class T> inline LinearMapR4T<T> operator- (const LinearMapR4T<T>&, const LinearMapR4T<T>&);
+template<class T> inline LinearMapR4T<T> operator* ( const LinearMapR4T<T>&, typename LinearScalar<T>::Type);
+template<class T> inline LinearMapR4T<T> operator* ( typename LinearScalar<T>::Type, const LinearMapR4T<T>& );
+template<class T> inline LinearMapR4T<T> operator/ ( const LinearMapR4T<T>&, typename LinearScalar<T>::Type );
+template<class T> inline LinearMapR4T<T> operator* ( const Matrix4x4T<T>&, const LinearMapR4T<T>& ); 
+template<class T> inline LinearMapR4T<T> operator* ( const LinearMapR4T<T>&, const Matrix4x4T<T>& ); 
 								// Matrix product (composition)
 
 
@@ -323,8 +344,8 @@ inline RotationMapR4 operator* ( const RotationMapR4&, const RotationMapR4& );
 
 // Returns the angle between vectors u and v.
 //		Use SolidAngleUnit if both vectors are unit vectors
-inline double SolidAngle( const VectorR4& u, const VectorR4& v);
-inline double SolidAngleUnit( const VectorR4 u, const VectorR4 v );
+template<class T> inline T SolidAngle( const VectorR4T<T>& u, const VectorR4T<T>& v);
+template<class T> inline T SolidAngleUnit( const VectorR4T<T> u, const VectorR4T<T> v );
 
 // Returns a righthanded orthonormal basis to complement vectors u,v,w.
 //		The vectors u,v,w must be unit and orthonormal.
@@ -336,30 +357,33 @@ void GetOrtho( int j, RotationMapR4& rotmap);	// Mainly for internal use
 
 // Projections
 
-inline VectorR4 ProjectToUnit ( const VectorR4& u, const VectorR4& v); 
+template<class T> inline VectorR4T<T> ProjectToUnit ( const VectorR4T<T>& u, const VectorR4T<T>& v); 
 			// Project u onto v
-inline VectorR4 ProjectPerpUnit ( const VectorR4& u, const VectorR4 & v); 
+template<class T> inline VectorR4T<T> ProjectPerpUnit ( const VectorR4T<T>& u, const VectorR4T<T> & v); 
 			// Project perp to v
-inline VectorR4 ProjectPerpUnitDiff ( const VectorR4& u, const VectorR4& v);
+template<class T> inline VectorR4T<T> ProjectPerpUnitDiff ( const VectorR4T<T>& u, const VectorR4T<T>& v);
 // v must be a unit vector.
 
 // Returns the projection of u onto unit v
-inline VectorR4 ProjectToUnit ( const VectorR4& u, const VectorR4& v)
+template<class T>
+inline VectorR4T<T> ProjectToUnit ( const VectorR4T<T>& u, const VectorR4T<T>& v)
 {
 	return (u^v)*v;
 }
 
 // Returns the projection of u onto the plane perpindicular to the unit vector v
-inline VectorR4 ProjectPerpUnit ( const VectorR4& u, const VectorR4& v)
+template<class T>
+inline VectorR4T<T> ProjectPerpUnit ( const VectorR4T<T>& u, const VectorR4T<T>& v)
 {
 	return ( u - ((u^v)*v) );
 }
 
 // Returns the projection of u onto the plane perpindicular to the unit vector v
 //    This one is more stable when u and v are nearly equal.
-inline VectorR4 ProjectPerpUnitDiff ( const VectorR4& u, const VectorR4& v)
+template<class T>
+inline VectorR4T<T> ProjectPerpUnitDiff ( const VectorR4T<T>& u, const VectorR4T<T>& v)
 {
-	VectorR4 ans = u;
+	VectorR4T<T> ans = u;
 	ans -= v;
 	ans -= ((ans^v)*v);
 	return ans;				// ans = (u-v) - ((u-v)^v)*v
@@ -371,36 +395,38 @@ inline VectorR4 ProjectPerpUnitDiff ( const VectorR4& u, const VectorR4& v)
 // VectorProjectMap returns map projecting onto a given vector u.
 //		u should be a unit vector (otherwise the returned map is
 //		scaled according to the magnitude of u.
-inline void VectorProjectMap( const VectorR4& u, LinearMapR4& M )
-{
-	double a = u.x*u.y;
-	double b = u.x*u.z;
-	double c = u.x*u.w;
-	double d = u.y*u.z;
-	double e = u.y*u.w;
-	double f = u.z*u.w;
+template<class T>
+inline void VectorProjectMap( const VectorR4T<T>& u, LinearMapR4T<T>& M )
+{
+	T a = u.x*u.y;
+	T b = u.x*u.z;
+	T c = u.x*u.w;
+	T d = u.y*u.z;
+	T e = u.y*u.w;
+	T f = u.z*u.w;
 	M.Set( u.x*u.x,     a,     b,		 c,
 			  a,    u.y*u.y,   d,        e,
 		 	  b,        d,   u.z*u.z,    f,
 			  c,        e,     f,     u.w*u.w );
 }
 
-inline LinearMapR4 VectorProjectMap( const VectorR4& u )
+template<class T>
+inline LinearMapR4T<T> VectorProjectMap( const VectorR4T<T>& u )
 {
-	LinearMapR4 result;
+	LinearMapR4T<T> result;
 	VectorProjectMap( u, result );
 	return result;
 }
 
-inline LinearMapR4 PerpProjectMap ( const VectorR4& u );
+template<class T> inline LinearMapR4T<T> PerpProjectMap ( const VectorR4T<T>& u );
 // u - must be unit vector.  
 
 LinearMapR4 TimesTranspose( const VectorR4& u, const VectorR4& v); // u * v^T.
-inline void TimesTranspose( const VectorR4& u, const VectorR4& v, LinearMapR4& M);
+template<class T> inline void TimesTranspose( const VectorR4T<T>& u, const VectorR4T<T>& v, LinearMapR4T<T>& M);
 
 // Rotation Maps
 
-RotationMapR4 RotateToMap( const VectorR4& fromVec, const VectorR4& toVec);
+template<class T> RotationMapR4 RotateToMap( const VectorR4T<T>& fromVec, const VectorR4T<T>& toVec);
 // fromVec and toVec should be unit vectors
 
 
@@ -409,14 +435,17 @@ RotationMapR4 RotateToMap( const VectorR4& fromVec, const VectorR4& toVec);
 // * Stream Output Routines	(Prototypes)						 *
 // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
-ostream& operator<< ( ostream& os, const VectorR4& u );
+template<class T> ostream& operator<< ( ostream& os, const VectorR4T<T>& u );
 
 
 // *****************************************************
 // * VectorR4 class - inlined functions				   *
 // * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
-inline VectorR4& VectorR4::Load( const double* v ) 
+template<class T> const VectorR4T<T> VectorR4T<T>::Zero;
+
+template<class T>
+inline VectorR4T<T>& VectorR4T<T>::Load( const double* v ) 
 {
 	x = *v; 
 	y = *(v+1);
@@ -425,7 +454,8 @@ inline VectorR4& VectorR4::Load( const double* v )
 	return *this;
 }
 
-inline VectorR4& VectorR4::Load( const float* v ) 
+template<class T>
+inline VectorR4T<T>& VectorR4T<T>::Load( const float* v ) 
 {
 	x = *v; 
 	y = *(v+1);
@@ -434,7 +464,8 @@ inline VectorR4& VectorR4::Load( const float* v )
 	return *this;
 }
 
-inline 	void VectorR4::Dump( double* v ) const
+template<class T>
+inline 	void VectorR4T<T>::Dump( double* v ) const
 {
 	*v = x; 
 	*(v+1) = y;
@@ -442,7 +473,8 @@ inline 	void VectorR4::Dump( double* v ) const
 	*(v+3) = w;
 }
 
-inline 	void VectorR4::Dump( float* v ) const
+template<class T>
+inline 	void VectorR4T<T>::Dump( float* v ) const
 {
 	*v = (float)x; 
 	*(v+1) = (float)y;
@@ -450,53 +482,63 @@ inline 	void VectorR4::Dump( float* v ) const
 	*(v+3) = (float)w;
 }
 
-inline VectorR4& VectorR4::MakeUnit ()			// Convert to unit vector (or leave zero).
+template<class T>
+inline VectorR4T<T>& VectorR4T<T>::MakeUnit ()			// Convert to unit vector (or leave zero).
 {
-	double nSq = NormSq();
+	T nSq = NormSq();
 	if (nSq != 0.0) {
 		*this /= sqrt(nSq);
 	}
 	return *this;
 }
 
-inline VectorR4 operator+( const VectorR4& u, const VectorR4& v ) 
+template<class T>
+inline VectorR4T<T> operator+( const VectorR4T<T>& u, const VectorR4T<T>& v ) 
 { 
-	return VectorR4(u.x+v.x, u.y+v.y, u.z+v.z, u.w+v.w ); 
+	return VectorR4T<T>(u.x+v.x, u.y+v.y, u.z+v.z, u.w+v.w ); 
 }
-inline VectorR4 operator-( const VectorR4& u, const VectorR4& v ) 
+template<class T>
+inline VectorR4T<T> operator-( const VectorR4T<T>& u, const VectorR4T<T>& v ) 
 { 
-	return VectorR4(u.x-v.x, u.y-v.y, u.z-v.z, u.w-v.w); 
+	return VectorR4T<T>(u.x-v.x, u.y-v.y, u.z-v.z, u.w-v.w); 
 }
-inline VectorR4 operator*( const VectorR4& u, register double m) 
+template<class T>
+inline VectorR4T<T> operator*( const VectorR4T<T>& u, typename LinearScalar<T>::Type m) 
 { 
-	return VectorR4( u.x*m, u.y*m, u.z*m, u.w*m ); 
+	return VectorR4T<T>( u.x*m, u.y*m, u.z*m, u.w*m ); 
 }
-inline VectorR4 operator*( register double m, const VectorR4& u) 
+template<class T>
+inline VectorR4T<T> operator*( typename LinearScalar<T>::Type m, const VectorR4T<T>& u) 
 { 
-	return VectorR4( u.x*m, u.y*m, u.z*m, u.w*m ); 
+	return VectorR4T<T>( u.x*m, u.y*m, u.z*m, u.w*m ); 
 }
-inline VectorR4 operator/( const VectorR4& u, double m) 
+template<class T>
+inline VectorR4T<T> operator/( const VectorR4T<T>& u, typename LinearScalar<T>::Type m) 
 { 
-	register double mInv = 1.0/m;
-	return VectorR4( u.x*mInv, u.y*mInv, u.z*mInv, u.w*mInv ); 
+	T mInv = 1.0/m;
+	return VectorR4T<T>( u.x*mInv, u.y*mInv, u.z*mInv, u.w*mInv ); 
 }
 
-inline bool operator==( const VectorR4& u, const VectorR4& v ) 
+template<class T>
+inline bool operator==( const VectorR4T<T>& u, const VectorR4T<T>& v ) 
 {
 	return ( u.x==v.x && u.y==v.y && u.z==v.z && u.w==v.w );
 }
 
-inline double operator^ ( const VectorR4& u, const VectorR4& v ) // Dot Product
+template<class T>
+inline T operator^ ( const VectorR4T<T>& u, const VectorR4T<T>& v ) // Dot Product
 { 
 	return ( u.x*v.x + u.y*v.y + u.z*v.z + u.w*v.w ); 
 }
 
-inline VectorR4 ArrayProd ( const VectorR4& u, const VectorR4& v )
+template<class T>
+inline VectorR4T<T> ArrayProd ( const VectorR4T<T>& u, const VectorR4T<T>& v )
 {
-	return ( VectorR4( u.x*v.x, u.y*v.y, u.z*v.z, u.w*v.w ) );
+	return ( VectorR4T<T>( u.x*v.x, u.y*v.y, u.z*v.z, u.w*v.w ) );
 }
 
-inline VectorR4& VectorR4::ArrayProd (const VectorR4& v)		// Component-wise Product
+template<class T>
+inline VectorR4T<T>& VectorR4T<T>::ArrayProd (const VectorR4T<T>& v)		// Component-wise Product
 {
 	x *= v.x;
 	y *= v.y;
@@ -505,7 +547,8 @@ inline VectorR4& VectorR4::ArrayProd (const VectorR4& v)		// Component-wise Prod
 	return ( *this );
 }
 
-inline VectorR4& VectorR4::ArrayProd3 (const VectorR3& v)		// Component-wise Product
+template<class T>
+inline VectorR4T<T>& VectorR4T<T>::ArrayProd3 (const VectorR3T<T>& v)		// Component-wise Product
 {
 	x *= v.x;
 	y *= v.y;
@@ -513,7 +556,8 @@ inline VectorR4& VectorR4::ArrayProd3 (const VectorR3& v)		// Component-wise Pro
 	return ( *this );
 }
 
-inline VectorR4& VectorR4::AddScaled( const VectorR4& u, double s ) 
+template<class T>
+inline VectorR4T<T>& VectorR4T<T>::AddScaled( const VectorR4T<T>& u, T s ) 
 {
 	x += s*u.x;
 	y += s*u.y;
@@ -522,17 +566,19 @@ inline VectorR4& VectorR4::AddScaled( const VectorR4& u, double s )
 	return(*this);
 }
 
-inline VectorR4& VectorR4::ReNormalize()			// Convert near unit back to unit
+template<class T>
+inline VectorR4T<T>& VectorR4T<T>::ReNormalize()			// Convert near unit back to unit
 {
-	double nSq = NormSq();
-	register double mFact = 1.0-0.5*(nSq-1.0);	// Multiplicative factor
+	T nSq = NormSq();
+	T mFact = 1.0-0.5*(nSq-1.0);	// Multiplicative factor
 	*this *= mFact;
 	return *this;
 }
 
-inline double NormalizeError (const VectorR4& u)
+template<class T>
+inline T NormalizeError (const VectorR4T<T>& u)
 {
-	register double discrepancy;
+	T discrepancy;
 	discrepancy = u.x*u.x + u.y*u.y + u.z*u.z + u.w*u.w - 1.0;
 	if ( discrepancy < 0.0 ) {
 		discrepancy = -discrepancy;
@@ -540,33 +586,82 @@ inline double NormalizeError (const VectorR4& u)
 	return discrepancy;
 }
 
-inline VectorR3& VectorR3::SetFromHg(const VectorR4& v) {
-	double wInv = 1.0/v.w;
+template<class T>
+inline VectorR3T<T>& VectorR3T<T>::SetFromHg(const VectorR4T<T>& v) {
+	T wInv = 1.0/v.w;
 	x = v.x*wInv;
 	y = v.y*wInv;
 	z = v.z*wInv;
 	return *this;
 }
 
-inline double VectorR4::Dist( const VectorR4& u ) const 	// Distance from u
+template<class T>
+inline T VectorR4T<T>::Dist( const VectorR4T<T>& u ) const 	// Distance from u
 {
 	return sqrt( DistSq(u) );
 }
 
-inline double VectorR4::DistSq( const VectorR4& u ) const	// Distance from u
+template<class T>
+inline T VectorR4T<T>::DistSq( const VectorR4T<T>& u ) const	// Distance from u
 {
 	return ( (x-u.x)*(x-u.x) + (y-u.y)*(y-u.y) + (z-u.z)*(z-u.z) + (w-u.w)*(w-u.w) );
 }
 
 
+template<class T>
+T VectorR4T<T>::MaxAbs() const
+{
+	T m;
+	m = (x>0.0) ? x : -x;
+	if ( y>m ) m=y;
+	else if ( -y >m ) m = -y;
+	if ( z>m ) m=z;
+	else if ( -z>m ) m = -z;
+	if ( w>m ) m=w;
+	else if ( -w>m ) m = -w;
+	return m;
+}
+
+// *********************************************************************
+// Rotation routines												   *
+// *********************************************************************
+
+// Rotate unit vector x in the direction of "dir": length of dir is rotation angle.
+//		x must be a unit vector.  dir must be perpindicular to x.
+template<class T>
+VectorR4T<T>& VectorR4T<T>::RotateUnitInDirection ( const VectorR4T<T>& dir)
+{	
+	assert ( this->Norm()<1.0001 && this->Norm()>0.9999 &&
+				(dir^(*this))<0.0001 && (dir^(*this))>-0.0001 );
+
+	T theta = dir.NormSq();
+	if ( theta==0.0 ) {
+		return *this;
+	}
+	else {
+		theta = sqrt(theta);
+		T costheta = cos(theta);
+		T sintheta = sin(theta);
+		VectorR4T<T> dirUnit = dir/theta;
+		*this = costheta*(*this) + sintheta*dirUnit;
+		// this->NormalizeFast();
+		return ( *this );
+	}
+}
+
+
 // *********************************************************
 // * Matrix4x4 class - inlined functions				   *
 // * * * * * * * * * * * * * * * * * * * * * * * * * * *****
 
-inline Matrix4x4::Matrix4x4() {}
+template<class T> const Matrix4x4T<T> Matrix4x4T<T>::Identity(1.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0,
+												  0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 0.0, 1.0);
 
-inline Matrix4x4::Matrix4x4( const VectorR4& u, const VectorR4& v, 
-							 const VectorR4& s, const VectorR4& t)
+template<class T> inline Matrix4x4T<T>::Matrix4x4T() {}
+
+template<class T>
+inline Matrix4x4T<T>::Matrix4x4T( const VectorR4T<T>& u, const VectorR4T<T>& v, 
+							 const VectorR4T<T>& s, const VectorR4T<T>& t)
 {
 	m11 = u.x;		// Column 1
 	m21 = u.y;
@@ -586,10 +681,11 @@ inline Matrix4x4::Matrix4x4( const VectorR4& u, const VectorR4& v,
 	m44 = t.w;
 }
 
-inline Matrix4x4::Matrix4x4( double a11, double a21, double a31, double a41,
-							 double a12, double a22, double a32, double a42,
-							 double a13, double a23, double a33, double a43,
-							 double a14, double a24, double a34, double a44)
+template<class T>
+inline Matrix4x4T<T>::Matrix4x4T( T a11, T a21, T a31, T a41,
+							 T a12, T a22, T a32, T a42,
+							 T a13, T a23, T a33, T a43,
+							 T a14, T a24, T a34, T a44)
 					// Values specified in column order!!!
 {
 	m11 = a11;		// Row 1
@@ -611,20 +707,23 @@ inline Matrix4x4::Matrix4x4( double a11, double a21, double a31, double a41,
 }
 
 /*
-inline Matrix4x4::Matrix4x4 ( const Matrix4x4& A)
+template<class T>
+inline Matrix4x4T<T>::Matrix4x4T ( const Matrix4x4T<T>& A)
 	: m11(A.m11), m12(A.m12), m13(A.m13), m14(A.m14),
 	  m21(A.m21), m22(A.m22), m23(A.m23), m24(A.m24),
 	  m31(A.m31), m32(A.m32), m33(A.m33), m34(A.m34),
 	  m41(A.m41), m42(A.m42), m43(A.m43), m44(A.m44) {} */
 
-inline void Matrix4x4::SetIdentity ( )
+template<class T>
+inline void Matrix4x4T<T>::SetIdentity ( )
 {
 	m11 = m22 = m33 = m44 = 1.0;
 	m12 = m13 = m14 = m21 = m23 = m24 = m31 = m32 = m34 = m41= m42 = m43 = 0.0;
 }
 
-inline void Matrix4x4::Set( const VectorR4& u, const VectorR4& v, 
-							 const VectorR4& s, const VectorR4& t )
+template<class T>
+inline void Matrix4x4T<T>::Set( const VectorR4T<T>& u, const VectorR4T<T>& v, 
+							 const VectorR4T<T>& s, const VectorR4T<T>& t )
 {
 	m11 = u.x;		// Column 1
 	m21 = u.y;
@@ -644,10 +743,11 @@ inline void Matrix4x4::Set( const VectorR4& u, const VectorR4& v,
 	m44 = t.w;
 }
 
-inline void Matrix4x4::Set( double a11, double a21, double a31, double a41,
-							 double a12, double a22, double a32, double a42,
-							 double a13, double a23, double a33, double a43,
-							 double a14, double a24, double a34, double a44)
+template<class T>
+inline void Matrix4x4T<T>::Set( T a11, T a21, T a31, T a41,
+							 T a12, T a22, T a32, T a42,
+							 T a13, T a23, T a33, T a43,
+							 T a14, T a24, T a34, T a44)
 					// Values specified in column order!!!
 {
 	m11 = a11;		// Row 1
@@ -668,7 +768,8 @@ inline void Matrix4x4::Set( double a11, double a21, double a31, double a41,
 	m44 = a44;
 }
 	
-inline void Matrix4x4::Set ( const Matrix4x4& M )	// Set to the matrix.
+template<class T>
+inline void Matrix4x4T<T>::Set ( const Matrix4x4T<T>& M )	// Set to the matrix.
 {
 	m11 = M.m11;
 	m12 = M.m12;
@@ -688,14 +789,16 @@ inline void Matrix4x4::Set ( const Matrix4x4& M )	// Set to the matrix.
 	m44 = M.m44;
 }
 
-inline void Matrix4x4::SetZero( ) 
+template<class T>
+inline void Matrix4x4T<T>::SetZero( ) 
 {
 	m11 = m12 = m13 = m14 = m21 = m22 = m23 = m24 
 		= m31 = m32 = m33 = m34 = m41 = m42 = m43 = m44 = 0.0;
 }
 
-inline void Matrix4x4::SetByRows( const VectorR4& u, const VectorR4& v, 
-							 const VectorR4& s, const VectorR4& t )
+template<class T>
+inline void Matrix4x4T<T>::SetByRows( const VectorR4T<T>& u, const VectorR4T<T>& v, 
+							 const VectorR4T<T>& s, const VectorR4T<T>& t )
 {
 	m11 = u.x;		// Row 1
 	m12 = u.y;
@@ -715,10 +818,11 @@ inline void Matrix4x4::SetByRows( const VectorR4& u, const VectorR4& v,
 	m44 = t.w;
 }
 
-inline void Matrix4x4::SetByRows( double a11, double a12, double a13, double a14, 
-							 double a21, double a22, double a23, double a24,
-							 double a31, double a32, double a33, double a34,
-							 double a41, double a42, double a43, double a44 )
+template<class T>
+inline void Matrix4x4T<T>::SetByRows( T a11, T a12, T a13, T a14, 
+							 T a21, T a22, T a23, T a24,
+							 T a31, T a32, T a33, T a34,
+							 T a41, T a42, T a43, T a44 )
 					// Values specified in row order!!!
 {
 	m11 = a11;		// Row 1
@@ -739,67 +843,80 @@ inline void Matrix4x4::SetByRows( double a11, double a12, double a13, double a14
 	m44 = a44;
 }
 
-inline void Matrix4x4::SetColumn1 ( double x, double y, double z, double w)
+template<class T>
+inline void Matrix4x4T<T>::SetColumn1 ( T x, T y, T z, T w)
 {
 	m11 = x; m21 = y; m31= z; m41 = w;
 }
 
-inline void Matrix4x4::SetColumn2 ( double x, double y, double z, double w)
+template<class T>
+inline void Matrix4x4T<T>::SetColumn2 ( T x, T y, T z, T w)
 {
 	m12 = x; m22 = y; m32= z; m42 = w;
 }
 
-inline void Matrix4x4::SetColumn3 ( double x, double y, double z, double w)
+template<class T>
+inline void Matrix4x4T<T>::SetColumn3 ( T x, T y, T z, T w)
 {
 	m13 = x; m23 = y; m33= z; m43 = w;
 }
 
-inline void Matrix4x4::SetColumn4 ( double x, double y, double z, double w)
+template<class T>
+inline void Matrix4x4T<T>::SetColumn4 ( T x, T y, T z, T w)
 {
 	m14 = x; m24 = y; m34= z; m44 = w;
 }
 
-inline void Matrix4x4::SetColumn1 ( const VectorR4& u )
+template<class T>
+inline void Matrix4x4T<T>::SetColumn1 ( const VectorR4T<T>& u )
 {
 	m11 = u.x; m21 = u.y; m31 = u.z; m41 = u.w;
 }
 
-inline void Matrix4x4::SetColumn2 ( const VectorR4& u )
+template<class T>
+inline void Matrix4x4T<T>::SetColumn2 ( const VectorR4T<T>& u )
 {
 	m12 = u.x; m22 = u.y; m32 = u.z; m42 = u.w;
 }
 
-inline void Matrix4x4::SetColumn3 ( const VectorR4& u )
+template<class T>
+inline void Matrix4x4T<T>::SetColumn3 ( const VectorR4T<T>& u )
 {
 	m13 = u.x; m23 = u.y; m33 = u.z; m43 = u.w;
 }
 
-inline void Matrix4x4::SetColumn4 ( const VectorR4& u )
+template<class T>
+inline void Matrix4x4T<T>::SetColumn4 ( const VectorR4T<T>& u )
 {
 	m14 = u.x; m24 = u.y; m34 = u.z; m44 = u.w;
 }
 
-VectorR4 Matrix4x4::Column1() const
+template<class T>
+VectorR4T<T> Matrix4x4T<T>::Column1() const
 {
-	return ( VectorR4(m11, m21, m31, m41) );
+	return ( VectorR4T<T>(m11, m21, m31, m41) );
 }
 
-VectorR4 Matrix4x4::Column2() const
+template<class T>
+VectorR4T<T> Matrix4x4T<T>::Column2() const
 {
-	return ( VectorR4(m12, m22, m32, m42) );
+	return ( VectorR4T<T>(m12, m22, m32, m42) );
 }
 
-VectorR4 Matrix4x4::Column3() const
+template<class T>
+VectorR4T<T> Matrix4x4T<T>::Column3() const
 {
-	return ( VectorR4(m13, m23, m33, m43) );
+	return ( VectorR4T<T>(m13, m23, m33, m43) );
 }
 
-VectorR4 Matrix4x4::Column4() const
+template<class T>
+VectorR4T<T> Matrix4x4T<T>::Column4() const
 {
-	return ( VectorR4(m14, m24, m34, m44) );
+	return ( VectorR4T<T>(m14, m24, m34, m44) );
 }
 
-void Matrix4x4::DumpByColumns(float* ret) const
+template<class T>
+void Matrix4x4T<T>::DumpByColumns(float* ret) const
 {
 	*ret =     (float)m11;
 	*(++ret) = (float)m21;
@@ -819,8 +936,9 @@ void Matrix4x4::DumpByColumns(float* ret) const
 	*(++ret) = (float)m44;
 }
 
-inline void Matrix4x4::SetDiagonal( double x, double y, 
-								    double z, double w)
+template<class T>
+inline void Matrix4x4T<T>::SetDiagonal( T x, T y, 
+								    T z, T w)
 {
 	m11 = x;
 	m22 = y;
@@ -828,12 +946,14 @@ inline void Matrix4x4::SetDiagonal( double x, double y,
 	m44 = w;
 }
 
-inline void Matrix4x4::SetDiagonal( const VectorR4& u )
+template<class T>
+inline void Matrix4x4T<T>::SetDiagonal( const VectorR4T<T>& u )
 {
 	SetDiagonal ( u.x, u.y, u.z, u.w );
 }
 
-inline double Matrix4x4::Diagonal( int i ) 
+template<class T>
+inline T Matrix4x4T<T>::Diagonal( int i ) 
 {
 	switch (i) {
 	case 0:
@@ -850,9 +970,10 @@ inline double Matrix4x4::Diagonal( int i )
 	}
 }
 
-inline void Matrix4x4::MakeTranspose()	// Transposes it.
+template<class T>
+inline void Matrix4x4T<T>::MakeTranspose()	// Transposes it.
 {
-	register double temp;
+	T temp;
 	temp = m12;
 	m12 = m21;
 	m21=temp;
@@ -873,9 +994,10 @@ inline void Matrix4x4::MakeTranspose()	// Transposes it.
 	m43 = temp;
 }
 
-inline VectorR4 operator* ( const Matrix4x4& A, const VectorR4& u)
+template<class T>
+inline VectorR4T<T> operator* ( const Matrix4x4T<T>& A, const VectorR4T<T>& u)
 {
-	VectorR4 ret;
+	VectorR4T<T> ret;
 	ret.x = A.m11*u.x + A.m12*u.y + A.m13*u.z + A.m14*u.w;
 	ret.y = A.m21*u.x + A.m22*u.y + A.m23*u.z + A.m24*u.w;
 	ret.z = A.m31*u.x + A.m32*u.y + A.m33*u.z + A.m34*u.w;
@@ -884,37 +1006,136 @@ inline VectorR4 operator* ( const Matrix4x4& A, const VectorR4& u)
 }
 
 
+
+
+template<class T>
+void Matrix4x4T<T>::operator*= (const Matrix4x4T<T>& B)	// Matrix product
+{
+	T t1, t2, t3;		// temporary values
+	t1 =  m11*B.m11 + m12*B.m21 + m13*B.m31 + m14*B.m41;
+	t2 =  m11*B.m12 + m12*B.m22 + m13*B.m32 + m14*B.m42;
+	t3 =  m11*B.m13 + m12*B.m23 + m13*B.m33 + m14*B.m43;
+	m14 = m11*B.m14 + m12*B.m24 + m13*B.m34 + m14*B.m44;
+	m11 = t1;
+	m12 = t2;
+	m13 = t3;
+
+	t1 =  m21*B.m11 + m22*B.m21 + m23*B.m31 + m24*B.m41;
+	t2 =  m21*B.m12 + m22*B.m22 + m23*B.m32 + m24*B.m42;
+	t3 =  m21*B.m13 + m22*B.m23 + m23*B.m33 + m24*B.m43;
+	m24 = m21*B.m14 + m22*B.m24 + m23*B.m34 + m24*B.m44;
+	m21 = t1;
+	m22 = t2;
+	m23 = t3;
+
+	t1 =  m31*B.m11 + m32*B.m21 + m33*B.m31 + m34*B.m41;
+	t2 =  m31*B.m12 + m32*B.m22 + m33*B.m32 + m34*B.m42;
+	t3 =  m31*B.m13 + m32*B.m23 + m33*B.m33 + m34*B.m43;
+	m34 = m31*B.m14 + m32*B.m24 + m33*B.m34 + m34*B.m44;
+	m31 = t1;
+	m32 = t2;
+	m33 = t3;
+
+	t1 =  m41*B.m11 + m42*B.m21 + m43*B.m31 + m44*B.m41;
+	t2 =  m41*B.m12 + m42*B.m22 + m43*B.m32 + m44*B.m42;
+	t3 =  m41*B.m13 + m42*B.m23 + m43*B.m33 + m44*B.m43;
+	m44 = m41*B.m14 + m42*B.m24 + m43*B.m34 + m44*B.m44;
+	m41 = t1;
+	m42 = t2;
+	m43 = t3;
+}
+
+template<class T>
+inline void ReNormalizeHelper ( T &a, T &b, T &c, T &d )
+{
+	T scaleF = a*a+b*b+c*c+d*d;		// Inner product of Vector-R4
+	scaleF = 1.0-0.5*(scaleF-1.0);
+	a *= scaleF;
+	b *= scaleF;
+	c *= scaleF;
+	d *= scaleF;
+}
+
+template<class T>
+Matrix4x4T<T>& Matrix4x4T<T>::ReNormalize() {
+	ReNormalizeHelper( m11, m21, m31, m41 );	// Renormalize first column
+	ReNormalizeHelper( m12, m22, m32, m42 );	// Renormalize second column
+	ReNormalizeHelper( m13, m23, m33, m43 );	// Renormalize third column
+	ReNormalizeHelper( m14, m24, m34, m44 );	// Renormalize fourth column
+	T alpha = 0.5*(m11*m12 + m21*m22 + m31*m32 + m41*m42);	//1st and 2nd cols
+	T beta  = 0.5*(m11*m13 + m21*m23 + m31*m33 + m41*m43);	//1st and 3rd cols
+	T gamma = 0.5*(m11*m14 + m21*m24 + m31*m34 + m41*m44);	//1st and 4nd cols
+	T delta = 0.5*(m12*m13 + m22*m23 + m32*m33 + m42*m43);	//2nd and 3rd cols
+	T eps   = 0.5*(m12*m14 + m22*m24 + m32*m34 + m42*m44);	//2nd and 4nd cols
+	T phi   = 0.5*(m13*m14 + m23*m24 + m33*m34 + m43*m44);	//3rd and 4nd cols
+	T temp1, temp2, temp3;
+	temp1 = m11 - alpha*m12 - beta*m13 - gamma*m14;
+	temp2 = m12 - alpha*m11 - delta*m13 - eps*m14;
+	temp3 = m13 - beta*m11 - delta*m12 - phi*m14;
+	m14 -= (gamma*m11 + eps*m12 + phi*m13);
+	m11 = temp1;
+	m12 = temp2;
+	m13 = temp3;
+	temp1 = m21 - alpha*m22 - beta*m23 - gamma*m24;
+	temp2 = m22 - alpha*m21 - delta*m23 - eps*m24;
+	temp3 = m23 - beta*m21 - delta*m22 - phi*m24;
+	m24 -= (gamma*m21 + eps*m22 + phi*m23);
+	m21 = temp1;
+	m22 = temp2;
+	m23 = temp3;
+	temp1 = m31 - alpha*m32 - beta*m33 - gamma*m34;
+	temp2 = m32 - alpha*m31 - delta*m33 - eps*m34;
+	temp3 = m33 - beta*m31 - delta*m32 - phi*m34;
+	m34 -= (gamma*m31 + eps*m32 + phi*m33);
+	m31 = temp1;
+	m32 = temp2;
+	m33 = temp3;
+	temp1 = m41 - alpha*m42 - beta*m43 - gamma*m44;
+	temp2 = m42 - alpha*m41 - delta*m43 - eps*m44;
+	temp3 = m43 - beta*m41 - delta*m42 - phi*m44;
+	m44 -= (gamma*m41 + eps*m42 + phi*m43);
+	m41 = temp1;
+	m42 = temp2;
+	m43 = temp3;
+	return *this;
+}
+
 // ******************************************************
 // * LinearMapR4 class - inlined functions				*
 // * * * * * * * * * * * * * * * * * * * * * * * * * * **
 
-inline LinearMapR4::LinearMapR4()
+template<class T>
+inline LinearMapR4T<T>::LinearMapR4T()
 {
-	SetZero();
+	this->SetZero();
 	return;
 }	
 
-inline LinearMapR4::LinearMapR4( const VectorR4& u, const VectorR4& v, 
-							 const VectorR4& s, const VectorR4& t)
-:Matrix4x4 ( u, v, s ,t )
+template<class T>
+inline LinearMapR4T<T>::LinearMapR4T( const VectorR4T<T>& u, const VectorR4T<T>& v, 
+							 const VectorR4T<T>& s, const VectorR4T<T>& t)
+:Matrix4x4T<T> ( u, v, s ,t )
 { }
 
-inline LinearMapR4::LinearMapR4( 
-							 double a11, double a21, double a31, double a41,
-							 double a12, double a22, double a32, double a42,
-							 double a13, double a23, double a33, double a43,
-							 double a14, double a24, double a34, double a44)
+template<class T>
+inline LinearMapR4T<T>::LinearMapR4T( 
+							 T a11, T a21, T a31, T a41,
+							 T a12, T a22, T a32, T a42,
+							 T a13, T a23, T a33, T a43,
+							 T a14, T a24, T a34, T a44)
 					// Values specified in column order!!!
-:Matrix4x4 ( a11, a21, a31, a41, a12, a22, a32, a42,
+:Matrix4x4T<T> ( a11, a21, a31, a41, a12, a22, a32, a42,
 			 a13, a23, a33, a43, a14, a24, a34, a44 )
 { }
 
-inline LinearMapR4::LinearMapR4 ( const Matrix4x4& A )
-: Matrix4x4 (A) 
+template<class T>
+inline LinearMapR4T<T>::LinearMapR4T ( const Matrix4x4T<T>& A )
+: Matrix4x4T<T> (A) 
 {}
 
 	
-inline LinearMapR4& LinearMapR4::operator+= (const LinearMapR4& B)
+template<class T>
+inline LinearMapR4T<T>& LinearMapR4T<T>::operator+= (const LinearMapR4T<T>& B)
 {
 	m11 += B.m11;
 	m12 += B.m12;
@@ -935,7 +1156,8 @@ inline LinearMapR4& LinearMapR4::operator+= (const LinearMapR4& B)
 	return ( *this );
 }
 
-inline LinearMapR4& LinearMapR4::operator-= (const LinearMapR4& B)
+template<class T>
+inline LinearMapR4T<T>& LinearMapR4T<T>::operator-= (const LinearMapR4T<T>& B)
 {
 	m11 -= B.m11;
 	m12 -= B.m12;
@@ -956,31 +1178,35 @@ inline LinearMapR4& LinearMapR4::operator-= (const LinearMapR4& B)
 	return( *this );
 }
 
-inline LinearMapR4 operator+ (const LinearMapR4& A, const LinearMapR4& B)
+template<class T>
+inline LinearMapR4T<T> operator+ (const LinearMapR4T<T>& A, const LinearMapR4T<T>& B)
 {
-	return( LinearMapR4( A.m11+B.m11, A.m21+B.m21, A.m31+B.m31, A.m41+B.m41,
+	return( LinearMapR4T<T>( A.m11+B.m11, A.m21+B.m21, A.m31+B.m31, A.m41+B.m41,
 						 A.m12+B.m12, A.m22+B.m22, A.m32+B.m32, A.m42+B.m42,
 						 A.m13+B.m13, A.m23+B.m23, A.m33+B.m33, A.m43+B.m43,
 						 A.m14+B.m14, A.m24+B.m24, A.m34+B.m34, A.m44+B.m44) );
 }
 
-inline LinearMapR4 operator- (const LinearMapR4& A)
+template<class T>
+inline LinearMapR4T<T> operator- (const LinearMapR4T<T>& A)
 {
-	return( LinearMapR4( -A.m11, -A.m21, -A.m31, -A.m41,
+	return( LinearMapR4T<T>( -A.m11, -A.m21, -A.m31, -A.m41,
 						 -A.m12, -A.m22, -A.m32, -A.m42,
 						 -A.m13, -A.m23, -A.m33, -A.m43,
 						 -A.m14, -A.m24, -A.m34, -A.m44 ) );
 }
 
-inline LinearMapR4 operator- (const LinearMapR4& A, const LinearMapR4& B)
+template<class T>
+inline LinearMapR4T<T> operator- (const LinearMapR4T<T>& A, const LinearMapR4T<T>& B)
 {
-	return( LinearMapR4( A.m11-B.m11, A.m21-B.m21, A.m31-B.m31, A.m41-B.m41,
+	return( LinearMapR4T<T>( A.m11-B.m11, A.m21-B.m21, A.m31-B.m31, A.m41-B.m41,
 						 A.m12-B.m12, A.m22-B.m22, A.m32-B.m32, A.m42-B.m42,
 						 A.m13-B.m13, A.m23-B.m23, A.m33-B.m33, A.m43-B.m43,
 						 A.m14-B.m14, A.m24-B.m24, A.m34-B.m34, A.m44-B.m44 ) );
 }
 
-inline LinearMapR4& LinearMapR4::operator*= (register double b)
+template<class T>
+inline LinearMapR4T<T>& LinearMapR4T<T>::operator*= (T b)
 {
 	m11 *= b;
 	m12 *= b;
@@ -1001,72 +1227,82 @@ inline LinearMapR4& LinearMapR4::operator*= (register double b)
 	return ( *this);
 }
 
-inline LinearMapR4 operator* ( const LinearMapR4& A, register double b)
+template<class T>
+inline LinearMapR4T<T> operator* ( const LinearMapR4T<T>& A, typename LinearScalar<T>::Type b)
 {
-	return( LinearMapR4( A.m11*b, A.m21*b, A.m31*b, A.m41*b,
+	return( LinearMapR4T<T>( A.m11*b, A.m21*b, A.m31*b, A.m41*b,
 						 A.m12*b, A.m22*b, A.m32*b, A.m42*b,
 						 A.m13*b, A.m23*b, A.m33*b, A.m43*b,
 						 A.m14*b, A.m24*b, A.m34*b, A.m44*b) );
 }
 
-inline LinearMapR4 operator* ( register double b, const LinearMapR4& A)
+template<class T>
+inline LinearMapR4T<T> operator* ( typename LinearScalar<T>::Type b, const LinearMapR4T<T>& A)
 {
-	return( LinearMapR4( A.m11*b, A.m21*b, A.m31*b, A.m41*b,
+	return( LinearMapR4T<T>( A.m11*b, A.m21*b, A.m31*b, A.m41*b,
 						 A.m12*b, A.m22*b, A.m32*b, A.m42*b,
 						 A.m13*b, A.m23*b, A.m33*b, A.m43*b,
 						 A.m14*b, A.m24*b, A.m34*b, A.m44*b ) );
 }
 
-inline LinearMapR4 operator/ ( const LinearMapR4& A, double b)
+template<class T>
+inline LinearMapR4T<T> operator/ ( const LinearMapR4T<T>& A, typename LinearScalar<T>::Type b)
 {
-	register double bInv = 1.0/b;
+	T bInv = 1.0/b;
 	return ( A*bInv );
 }
 
-inline LinearMapR4& LinearMapR4::operator/= (register double b)
+template<class T>
+inline LinearMapR4T<T>& LinearMapR4T<T>::operator/= (T b)
 {
-	register double bInv = 1.0/b;
+	T bInv = 1.0/b;
 	return ( *this *= bInv );
 }
 
-inline VectorR4 operator* ( const LinearMapR4& A, const VectorR4& u)
+template<class T>
+inline VectorR4T<T> operator* ( const LinearMapR4T<T>& A, const VectorR4T<T>& u)
 {
-	return(VectorR4 ( A.m11*u.x + A.m12*u.y + A.m13*u.z + A.m14*u.w,
+	return(VectorR4T<T> ( A.m11*u.x + A.m12*u.y + A.m13*u.z + A.m14*u.w,
 					  A.m21*u.x + A.m22*u.y + A.m23*u.z + A.m24*u.w,
 					  A.m31*u.x + A.m32*u.y + A.m33*u.z + A.m34*u.w,
 					  A.m41*u.x + A.m42*u.y + A.m43*u.z + A.m44*u.w ) ); 
 }
 	
-inline LinearMapR4 LinearMapR4::Transpose() const	// Returns the transpose
+template<class T>
+inline LinearMapR4T<T> LinearMapR4T<T>::Transpose() const	// Returns the transpose
 {
-	return (LinearMapR4( m11, m12, m13, m14, 
+	return (LinearMapR4T<T>( m11, m12, m13, m14, 
 						 m21, m22, m23, m24,
 						 m31, m32, m33, m34,
 						 m41, m42, m43, m44 ) );
 }
 
-inline LinearMapR4& LinearMapR4::operator*= (const Matrix4x4& B)	// Matrix product
+template<class T>
+inline LinearMapR4T<T>& LinearMapR4T<T>::operator*= (const Matrix4x4T<T>& B)	// Matrix product
 {
-	(*this).Matrix4x4::operator*=(B);
+	(*this).Matrix4x4T<T>::operator*=(B);
 
 	return( *this );
 }
 
-inline LinearMapR4 operator* ( const LinearMapR4& A, const Matrix4x4& B)
+template<class T>
+inline LinearMapR4T<T> operator* ( const LinearMapR4T<T>& A, const Matrix4x4T<T>& B)
 {
-	LinearMapR4 AA(A);
-	AA.Matrix4x4::operator*=(B);
+	LinearMapR4T<T> AA(A);
+	AA.Matrix4x4T<T>::operator*=(B);
 	return AA;
 }
 
-inline LinearMapR4 operator* ( const Matrix4x4& A, const LinearMapR4& B)
+template<class T>
+inline LinearMapR4T<T> operator* ( const Matrix4x4T<T>& A, const LinearMapR4T<T>& B)
 {
-	LinearMapR4 AA(A);
-	AA.Matrix4x4::operator*=(B);
+	LinearMapR4T<T> AA(A);
+	AA.Matrix4x4T<T>::operator*=(B);
 	return AA;
 }
 
-inline bool LinearMapR4::IsAffine() const
+template<class T>
+inline bool LinearMapR4T<T>::IsAffine() const
 {
     return m41 == 0.0 && m42 == 0.0 && m43 == 0.0 && m44 != 0.0;
 }
@@ -1077,17 +1313,20 @@ inline bool LinearMapR4::IsAffine() const
 //   The "Set" routines replace the matrix contents.
 //   All routines return the *this matrix.
 
-inline LinearMapR4& LinearMapR4::Set_glScale(double xyzScale)
+template<class T>
+inline LinearMapR4T<T>& LinearMapR4T<T>::Set_glScale(T xyzScale)
 {
 	return Set_glScale(xyzScale, xyzScale, xyzScale);
 }
 
-inline LinearMapR4& LinearMapR4::Mult_glScale(double xyzScale)
+template<class T>
+inline LinearMapR4T<T>& LinearMapR4T<T>::Mult_glScale(T xyzScale)
 {
 	return Mult_glScale(xyzScale, xyzScale, xyzScale);
 }
 
-inline LinearMapR4& LinearMapR4::Set_glScale(double xScale, double yScale, double zScale)
+template<class T>
+inline LinearMapR4T<T>& LinearMapR4T<T>::Set_glScale(T xScale, T yScale, T zScale)
 {
 	m11 = xScale;
 	m22 = yScale;
@@ -1097,7 +1336,8 @@ inline LinearMapR4& LinearMapR4::Set_glScale(double xScale, double yScale, doubl
 	return *this;
 }
 
-inline LinearMapR4& LinearMapR4::Mult_glScale(double xScale, double yScale, double zScale)
+template<class T>
+inline LinearMapR4T<T>& LinearMapR4T<T>::Mult_glScale(T xScale, T yScale, T zScale)
 {
 	m11 *= xScale;
 	m21 *= xScale;
@@ -1114,7 +1354,8 @@ inline LinearMapR4& LinearMapR4::Mult_glScale(double xScale, double yScale, doub
 	return *this;
 }
 
-inline LinearMapR4& LinearMapR4::Set_glTranslate(double xTranslation, double yTranslation, double zTranslation)
+template<class T>
+inline LinearMapR4T<T>& LinearMapR4T<T>::Set_glTranslate(T xTranslation, T yTranslation, T zTranslation)
 {
 	m14 = xTranslation;
 	m24 = yTranslation;
@@ -1124,7 +1365,8 @@ inline LinearMapR4& LinearMapR4::Set_glTranslate(double xTranslation, double yTr
 	return *this;
 }
 
-inline LinearMapR4& LinearMapR4::Mult_glTranslate(double xTranslation, double yTranslation, double zTranslation)
+template<class T>
+inline LinearMapR4T<T>& LinearMapR4T<T>::Mult_glTranslate(T xTranslation, T yTranslation, T zTranslation)
 {
 	m14 += xTranslation * m11 + yTranslation * m12 + zTranslation * m13;
 	m24 += xTranslation * m21 + yTranslation * m22 + zTranslation * m23;
@@ -1133,56 +1375,349 @@ inline LinearMapR4& LinearMapR4::Mult_glTranslate(double xTranslation, double yT
 	return *this;
 }
 
-inline LinearMapR4& LinearMapR4::Set_glTranslate(const VectorR3& translation)
+template<class T>
+inline LinearMapR4T<T>& LinearMapR4T<T>::Set_glTranslate(const VectorR3T<T>& translation)
 {
 	return Set_glTranslate(translation.x, translation.y, translation.z);
 }
 
-inline LinearMapR4& LinearMapR4::Mult_glTranslate(const VectorR3& translation)
+template<class T>
+inline LinearMapR4T<T>& LinearMapR4T<T>::Mult_glTranslate(const VectorR3T<T>& translation)
 {
 	return Mult_glTranslate(translation.x, translation.y, translation.z);
 }
 
-inline LinearMapR4& LinearMapR4::Set_glRotate(double radians, double x, double y, double z)
+template<class T>
+inline LinearMapR4T<T>& LinearMapR4T<T>::Set_glRotate(T radians, T x, T y, T z)
 {
 	return Set_glRotate(cos(radians), sin(radians), x, y, z);
 }
 
-inline LinearMapR4& LinearMapR4::Mult_glRotate(double radians, double x, double y, double z)
+template<class T>
+inline LinearMapR4T<T>& LinearMapR4T<T>::Mult_glRotate(T radians, T x, T y, T z)
 {
 	return Mult_glRotate(cos(radians), sin(radians), x, y, z);
 }
 
-inline LinearMapR4& LinearMapR4::Set_glRotate(double radians, const VectorR3& axis)
+template<class T>
+inline LinearMapR4T<T>& LinearMapR4T<T>::Set_glRotate(T radians, const VectorR3T<T>& axis)
 {
 	return Set_glRotate(cos(radians), sin(radians), axis);
 }
 
-inline LinearMapR4& LinearMapR4::Mult_glRotate(double radians, const VectorR3& axis)
+template<class T>
+inline LinearMapR4T<T>& LinearMapR4T<T>::Mult_glRotate(T radians, const VectorR3T<T>& axis)
 {
 	return Mult_glRotate(cos(radians), sin(radians), axis);
 }
 
-inline LinearMapR4& LinearMapR4::Mult_glRotate(double costheta, double sintheta, double x, double y, double z)
+template<class T>
+inline LinearMapR4T<T>& LinearMapR4T<T>::Mult_glRotate(T costheta, T sintheta, T x, T y, T z)
 {
-	LinearMapR4 rotMatrix;
+	LinearMapR4T<T> rotMatrix;
 	rotMatrix.Set_glRotate(costheta, sintheta, x, y, z);
 	(*this) *= rotMatrix;
 	return *this;
 }
 
-inline LinearMapR4& LinearMapR4::Set_glRotate(double costheta, double sintheta, const VectorR3& axis)
+template<class T>
+inline LinearMapR4T<T>& LinearMapR4T<T>::Set_glRotate(T costheta, T sintheta, const VectorR3T<T>& axis)
 {
 	return Set_glRotate(costheta, sintheta, axis.x, axis.y, axis.z);
 }
 
-inline LinearMapR4& LinearMapR4::Mult_glRotate(double costheta, double sintheta, const VectorR3& axis)
+template<class T>
+inline LinearMapR4T<T>& LinearMapR4T<T>::Mult_glRotate(T costheta, T sintheta, const VectorR3T<T>& axis)
 {
 	return Mult_glRotate(costheta, sintheta, axis.x, axis.y, axis.z);
 }
 
 
 
+
+template<class T>
+T LinearMapR4T<T>::Determinant () const		// Returns the determinant
+{
+	T Tbt34C12 = m31*m42-m32*m41;		// 2x2 subdeterminants
+	T Tbt34C13 = m31*m43-m33*m41;
+	T Tbt34C14 = m31*m44-m34*m41;
+	T Tbt34C23 = m32*m43-m33*m42;
+	T Tbt34C24 = m32*m44-m34*m42;
+	T Tbt34C34 = m33*m44-m34*m43;
+
+	T sd11 = m22*Tbt34C34 - m23*Tbt34C24 + m24*Tbt34C23;	// 3x3 subdeterminants
+	T sd12 = m21*Tbt34C34 - m23*Tbt34C14 + m24*Tbt34C13;
+	T sd13 = m21*Tbt34C24 - m22*Tbt34C14 + m24*Tbt34C12;
+	T sd14 = m21*Tbt34C23 - m22*Tbt34C13 + m23*Tbt34C12;
+
+	return ( m11*sd11 - m12*sd12 + m13*sd13 - m14*sd14 );
+}
+
+template<class T>
+LinearMapR4T<T> LinearMapR4T<T>::Inverse() const			// Returns inverse
+{
+
+	T Tbt34C12 = m31*m42-m32*m41;		// 2x2 subdeterminants
+	T Tbt34C13 = m31*m43-m33*m41;
+	T Tbt34C14 = m31*m44-m34*m41;
+	T Tbt34C23 = m32*m43-m33*m42;
+	T Tbt34C24 = m32*m44-m34*m42;
+	T Tbt34C34 = m33*m44-m34*m43;
+	T Tbt24C12 = m21*m42-m22*m41;		// 2x2 subdeterminants
+	T Tbt24C13 = m21*m43-m23*m41;
+	T Tbt24C14 = m21*m44-m24*m41;
+	T Tbt24C23 = m22*m43-m23*m42;
+	T Tbt24C24 = m22*m44-m24*m42;
+	T Tbt24C34 = m23*m44-m24*m43;
+	T Tbt23C12 = m21*m32-m22*m31;		// 2x2 subdeterminants
+	T Tbt23C13 = m21*m33-m23*m31;
+	T Tbt23C14 = m21*m34-m24*m31;
+	T Tbt23C23 = m22*m33-m23*m32;
+	T Tbt23C24 = m22*m34-m24*m32;
+	T Tbt23C34 = m23*m34-m24*m33;
+
+	T sd11 = m22*Tbt34C34 - m23*Tbt34C24 + m24*Tbt34C23;	// 3x3 subdeterminants
+	T sd12 = m21*Tbt34C34 - m23*Tbt34C14 + m24*Tbt34C13;
+	T sd13 = m21*Tbt34C24 - m22*Tbt34C14 + m24*Tbt34C12;
+	T sd14 = m21*Tbt34C23 - m22*Tbt34C13 + m23*Tbt34C12;
+	T sd21 = m12*Tbt34C34 - m13*Tbt34C24 + m14*Tbt34C23;	// 3x3 subdeterminants
+	T sd22 = m11*Tbt34C34 - m13*Tbt34C14 + m14*Tbt34C13;
+	T sd23 = m11*Tbt34C24 - m12*Tbt34C14 + m14*Tbt34C12;
+	T sd24 = m11*Tbt34C23 - m12*Tbt34C13 + m13*Tbt34C12;
+	T sd31 = m12*Tbt24C34 - m13*Tbt24C24 + m14*Tbt24C23;	// 3x3 subdeterminants
+	T sd32 = m11*Tbt24C34 - m13*Tbt24C14 + m14*Tbt24C13;
+	T sd33 = m11*Tbt24C24 - m12*Tbt24C14 + m14*Tbt24C12;
+	T sd34 = m11*Tbt24C23 - m12*Tbt24C13 + m13*Tbt24C12;
+	T sd41 = m12*Tbt23C34 - m13*Tbt23C24 + m14*Tbt23C23;	// 3x3 subdeterminants
+	T sd42 = m11*Tbt23C34 - m13*Tbt23C14 + m14*Tbt23C13;
+	T sd43 = m11*Tbt23C24 - m12*Tbt23C14 + m14*Tbt23C12;
+	T sd44 = m11*Tbt23C23 - m12*Tbt23C13 + m13*Tbt23C12;
+
+
+	T detInv = 1.0/(m11*sd11 - m12*sd12 + m13*sd13 - m14*sd14);
+
+	return( LinearMapR4T<T>( sd11*detInv, -sd12*detInv, sd13*detInv, -sd14*detInv,
+						 -sd21*detInv, sd22*detInv, -sd23*detInv, sd24*detInv,
+						 sd31*detInv, -sd32*detInv, sd33*detInv, -sd34*detInv,
+						 -sd41*detInv, sd42*detInv, -sd43*detInv, sd44*detInv ) );
+}
+
+template<class T>
+LinearMapR4T<T>& LinearMapR4T<T>::Invert() 			// Converts into inverse.
+{
+	T Tbt34C12 = m31*m42-m32*m41;		// 2x2 subdeterminants
+	T Tbt34C13 = m31*m43-m33*m41;
+	T Tbt34C14 = m31*m44-m34*m41;
+	T Tbt34C23 = m32*m43-m33*m42;
+	T Tbt34C24 = m32*m44-m34*m42;
+	T Tbt34C34 = m33*m44-m34*m43;
+	T Tbt24C12 = m21*m42-m22*m41;		// 2x2 subdeterminants
+	T Tbt24C13 = m21*m43-m23*m41;
+	T Tbt24C14 = m21*m44-m24*m41;
+	T Tbt24C23 = m22*m43-m23*m42;
+	T Tbt24C24 = m22*m44-m24*m42;
+	T Tbt24C34 = m23*m44-m24*m43;
+	T Tbt23C12 = m21*m32-m22*m31;		// 2x2 subdeterminants
+	T Tbt23C13 = m21*m33-m23*m31;
+	T Tbt23C14 = m21*m34-m24*m31;
+	T Tbt23C23 = m22*m33-m23*m32;
+	T Tbt23C24 = m22*m34-m24*m32;
+	T Tbt23C34 = m23*m34-m24*m33;
+
+	T sd11 = m22*Tbt34C34 - m23*Tbt34C24 + m24*Tbt34C23;	// 3x3 subdeterminants
+	T sd12 = m21*Tbt34C34 - m23*Tbt34C14 + m24*Tbt34C13;
+	T sd13 = m21*Tbt34C24 - m22*Tbt34C14 + m24*Tbt34C12;
+	T sd14 = m21*Tbt34C23 - m22*Tbt34C13 + m23*Tbt34C12;
+	T sd21 = m12*Tbt34C34 - m13*Tbt34C24 + m14*Tbt34C23;	// 3x3 subdeterminants
+	T sd22 = m11*Tbt34C34 - m13*Tbt34C14 + m14*Tbt34C13;
+	T sd23 = m11*Tbt34C24 - m12*Tbt34C14 + m14*Tbt34C12;
+	T sd24 = m11*Tbt34C23 - m12*Tbt34C13 + m13*Tbt34C12;
+	T sd31 = m12*Tbt24C34 - m13*Tbt24C24 + m14*Tbt24C23;	// 3x3 subdeterminants
+	T sd32 = m11*Tbt24C34 - m13*Tbt24C14 + m14*Tbt24C13;
+	T sd33 = m11*Tbt24C24 - m12*Tbt24C14 + m14*Tbt24C12;
+	T sd34 = m11*Tbt24C23 - m12*Tbt24C13 + m13*Tbt24C12;
+	T sd41 = m12*Tbt23C34 - m13*Tbt23C24 + m14*Tbt23C23;	// 3x3 subdeterminants
+	T sd42 = m11*Tbt23C34 - m13*Tbt23C14 + m14*Tbt23C13;
+	T sd43 = m11*Tbt23C24 - m12*Tbt23C14 + m14*Tbt23C12;
+	T sd44 = m11*Tbt23C23 - m12*Tbt23C13 + m13*Tbt23C12;
+
+	T detInv = 1.0/(m11*sd11 - m12*sd12 + m13*sd13 - m14*sd14);
+
+	m11 = sd11*detInv;
+	m12 = -sd21*detInv;
+	m13 = sd31*detInv;
+	m14 = -sd41*detInv;
+	m21 = -sd12*detInv;
+	m22 = sd22*detInv;
+	m23 = -sd32*detInv;
+	m24 = sd42*detInv;
+	m31 = sd13*detInv;
+	m32 = -sd23*detInv;
+	m33 = sd33*detInv;
+	m34 = -sd43*detInv;
+	m41 = -sd14*detInv;
+	m42 = sd24*detInv;
+	m43 = -sd34*detInv;
+	m44 = sd44*detInv;
+
+	return ( *this );
+}
+
+template<class T>
+VectorR4T<T> LinearMapR4T<T>::Solve(const VectorR4T<T>& u) const	// Returns solution
+{												
+	// Just uses Inverse() for now.
+	return ( Inverse()*u );
+}
+
+// Multiply a VectorR3 postion by an affine transformation.
+//     The w component of the VectorR3 object is treated as equal to 1.0.
+template<class T>
+void LinearMapR4T<T>::AffineTransformPosition(VectorR3T<T>& dest) const
+{
+    assert(IsAffine());
+    T newX = dest.x*m11 + dest.y*m12 + dest.z * m13 + m14;
+    T newY = dest.x*m21 + dest.y*m22 + dest.z * m23 + m24;
+    T wInv = 1.0 / m44;
+    dest.z = dest.x*m31 + dest.y*m32 + dest.z * m33 + m34;
+    dest.z *= wInv;
+    dest.x = newX * wInv;
+    dest.y = newY * wInv;
+}
+
+// Multiply a VectorR3 direction vector by an affine transformation.
+//     The w component of the VectorR3 object is treated as equal to 0.0.
+template<class T>
+void LinearMapR4T<T>::AffineTransformDirection(VectorR3T<T>& dest) const
+{
+    assert(IsAffine());
+    T newX = dest.x*m11 + dest.y*m12 + dest.z * m13;
+    T newY = dest.x*m21 + dest.y*m22 + dest.z * m23;
+    dest.z = dest.x*m31 + dest.y*m32 + dest.z * m33;
+    dest.x = newX;
+    dest.y = newY;
+}
+
+// As Matrix3x3T::Transform(), with the translation and the 1/m44 scale added.
+template<class T>
+void LinearMapR4T<T>::AffineTransformPositions(const T* x, const T* y, const T* z,
+                                               T* outX, T* outY, T* outZ, long count) const
+{
+    assert(IsAffine());
+    T wInv = 1.0 / m44;
+    const T a11 = m11*wInv, a12 = m12*wInv, a13 = m13*wInv, a14 = m14*wInv;
+    const T a21 = m21*wInv, a22 = m22*wInv, a23 = m23*wInv, a24 = m24*wInv;
+    const T a31 = m31*wInv, a32 = m32*wInv, a33 = m33*wInv, a34 = m34*wInv;
+    for (long i = 0; i < count; i++) {
+        T px = x[i], py = y[i], pz = z[i];
+        outX[i] = px*a11 + py*a12 + pz*a13 + a14;
+        outY[i] = px*a21 + py*a22 + pz*a23 + a24;
+        outZ[i] = px*a31 + py*a32 + pz*a33 + a34;
+    }
+}
+
+template<class T>
+void LinearMapR4T<T>::AffineTransformDirections(const T* x, const T* y, const T* z,
+                                                T* outX, T* outY, T* outZ, long count) const
+{
+    assert(IsAffine());
+    const T a11 = m11, a12 = m12, a13 = m13;
+    const T a21 = m21, a22 = m22, a23 = m23;
+    const T a31 = m31, a32 = m32, a33 = m33;
+    for (long i = 0; i < count; i++) {
+        T px = x[i], py = y[i], pz = z[i];
+        outX[i] = px*a11 + py*a12 + pz*a13;
+        outY[i] = px*a21 + py*a22 + pz*a23;
+        outZ[i] = px*a31 + py*a32 + pz*a33;
+    }
+}
+
+// glOrtho, glFrustum, gluPerspective functions
+//  reproduce OpenGL functionality for the Projection Matrices
+
+template<class T>
+LinearMapR4T<T>& LinearMapR4T<T>::Set_glOrtho(T left, T right,
+	T bottom, T top,
+	T near, T far)
+{
+	T bottomMinusTopInv = 1.0 / (bottom - top);
+	T leftMinusRightInv = 1.0 / (left - right);
+	T farMinusNearInv = 1.0 / (far - near);
+	this->m11 = -2.0*leftMinusRightInv;
+	this->m22 = -2.0*bottomMinusTopInv;
+	this->m33 = -2.0*farMinusNearInv;
+	this->m14 = (left+right)*leftMinusRightInv;
+	this->m24 = (bottom+top)*bottomMinusTopInv;
+	this->m34 = (near+far)*farMinusNearInv;
+	this->m44 = 1.0;
+	this->m21 = this->m31 = this->m41 = 0;
+	this->m12 = this->m32 = this->m42 = 0;
+	this->m13 = this->m23 = this->m43 = 0;
+	return *this;
+}
+
+// Various scale, translation and rotation matrices,
+//   to reproduce OpenGL ModelView matrix functionality
+//   The "Mult" routines multiply on the right. (Like legacy OpenGL.)
+//   The "Set" routines replace the matrix contents.
+//   All routines return the *this matrix.
+//   Most of them are inlined in the header file
+
+
+template<class T>
+LinearMapR4T<T>& LinearMapR4T<T>::Set_glRotate(T costheta, T sintheta, T x, T y, T z)
+{
+	T normSq = x * x + y * y + z * z;
+	assert(normSq > 0.0);
+	T normInv = 1.0 / sqrt(normSq);
+	x *= normInv;
+	y *= normInv;
+	z *= normInv;
+	T omC = 1 - costheta;
+	T omCx = omC * x;
+	T omCy = omC * y;
+	T omCz = omC * z;
+	m11 = omCx * x + costheta;
+	m21 = omCx * y + sintheta * z;
+	m31 = omCx * z - sintheta * y;
+	m12 = omCy * x - sintheta * z;
+	m22 = omCy * y + costheta;
+	m32 = omCy * z + sintheta * x;
+	m13 = omCz * x + sintheta * y;
+	m23 = omCz * y - sintheta * x;
+	m33 = omCz * z + costheta;
+	m41 = m42 = m43 = m14 = m24 = m34 = 0.0;
+	m44 = 1.0;
+	return *this;
+}
+
+
+template<class T>
+LinearMapR4T<T>& LinearMapR4T<T>::Set_glFrustum(T left, T right, T bottom, T top, T near, T far)
+{
+    T topMinusBottomInv = 1.0 / (top - bottom);
+    T rightMinusLeftInv = 1.0 / (right - left);
+    T nearMinusFarInv = 1.0 / (near - far);
+    T twoN = 2.0*near;
+    m11 = twoN * rightMinusLeftInv;
+    m22 = twoN * topMinusBottomInv;
+    m13 = (right + left) * rightMinusLeftInv;
+    m23 = (top + bottom) * topMinusBottomInv;
+    m33 = (far + near) * nearMinusFarInv;
+    m43 = -1.0;
+    m34 = far * twoN * nearMinusFarInv;
+    m21 = m31 = m41 = m12 = m32 = m42 = m14 = m24 = 0.0;
+    return *this;
+}
+
+template<class T>
+LinearMapR4T<T>& LinearMapR4T<T>::Set_gluPerspective(T fieldofview_y_Radians, T aspectRatio, T zNear, T zFar)
+{
+    T upDown = zNear * tan(0.5*fieldofview_y_Radians);
+    T leftRight = aspectRatio * upDown;
+    return Set_glFrustum(-leftRight, leftRight, -upDown, upDown, zNear, zFar);
+}
+
 // ******************************************************
 // * RotationMapR4 class - inlined functions			*
 // * * * * * * * * * * * * * * * * * * * * * * * * * * **
@@ -1264,7 +1799,8 @@ inline void Matrix3x4::Transform( const VectorR4& src, VectorR4* dest ) const {
 // * 4-space vector and matrix utilities (inlined functions)	 *
 // * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
 
-inline void TimesTranspose( const VectorR4& u, const VectorR4& v, LinearMapR4& M)
+template<class T>
+inline void TimesTranspose( const VectorR4T<T>& u, const VectorR4T<T>& v, LinearMapR4T<T>& M)
 {
 	M.Set ( v.x*u.x, v.x*u.y, v.x*u.z, v.x*u.w,			// Set by columns!
 			v.y*u.x, v.y*u.y, v.y*u.z, v.y*u.w,
@@ -1273,10 +1809,11 @@ inline void TimesTranspose( const VectorR4& u, const VectorR4& v, LinearMapR4& M
 }
 
 // Returns the solid angle between vectors u and v (not necessarily unit vectors)
-inline double SolidAngle( const VectorR4& u, const VectorR4& v)
+template<class T>
+inline T SolidAngle( const VectorR4T<T>& u, const VectorR4T<T>& v)
 {
-	double nSqU = u.NormSq();
-	double nSqV = v.NormSq();
+	T nSqU = u.NormSq();
+	T nSqV = v.NormSq();
 	if ( nSqU==0.0 && nSqV==0.0 ) {
 		return (0.0);
 	}
@@ -1285,10 +1822,21 @@ inline double SolidAngle( const VectorR4& u, const VectorR4& v)
 	}
 }
 
-inline double SolidAngleUnit( const VectorR4 u, const VectorR4 v )
+template<class T>
+inline T SolidAngleUnit( const VectorR4T<T> u, const VectorR4T<T> v )
 {
 	return ( atan2 ( ProjectPerpUnit(v,u).Norm(), u^v ) );
 }
 
 
+// ***************************************************************
+// * Stream Output Routines										 *
+// * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+
+template<class T>
+ostream& operator<< ( ostream& os, const VectorR4T<T>& u )
+{
+	return (os << "<" << u.x << "," << u.y << "," << u.z << "," << u.w << ">");
+}
+
 #endif	// LINEAR_R4_H
@@ -0,0 +1,306 @@
+// *******************************
+// LinearR4f.h
+//
+// LinearMapR4f: a single precision 4x4 matrix for the render path.
+// AffineMapR4f: the same, restricted to affine maps (the bottom row is
+//    always 0,0,0,1), for building modelview matrices.
+//
+// The entries are 16 floats in column order, 16-byte aligned, which is
+//    exactly the layout glUniformMatrix4fv() expects: Data() can be
+//    uploaded as is, with no conversion.
+// The products, the inverses and the point transforms use SSE when it
+//    is available (always on x64), and plain C++ otherwise.
+//
+// LinearMapR4 (double precision) stays the type to use when precision
+//    matters, e.g. for the physics.  Convert with Set() or the constructor.
+// Like LinearMapR4, the Mult_gl* routines multiply on the right and
+//    the angles are in radians.
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+#pragma once
+
+#ifndef LINEAR_R4F_H
+#define LINEAR_R4F_H
+
+#include <math.h>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LINEAR_R4F_SSE
+#include <xmmintrin.h>
+#endif
+
+template<class T> class VectorR3T;
+template<class T> class LinearMapR4T;
+typedef VectorR3T<double> VectorR3;
+typedef LinearMapR4T<double> LinearMapR4;
+class AffineMapR4f;
+
+class alignas(16) LinearMapR4f {
+
+public:
+    float m[16];        // Column order: m[4*j+i] is the entry in row i, column j
+
+    LinearMapR4f() { SetZero(); }
+    explicit LinearMapR4f(const LinearMapR4& A) { Set(A); }
+
+    void SetZero();
+    void SetIdentity();
+    LinearMapR4f& Set(const LinearMapR4& A);    // Round the double precision entries to floats
+    void Get(LinearMapR4& A) const;             // Back to double precision
+
+    const float* Data() const { return m; }     // For glUniformMatrix4fv(loc, 1, false, Data())
+    float& operator()(int row, int col) { return m[4 * col + row]; }
+    float operator()(int row, int col) const { return m[4 * col + row]; }
+
+    LinearMapR4f& operator*=(const LinearMapR4f& B);    // Matrix product, *this = (*this)*B
+    LinearMapR4f& MultAffine(const LinearMapR4f& B);    // Same, but B must be affine
+
+    bool IsAffine() const;          // Bottom row is (0,0,0,1)
+    LinearMapR4f Inverse() const;   // General inverse. The matrix must be invertible.
+    LinearMapR4f InverseAffine() const;     // Faster inverse for an affine matrix
+
+    // Transform positions (w = 1) given as x,y,z triples; in and out may be the same array.
+    //   An affine matrix is assumed: the bottom row is ignored and there is no divide by w.
+    void TransformPoint(const float* in, float* out) const;
+    void TransformPoints(const float* in, float* out, long count) const;
+
+    // The same for points stored as separate x, y and z arrays (structure of arrays),
+    //   four points per SSE operation.  The output arrays may be the input arrays.
+    //   TransformVectorsSoA() uses only the 3x3 part (w = 0), for directions.
+    //   For normals, use the inverse transpose matrix.
+    //   Nothing in the program calls these yet (bench/MathBench.cpp times TransformPointsSoA()):
+    //   the renderer leaves per-frame point transforms to the vertex shaders.
+    void TransformPointsSoA(const float* x, const float* y, const float* z,
+                            float* outX, float* outY, float* outZ, long count) const;
+    void TransformVectorsSoA(const float* x, const float* y, const float* z,
+                             float* outX, float* outY, float* outZ, long count) const;
+
+    // OpenGL style modelview operations, as in LinearMapR4 (radians, not degrees)
+    LinearMapR4f& Set_glScale(float xyzScale);
+    LinearMapR4f& Mult_glScale(float xyzScale);
+    LinearMapR4f& Set_glScale(float xScale, float yScale, float zScale);
+    LinearMapR4f& Mult_glScale(float xScale, float yScale, float zScale);
+    LinearMapR4f& Set_glTranslate(float xTranslation, float yTranslation, float zTranslation);
+    LinearMapR4f& Mult_glTranslate(float xTranslation, float yTranslation, float zTranslation);
+    LinearMapR4f& Set_glTranslate(const VectorR3& translation);
+    LinearMapR4f& Mult_glTranslate(const VectorR3& translation);
+    LinearMapR4f& Set_glRotate(double radians, float x, float y, float z);
+    LinearMapR4f& Mult_glRotate(double radians, float x, float y, float z);
+    LinearMapR4f& Set_glRotate(float costheta, float sintheta, float x, float y, float z);
+    LinearMapR4f& Mult_glRotate(float costheta, float sintheta, float x, float y, float z);
+};
+
+LinearMapR4f operator*(const LinearMapR4f& A, const LinearMapR4f& B);      // Matrix product
+void MultiplyAffine(const LinearMapR4f& A, const LinearMapR4f& B, LinearMapR4f& result);   // B affine
+
+// A span of matrices applied to a span of points: point i is transformed by A[i].
+//   The points are x, y and z arrays as in TransformPointsSoA(); A[i] must be affine.
+void TransformPointsSoA(const LinearMapR4f* A, const float* x, const float* y, const float* z,
+                        float* outX, float* outY, float* outZ, long count);
+
+// ****************************************************
+// AffineMapR4f: an affine map  | R t |, i.e. a 3x4 matrix.
+//                              | 0 1 |
+//   The constant bottom row is stored too, so that Data() can be
+//   uploaded as a mat4 with no conversion.  Only the operations that
+//   keep the map affine are provided, and they never compute the
+//   bottom row.  Rotations about the coordinate axes only touch two
+//   columns; the cos/sin versions let callers precompute the trig.
+// ****************************************************
+
+class alignas(16) AffineMapR4f {
+
+public:
+    AffineMapR4f() { M.SetIdentity(); }
+    explicit AffineMapR4f(const LinearMapR4& A) { Set(A); }
+
+    void SetIdentity() { M.SetIdentity(); }
+    AffineMapR4f& Set(const LinearMapR4& A);    // A must be affine
+    const LinearMapR4f& AsLinearMap() const { return M; }
+
+    const float* Data() const { return M.m; }   // For glUniformMatrix4fv(loc, 1, false, Data())
+    float operator()(int row, int col) const { return M(row, col); }
+
+    AffineMapR4f& operator*=(const AffineMapR4f& B) { M.MultAffine(B.M); return *this; }
+
+    AffineMapR4f Inverse() const;           // General affine inverse
+    AffineMapR4f RigidInverse() const;      // Only for rotations and translations: R^T, -R^T t
+
+    void TransformPoints(const float* in, float* out, long count) const { M.TransformPoints(in, out, count); }
+    void TransformPointsSoA(const float* x, const float* y, const float* z,
+                            float* outX, float* outY, float* outZ, long count) const
+        { M.TransformPointsSoA(x, y, z, outX, outY, outZ, count); }
+    void TransformVectorsSoA(const float* x, const float* y, const float* z,
+                             float* outX, float* outY, float* outZ, long count) const
+        { M.TransformVectorsSoA(x, y, z, outX, outY, outZ, count); }
+
+    AffineMapR4f& Mult_glScale(float xyzScale) { M.Mult_glScale(xyzScale); return *this; }
+    AffineMapR4f& Mult_glScale(float xScale, float yScale, float zScale)
+        { M.Mult_glScale(xScale, yScale, zScale); return *this; }
+    AffineMapR4f& Mult_glTranslate(float xTranslation, float yTranslation, float zTranslation)
+        { M.Mult_glTranslate(xTranslation, yTranslation, zTranslation); return *this; }
+    AffineMapR4f& Mult_glTranslate(const VectorR3& translation) { M.Mult_glTranslate(translation); return *this; }
+    AffineMapR4f& Mult_glRotate(double radians, float x, float y, float z) { M.Mult_glRotate(radians, x, y, z); return *this; }
+    AffineMapR4f& Mult_glRotate(float costheta, float sintheta, float x, float y, float z)
+        { M.Mult_glRotate(costheta, sintheta, x, y, z); return *this; }
+
+    // Rotations about the x, y and z axes.
+    AffineMapR4f& Mult_glRotateX(float costheta, float sintheta) { RotateColumns(M.m + 4, M.m + 8, costheta, sintheta); return *this; }
+    AffineMapR4f& Mult_glRotateY(float costheta, float sintheta) { RotateColumns(M.m + 8, M.m, costheta, sintheta); return *this; }
+    AffineMapR4f& Mult_glRotateZ(float costheta, float sintheta) { RotateColumns(M.m, M.m + 4, costheta, sintheta); return *this; }
+    AffineMapR4f& Mult_glRotateX(double radians) { return Mult_glRotateX((float)cos(radians), (float)sin(radians)); }
+    AffineMapR4f& Mult_glRotateY(double radians) { return Mult_glRotateY((float)cos(radians), (float)sin(radians)); }
+    AffineMapR4f& Mult_glRotateZ(double radians) { return Mult_glRotateZ((float)cos(radians), (float)sin(radians)); }
+
+private:
+    LinearMapR4f M;
+
+    // Replace the columns a and b by  c*a + s*b  and  c*b - s*a.
+    static void RotateColumns(float* a, float* b, float c, float s);
+};
+
+inline AffineMapR4f operator*(const AffineMapR4f& A, const AffineMapR4f& B)
+{
+    AffineMapR4f result = A;
+    result *= B;
+    return result;
+}
+
+// ******************************************************
+// * LinearMapR4f class - inlined functions             *
+// * * * * * * * * * * * * * * * * * * * * * * * * * * **
+
+inline void LinearMapR4f::SetZero()
+{
+    for (int i = 0; i < 16; i++) {
+        m[i] = 0.0f;
+    }
+}
+
+inline void LinearMapR4f::SetIdentity()
+{
+    SetZero();
+    m[0] = m[5] = m[10] = m[15] = 1.0f;
+}
+
+inline bool LinearMapR4f::IsAffine() const
+{
+    return m[3] == 0.0f && m[7] == 0.0f && m[11] == 0.0f && m[15] == 1.0f;
+}
+
+inline LinearMapR4f& LinearMapR4f::operator*=(const LinearMapR4f& B)
+{
+    *this = (*this) * B;
+    return *this;
+}
+
+inline LinearMapR4f& LinearMapR4f::MultAffine(const LinearMapR4f& B)
+{
+    MultiplyAffine(*this, B, *this);
+    return *this;
+}
+
+inline LinearMapR4f& LinearMapR4f::Set_glScale(float xyzScale)
+{
+    return Set_glScale(xyzScale, xyzScale, xyzScale);
+}
+
+inline LinearMapR4f& LinearMapR4f::Mult_glScale(float xyzScale)
+{
+    return Mult_glScale(xyzScale, xyzScale, xyzScale);
+}
+
+inline LinearMapR4f& LinearMapR4f::Set_glScale(float xScale, float yScale, float zScale)
+{
+    SetZero();
+    m[0] = xScale;
+    m[5] = yScale;
+    m[10] = zScale;
+    m[15] = 1.0f;
+    return *this;
+}
+
+// Scales the first three columns
+inline LinearMapR4f& LinearMapR4f::Mult_glScale(float xScale, float yScale, float zScale)
+{
+#ifdef LINEAR_R4F_SSE
+    _mm_store_ps(m, _mm_mul_ps(_mm_load_ps(m), _mm_set1_ps(xScale)));
+    _mm_store_ps(m + 4, _mm_mul_ps(_mm_load_ps(m + 4), _mm_set1_ps(yScale)));
+    _mm_store_ps(m + 8, _mm_mul_ps(_mm_load_ps(m + 8), _mm_set1_ps(zScale)));
+#else
+    for (int i = 0; i < 4; i++) {
+        m[i] *= xScale;
+        m[4 + i] *= yScale;
+        m[8 + i] *= zScale;
+    }
+#endif
+    return *this;
+}
+
+inline LinearMapR4f& LinearMapR4f::Set_glTranslate(float xTranslation, float yTranslation, float zTranslation)
+{
+    SetIdentity();
+    m[12] = xTranslation;
+    m[13] = yTranslation;
+    m[14] = zTranslation;
+    return *this;
+}
+
+// Adds a combination of the first three columns to the last column
+inline LinearMapR4f& LinearMapR4f::Mult_glTranslate(float xTranslation, float yTranslation, float zTranslation)
+{
+#ifdef LINEAR_R4F_SSE
+    __m128 col = _mm_add_ps(_mm_load_ps(m + 12), _mm_mul_ps(_mm_load_ps(m), _mm_set1_ps(xTranslation)));
+    col = _mm_add_ps(col, _mm_mul_ps(_mm_load_ps(m + 4), _mm_set1_ps(yTranslation)));
+    col = _mm_add_ps(col, _mm_mul_ps(_mm_load_ps(m + 8), _mm_set1_ps(zTranslation)));
+    _mm_store_ps(m + 12, col);
+#else
+    for (int i = 0; i < 4; i++) {
+        m[12 + i] += xTranslation * m[i] + yTranslation * m[4 + i] + zTranslation * m[8 + i];
+    }
+#endif
+    return *this;
+}
+
+inline LinearMapR4f& LinearMapR4f::Set_glRotate(double radians, float x, float y, float z)
+{
+    return Set_glRotate((float)cos(radians), (float)sin(radians), x, y, z);
+}
+
+inline LinearMapR4f& LinearMapR4f::Mult_glRotate(double radians, float x, float y, float z)
+{
+    return Mult_glRotate((float)cos(radians), (float)sin(radians), x, y, z);
+}
+
+inline void LinearMapR4f::TransformPoint(const float* in, float* out) const
+{
+    TransformPoints(in, out, 1);
+}
+
+// ******************************************************
+// * AffineMapR4f class - inlined functions             *
+// * * * * * * * * * * * * * * * * * * * * * * * * * * **
+
+inline void AffineMapR4f::RotateColumns(float* a, float* b, float c, float s)
+{
+#ifdef LINEAR_R4F_SSE
+    __m128 va = _mm_load_ps(a);
+    __m128 vb = _mm_load_ps(b);
+    __m128 vc = _mm_set1_ps(c);
+    __m128 vs = _mm_set1_ps(s);
+    _mm_store_ps(a, _mm_add_ps(_mm_mul_ps(vc, va), _mm_mul_ps(vs, vb)));
+    _mm_store_ps(b, _mm_sub_ps(_mm_mul_ps(vc, vb), _mm_mul_ps(vs, va)));
+#else
+    for (int i = 0; i < 3; i++) {
+        float ai = a[i];
+        a[i] = c * ai + s * b[i];
+        b[i] = c * b[i] - s * ai;
+    }
+#endif
+}
+
+#endif // LINEAR_R4F_H
@@ -34,32 +34,32 @@
 
 const double DBL_NAN = sqrt(-1.0);	// Kludgy - ought to be an IEEE standard for this constant
 
-const double PI = 3.1415926535897932384626433832795028841972;
-const double PI2 = 2.0*PI;
-const double PI4 = 4.0*PI;
-const double PISq = PI*PI;
-const double PIhalves = 0.5*PI;
-const double PIthirds = PI/3.0;
-const double PItwothirds = PI2/3.0;
-const double PIfourths = 0.25*PI;
-const double PIsixths = PI/6.0;
-const double PIsixthsSq = PIsixths*PIsixths;
-const double PItwelfths = PI/12.0;
-const double PItwelfthsSq = PItwelfths*PItwelfths;
-const double PIinv = 1.0/PI;
-const double PI2inv = 0.5/PI;
-const double PIhalfinv = 2.0/PI;
+constexpr double PI = 3.1415926535897932384626433832795028841972;
+constexpr double PI2 = 2.0*PI;
+constexpr double PI4 = 4.0*PI;
+constexpr double PISq = PI*PI;
+constexpr double PIhalves = 0.5*PI;
+constexpr double PIthirds = PI/3.0;
+constexpr double PItwothirds = PI2/3.0;
+constexpr double PIfourths = 0.25*PI;
+constexpr double PIsixths = PI/6.0;
+constexpr double PIsixthsSq = PIsixths*PIsixths;
+constexpr double PItwelfths = PI/12.0;
+constexpr double PItwelfthsSq = PItwelfths*PItwelfths;
+constexpr double PIinv = 1.0/PI;
+constexpr double PI2inv = 0.5/PI;
+constexpr double PIhalfinv = 2.0/PI;
 const double TwoPiSqrtInv = 1.0/sqrt(2.0*PI);
 const double LogPI = log(PI);
 
-const double RadiansToDegrees = 180.0/PI;
-const double DegreesToRadians = PI/180;
+constexpr double RadiansToDegrees = 180.0/PI;
+constexpr double DegreesToRadians = PI/180;
 
-const double OneThird = 1.0/3.0;
-const double TwoThirds = 2.0/3.0;
-const double OneSixth = 1.0/6.0;
-const double OneEighth = 1.0/8.0;
-const double OneTwelfth = 1.0/12.0;
+constexpr double OneThird = 1.0/3.0;
+constexpr double TwoThirds = 2.0/3.0;
+constexpr double OneSixth = 1.0/6.0;
+constexpr double OneEighth = 1.0/8.0;
+constexpr double OneTwelfth = 1.0/12.0;
 
 const double Root2 = sqrt(2.0);
 const double Root3 = sqrt(3.0);
@@ -74,8 +74,8 @@ const double GoldenRatio = (sqrt(5.0)+1.0)*0.5;
 const double GoldenRatioInv = (sqrt(5.0)-1.0)*0.5;  // 1.0/GoldenRatio
 
 // Special purpose constants
-const double OnePlusEpsilon15 = 1.0+1.0e-15;
-const double OneMinusEpsilon15 = 1.0-1.0e-15;
+constexpr double OnePlusEpsilon15 = 1.0+1.0e-15;
+constexpr double OneMinusEpsilon15 = 1.0-1.0e-15;
 
 const long HALF_LONG_MIN = (LONG_MIN>>1);	// Signed half of long min.
 
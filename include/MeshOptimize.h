@@ -0,0 +1,63 @@
+// *******************************
+// MeshOptimize.h
+//
+// Vertex cache ordering and compact vertex formats for the GlGeom meshes.
+//
+// TipsifyTriangles() reorders an indexed triangle list so that vertices
+//    are reused while they are still in the GPU's post-transform cache
+//    (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex
+//    Locality and Reduced Overdraw", 2007).  It runs in linear time.
+//    AverageCacheMissRatio() measures the result: the number of vertices
+//    transformed per triangle with a FIFO cache.
+//
+// The packed vertex format is, per vertex:
+//    the position, as four normalized signed shorts (GL_SHORT, the fourth is 0),
+//    the normal (optional), as GL_INT_2_10_10_10_REV, normalized,
+//    the texture coordinates (optional), as two half floats (GL_HALF_FLOAT).
+//    This is 16 bytes instead of 32, for positions in [-1,1]^3.
+//    The shaders see the same vec3 and vec2 attributes as before.
+//
+// None of these make OpenGL calls, so they can be used on any thread.
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+#pragma once
+
+#ifndef MESH_OPTIMIZE_H
+#define MESH_OPTIMIZE_H
+
+const int MeshVertexCacheSize = 16;     // A typical post-transform cache size
+
+// Convert one triangle strip to a triangle list, keeping the orientation of
+//    every triangle and dropping degenerate ones.  Returns the number of indices
+//    written to triangles (at most 3*(length-2)).
+long StripToTriangles(const unsigned short* strip, long length, unsigned int* triangles);
+long StripToTriangles(const unsigned int* strip, long length, unsigned int* triangles);
+
+// Reorder the triangles (numIndices/3 of them) for a vertex cache of size cacheSize.
+//    Every index must be less than numVertices.  out may not be triangles.
+void TipsifyTriangles(const unsigned int* triangles, long numIndices, long numVertices,
+                      int cacheSize, unsigned int* out);
+
+double AverageCacheMissRatio(const unsigned int* triangles, long numIndices, int cacheSize);
+
+// The packed vertex format, see above.
+int PackedVertexStride(bool normals, bool texCoords);   // In bytes
+int PackedNormalOffset();
+int PackedTexOffset(bool normals);
+
+// Pack float vertices (stride floats apart, the position first) into the packed format.
+//    normalOffset and texOffset are in floats, or negative if there are none.
+void PackVertices(const float* vertices, long numVertices, int stride, int normalOffset, int texOffset,
+                  void* packed);
+
+// Copy the indices as unsigned shorts if shortIndices is true, else as unsigned ints.
+void CopyIndices(const unsigned int* indices, long count, bool shortIndices, void* out);
+
+unsigned short FloatToHalf(float x);        // Rounds to nearest even
+unsigned int PackSnorm10x3(float x, float y, float z);      // For GL_INT_2_10_10_10_REV
+
+#endif // MESH_OPTIMIZE_H
@@ -21,26 +21,27 @@
 #include "LinearR4.h"
 #include "MathMisc.h"
 
-const double floatingHeight = 3.0;
-const double axleHeight = 1.0;
-const double axleRadius = 0.1;
-const double centerSphereRadius = 0.3;
-const double bladeLength = 1.5;
-const double bladeWidth = 0.2;
-const double bladeHeight = 0.05;
-const double frameLength = 3.0;
-const double frameRadius = 0.2;
-const double connectSphereRadius = 0.25;
-const double droneHeight = connectSphereRadius + axleHeight;
-const double centerOfGravityHeight = 0.0 * droneHeight - floatingHeight;
-
-const double density = 3.0;
-const double totalMass = density * frameLength * PI * frameRadius * frameRadius * 4.0;
-const double inertiaPerMassAxle = frameRadius * frameRadius / 2.0;
-const double inertiaPerMassEnd = (3.0 * frameRadius * frameRadius + 4.0 * frameLength * frameLength) / 12.0;
-const double Ix = inertiaPerMassAxle * totalMass / 2.0 + inertiaPerMassEnd * totalMass / 2.0;
-const double Iy = inertiaPerMassEnd * totalMass;
-const LinearMapR3 momentOfInertia = LinearMapR3(Ix, 0.0, 0.0, 0.0, Iy, 0.0, 0.0, 0.0, Ix);
+constexpr double floatingHeight = 3.0;
+constexpr double axleHeight = 1.0;
+constexpr double axleRadius = 0.1;
+constexpr double centerSphereRadius = 0.3;
+constexpr double bladeLength = 1.5;
+constexpr double bladeWidth = 0.2;
+constexpr double bladeHeight = 0.05;
+constexpr double frameLength = 3.0;
+constexpr double frameRadius = 0.2;
+constexpr double connectSphereRadius = 0.25;
+constexpr double droneHeight = connectSphereRadius + axleHeight;
+constexpr double centerOfGravityHeight = 0.0 * droneHeight - floatingHeight;
+
+constexpr double density = 3.0;
+constexpr double totalMass = density * frameLength * PI * frameRadius * frameRadius * 4.0;
+constexpr double inertiaPerMassAxle = frameRadius * frameRadius / 2.0;
+constexpr double inertiaPerMassEnd = (3.0 * frameRadius * frameRadius + 4.0 * frameLength * frameLength) / 12.0;
+constexpr double Ix = inertiaPerMassAxle * totalMass / 2.0 + inertiaPerMassEnd * totalMass / 2.0;
+constexpr double Iy = inertiaPerMassEnd * totalMass;
+constexpr LinearMapR3 momentOfInertia = LinearMapR3(Ix, 0.0, 0.0, 0.0, Iy, 0.0, 0.0, 0.0, Ix);
+constexpr LinearMapR3 momentOfInertiaInverse = momentOfInertia.Inverse();   // Computed at compile time
 
 //
 // Function Prototypes
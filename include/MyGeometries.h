@@ -17,7 +17,8 @@
 // Information for loading textures
 // **************************
 const int NumTextures = 5;
-//unsigned int TextureNames[NumTextures];     // Texture names generated by OpenGL
+const int TextureLayerSize = 1024;      // The textures are resized to this, as layers of one texture array
+extern unsigned int TextureArrayName;   // The texture array: layer i is TextureFiles[i]
 //const char* TextureFiles[NumTextures];
 
 // *******************************
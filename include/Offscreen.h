@@ -0,0 +1,36 @@
+// *******************************
+// Offscreen.h
+//
+// Rendering without a window, for running the program on machines with
+//    no display (no X or Wayland server), e.g., for regression tests and
+//    benchmarks.
+//
+// On Linux, CreateOffscreenContext() makes a "surfaceless" EGL context:
+//    an OpenGL 3.3 core context with no window and no default frame buffer.
+//    Mesa's llvmpipe software renderer suffices.  Link with -lEGL.
+// Elsewhere, it makes a hidden GLFW window instead.
+// Either way, the scene is rendered into the frame buffer object made by
+//    CreateOffscreenFramebuffer().
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+#pragma once
+
+#ifndef OFFSCREEN_H
+#define OFFSCREEN_H
+
+// Create an OpenGL context without a window, and make it current.
+//    Returns false (after printing an error) if that is not possible.
+bool CreateOffscreenContext();
+void DestroyOffscreenContext();
+
+// Create a frame buffer object of width x height pixels, with color and
+//    depth buffers, and bind it for drawing and reading.
+//    Returns false (after printing an error) if it is not complete.
+bool CreateOffscreenFramebuffer(int width, int height);
+void DeleteOffscreenFramebuffer();
+
+#endif // OFFSCREEN_H
@@ -0,0 +1,98 @@
+// *******************************
+// Profiler.h
+//
+// A small hierarchical CPU profiler.
+//
+// PROFILE_SCOPE("name") at the top of a function (or block) times it,
+//    from there to the end of the block.  Scopes nest: a scope's "self"
+//    time is its time less the time of the scopes nested inside it.
+// When the profiler is off, a scope costs one relaxed atomic load.
+//    When it is on, each thread appends its timings to its own buffer:
+//    there is no lock on the way, and no allocation after the buffer
+//    is made.  A full buffer drops further timings (and counts them).
+//
+// The timings can be written as a Chrome trace ("Trace Event Format"
+//    JSON), to be opened in chrome://tracing or ui.perfetto.dev,
+//    and summarized with the AsyncLog: the top scopes by self time.
+//
+// The name must be a string literal (only its pointer is kept).
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+#pragma once
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <chrono>
+
+constexpr int ProfileEventsPerThread = 1 << 18;    // Timings kept per thread (32 bytes each)
+constexpr int ProfileSummaryTopN = 8;               // Scopes listed by ProfilerFrameEnd's summaries
+
+extern std::atomic<bool> profilerEnabled;
+
+// Clear the timings and start timing the scopes.
+void StartProfiler();
+// Stop timing.  The timings are kept until the next StartProfiler().
+void StopProfiler();
+bool ProfilerRunning();
+
+// Write the timings as a Chrome trace.  Returns false on failure.
+bool WriteProfilerTrace(const char* filename);
+
+// Log the topN scopes by self time, over the timings since the previous summary.
+void LogProfilerSummary(int topN);
+
+// Call once a frame: while the profiler is running, logs a summary
+//    (of the top ProfileSummaryTopN scopes) about once a second.
+void ProfilerFrameEnd();
+
+// ********
+// ProfileScope -
+//   Times the block it is declared in.  Use PROFILE_SCOPE.
+// ********
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name);
+    ~ProfileScope();
+
+private:
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    void Begin(const char* name);
+    void End();
+
+    const char* Name;               // Null if the profiler was off when the scope began
+    long long StartTick;
+    long long ChildTicks;           // Time in the scopes nested inside this one
+    ProfileScope* Parent;
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(name)
+
+// *************************************
+// Inlined functions
+// *************************************
+
+inline ProfileScope::ProfileScope(const char* name) : Name(nullptr)
+{
+    if (profilerEnabled.load(std::memory_order_relaxed)) {
+        Begin(name);
+    }
+}
+
+inline ProfileScope::~ProfileScope()
+{
+    if (Name != nullptr) {
+        End();
+    }
+}
+
+#endif // PROFILER_H
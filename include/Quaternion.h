@@ -0,0 +1,210 @@
+// *******************************
+// Quaternion.h
+//
+// Quaternion: a double precision quaternion, for rotations in R3.
+//    The unit quaternion (u*sin(theta/2), cos(theta/2)) is the rotation
+//    by the angle theta around the unit vector u.  q and -q are the same
+//    rotation.
+//
+// The product p*q is the rotation q followed by the rotation p, the same
+//    order as for the products of RotationMapR3's.
+// Exp() and Log() convert between unit quaternions and the pure
+//    quaternions (v,0): Exp(v) is the rotation by the angle 2|v| around v.
+//    SetRotate() and VectorR3::Set() use rotation vectors instead,
+//    the axis times the full angle.
+// The conversions to RotationMapR3 and LinearMapR4 use no trig functions.
+//
+// Slerp() and Nlerp() interpolate along the shorter arc.  Nlerp() is much
+//    cheaper, and is close enough for nearby orientations, e.g. for
+//    smoothing between two physics steps.  Both have batch versions which
+//    interpolate whole arrays of orientations with one parameter t.
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+#pragma once
+
+#ifndef QUATERNION_H
+#define QUATERNION_H
+
+#include <math.h>
+#include <assert.h>
+
+#include "LinearR3.h"
+#include "LinearR4.h"
+
+class Quaternion {
+
+public:
+    double x, y, z, w;      // w is the real part
+
+public:
+    Quaternion() : x(0.0), y(0.0), z(0.0), w(1.0) {}        // The identity rotation
+    Quaternion(double xx, double yy, double zz, double ww) : x(xx), y(yy), z(zz), w(ww) {}
+    Quaternion(const VectorR3& u, double theta) { Set(u, theta); }
+
+    Quaternion& Set(double xx, double yy, double zz, double ww)
+        { x = xx; y = yy; z = zz; w = ww; return *this; }
+    Quaternion& Set(const VectorR4& v) { return Set(v.x, v.y, v.z, v.w); }
+    Quaternion& Set(const VectorR3& u, double theta);       // u must be a unit vector
+    Quaternion& Set(const Matrix3x3& R);                    // R must be a rotation
+    Quaternion& SetRotate(const VectorR3& rotVec);          // Axis times angle
+    Quaternion& SetIdentity() { return Set(0.0, 0.0, 0.0, 1.0); }
+
+    double NormSq() const { return x*x + y*y + z*z + w*w; }
+    double Norm() const { return sqrt(NormSq()); }
+    Quaternion& Normalize() { return *this *= 1.0 / Norm(); }      // No error checking
+    Quaternion& ReNormalize();      // Cheaper, for a quaternion already close to unit
+    double Angle() const;           // The rotation angle, in [0,PI]
+
+    Quaternion Conjugate() const { return Quaternion(-x, -y, -z, w); }
+    Quaternion Inverse() const;
+    Quaternion& Invert();
+
+    Quaternion& operator*=(const Quaternion& q);   // *this = (*this)*q
+    Quaternion& operator+=(const Quaternion& q) { x += q.x; y += q.y; z += q.z; w += q.w; return *this; }
+    Quaternion& operator-=(const Quaternion& q) { x -= q.x; y -= q.y; z -= q.z; w -= q.w; return *this; }
+    Quaternion& operator*=(double m) { x *= m; y *= m; z *= m; w *= m; return *this; }
+    Quaternion& operator/=(double m) { return *this *= 1.0 / m; }
+    Quaternion operator-() const { return Quaternion(-x, -y, -z, -w); }
+
+    bool operator==(const Quaternion& q) const { return x == q.x && y == q.y && z == q.z && w == q.w; }
+    bool operator!=(const Quaternion& q) const { return !(*this == q); }
+};
+
+inline Quaternion operator*(const Quaternion& p, const Quaternion& q);  // Quaternion product
+inline Quaternion operator+(const Quaternion& p, const Quaternion& q)
+    { return Quaternion(p.x + q.x, p.y + q.y, p.z + q.z, p.w + q.w); }
+inline Quaternion operator-(const Quaternion& p, const Quaternion& q)
+    { return Quaternion(p.x - q.x, p.y - q.y, p.z - q.z, p.w - q.w); }
+inline Quaternion operator*(const Quaternion& q, double m) { return Quaternion(q.x*m, q.y*m, q.z*m, q.w*m); }
+inline Quaternion operator*(double m, const Quaternion& q) { return q * m; }
+inline double operator^(const Quaternion& p, const Quaternion& q)      // Inner product
+    { return p.x*q.x + p.y*q.y + p.z*q.z + p.w*q.w; }
+
+Quaternion Exp(const VectorR3& v);      // The exponential of the pure quaternion (v,0)
+VectorR3 Log(const Quaternion& q);      // q must be a unit quaternion; Exp(Log(q)) == q
+
+Quaternion Slerp(const Quaternion& q0, const Quaternion& q1, double t);    // q0, q1 unit
+Quaternion Nlerp(const Quaternion& q0, const Quaternion& q1, double t);
+
+// Batch interpolation: out[i] is the interpolation from q0[i] to q1[i].
+//    out may be q0 or q1.
+void Slerp(const Quaternion* q0, const Quaternion* q1, double t, Quaternion* out, long count);
+void Nlerp(const Quaternion* q0, const Quaternion* q1, double t, Quaternion* out, long count);
+
+std::ostream& operator<<(std::ostream& os, const Quaternion& q);
+
+// ***************************************************************
+// * Inlined member functions                                    *
+// ***************************************************************
+
+inline Quaternion operator*(const Quaternion& p, const Quaternion& q)
+{
+    return Quaternion(p.w*q.x + p.x*q.w + p.y*q.z - p.z*q.y,
+                      p.w*q.y + p.y*q.w + p.z*q.x - p.x*q.z,
+                      p.w*q.z + p.z*q.w + p.x*q.y - p.y*q.x,
+                      p.w*q.w - p.x*q.x - p.y*q.y - p.z*q.z);
+}
+
+inline Quaternion& Quaternion::operator*=(const Quaternion& q)
+{
+    return *this = (*this) * q;
+}
+
+inline Quaternion& Quaternion::Set(const VectorR3& u, double theta)
+{
+    assert(fabs(u.NormSq() - 1.0) < 2.0e-6);
+    double halfTheta = 0.5 * theta;
+    double s = sin(halfTheta);
+    return Set(u.x*s, u.y*s, u.z*s, cos(halfTheta));
+}
+
+inline Quaternion& Quaternion::SetRotate(const VectorR3& rotVec)
+{
+    return *this = Exp(0.5 * rotVec);
+}
+
+// One Newton step towards 1/Norm(): exact to first order in NormSq()-1.
+inline Quaternion& Quaternion::ReNormalize()
+{
+    return *this *= 1.5 - 0.5 * NormSq();
+}
+
+inline Quaternion Quaternion::Inverse() const
+{
+    return Conjugate() * (1.0 / NormSq());
+}
+
+inline Quaternion& Quaternion::Invert()
+{
+    return *this = Inverse();
+}
+
+// The rotation vector: the rotation axis times the angle, in [0,PI].
+template<class T>
+inline VectorR3T<T>& VectorR3T<T>::Set(const Quaternion& q)
+{
+    VectorR3 v = (q.w >= 0.0) ? Log(q) : Log(-q);
+    return Set((T)(2.0*v.x), (T)(2.0*v.y), (T)(2.0*v.z));
+}
+
+// Rotate by the unit quaternion q: u + w*t + (x,y,z)*t, where t = 2*(x,y,z)*u.
+template<class T>
+inline VectorR3T<T>& VectorR3T<T>::Rotate(const Quaternion& q)
+{
+    T tx = 2.0*(q.y*z - q.z*y);
+    T ty = 2.0*(q.z*x - q.x*z);
+    T tz = 2.0*(q.x*y - q.y*x);
+    return Set(x + q.w*tx + q.y*tz - q.z*ty,
+               y + q.w*ty + q.z*tx - q.x*tz,
+               z + q.w*tz + q.x*ty - q.y*tx);
+}
+
+template<class T>
+inline VectorR4T<T>& VectorR4T<T>::Set(const Quaternion& q)
+{
+    return Set((T)q.x, (T)q.y, (T)q.z, (T)q.w);
+}
+
+// The rotation matrix of q, in the upper left 3x3 part.  q need not be a
+//    unit quaternion: it is scaled by 2/NormSq().
+template<class T>
+LinearMapR4T<T>& LinearMapR4T<T>::Set_glRotate(const Quaternion& q)
+{
+    T s = 2.0 / q.NormSq();
+    T xs = q.x*s, ys = q.y*s, zs = q.z*s;
+    T wx = q.w*xs, wy = q.w*ys, wz = q.w*zs;
+    T xx = q.x*xs, xy = q.x*ys, xz = q.x*zs;
+    T yy = q.y*ys, yz = q.y*zs, zz = q.z*zs;
+    m11 = 1.0 - (yy + zz);
+    m21 = xy + wz;
+    m31 = xz - wy;
+    m12 = xy - wz;
+    m22 = 1.0 - (xx + zz);
+    m32 = yz + wx;
+    m13 = xz + wy;
+    m23 = yz - wx;
+    m33 = 1.0 - (xx + yy);
+    m41 = m42 = m43 = m14 = m24 = m34 = 0.0;
+    m44 = 1.0;
+    return *this;
+}
+
+template<class T>
+inline LinearMapR4T<T>& LinearMapR4T<T>::Mult_glRotate(const Quaternion& q)
+{
+    LinearMapR4T<T> rotMatrix;
+    rotMatrix.Set_glRotate(q);
+    (*this) *= rotMatrix;
+    return *this;
+}
+
+inline Quaternion ToQuaternion(const RotationMapR3& R)
+{
+    return Quaternion().Set(R);
+}
+
+#endif // QUATERNION_H
@@ -0,0 +1,22 @@
+// *******************************
+// RenderStats.h
+//
+// Count of the draw calls issued, for the benchmark mode.
+//    Every function that calls glDrawElements() or glMultiDrawElements()
+//    (or their indirect versions) calls CountDrawCall() once per call.
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+#pragma once
+
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+extern unsigned long renderDrawCalls;      // Draw calls since it was last reset to zero
+
+inline void CountDrawCall() { renderDrawCalls++; }
+
+#endif // RENDER_STATS_H
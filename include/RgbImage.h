@@ -38,6 +38,11 @@ public:
 
 	bool LoadBmpFile( const char *filename );	    // Loads the bitmap from the specified file
 	bool WriteBmpFile( const char* filename );	    // Write the bitmap to the specified file
+	// The QOI format ("Quite OK Image", qoiformat.org) is lossless, and much
+	//   smaller than BMP for rendered frames, with encoding and decoding in one
+	//   pass over the pixels.  The file is read and written in large blocks.
+	bool LoadQoiFile( const char* filename );
+	bool WriteQoiFile( const char* filename );
 #ifndef RGBIMAGE_DONT_USE_OPENGL
 	bool LoadFromOpenglBuffer();				    // Load the bitmap from the current OpenGL buffer
 #endif
@@ -60,12 +65,32 @@ public:
 	void SetRgbPixelc( long row, long col, 
 					   unsigned char red, unsigned char green, unsigned char blue );
 
+	// Make the next mipmap level: each dimension is halved (rounding down, but at
+	//   least 1).  The filter is the separable 1-3-3-1 tent filter, which blurs
+	//   less than a box filter while still avoiding aliasing.
+	// The filter uses SSE2 when available; the rows of large images are split
+	//   among numThreads threads (0 means one per core).
+	bool Downsample( RgbImage& halfImage, int numThreads=0 ) const;
+	// Make the mipmap chain below this image, down to 1x1: levels[0] is half
+	//   size, levels[1] quarter size, etc.  Returns the number of levels made,
+	//   at most maxLevels (and NumMipmapLevels()-1 if there is room).
+	int BuildMipmaps( RgbImage* levels, int maxLevels, int numThreads=0 ) const;
+	// Number of mipmap levels of an image this size, counting the image itself.
+	static int NumMipmapLevels( long numRows, long numCols );
+	// Resample the image to numRows x numCols, with bilinear interpolation
+	//   (after halving with Downsample, on numThreads threads, while the image is
+	//   twice the size or more).
+	bool Resize( RgbImage& resized, long numRows, long numCols, int numThreads=0 ) const;
+
+	// Swap the red and blue values of numPixels consecutive pixels (BGR <-> RGB)
+	static void SwapRedBlue( unsigned char* pixels, long numPixels );
+
 	// Error reporting. (errors also print message to stderr)
 	int GetErrorCode() const { return ErrorCode; }
 	enum {
 		NoError = 0,
 		OpenError = 1,			// Unable to open file for reading
-		FileFormatError = 2,	// Not recognized as a 24 bit BMP file
+		FileFormatError = 2,	// Not recognized as a 24 bit BMP file (or a QOI file)
 		MemoryError = 3,		// Unable to allocate memory for image data
 		ReadError = 4,			// End of file reached prematurely
 		WriteError = 5			// Unable to write out data (or no date to write out)
@@ -77,13 +102,16 @@ private:
 	long NumCols;				// number of columns in image
 	int ErrorCode;				// error code
 
-	static short readShort( FILE* infile );
-	static long readLong( FILE* infile );
-	static void skipChars( FILE* infile, int numChars );
-	static void writeLong( long data, FILE* outfile );
-	static void writeShort( short data, FILE* outfile );
+	static short getShort( const unsigned char* bytes );
+	static long getLong( const unsigned char* bytes );
+	static void putLong( long data, unsigned char* bytes );
+	static void putShort( short data, unsigned char* bytes );
+	static long getLongBigEndian( const unsigned char* bytes );
+	static void putLongBigEndian( long data, unsigned char* bytes );
 	
 	static unsigned char doubleToUnsignedChar( double x );
+	static long ClampIndex( long i, long n ) { return i<0 ? 0 : (i>=n ? n-1 : i); }
+	void DownsampleRows( RgbImage& halfImage, long firstRow, long endRow ) const;
 
 };
 
@@ -22,7 +22,6 @@ constexpr unsigned int vertNormal_loc = 1;      // Location of vertex normal in
 constexpr unsigned int vertTexCoords_loc = 2;   // Location of vertex texture coordinates in vertex shaders
 extern unsigned int projMatLocation;		    // Location of the projectionMatrix in the shader programs.
 extern unsigned int modelviewMatLocation;	    // Location of the modelviewMatrix in the shader programs.
-extern unsigned int applyTextureLocation;	    // Location of the modelviewMatrix in the shader programs.
 
 extern float matEntries[16];	// Holds 16 floats (since cannot load doubles into a shader that uses floats)
 
@@ -33,6 +32,34 @@ extern float matEntries[16];	// Holds 16 floats (since cannot load doubles into
 
 unsigned int setup_shader_vertfrag(const char* vertexShaderSource, const char* fragmentShaderSource);
 
+// Same as setup_shader_vertfrag, but first tries to load a previously linked
+//    program binary from the file cacheFileName (with glProgramBinary).
+//    The cached binary is used only if it was made from the same shader source
+//    by the same driver (vendor, renderer and version strings).
+//    Otherwise the shaders are compiled and the new binary is saved to the file.
+unsigned int setup_shader_vertfrag_cached(const char* vertexShaderSource, const char* fragmentShaderSource,
+                                          const char* cacheFileName);
+extern bool shaderBinaryCacheEnabled;       // Set false to always compile from source.
+
+// Asynchronous builds.
+//    start_shader_vertfrag() starts compiling and linking a program, and returns
+//    a build number at once.  The driver compiles in the background if it supports
+//    GL_KHR_parallel_shader_compile; otherwise a worker thread does it, if one was
+//    started with start_shader_compile_thread(); otherwise it is done immediately.
+//    finish_shader_vertfrag() waits for the build, checks for errors
+//    and returns the program, the same as setup_shader_vertfrag_cached().
+int start_shader_vertfrag(const char* vertexShaderSource, const char* fragmentShaderSource,
+                          const char* cacheFileName);
+bool is_shader_build_done(int buildNumber);             // Never waits
+unsigned int finish_shader_vertfrag(int buildNumber);
+
+// The worker thread makes the (hidden) sharedContextWindow's context current,
+//    which must share objects with the main window's context.
+//    It is only needed when parallel_shader_compile_supported() is false.
+bool parallel_shader_compile_supported();
+void start_shader_compile_thread(GLFWwindow* sharedContextWindow);
+void stop_shader_compile_thread();
+
 GLuint check_compilation_shader(GLuint shader);
 GLuint check_link_status(GLuint program);
 
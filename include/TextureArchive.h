@@ -0,0 +1,99 @@
+// *******************************
+// TextureArchive.h
+//
+// A texture archive holds all the scene's textures in one file, ready to
+//    be uploaded: each texture has its complete mipmap chain, computed
+//    offline with a good filter, with rows padded exactly as OpenGL
+//    expects for the archive's row alignment.
+// The archive is made by the TexturePack tool (tools/TexturePack.cpp).
+//
+// At run time the file is memory mapped, and each mipmap level is passed
+//    straight from the mapped file to glTexImage2D: there is nothing to
+//    parse except the fixed size directory, and no intermediate copies.
+// Textures may also be stored BC1 compressed (TexturePack -bc1).  If the
+//    driver lacks S3TC support, they are decompressed when uploaded.
+//
+// File layout (little endian):
+//    TextureArchiveHeader
+//    TextureArchiveEntry[NumTextures]
+//    pixel data for each level, starting at multiples of TextureArchiveDataAlignment
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+#pragma once
+
+#ifndef TEXTURE_ARCHIVE_H
+#define TEXTURE_ARCHIVE_H
+
+#include <stdint.h>
+
+const char TextureArchiveMagic[8] = { 'T', 'E', 'X', 'P', 'A', 'C', 'K', '1' };
+constexpr int TextureArchiveMaxLevels = 16;         // Enough for 32768 x 32768 textures
+constexpr uint32_t TextureArchiveMaxSize = 32768;     // Largest width or height of a level
+constexpr int TextureArchiveNameLength = 56;
+constexpr int TextureArchiveDataAlignment = 4096;   // Level data starts on a page boundary
+constexpr uint32_t TextureArchiveBC1 = 0x83F0;      // GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+
+struct TextureArchiveHeader {
+    char Magic[8];
+    uint32_t NumTextures;
+    uint32_t EntrySize;                 // sizeof(TextureArchiveEntry), as a version check
+    uint64_t FileSize;
+};
+
+struct TextureArchiveEntry {
+    char Name[TextureArchiveNameLength];        // File the texture came from (e.g., "sky.bmp"), null terminated
+    uint32_t Format;                            // GL_RGB, GL_RGBA or TextureArchiveBC1
+    uint32_t BytesPerPixel;                     // 3 or 4 (0 if compressed)
+    uint32_t RowAlignment;                      // Rows are padded to a multiple of this (GL_UNPACK_ALIGNMENT)
+    uint32_t NumLevels;
+    uint32_t LevelWidth[TextureArchiveMaxLevels];
+    uint32_t LevelHeight[TextureArchiveMaxLevels];
+    uint64_t LevelOffset[TextureArchiveMaxLevels];   // From the start of the file
+};
+
+static_assert(sizeof(TextureArchiveHeader) == 24, "TextureArchiveHeader layout");
+static_assert(sizeof(TextureArchiveEntry) == 56 + 16 + 2*4*TextureArchiveMaxLevels + 8*TextureArchiveMaxLevels,
+              "TextureArchiveEntry layout");
+
+// ********
+// TextureArchive -
+//   A memory mapped texture archive.
+// ********
+class TextureArchive {
+public:
+    TextureArchive();
+    ~TextureArchive();
+
+    bool Open(const char* fileName);    // Map the file, and check its header. Prints an error on failure.
+    void Close();
+    bool IsOpen() const { return Data != 0; }
+
+    int GetNumTextures() const { return NumTextures; }
+    const TextureArchiveEntry& GetEntry(int i) const { return Entries[i]; }
+    int FindTexture(const char* name) const;        // Index of the texture, or -1
+    static uint64_t LevelSize(const TextureArchiveEntry& entry, int level);    // Bytes of data in the level
+
+    // Upload every mipmap level of the i-th texture into textureName.
+    //   Sets GL_TEXTURE_MAX_LEVEL; leaves the other texture parameters alone.
+    void Upload(int i, unsigned int textureName) const;
+
+    // Upload the i-th texture into a layer of a texture array (see AllocateTextureArray
+    //   in TextureLoader.h).  Does nothing, and returns false, unless the texture is
+    //   layerSize x layerSize with all its mipmaps, and is compressed exactly if the array is.
+    bool UploadLayer(int i, unsigned int arrayName, int layer, int layerSize, bool compressed) const;
+
+private:
+    void UploadCompressed(const TextureArchiveEntry& entry, unsigned int textureName) const;
+
+    const unsigned char* Data;          // The mapped file
+    uint64_t Size;
+    int NumTextures;
+    const TextureArchiveEntry* Entries;
+    void* MappingHandle;                // Windows file mapping (unused elsewhere)
+};
+
+#endif // TEXTURE_ARCHIVE_H
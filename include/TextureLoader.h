@@ -0,0 +1,51 @@
+// *******************************
+// TextureLoader.h
+//
+// Loads texture maps from BMP files in the background, into the layers of
+//    a 2D texture array, so that one texture binding serves every draw.
+//    Each layer is layerSize x layerSize, with a full mipmap chain.
+//
+// AllocateTextureArray() makes every layer mid-gray.  StartTextureLayerLoads()
+//    returns at once; worker threads then decode the files, resize them to
+//    the layer size (RgbImage::Resize) and build their mipmaps (with
+//    RgbImage::BuildMipmaps, not glGenerateMipmap).
+// PollTextureLoads() is called once per frame on the thread that owns the
+//    OpenGL context.  It uploads the images that are ready through a pixel
+//    buffer object.  Until then the scene renders with the gray layers.
+//
+// If textureCompressionEnabled is set and the driver supports S3TC, the worker
+//    threads also compress every level to BC1 (see BlockCompress.h), which
+//    uses a sixth of the memory of GL_RGB textures.
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+#pragma once
+
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <string>
+
+extern bool textureCompressionEnabled;     // Compress textures (BC1) when they are loaded. Default: true
+
+// Allocate the storage of a texture array (BC1 if TextureArrayCompressed()),
+//    and make every layer mid-gray until its image is loaded.
+void AllocateTextureArray(unsigned int arrayName, int numLayers, int layerSize);
+bool TextureArrayCompressed();      // Textures are compressed, and the driver supports it
+
+// Start loading the files into layers of a texture array made by AllocateTextureArray.
+//    If an earlier batch of loads is still decoding, this waits until it is decoded.
+void StartTextureLayerLoads(const std::string* fileNames, unsigned int arrayName, const int* layers,
+                            int numFiles, int layerSize);
+
+// Upload up to maxUploads decoded images.  Returns the number of textures
+//    still waiting for their image.
+int PollTextureLoads(int maxUploads = 2);
+
+// Wait for every texture to be loaded and uploaded.
+void FinishTextureLoads();
+
+#endif // TEXTURE_LOADER_H
@@ -0,0 +1,267 @@
+// *******************************
+// AsyncLog.cpp
+//
+// Lock-free ring buffer and background writer thread for AsyncLog.h.
+//
+// The ring buffer is a bounded multi-producer, single-consumer queue.
+//    Each slot holds a sequence number: a producer claims a slot by
+//    advancing enqueuePos with a compare-and-swap, fills in the record,
+//    and then publishes it by storing the sequence number.
+//    The writer thread is the only consumer.
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+#include <stddef.h>
+#include <string.h>
+#include <thread>
+
+#include "AsyncLog.h"
+
+LogLevel logMinLevel = LogDebug;
+
+namespace {
+
+struct LogRecord {
+    std::atomic<size_t> Sequence;
+    LogLevel Level;
+    const char* Format;
+    unsigned int Suppressed;            // Messages from the same site dropped by rate limiting
+    int NumArgs;
+    LogArg Args[LogMaxArgs];            // Text arguments hold an offset into InlineText in .u
+    char InlineText[LogMaxInlineText];
+};
+
+LogRecord logRing[LogQueueSize];
+std::atomic<size_t> enqueuePos(0);
+size_t dequeuePos = 0;                  // Only touched by the writer thread
+std::atomic<unsigned int> numDropped(0);
+std::atomic<bool> writerRunning(false);
+std::thread writerThread;
+FILE* logStream = 0;
+std::chrono::steady_clock::time_point logStartTime = std::chrono::steady_clock::now();
+std::atomic<long long> lastTimelineNanos(0);   // Time of the last timeline event, since logStartTime
+
+static_assert((LogQueueSize & (LogQueueSize - 1)) == 0, "LogQueueSize must be a power of two");
+
+struct LogRingInit {
+    LogRingInit() {
+        for (size_t i = 0; i < LogQueueSize; i++) {
+            logRing[i].Sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+} logRingInit;
+
+const char* LevelPrefix(LogLevel level)
+{
+    switch (level) {
+    case LogWarning:
+        return "Warning: ";
+    case LogError:
+        return "ERROR: ";
+    default:
+        return "";
+    }
+}
+
+// Format one record, a single conversion at a time, following printf() rules.
+//    Length modifiers in the format are ignored: every integer is held
+//    as a 64 bit value and every floating point value as a double.
+void FormatRecord(const LogRecord& rec, FILE* out)
+{
+    fputs(LevelPrefix(rec.Level), out);
+    int argNum = 0;
+    const char* f = rec.Format;
+    while (*f) {
+        if (*f != '%') {
+            const char* next = strchr(f, '%');
+            size_t len = next ? (size_t)(next - f) : strlen(f);
+            fwrite(f, 1, len, out);
+            f += len;
+            continue;
+        }
+        if (f[1] == '%') {
+            fputc('%', out);
+            f += 2;
+            continue;
+        }
+        // Copy flags, width and precision into spec; skip length modifiers.
+        char spec[32];
+        int s = 0;
+        spec[s++] = *(f++);
+        while (*f && strchr("-+ #0123456789.", *f) && s < 24) {
+            spec[s++] = *(f++);
+        }
+        while (*f && strchr("hlLqjzt", *f)) {
+            f++;
+        }
+        char conv = *f;
+        if (conv == 0) {
+            break;
+        }
+        f++;
+        if (argNum >= rec.NumArgs) {
+            fputs("<missing>", out);
+            continue;
+        }
+        const LogArg& a = rec.Args[argNum++];
+        switch (conv) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': {
+            spec[s++] = 'l'; spec[s++] = 'l'; spec[s++] = conv; spec[s] = 0;
+            if (a.Type == LogArg::Double) {
+                fprintf(out, spec, (long long)a.d);
+            }
+            else {
+                fprintf(out, spec, a.i);
+            }
+            break;
+        }
+        case 'c':
+            spec[s++] = conv; spec[s] = 0;
+            fprintf(out, spec, (int)a.i);
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+            spec[s++] = conv; spec[s] = 0;
+            fprintf(out, spec, a.Type == LogArg::Double ? a.d
+                               : a.Type == LogArg::UInt ? (double)a.u : (double)a.i);
+            break;
+        case 's':
+            spec[s++] = conv; spec[s] = 0;
+            fprintf(out, spec, a.Type == LogArg::Text ? rec.InlineText + a.u : "<not a string>");
+            break;
+        case 'p':
+            spec[s++] = conv; spec[s] = 0;
+            fprintf(out, spec, a.p);
+            break;
+        default:
+            fputs("<bad format>", out);
+            break;
+        }
+    }
+    if (rec.Suppressed > 0) {
+        fprintf(out, " (%u similar messages suppressed)", rec.Suppressed);
+    }
+    fputc('\n', out);
+}
+
+// Write out every record that is ready.  Returns the number written.
+int DrainRing()
+{
+    int count = 0;
+    for (;;) {
+        LogRecord& rec = logRing[dequeuePos & (LogQueueSize - 1)];
+        size_t seq = rec.Sequence.load(std::memory_order_acquire);
+        if (seq != dequeuePos + 1) {
+            break;          // Not yet published
+        }
+        FormatRecord(rec, logStream);
+        rec.Sequence.store(dequeuePos + LogQueueSize, std::memory_order_release);
+        dequeuePos++;
+        count++;
+    }
+    if (count > 0) {
+        fflush(logStream);
+    }
+    return count;
+}
+
+void WriterLoop()
+{
+    while (writerRunning.load(std::memory_order_acquire)) {
+        if (DrainRing() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+    DrainRing();
+}
+
+} // namespace
+
+bool LogPush(LogLevel level, const char* fmt, const LogArg* args, int numArgs, LogSite* site)
+{
+    // Claim a slot
+    LogRecord* rec;
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        rec = &logRing[pos & (LogQueueSize - 1)];
+        size_t seq = rec->Sequence.load(std::memory_order_acquire);
+        ptrdiff_t diff = (ptrdiff_t)seq - (ptrdiff_t)pos;
+        if (diff == 0) {
+            if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        else if (diff < 0) {
+            numDropped.fetch_add(1, std::memory_order_relaxed);   // Queue is full
+            return false;
+        }
+        else {
+            pos = enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Fill in the record. Only string arguments need more than a raw copy.
+    rec->Level = level;
+    rec->Format = fmt;
+    rec->Suppressed = site ? site->TakeSuppressed() : 0;
+    rec->NumArgs = numArgs;
+    int textUsed = 0;
+    for (int i = 0; i < numArgs; i++) {
+        rec->Args[i] = args[i];
+        if (args[i].Type == LogArg::Text) {
+            const char* src = args[i].s ? args[i].s : "(null)";
+            int room = LogMaxInlineText - 1 - textUsed;
+            int len = 0;
+            while (len < room && src[len] != 0) {
+                len++;
+            }
+            memcpy(rec->InlineText + textUsed, src, len);
+            rec->InlineText[textUsed + len] = 0;
+            rec->Args[i].u = textUsed;
+            textUsed += len + (textUsed + len < LogMaxInlineText - 1 ? 1 : 0);
+        }
+    }
+
+    rec->Sequence.store(pos + 1, std::memory_order_release);     // Publish
+    return true;
+}
+
+void StartAsyncLog(FILE* outStream)
+{
+    if (writerRunning.load()) {
+        return;
+    }
+    logStream = outStream;
+    logStartTime = std::chrono::steady_clock::now();
+    lastTimelineNanos.store(0);
+    writerRunning.store(true, std::memory_order_release);
+    writerThread = std::thread(WriterLoop);
+}
+
+void StopAsyncLog()
+{
+    if (!writerRunning.exchange(false)) {
+        return;
+    }
+    writerThread.join();
+    unsigned int dropped = numDropped.load();
+    if (dropped > 0) {
+        fprintf(logStream, "AsyncLog: %u messages dropped (queue full).\n", dropped);
+        fflush(logStream);
+    }
+}
+
+unsigned int LogNumDropped()
+{
+    return numDropped.load(std::memory_order_relaxed);
+}
+
+void LogTimelineEvent(const char* label)
+{
+    long long now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - logStartTime).count();
+    long long previous = lastTimelineNanos.exchange(now);
+    LogMessage(LogInfo, "[startup %8.2f ms  +%7.2f ms] %s", now * 1.0e-6, (now - previous) * 1.0e-6, label);
+}
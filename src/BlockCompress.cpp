@@ -0,0 +1,319 @@
+// *******************************
+// BlockCompress.cpp
+//
+// BC1 and BC3 block compression (see BlockCompress.h).
+//
+// Color block: two RGB 565 endpoints c0 > c1, then 16 two-bit indices:
+//    0 = c0, 1 = c1, 2 = (2*c0 + c1)/3, 3 = (c0 + 2*c1)/3.
+// Alpha block: two alpha endpoints a0 > a1, then 16 three-bit indices:
+//    0 = a0, 1 = a1, and 2..7 interpolate from a0 towards a1 in sevenths.
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+#include <math.h>
+#include <string.h>
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLOCK_COMPRESS_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "BlockCompress.h"
+#include "RgbImage.h"
+
+namespace {
+
+// Copy a 4x4 block into RGBA order, repeating the last row and column at the edges.
+void GatherBlock(const unsigned char* pixels, long x, long y, long width, long height,
+                 long bytesPerRow, int bytesPerPixel, unsigned char rgba[64])
+{
+    for (int j = 0; j < 4; j++) {
+        long row = (y + j < height) ? y + j : height - 1;
+        const unsigned char* rowPtr = pixels + row * bytesPerRow;
+        for (int i = 0; i < 4; i++) {
+            long col = (x + i < width) ? x + i : width - 1;
+            const unsigned char* p = rowPtr + col * bytesPerPixel;
+            unsigned char* q = rgba + 4 * (4 * j + i);
+            q[0] = p[0];
+            q[1] = p[1];
+            q[2] = p[2];
+            q[3] = (bytesPerPixel == 4) ? p[3] : 255;
+        }
+    }
+}
+
+inline int To565(int r, int g, int b)
+{
+    return (((r * 31 + 127) / 255) << 11) | (((g * 63 + 127) / 255) << 5) | ((b * 31 + 127) / 255);
+}
+
+inline void From565(int c, int rgb[3])
+{
+    int r = (c >> 11) & 0x1f, g = (c >> 5) & 0x3f, b = c & 0x1f;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+inline void Store16(unsigned char* out, int v)
+{
+    out[0] = (unsigned char)v;
+    out[1] = (unsigned char)(v >> 8);
+}
+
+inline void Store32(unsigned char* out, unsigned int v)
+{
+    out[0] = (unsigned char)v;
+    out[1] = (unsigned char)(v >> 8);
+    out[2] = (unsigned char)(v >> 16);
+    out[3] = (unsigned char)(v >> 24);
+}
+
+// The endpoints for a block's color bounding box, inset by 1/16 of its size
+//    (which lowers the error of a range fit).  Returns false if both
+//    endpoints are the same color.  end0 and end1 are the expanded 565 colors.
+bool ColorEndpoints(const int minColor[3], const int maxColor[3], int* c0, int* c1, int end0[3], int end1[3])
+{
+    int lo[3], hi[3];
+    for (int k = 0; k < 3; k++) {
+        int inset = (maxColor[k] - minColor[k]) >> 4;
+        lo[k] = minColor[k] + inset;
+        hi[k] = maxColor[k] - inset;
+    }
+    *c0 = To565(hi[0], hi[1], hi[2]);
+    *c1 = To565(lo[0], lo[1], lo[2]);
+    From565(*c0, end0);
+    From565(*c1, end1);
+    return *c0 != *c1;          // Quantization is monotonic, so otherwise c0 > c1
+}
+
+// Each pixel's level along the diagonal from end1 (level 0) to end0 (level 3)
+//    is the number of thresholds 1/6, 3/6 and 5/6 its projection passes.
+//    With m1, m3, m5 for those comparisons, the BC1 index is ((m1^m5)<<1) | !m3.
+void EncodeColorBlockScalar(const unsigned char rgba[64], unsigned char out[8])
+{
+    int minColor[3] = { 255, 255, 255 }, maxColor[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; i++) {
+        for (int k = 0; k < 3; k++) {
+            int v = rgba[4 * i + k];
+            minColor[k] = v < minColor[k] ? v : minColor[k];
+            maxColor[k] = v > maxColor[k] ? v : maxColor[k];
+        }
+    }
+    int c0, c1, end0[3], end1[3];
+    bool twoColors = ColorEndpoints(minColor, maxColor, &c0, &c1, end0, end1);
+    Store16(out, c0);
+    Store16(out + 2, c1);
+    unsigned int indices = 0;
+    if (twoColors) {
+        int d[3] = { end0[0] - end1[0], end0[1] - end1[1], end0[2] - end1[2] };
+        int total = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+        for (int i = 0; i < 16; i++) {
+            const unsigned char* p = rgba + 4 * i;
+            int dot6 = 6 * ((p[0] - end1[0]) * d[0] + (p[1] - end1[1]) * d[1] + (p[2] - end1[2]) * d[2]);
+            int m1 = dot6 > total, m3 = dot6 > 3 * total, m5 = dot6 > 5 * total;
+            indices |= (unsigned int)(((m1 ^ m5) << 1) | (m3 ^ 1)) << (2 * i);
+        }
+    }
+    Store32(out + 4, indices);
+}
+
+#ifdef BLOCK_COMPRESS_SSE2
+
+// Projections of four RGBA pixels (relative to base) onto the diagonal d.
+inline __m128i Dot4(__m128i pixels, __m128i base, __m128i d)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_madd_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(pixels, zero), base), d);
+    __m128i hi = _mm_madd_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(pixels, zero), base), d);
+    // lo holds (r*dr + g*dg, b*db) for pixels 0 and 1; add the pairs.
+    __m128 even = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 odd = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1));
+    return _mm_add_epi32(_mm_castps_si128(even), _mm_castps_si128(odd));
+}
+
+// The same as EncodeColorBlockScalar, four pixels at a time.
+void EncodeColorBlockSSE2(const unsigned char rgba[64], unsigned char out[8])
+{
+    __m128i row[4];
+    for (int j = 0; j < 4; j++) {
+        row[j] = _mm_loadu_si128((const __m128i*)(rgba + 16 * j));
+    }
+    __m128i vmin = _mm_min_epu8(_mm_min_epu8(row[0], row[1]), _mm_min_epu8(row[2], row[3]));
+    __m128i vmax = _mm_max_epu8(_mm_max_epu8(row[0], row[1]), _mm_max_epu8(row[2], row[3]));
+    vmin = _mm_min_epu8(vmin, _mm_shuffle_epi32(vmin, _MM_SHUFFLE(1, 0, 3, 2)));
+    vmax = _mm_max_epu8(vmax, _mm_shuffle_epi32(vmax, _MM_SHUFFLE(1, 0, 3, 2)));
+    vmin = _mm_min_epu8(vmin, _mm_shuffle_epi32(vmin, _MM_SHUFFLE(2, 3, 0, 1)));
+    vmax = _mm_max_epu8(vmax, _mm_shuffle_epi32(vmax, _MM_SHUFFLE(2, 3, 0, 1)));
+    unsigned int minBits = (unsigned int)_mm_cvtsi128_si32(vmin);
+    unsigned int maxBits = (unsigned int)_mm_cvtsi128_si32(vmax);
+    int minColor[3] = { (int)(minBits & 0xff), (int)((minBits >> 8) & 0xff), (int)((minBits >> 16) & 0xff) };
+    int maxColor[3] = { (int)(maxBits & 0xff), (int)((maxBits >> 8) & 0xff), (int)((maxBits >> 16) & 0xff) };
+
+    int c0, c1, end0[3], end1[3];
+    bool twoColors = ColorEndpoints(minColor, maxColor, &c0, &c1, end0, end1);
+    Store16(out, c0);
+    Store16(out + 2, c1);
+    if (!twoColors) {
+        Store32(out + 4, 0);
+        return;
+    }
+    int d[3] = { end0[0] - end1[0], end0[1] - end1[1], end0[2] - end1[2] };
+    int total = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+    __m128i base = _mm_set_epi16(0, (short)end1[2], (short)end1[1], (short)end1[0],
+                                 0, (short)end1[2], (short)end1[1], (short)end1[0]);
+    __m128i dir = _mm_set_epi16(0, (short)d[2], (short)d[1], (short)d[0], 0, (short)d[2], (short)d[1], (short)d[0]);
+    __m128i t1 = _mm_set1_epi32(total), t3 = _mm_set1_epi32(3 * total), t5 = _mm_set1_epi32(5 * total);
+    __m128i one = _mm_set1_epi32(1), two = _mm_set1_epi32(2);
+    __m128i index[4];
+    for (int j = 0; j < 4; j++) {
+        __m128i dot = Dot4(row[j], base, dir);
+        __m128i dot6 = _mm_add_epi32(_mm_slli_epi32(dot, 2), _mm_slli_epi32(dot, 1));
+        __m128i m1 = _mm_cmpgt_epi32(dot6, t1);
+        __m128i m3 = _mm_cmpgt_epi32(dot6, t3);
+        __m128i m5 = _mm_cmpgt_epi32(dot6, t5);
+        index[j] = _mm_or_si128(_mm_and_si128(_mm_xor_si128(m1, m5), two), _mm_andnot_si128(m3, one));
+    }
+    // Pack the sixteen indices into bytes, then merge neighbours: 2 bits, 4 bits, 8 bits, 16 bits.
+    __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(index[0], index[1]), _mm_packs_epi32(index[2], index[3]));
+    bytes = _mm_and_si128(_mm_or_si128(bytes, _mm_srli_epi16(bytes, 6)), _mm_set1_epi16(0x00ff));
+    bytes = _mm_and_si128(_mm_or_si128(bytes, _mm_srli_epi32(bytes, 12)), _mm_set1_epi32(0x000000ff));
+    bytes = _mm_or_si128(bytes, _mm_srli_epi64(bytes, 24));
+    unsigned int indices = ((unsigned int)_mm_cvtsi128_si32(bytes) & 0xffff)
+        | ((unsigned int)_mm_cvtsi128_si32(_mm_srli_si128(bytes, 8)) << 16);
+    Store32(out + 4, indices);
+}
+
+#endif  // BLOCK_COMPRESS_SSE2
+
+void EncodeAlphaBlock(const unsigned char rgba[64], unsigned char out[8])
+{
+    int minAlpha = 255, maxAlpha = 0;
+    for (int i = 0; i < 16; i++) {
+        int a = rgba[4 * i + 3];
+        minAlpha = a < minAlpha ? a : minAlpha;
+        maxAlpha = a > maxAlpha ? a : maxAlpha;
+    }
+    out[0] = (unsigned char)maxAlpha;
+    out[1] = (unsigned char)minAlpha;
+    unsigned long long indices = 0;
+    int range = maxAlpha - minAlpha;
+    if (range > 0) {
+        for (int i = 0; i < 16; i++) {
+            int level = (14 * (rgba[4 * i + 3] - minAlpha) + range) / (2 * range);  // 0 to 7, from min to max
+            int index = (level == 0) ? 1 : (level == 7) ? 0 : 8 - level;
+            indices |= (unsigned long long)index << (3 * i);
+        }
+    }
+    for (int k = 0; k < 6; k++) {
+        out[2 + k] = (unsigned char)(indices >> (8 * k));
+    }
+}
+
+typedef void ColorBlockEncoder(const unsigned char rgba[64], unsigned char out[8]);
+
+void EncodeImage(ColorBlockEncoder* encodeColor, BlockFormat format, const unsigned char* pixels,
+                 long width, long height, long bytesPerRow, int bytesPerPixel, unsigned char* out)
+{
+    unsigned char rgba[64];
+    for (long y = 0; y < height; y += 4) {
+        for (long x = 0; x < width; x += 4) {
+            GatherBlock(pixels, x, y, width, height, bytesPerRow, bytesPerPixel, rgba);
+            if (format == BlockBC3) {
+                EncodeAlphaBlock(rgba, out);
+                out += 8;
+            }
+            encodeColor(rgba, out);
+            out += 8;
+        }
+    }
+}
+
+} // namespace
+
+void EncodeBlocks(BlockFormat format, const unsigned char* pixels, long width, long height,
+                  long bytesPerRow, int bytesPerPixel, unsigned char* out)
+{
+#ifdef BLOCK_COMPRESS_SSE2
+    EncodeImage(EncodeColorBlockSSE2, format, pixels, width, height, bytesPerRow, bytesPerPixel, out);
+#else
+    EncodeImage(EncodeColorBlockScalar, format, pixels, width, height, bytesPerRow, bytesPerPixel, out);
+#endif
+}
+
+void EncodeBlocksScalar(BlockFormat format, const unsigned char* pixels, long width, long height,
+                        long bytesPerRow, int bytesPerPixel, unsigned char* out)
+{
+    EncodeImage(EncodeColorBlockScalar, format, pixels, width, height, bytesPerRow, bytesPerPixel, out);
+}
+
+void EncodeBlocks(BlockFormat format, const RgbImage& image, unsigned char* out)
+{
+    EncodeBlocks(format, (const unsigned char*)image.ImageData(), image.GetNumCols(), image.GetNumRows(),
+                 image.GetNumBytesPerRow(), 3, out);
+}
+
+void DecodeBlocks(BlockFormat format, const unsigned char* blocks, long width, long height,
+                  long bytesPerRow, unsigned char* rgbOut)
+{
+    for (long y = 0; y < height; y += 4) {
+        for (long x = 0; x < width; x += 4) {
+            if (format == BlockBC3) {
+                blocks += 8;        // Alpha is not decoded
+            }
+            int c0 = blocks[0] | (blocks[1] << 8);
+            int c1 = blocks[2] | (blocks[3] << 8);
+            unsigned int indices = blocks[4] | (blocks[5] << 8) | (blocks[6] << 16) | ((unsigned int)blocks[7] << 24);
+            blocks += 8;
+            int palette[4][3];
+            From565(c0, palette[0]);
+            From565(c1, palette[1]);
+            bool fourColors = (c0 > c1) || format == BlockBC3;
+            for (int k = 0; k < 3; k++) {
+                if (fourColors) {
+                    palette[2][k] = (2 * palette[0][k] + palette[1][k]) / 3;
+                    palette[3][k] = (palette[0][k] + 2 * palette[1][k]) / 3;
+                }
+                else {
+                    palette[2][k] = (palette[0][k] + palette[1][k]) / 2;
+                    palette[3][k] = 0;
+                }
+            }
+            for (int j = 0; j < 4 && y + j < height; j++) {
+                unsigned char* q = rgbOut + (y + j) * bytesPerRow + 3 * x;
+                for (int i = 0; i < 4 && x + i < width; i++) {
+                    const int* c = palette[(indices >> (2 * (4 * j + i))) & 3];
+                    *(q++) = (unsigned char)c[0];
+                    *(q++) = (unsigned char)c[1];
+                    *(q++) = (unsigned char)c[2];
+                }
+            }
+        }
+    }
+}
+
+void DecodeBlocks(BlockFormat format, const unsigned char* blocks, RgbImage& image)
+{
+    DecodeBlocks(format, blocks, image.GetNumCols(), image.GetNumRows(), image.GetNumBytesPerRow(),
+                 image.GetRgbPixel(0, 0));
+}
+
+double ImagePSNR(const RgbImage& a, const RgbImage& b)
+{
+    double sumSq = 0.0;
+    for (long row = 0; row < a.GetNumRows(); row++) {
+        const unsigned char* p = a.GetRgbPixel(row, 0);
+        const unsigned char* q = b.GetRgbPixel(row, 0);
+        long long rowSum = 0;
+        for (long i = 0; i < 3 * a.GetNumCols(); i++) {
+            int diff = p[i] - q[i];
+            rowSum += diff * diff;
+        }
+        sumSq += (double)rowSum;
+    }
+    double mse = sumSq / (3.0 * a.GetNumRows() * a.GetNumCols());
+    return mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+}
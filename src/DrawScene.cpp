@@ -43,10 +43,12 @@
 
 #include "DrawScene.h"
 #include "MyDrone.h"
+#include "RenderStats.h"
 
 const unsigned int aPos_loc = 0;   // Corresponds to "location = 0" in the verter shader definitions
 const unsigned int aColor_loc = 1; // Corresponds to "location = 1" in the verter shader definitions
 bool singleStep = false;
+unsigned long renderDrawCalls = 0;
 
 // These variables control the animation's state and speed.
 // YOU PROBABLY WANT TO RE-DO THIS FOR YOUR CUSTOM ANIMATION.  
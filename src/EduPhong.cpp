@@ -15,16 +15,16 @@
 // *******************************
 
 #include <stdio.h>
+#include <string.h>
 
 #include "ShaderBuild.h"
 #include "EduPhong.h"
+#include "AsyncLog.h"
 
 bool check_for_opengl_errors();
 
 // *********************************
 // Interface data for the shader programs.
-unsigned int phShaderPhongPhong;
-unsigned int phShaderPhongGouraud;
 const unsigned int phVertPos_loc = 0;                  // Corresponds to "location = 0" in the vertex shader definition
 const unsigned int phVertNormal_loc = 1;               // Corresponds to "location = 1" in the vertex shader definition
 const unsigned int phEmissiveColor_loc = 3;            // Corresponds to "location = 3" in the vertex shader definition
@@ -32,32 +32,69 @@ const unsigned int phAmbientColor_loc = 4;             // Corresponds to "locati
 const unsigned int phDiffuseColor_loc = 5;             // Corresponds to "location = 5" in the vertex shader definition
 const unsigned int phSpecularColor_loc = 6;            // Corresponds to "location = 6" in the vertex shader definition
 const unsigned int phSpecularExponent_loc = 7;         // Corresponds to "location = 7" in the vertex shader definition
+const unsigned int phTextureLayer_loc = 8;             // Corresponds to "location = 8" in the vertex shader definition
 
-unsigned int projMatLocationPG;				        // Location of the projectionMatrix in the Phong-Phong shader program.
-unsigned int modelviewMatLocationPG;			    // Location of the modelviewMatrix in the Phong-Phong shader program.
-unsigned int applyTextureLocationPG;				// Location of the applyTexture bool in the Phong-Gouraud shader program.
-unsigned int projMatLocationPP;				        // Location of the projectionMatrix in the Phong-Phong shader program.
-unsigned int modelviewMatLocationPP;			    // Location of the modelviewMatrix in the Phong-Phong shader program.
-unsigned int applyTextureLocationPP;				// Location of the applyTexture bool in the Phong-Phong shader program.
-unsigned int globallightBlockIndexPG;               // Index of the global light block Phong-Gouraud
-unsigned int lightsBlockIndexPG;                    // Index of the light array block Phong-Gouraud
-unsigned int globallightBlockIndexPP;               // Index of the global light block Phong-Phong
-unsigned int lightsBlockIndexPP;                    // Index of the light array block Phong-Phong
 const char* projMatName = "projectionMatrix";		// Name of the uniform variable projectionMatrix
 const char* modelviewMatName = "modelviewMatrix";	// Name of the uniform variable modelviewMatrix
-const char* applyTextureName = "applyTexture";	    // Name of the uniform variable applyTexture
+const char* textureMapName = "theTextureMap";	    // Name of the uniform sampler for the texture map
 const char* globallightBlockName= "phGlobal";       // Name of the global light uniform block
 const char* lightsBlockName = "phLightArray";       // Name of the light array uniform block
 
+// *********************************
+// Shader variants.
+// One entry for each combination of the phVariant flags.
+//   A variant's build is started the first time it is asked for;
+//   Program stays zero until the build has finished.
+struct phShaderVariant {
+    bool Started;                           // True once the build has been started
+    int BuildNumber;                        // From start_shader_vertfrag()
+    unsigned int Program;
+    unsigned int ProjMatLocation;           // Location of the projectionMatrix in the program
+    unsigned int ModelviewMatLocation;      // Location of the modelviewMatrix in the program
+    unsigned int ProjMatSerial;             // Value of projMatSerial when the projection matrix was last loaded
+};
+phShaderVariant phVariants[phNumVariants];
+
+// The #define for each bit of a variant key, in order.
+const char* phVariantDefines[] = {
+    "#define PH_APPLY_TEXTURE\n",
+    "#define PH_ENABLE_EMISSIVE\n",
+    "#define PH_ENABLE_AMBIENT\n",
+    "#define PH_ENABLE_DIFFUSE\n",
+    "#define PH_ENABLE_SPECULAR\n",
+    "#define PH_LOCAL_VIEWER\n",
+    "#define PH_SPOTLIGHTS\n",
+    "#define PH_ATTENUATION\n",
+    "#define PH_GOURAUD\n",
+};
+static_assert(sizeof(phVariantDefines) / sizeof(phVariantDefines[0]) == phNumVariantBits,
+              "Need one #define per variant flag");
+
+// Lighting state that selects the variant, updated by phGlobal::LoadIntoShaders
+//    and phLight::LoadIntoShaders.
+unsigned int phGlobalFlags = phVariantEmissive | phVariantAmbient | phVariantDiffuse | phVariantSpecular;
+unsigned int phSpotLightMask = 0;           // Bit i set if light i is an enabled spotlight
+unsigned int phAttenuatedMask = 0;          // Bit i set if light i is enabled and attenuated
+bool phUseGouraud = false;
+bool phExactShaders = false;                // Wait for the exact variant, never use a substitute
+
+unsigned int phCurrentProgram = 0;          // The program last bound by phUseProgram
+float projMatEntries[16];                   // The current projection matrix
+unsigned int projMatSerial = 0;             // Incremented each time the projection matrix changes
+
 
 // *********************************
-// Source code for the shader programs
+// Source code for the shader programs.
+// The sources do not have a #version line: it is added, followed by the
+//    #define's for the variant, when a variant is compiled.
+//    The PH_ defines remove the code for features that are turned off.
+
+const char shaderVersionLine[] = "#version 330 core\n";
 
 // The vertex shader for Phong lighting with Phong shading.
 //   Mostly this copies material values, modelview position,
 //   and modelview surface normal to the fragment shader.
 const char vertexShader_PhongPhong[] =
-"#version 330 core\n"
 "layout (location = 0) in vec3 vertPos;	     // Position in attribute location 0\n"
 "layout (location = 1) in vec3 vertNormal;	 // Surface normal in attribute location 1\n"
 "layout (location = 2) in vec2 vertTexCoords;	 // Texture coordinates in attribute location 2\n"
@@ -66,6 +103,7 @@ const char vertexShader_PhongPhong[] =
 "layout (location = 5) in vec3 DiffuseColor; \n"
 "layout (location = 6) in vec3 SpecularColor; \n"
 "layout (location = 7) in float SpecularExponent; \n"
+"layout (location = 8) in float TextureLayer;  // Layer of the texture array \n"
 ""
 "out vec3 mvPos;   // Vertex position in modelview coordinates\n"
 "out vec3 mvNormal; // Normal vector to vertex in modelview coordinates\n"
@@ -75,6 +113,7 @@ const char vertexShader_PhongPhong[] =
 "out vec3 matSpecular;\n"
 "out float matSpecExponent;\n"
 "out vec2 theTexCoords;\n"
+"flat out float theTextureLayer;\n"
 ""
 "uniform mat4 projectionMatrix;		// The projection matrix\n"
 "uniform mat4 modelviewMatrix;		// The modelview matrix\n"
@@ -91,13 +130,12 @@ const char vertexShader_PhongPhong[] =
 "    matSpecular = SpecularColor;\n"
 "    matSpecExponent = SpecularExponent;\n"
 "    theTexCoords = vertTexCoords;\n"
+"    theTextureLayer = TextureLayer;\n"
 "}\0";
 
 // The base code for the fragment shader for Phong lighting with Phong shading.
 //   This does all the hard work of the Phong lighting
 const char fragmentShader_PhongPhongBase[] =
-"#version 330 core\n"
-""
 "in vec3 mvPos;   // Vertex position in modelview coordinates\n"
 "in vec3 mvNormal; // Normal vector to vertex in modelview coordinates\n"
 "in vec3 matEmissive;\n"
@@ -138,8 +176,10 @@ const char fragmentShader_PhongPhongBase[] =
 "};\n"
 ""
 "in vec2 theTexCoords;	// Texture coordinates (interpolated from vertex shader) \n"
-"uniform sampler2D theTextureMap;\n"
-"uniform bool applyTexture;\n"
+"#ifdef PH_APPLY_TEXTURE\n"
+"flat in float theTextureLayer;\n"
+"uniform sampler2DArray theTextureMap;\n"
+"#endif\n"
 ""
 "vec3 nonspecColor;  \n"
 "vec3 specularColor;  \n"
@@ -148,17 +188,16 @@ const char fragmentShader_PhongPhongBase[] =
 ""
 "void main() { \n"
 "    CalculatePhongLighting();  // Calculate: nonspecColor and specularColor. \n"
-"   fragmentColor = vec4(nonspecColor+specularColor, 1.0f);   // Add alpha value of 1.0.\n"
-"   if ( applyTexture ) { \n"
-"        fragmentColor = vec4(nonspecColor, 1.0f)*texture(theTextureMap, theTexCoords) + vec4(specularColor,0.0);\n"
-"   }\n"
+"#ifdef PH_APPLY_TEXTURE\n"
+"    fragmentColor = vec4(nonspecColor, 1.0f)*texture(theTextureMap, vec3(theTexCoords, theTextureLayer)) + vec4(specularColor,0.0);\n"
+"#else\n"
+"    fragmentColor = vec4(nonspecColor+specularColor, 1.0f);   // Add alpha value of 1.0.\n"
+"#endif\n"
 "}\0";
 
 // The vertex shader for Phong lighting (with Gouraud shading).
 //   This does all the hard work of the Phong lighting
 const char vertexShader_PhongGouraudBase[] =
-"#version 330 core\n"
-""
 "layout (location = 0) in vec3 vertPos;	     // Position in attribute location 0\n"
 "layout (location = 1) in vec3 vertNormal;	 // Surface normal in attribute location 1\n"
 "layout (location = 2) in vec2 vertTexCoords;	 // Texture coordinates in attribute location 2\n"
@@ -167,10 +206,12 @@ const char vertexShader_PhongGouraudBase[] =
 "layout (location = 5) in vec3 DiffuseColor; \n"
 "layout (location = 6) in vec3 SpecularColor; \n"
 "layout (location = 7) in float SpecularExponent; \n"
+"layout (location = 8) in float TextureLayer;  // Layer of the texture array \n"
 ""
 "out vec3 nonspecColor;  \n"
 "out vec3 specularColor;  \n"
 "out vec2 theTexCoords;\n"
+"flat out float theTextureLayer;\n"
 ""
 "layout (std140) uniform phGlobal { \n"
 "    vec3 GlobalAmbientColor;        // Global ambient light color \n"
@@ -227,26 +268,32 @@ const char vertexShader_PhongGouraudBase[] =
 "    matSpecular = SpecularColor;\n"
 "    matSpecExponent = SpecularExponent;\n"
 "    theTexCoords = vertTexCoords; \n"
+"    theTextureLayer = TextureLayer; \n"
 "    CalculatePhongLighting();  // Calculate: nonspecColor and specularColor. \n"
 "} \n"
 "\0";
 
 
 // Shared code for calculating Phong light!
+//   The EnableXXX and LocalViewer flags are not tested at run time:
+//   the variant's #define's decide which terms are compiled in.
 const char shaderCalcPhong[] = 
 ""
 "// This routine calculates the two vec3's nonspecColor and specularColor\n"
 "void CalculatePhongLighting() { \n"
 "    nonspecColor = vec3(0.0, 0.0, 0.0);  \n"
 "    specularColor = vec3(0.0, 0.0, 0.0);  \n"
-"    if ( EnableEmissive ) { \n"
-"       nonspecColor = matEmissive; \n"
-"    }\n"
-"    if ( EnableAmbient ) { \n"
-"         nonspecColor += matAmbient*GlobalAmbientColor; \n"
-"    } \n"
-"    vec3 vVector = LocalViewer ? -mvPos : vec3(0.0, 0.0, 1.0); // Unit vector towards non-local viewer \n"
-"    vVector = normalize(vVector);\n"
+"#ifdef PH_ENABLE_EMISSIVE\n"
+"    nonspecColor = matEmissive; \n"
+"#endif\n"
+"#ifdef PH_ENABLE_AMBIENT\n"
+"    nonspecColor += matAmbient*GlobalAmbientColor; \n"
+"#endif\n"
+"#ifdef PH_LOCAL_VIEWER\n"
+"    vec3 vVector = normalize(-mvPos);   // Unit vector towards local viewer \n"
+"#else\n"
+"    vec3 vVector = vec3(0.0, 0.0, 1.0); // Unit vector towards non-local viewer \n"
+"#endif\n"
 "    for ( int i=0; i<NumLights; i++ ) {\n"
 "        if ( Lights[i].IsEnabled ) { \n"
 "            vec3 nonspecColorLt = vec3(0.0, 0.0, 0.0);\n"
@@ -258,37 +305,40 @@ const char shaderCalcPhong[] =
 "            lVector = normalize(lVector); // Unit vector to the light position.\n"
 "            float dotEllNormal = dot(lVector, mvNormal); \n"
 "            if (dotEllNormal > 0 ) { \n"
-"                float spotCosine;\n"
-"                if ( Lights[i].IsSpotLight ) {\n"
-"                    spotCosine = -dot(lVector,Lights[i].SpotDirection);\n"
-"                }\n"
+"#ifdef PH_SPOTLIGHTS\n"
+"                float spotCosine = -dot(lVector,Lights[i].SpotDirection);\n"
 "                if ( !Lights[i].IsSpotLight || spotCosine > Lights[i].SpotCosCutoff ) {\n"
-"                    if ( EnableDiffuse ) { \n"
-"                        nonspecColorLt += matDiffuse*Lights[i].DiffuseColor*dotEllNormal; \n"
-"                    } \n"
-"                    if ( EnableSpecular ) { \n"
-"                        float rDotV = dot(vVector, 2.0*dotEllNormal*mvNormal - lVector); \n"
-"                        if ( rDotV>0.0 ) {\n"
-"                            float specFactor = pow( rDotV, matSpecExponent);\n"
-"                            specularColorLt += specFactor*matSpecular*Lights[i].SpecularColor; \n"
-"                        } \n"
+"#endif\n"
+"#ifdef PH_ENABLE_DIFFUSE\n"
+"                    nonspecColorLt += matDiffuse*Lights[i].DiffuseColor*dotEllNormal; \n"
+"#endif\n"
+"#ifdef PH_ENABLE_SPECULAR\n"
+"                    float rDotV = dot(vVector, 2.0*dotEllNormal*mvNormal - lVector); \n"
+"                    if ( rDotV>0.0 ) {\n"
+"                        float specFactor = pow( rDotV, matSpecExponent);\n"
+"                        specularColorLt += specFactor*matSpecular*Lights[i].SpecularColor; \n"
 "                    } \n"
-"                    if ( Lights[i].IsSpotLight ) {"
-"                        float spotAtten = pow(spotCosine,Lights[i].SpotExponent);"
+"#endif\n"
+"#ifdef PH_SPOTLIGHTS\n"
+"                    if ( Lights[i].IsSpotLight ) {\n"
+"                        float spotAtten = pow(spotCosine,Lights[i].SpotExponent);\n"
 "                        nonspecColorLt *= spotAtten; \n"
-"                       specularColorLt *= spotAtten;\n"
+"                        specularColorLt *= spotAtten;\n"
 "                    } \n"
 "                }\n"
+"#endif\n"
 "            }\n"
+"#ifdef PH_ATTENUATION\n"
 "            if ( Lights[i].IsAttenuated ) { \n"
 "                float dist = distance(mvPos,Lights[i].Position); \n"
 "                float atten = 1.0/(Lights[i].ConstantAttenuation + (Lights[i].LinearAttenuation + Lights[i].QuadraticAttenuation*dist)*dist);\n"
 "                nonspecColorLt *= atten; \n"
 "                specularColorLt *= atten;\n"
 "            } \n"
-"            if ( EnableAmbient ) { \n"
-"                nonspecColorLt += matAmbient*Lights[i].AmbientColor; \n"
-"            } \n"
+"#endif\n"
+"#ifdef PH_ENABLE_AMBIENT\n"
+"            nonspecColorLt += matAmbient*Lights[i].AmbientColor; \n"
+"#endif\n"
 "            nonspecColor += nonspecColorLt;\n"
 "            specularColor += specularColorLt;\n"
 "        }\n "
@@ -299,25 +349,27 @@ const char shaderCalcPhong[] =
 // is very simple.  All it does it output the color as averaged (smoothed)
 // the colors computed by the vertex shaders
 const char fragmentShader_PhongGouraud[] =
-"#version 330 core\n"
 "in vec3 nonspecColor;   // Nonspecular color (smoothed) calculated at vertex \n"
 "in vec3 specularColor;  // Specular color (smoothed) calculated at vertex \n"
 "in vec2 theTexCoords;\n"
 "out vec4 fragmentColor;	// Color that will be used for the fragment\n"
-"uniform sampler2D theTextureMap;\n"
-"uniform bool applyTexture;\n"
+"#ifdef PH_APPLY_TEXTURE\n"
+"flat in float theTextureLayer;\n"
+"uniform sampler2DArray theTextureMap;\n"
+"#endif\n"
 "void main()\n"
 "{\n"
-"   fragmentColor = vec4(nonspecColor+specularColor, 1.0f);   // Add alpha value of 1.0.\n"
-"    if ( applyTexture ) { \n"
-"        fragmentColor = vec4(nonspecColor, 1.0f)*texture(theTextureMap, theTexCoords) + vec4(specularColor,0.0);\n"
-"    }\n"
+"#ifdef PH_APPLY_TEXTURE\n"
+"    fragmentColor = vec4(nonspecColor, 1.0f)*texture(theTextureMap, vec3(theTexCoords, theTextureLayer)) + vec4(specularColor,0.0);\n"
+"#else\n"
+"    fragmentColor = vec4(nonspecColor+specularColor, 1.0f);   // Add alpha value of 1.0.\n"
+"#endif\n"
 "}\n\0";
 
 /*
- * Build and compile two shader programs
- *  One is for Phong lighting with Phong shading
- *  The other is for Phong lighting with Gouraud shading
+ * Build and compile the shader programs
+ *  Each variant is either Phong lighting with Phong shading
+ *  or Phong lighting with Gouraud shading.
  */
 unsigned int phongUBO;              // Uniform Buffer Object for Phong lighting information
 const int numGlobal = 7;            // Number of entries in the phGlobal structure
@@ -329,35 +381,133 @@ int lightsBlockSize;                // Size of data for a single light
 int lightsBlockOffset;              // Offset for the light blonk in the uniform buffer object
 int lightStride;                    // Stride between light blocks in the shader.
 
+// Start compiling and linking the program for one variant.
+void start_phong_variant(unsigned int variantKey) {
+    phShaderVariant& variant = phVariants[variantKey];
+    if (variant.Started) {
+        return;
+    }
+    char defines[512];
+    strcpy_s(defines, sizeof(defines), shaderVersionLine);
+    for (int i = 0; i < phNumVariantBits; i++) {
+        if (variantKey & (1u << i)) {
+            strcat_s(defines, sizeof(defines), phVariantDefines[i]);
+        }
+    }
+    char cacheFileName[64];
+    snprintf(cacheFileName, sizeof(cacheFileName), "PhongVariant%03x.shadercache", variantKey);
+
+    if (variantKey & phVariantGouraud) {
+        char vertexShader[sizeof(defines) + sizeof(vertexShader_PhongGouraudBase) + sizeof(shaderCalcPhong)];
+        strcpy_s(vertexShader, sizeof(vertexShader), defines);
+        strcat_s(vertexShader, sizeof(vertexShader), vertexShader_PhongGouraudBase);
+        strcat_s(vertexShader, sizeof(vertexShader), shaderCalcPhong);
+        char fragmentShader[sizeof(defines) + sizeof(fragmentShader_PhongGouraud)];
+        strcpy_s(fragmentShader, sizeof(fragmentShader), defines);
+        strcat_s(fragmentShader, sizeof(fragmentShader), fragmentShader_PhongGouraud);
+        variant.BuildNumber = start_shader_vertfrag(vertexShader, fragmentShader, cacheFileName);
+    }
+    else {
+        char vertexShader[sizeof(defines) + sizeof(vertexShader_PhongPhong)];
+        strcpy_s(vertexShader, sizeof(vertexShader), defines);
+        strcat_s(vertexShader, sizeof(vertexShader), vertexShader_PhongPhong);
+        char fragmentShader[sizeof(defines) + sizeof(fragmentShader_PhongPhongBase) + sizeof(shaderCalcPhong)];
+        strcpy_s(fragmentShader, sizeof(fragmentShader), defines);
+        strcat_s(fragmentShader, sizeof(fragmentShader), fragmentShader_PhongPhongBase);
+        strcat_s(fragmentShader, sizeof(fragmentShader), shaderCalcPhong);
+        variant.BuildNumber = start_shader_vertfrag(vertexShader, fragmentShader, cacheFileName);
+    }
+    variant.Started = true;
+}
+
+// Wait for a variant's program, and fill in the rest of its entry in phVariants.
+void finish_phong_variant(unsigned int variantKey) {
+    phShaderVariant& variant = phVariants[variantKey];
+    start_phong_variant(variantKey);
+    if (variant.Program != 0) {
+        return;
+    }
+    unsigned int program = finish_shader_vertfrag(variant.BuildNumber);
+
+    // Get the locations of the uniform variables in the shader program.
+    variant.ProjMatLocation = glGetUniformLocation(program, projMatName);
+    variant.ModelviewMatLocation = glGetUniformLocation(program, modelviewMatName);
+    variant.ProjMatSerial = 0;
+    glUniformBlockBinding(program, glGetUniformBlockIndex(program, globallightBlockName), 0);  // Buffer binding 0 for global lights
+    glUniformBlockBinding(program, glGetUniformBlockIndex(program, lightsBlockName), 1);       // Buffer binding 1 for lights
+    if (variantKey & phVariantTexture) {
+        glUseProgram(program);
+        glUniform1i(glGetUniformLocation(program, textureMapName), 0);  // Use the GL_TEXTURE_0 texture.
+        phCurrentProgram = program;
+    }
+    variant.Program = program;
+
+    char label[64];
+    snprintf(label, sizeof(label), "Shader variant 0x%03x ready", variantKey);
+    LogTimelineEvent(label);
+}
+
+// True if the variant can be used now.  Never waits.
+bool phong_variant_ready(unsigned int variantKey) {
+    phShaderVariant& variant = phVariants[variantKey];
+    if (variant.Program != 0) {
+        return true;
+    }
+    if (variant.Started && is_shader_build_done(variant.BuildNumber)) {
+        finish_phong_variant(variantKey);
+        return true;
+    }
+    return false;
+}
+
+// The ready variant closest to variantKey: one that agrees on applying a texture
+//    if possible, and then with the fewest different flags.  Returns -1 if none is ready.
+int closest_ready_phong_variant(unsigned int variantKey) {
+    int best = -1;
+    int bestScore = 0;
+    for (unsigned int key = 0; key < phNumVariants; key++) {
+        if (phVariants[key].Program == 0) {
+            continue;
+        }
+        unsigned int diff = key ^ variantKey;
+        int score = (diff & phVariantTexture) ? phNumVariantBits : 0;
+        for (; diff != 0; diff &= diff - 1) {
+            score++;
+        }
+        if (best < 0 || score < bestScore) {
+            best = key;
+            bestScore = score;
+        }
+    }
+    return best;
+}
+
+// The uniform buffer layout is the same in every variant (std140), so it is
+//    queried from the Gouraud variant with every feature turned on.
+const unsigned int layoutVariant = phNumVariants - 1 - phVariantTexture;
+
+// Start building the shader programs that the first frame is likely to use.
+//    The builds run in the background (see ShaderBuild.h); the uniform buffer
+//    is set up when the lighting data is first loaded.
 void setup_phong_shaders() {
-    char fragmentShader_PhongPhong[sizeof(fragmentShader_PhongPhongBase) + sizeof(shaderCalcPhong)];
-    strcpy_s(fragmentShader_PhongPhong, sizeof(fragmentShader_PhongPhong), fragmentShader_PhongPhongBase);
-    strcat_s(fragmentShader_PhongPhong, sizeof(fragmentShader_PhongPhong), shaderCalcPhong);
-    phShaderPhongPhong = setup_shader_vertfrag(vertexShader_PhongPhong, fragmentShader_PhongPhong);
-    char vertexShader_PhongGouraud[sizeof(vertexShader_PhongGouraudBase) + sizeof(shaderCalcPhong)];
-    strcpy_s(vertexShader_PhongGouraud, sizeof(vertexShader_PhongGouraud), vertexShader_PhongGouraudBase);
-    strcat_s(vertexShader_PhongGouraud, sizeof(vertexShader_PhongGouraud), shaderCalcPhong);
-    phShaderPhongGouraud = setup_shader_vertfrag(vertexShader_PhongGouraud, fragmentShader_PhongGouraud);
-
-    // Get the locations of the uniform variables in the shader programs.
-    projMatLocationPG = glGetUniformLocation(phShaderPhongGouraud, projMatName);
-    modelviewMatLocationPG = glGetUniformLocation(phShaderPhongGouraud, modelviewMatName);
-    applyTextureLocationPG = glGetUniformLocation(phShaderPhongGouraud, applyTextureName);
-    globallightBlockIndexPG = glGetUniformBlockIndex(phShaderPhongGouraud, globallightBlockName);
-    lightsBlockIndexPG = glGetUniformBlockIndex(phShaderPhongGouraud, lightsBlockName);
-    glUniformBlockBinding(phShaderPhongGouraud, globallightBlockIndexPG, 0);      // Buffer binding 0 for global lights
-    glUniformBlockBinding(phShaderPhongGouraud, lightsBlockIndexPG, 1);      // Buffer binding 1 for lights
-
-    projMatLocationPP = glGetUniformLocation(phShaderPhongPhong, projMatName);
-    modelviewMatLocationPP = glGetUniformLocation(phShaderPhongPhong, modelviewMatName);
-    applyTextureLocationPP = glGetUniformLocation(phShaderPhongPhong, applyTextureName);
-    globallightBlockIndexPP = glGetUniformBlockIndex(phShaderPhongPhong, globallightBlockName);
-    lightsBlockIndexPP = glGetUniformBlockIndex(phShaderPhongPhong, lightsBlockName);
-    glUniformBlockBinding(phShaderPhongPhong, globallightBlockIndexPP, 0);      // Buffer binding 0 for global lights
-    glUniformBlockBinding(phShaderPhongPhong, lightsBlockIndexPP, 1);      // Buffer binding 1 for lights
-
-    glGetActiveUniformBlockiv(phShaderPhongGouraud, globallightBlockIndexPG, GL_UNIFORM_BLOCK_DATA_SIZE, &globallightBlockSize);
-    glGetActiveUniformBlockiv(phShaderPhongGouraud, lightsBlockIndexPG, GL_UNIFORM_BLOCK_DATA_SIZE, &lightsBlockSize);
+    start_phong_variant(layoutVariant);
+    unsigned int firstFrameVariant = phGlobalFlags | (phUseGouraud ? phVariantGouraud : 0);
+    start_phong_variant(firstFrameVariant);
+    start_phong_variant(firstFrameVariant | phVariantTexture);
+    start_phong_variant(firstFrameVariant | phVariantSpotLights);
+    start_phong_variant(firstFrameVariant | phVariantSpotLights | phVariantTexture);
+    LogTimelineEvent("Shader builds started");
+}
+
+// Create the uniform buffer object, and find the offsets of the lighting data.
+void setup_phong_uniform_buffer() {
+    finish_phong_variant(layoutVariant);
+    unsigned int layoutProgram = phVariants[layoutVariant].Program;
+    unsigned int globallightBlockIndex = glGetUniformBlockIndex(layoutProgram, globallightBlockName);
+    unsigned int lightsBlockIndex = glGetUniformBlockIndex(layoutProgram, lightsBlockName);
+
+    glGetActiveUniformBlockiv(layoutProgram, globallightBlockIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &globallightBlockSize);
+    glGetActiveUniformBlockiv(layoutProgram, lightsBlockIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &lightsBlockSize);
     glGenBuffers(1, &phongUBO);
     glBindBuffer(GL_UNIFORM_BUFFER, phongUBO);
     int uboAlign;
@@ -376,10 +526,10 @@ void setup_phong_shaders() {
     GLuint indicesGlobal[numGlobal];
     // GLint sizesGlobal[numGlobal];
     // GLint typesGlobal[numGlobal];
-    glGetUniformIndices(phShaderPhongGouraud, numGlobal, globalNames, indicesGlobal);
-    glGetActiveUniformsiv(phShaderPhongGouraud, numGlobal, indicesGlobal, GL_UNIFORM_OFFSET, offsetsGlobal);
-    // glGetActiveUniformsiv(phShaderPhongGouraud, numGlobal, indicesGlobal, GL_UNIFORM_SIZE, sizesGlobal);
-    // glGetActiveUniformsiv(phShaderPhongGouraud, numGlobal, indicesGlobal, GL_UNIFORM_TYPE, typesGlobal);
+    glGetUniformIndices(layoutProgram, numGlobal, globalNames, indicesGlobal);
+    glGetActiveUniformsiv(layoutProgram, numGlobal, indicesGlobal, GL_UNIFORM_OFFSET, offsetsGlobal);
+    // glGetActiveUniformsiv(layoutProgram, numGlobal, indicesGlobal, GL_UNIFORM_SIZE, sizesGlobal);
+    // glGetActiveUniformsiv(layoutProgram, numGlobal, indicesGlobal, GL_UNIFORM_TYPE, typesGlobal);
 
     // Query locations in the individual lights block
     const char* lightNames[numLightData+1] = {
@@ -391,21 +541,75 @@ void setup_phong_shaders() {
     GLuint indicesLight[numLightData+1];
     GLint sizesLight[numLightData];
     GLint typesLight[numLightData];
-    glGetUniformIndices(phShaderPhongGouraud, numLightData+1, lightNames, indicesLight);
-    glGetActiveUniformsiv(phShaderPhongGouraud, numLightData+1, indicesLight, GL_UNIFORM_OFFSET, offsetsLight);
-    glGetActiveUniformsiv(phShaderPhongGouraud, numLightData, indicesLight, GL_UNIFORM_SIZE, sizesLight);
-    glGetActiveUniformsiv(phShaderPhongGouraud, numLightData, indicesLight, GL_UNIFORM_TYPE, typesLight);
+    glGetUniformIndices(layoutProgram, numLightData+1, lightNames, indicesLight);
+    glGetActiveUniformsiv(layoutProgram, numLightData+1, indicesLight, GL_UNIFORM_OFFSET, offsetsLight);
+    glGetActiveUniformsiv(layoutProgram, numLightData, indicesLight, GL_UNIFORM_SIZE, sizesLight);
+    glGetActiveUniformsiv(layoutProgram, numLightData, indicesLight, GL_UNIFORM_TYPE, typesLight);
     lightStride = offsetsLight[numLightData] - offsetsLight[0];
     if (phMaxNumLights*lightStride != lightsBlockSize) {
         fprintf(stderr, "EduPhong: Likely error in layout with shaders.\n");
     }
+}
+
+void phSetShadingModel(bool useGouraud) {
+    phUseGouraud = useGouraud;
+}
+
+void phSetExactShaders(bool exact) {
+    phExactShaders = exact;
+}
+
+void phSetProjectionMatrix(const float* entries) {
+    memcpy(projMatEntries, entries, sizeof(projMatEntries));
+    projMatSerial++;
+}
+
+void phSetTextureLayer(int layer) {
+    glVertexAttrib1f(phTextureLayer_loc, (float)layer);
+}
 
-    glUseProgram(phShaderPhongPhong);
-    glUniform1i(applyTextureLocationPP, 0); // Default is to  not apply the texture
-    glUseProgram(phShaderPhongGouraud);
-    glUniform1i(applyTextureLocationPG, 0); // Default is to  not apply the texture
+void phUseProgram(bool applyTexture) {
+    unsigned int variantKey = phGlobalFlags;
+    if (applyTexture) {
+        variantKey |= phVariantTexture;
+    }
+    if (phSpotLightMask != 0) {
+        variantKey |= phVariantSpotLights;
+    }
+    if (phAttenuatedMask != 0) {
+        variantKey |= phVariantAttenuation;
+    }
+    if (phUseGouraud) {
+        variantKey |= phVariantGouraud;
+    }
+    if (phExactShaders) {
+        finish_phong_variant(variantKey);       // Returns at once if it is ready
+    }
+    else if (!phong_variant_ready(variantKey)) {
+        start_phong_variant(variantKey);
+        // Use whatever is ready while this variant is being built.
+        int readyKey = closest_ready_phong_variant(variantKey);
+        if (readyKey >= 0) {
+            variantKey = readyKey;
+        }
+        else {
+            finish_phong_variant(variantKey);   // Nothing else is ready: wait for it
+        }
+    }
+    phShaderVariant& variant = phVariants[variantKey];
+    if (variant.Program != phCurrentProgram) {
+        glUseProgram(variant.Program);
+        phCurrentProgram = variant.Program;
+    }
+    if (variant.ProjMatSerial != projMatSerial) {
+        glUniformMatrix4fv(variant.ProjMatLocation, 1, false, projMatEntries);
+        variant.ProjMatSerial = projMatSerial;
+    }
+    projMatLocation = variant.ProjMatLocation;
+    modelviewMatLocation = variant.ModelviewMatLocation;
 }
 
+
 void phMaterial::LoadIntoShaders()
 {
     float vecEntries[3];
@@ -425,6 +629,9 @@ unsigned int trueGLbool = 0xffffffff, falseGLbool = 0;
 
 void phGlobal::LoadIntoShaders()
 {
+    if (phongUBO == 0) {
+        setup_phong_uniform_buffer();
+    }
     char* buffer = new char[globallightBlockSize];
     GlobalAmbientColor.Dump((float*)(buffer + offsetsGlobal[0]));
     memcpy(buffer + offsetsGlobal[1], &NumLights, sizeof(unsigned int));
@@ -436,11 +643,18 @@ void phGlobal::LoadIntoShaders()
     glBindBuffer(GL_UNIFORM_BUFFER, phongUBO);
     glBufferSubData(GL_UNIFORM_BUFFER, 0, globallightBlockSize, buffer);
 
+    phGlobalFlags = (EnableEmissive ? phVariantEmissive : 0) | (EnableAmbient ? phVariantAmbient : 0)
+        | (EnableDiffuse ? phVariantDiffuse : 0) | (EnableSpecular ? phVariantSpecular : 0)
+        | (LocalViewer ? phVariantLocalViewer : 0);
+
     delete[] buffer;
 }
 
 void phLight::LoadIntoShaders(int lightNumber) {
     assert(0<=lightNumber && lightNumber < phMaxNumLights);
+    if (phongUBO == 0) {
+        setup_phong_uniform_buffer();
+    }
     char* buffer = new char[lightStride];       // Allocate enough space to hold data for one light
     int d = globallightBlockSize;               // Subtract of size of the buffer used for global lighting data
     memcpy(buffer + offsetsLight[0], IsEnabled ? &trueGLbool : &falseGLbool, 4);      // Note: load a bool as a 4 byte integer
@@ -461,6 +675,10 @@ void phLight::LoadIntoShaders(int lightNumber) {
     int startLoc = lightsBlockOffset + lightNumber * lightStride;
     glBufferSubData(GL_UNIFORM_BUFFER, startLoc, lightStride, buffer);
 
+    unsigned int lightBit = 1u << lightNumber;
+    phSpotLightMask = (IsEnabled && IsSpotLight) ? (phSpotLightMask | lightBit) : (phSpotLightMask & ~lightBit);
+    phAttenuatedMask = (IsEnabled && IsAttenuated) ? (phAttenuatedMask | lightBit) : (phAttenuatedMask & ~lightBit);
+
 }
 
 
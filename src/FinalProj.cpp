@@ -32,10 +32,21 @@
 #include "ShaderBuild.h"
 #include "GlGeomSphere.h"
 #include "GlGeomCylinder.h"
+#include "AsyncLog.h"
+#include "TextureLoader.h"
+#include "FrameCapture.h"
+#include "Offscreen.h"
+#include "FlyThrough.h"
+#include "RenderStats.h"
+#include "Profiler.h"
 
 // Enable standard input and output via printf(), etc.
 // Put this include *after* the includes for glew and GLFW!
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
 
 #include "FinalProj.h"
 #include "MyGeometries.h"
@@ -88,7 +99,6 @@ double lastViewAzimuth = 0.0, lastViewDirection = 0.0;
 
 unsigned int projMatLocation;						// Location of the projectionMatrix in the currently active shader program
 unsigned int modelviewMatLocation;					// Location of the modelviewMatrix in the currently active shader program
-unsigned int applyTextureLocation; 					// Location of the applyTexture bool in the currently active shader program
 
 //  The Projection matrix: Controls the "camera view/field-of-view" transformation
 //     Generally is the same for all objects in the scene.
@@ -150,6 +160,7 @@ void mySetViewMatrix() {
 // The EduPhong shaders are already setup.
 // *************************************
 void MyRenderScene() {
+    PROFILE_SCOPE("MyRenderScene");
    
     // Clear the rendering window
     static const float black[] = { 0.0f, 0.0f, 0.0f, 0.0f };
@@ -157,7 +168,8 @@ void MyRenderScene() {
     glClearBufferfv(GL_COLOR, 0, black);
     glClearBufferfv(GL_DEPTH, 0, &clearDepth);	// Must pass in a *pointer* to the depth
 
-    glUseProgram(UsePhongGouraud ? phShaderPhongGouraud : phShaderPhongPhong);
+    PollTextureLoads();                 // Upload any textures that have finished loading
+    phSetShadingModel(UsePhongGouraud);
 
     MyRenderGeometries();
 	MyRenderDrone();
@@ -168,20 +180,18 @@ void MyRenderScene() {
 
 void my_setup_SceneData() {
 
-	setup_phong_shaders();
+	setup_phong_shaders();              // Starts the shader builds; they finish in the background
 	mySetupGeometries();
 	MySetupInitialGeometries();
+    LogTimelineEvent("Geometries set up");
     SetupForTextures();
-
-    // Initially, the Phong-Gouraud shader is used 
-    projMatLocation = UsePhongGouraud ? projMatLocationPG : projMatLocationPP;
-    modelviewMatLocation = UsePhongGouraud ? modelviewMatLocationPG : modelviewMatLocationPP;
-    applyTextureLocation = UsePhongGouraud ? applyTextureLocationPG : applyTextureLocationPP;
+    LogTimelineEvent("Texture loads started");
 
     MySetupGlobalLight();
     MySetupLights();
     LoadAllLights();
     MySetupMaterials();
+    LogTimelineEvent("Lights and materials set up");
 
 	check_for_opengl_errors();   // Really a great idea to check for errors -- esp. good for debugging!
 }
@@ -261,9 +271,28 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
         return;
     case GLFW_KEY_P:
         UsePhongGouraud = !UsePhongGouraud;
-        projMatLocation = UsePhongGouraud ? projMatLocationPG : projMatLocationPP;
-        modelviewMatLocation = UsePhongGouraud ? modelviewMatLocationPG : modelviewMatLocationPP;
-        applyTextureLocation = UsePhongGouraud ? applyTextureLocationPG : applyTextureLocationPP;
+        return;
+    case GLFW_KEY_I:        // Toggle profiling; the timings are written out when it stops
+        if (ProfilerRunning()) {
+            StopProfiler();
+            LogProfilerSummary(ProfileSummaryTopN);
+            if (WriteProfilerTrace("profile.json")) {
+                LogMessage(LogInfo, "Profile trace written to profile.json.");
+            }
+        }
+        else {
+            StartProfiler();
+        }
+        return;
+    case GLFW_KEY_O:        // Toggle recording the frames to files
+        if (FrameCaptureRunning()) {
+            StopFrameCapture();
+        }
+        else {
+            int width, height;
+            glfwGetFramebufferSize(window, &width, &height);
+            StartFrameCapture("frame%05d.qoi", width, height);
+        }
         return;
     case GLFW_KEY_UP:
 		viewAzimuth = Min(viewAzimuth + 0.01, PIhalves - 0.05);
@@ -341,7 +370,7 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 
 void cursor_pos_callback(GLFWwindow* window, double xpos, double ypos)
 {
-	if (testInfo) printf("Mouse location is at (%i, %i).\n", int(xpos), int(ypos));
+	if (testInfo) LOG_RATE_LIMITED(0.1, LogDebug, "Mouse location is at (%i, %i).", int(xpos), int(ypos));
 	if (mouseLeftButtonPressed) {
 		double lastReleaseXPos, lastReleaseYPos;
 		glfwGetCursorPos(window, &lastReleaseXPos, &lastReleaseYPos);
@@ -362,33 +391,33 @@ void cursor_enter_callback(GLFWwindow* window, int entered)
 {
 	if (entered)
 	{
-		if (testInfo) printf("Mouse entered.\n");
+		if (testInfo) LogMessage(LogDebug, "Mouse entered.");
 	}
 	else
 	{
-		if (testInfo) printf("Mouse left.\n");
+		if (testInfo) LogMessage(LogDebug, "Mouse left.");
 	}
 }
 
 void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
 {
 	if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS) {
-		if (testInfo) printf("Left button of the mouse was pressed.\n");
+		if (testInfo) LogMessage(LogDebug, "Left button of the mouse was pressed.");
 		mouseLeftButtonPressed = true;
 		glfwGetCursorPos(window, &lastPressXPos, &lastPressYPos);
 		lastViewAzimuth = viewAzimuth; lastViewDirection = viewDirection;
 	}
 	if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_RELEASE) {
-		if (testInfo) printf("Left button of the mouse was released.\n");
+		if (testInfo) LogMessage(LogDebug, "Left button of the mouse was released.");
 		mouseLeftButtonPressed = false;
 	}
 	if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS)
-		if (testInfo) printf("Right button of the mouse was pressed. I want to do popup_menu() but I do not know how to realize it.\n");
+		if (testInfo) LogMessage(LogDebug, "Right button of the mouse was pressed. I want to do popup_menu() but I do not know how to realize it.");
 }
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 {
-	if (testInfo) printf("Mouse scrool (%i, %i).\n", int(xoffset), int(yoffset));
+	if (testInfo) LOG_RATE_LIMITED(0.05, LogDebug, "Mouse scrool (%i, %i).", int(xoffset), int(yoffset));
 	ZextraDistance -= ZextraDelta * yoffset * 5.0f;         // Move closer or farther, adjust 5.0f to change the sensitivity   
 	ClampMin(&ZextraDistance, ZextraDistanceMin);
 	UpdateView();
@@ -433,16 +462,8 @@ void setProjectionMatrix() {
     theProjectionMatrix.Set_glFrustum(-windowXmax * scale, windowXmax * scale,
                                       -windowYmax * scale, windowYmax * scale, zNear, zFar);
 
-    if (glIsProgram(phShaderPhongGouraud)) {
-        glUseProgram(phShaderPhongGouraud);
-        theProjectionMatrix.DumpByColumns(matEntries);
-        glUniformMatrix4fv(projMatLocationPG, 1, false, matEntries);
-    }
-    if (glIsProgram(phShaderPhongPhong)) {
-        glUseProgram(phShaderPhongPhong);
-        theProjectionMatrix.DumpByColumns(matEntries);
-        glUniformMatrix4fv(projMatLocationPP, 1, false, matEntries);
-    }
+    theProjectionMatrix.DumpByColumns(matEntries);
+    phSetProjectionMatrix(matEntries);      // Loaded into each shader program when it is next used
     check_for_opengl_errors();   // Really a great idea to check for errors -- esp. good for debugging!
 }
 
@@ -461,8 +482,9 @@ void my_setup_OpenGL() {
 
 void error_callback(int error, const char* description)
 {
-	// Print error
-	fputs(description, stderr);
+	// Print error.  The description is copied into the log record, so this is safe from the
+	//    callback, but only its first LogMaxInlineText-1 (95) characters are kept.
+	LogMessage(LogError, "GLFW error %d: %s", error, description);
 }
 
 void setup_callbacks(GLFWwindow* window) {
@@ -479,7 +501,245 @@ void setup_callbacks(GLFWwindow* window) {
 	glfwSetScrollCallback(window, scroll_callback);
 }
 
-int main() {
+// *************************************************
+// The view and rotor speeds, as in a key of a camera path (FlyThrough.h)
+// *************************************************
+void SetViewAndRotors(const FlyThroughKey& key) {
+	viewAzimuth = key.ViewAzimuth;
+	viewDirection = key.ViewDirection;
+	ZextraDistance = key.ZextraDistance;
+	for (int j = 0; j < 4; j++) {
+		spinVelocity[j] = key.SpinVelocity[j];
+	}
+	UpdateView();
+}
+
+FlyThroughKey GetViewAndRotors(int frame) {
+	FlyThroughKey key;
+	key.Frame = frame;
+	key.ViewAzimuth = viewAzimuth;
+	key.ViewDirection = viewDirection;
+	key.ZextraDistance = ZextraDistance;
+	for (int j = 0; j < 4; j++) {
+		key.SpinVelocity[j] = spinVelocity[j];
+	}
+	return key;
+}
+
+// *************************************************
+// Headless mode: render frames into an offscreen frame buffer, with no
+//    window, and write them to files (see StartFrameCapture).
+//    The textures are all loaded before the first frame, and no shader
+//    variant is ever substituted for one that is still being built,
+//    so the same frames are rendered on every run.
+// As a benchmark, the frames follow a camera path, after a few warm up
+//    frames.  As with double buffering, at most two frames are queued:
+//    a fence is waited on before starting a frame two frames later.
+//    A frame's time is from its start to the start of the next frame.
+//    The triangles are counted with a GL_PRIMITIVES_GENERATED query.
+// *************************************************
+int RunHeadless(const HeadlessOptions& options) {
+	const int FramesInFlight = 2;
+	const int WarmupFrames = 10;
+
+	FlyThroughPath path;
+	bool benchmark = (options.BenchmarkPath != 0);
+	if (benchmark) {
+		if (options.BenchmarkPath[0] == 0) {
+			path.SetDefault();
+		}
+		else if (!path.Load(options.BenchmarkPath)) {
+			StopAsyncLog();
+			return -1;
+		}
+	}
+	int numFrames = benchmark ? path.NumFrames() : options.NumFrames;
+	int width = options.Width;
+	int height = options.Height;
+
+	if (!CreateOffscreenContext()) {
+		StopAsyncLog();
+		return -1;
+	}
+	GLenum glewStatus = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+	if (glewStatus == GLEW_ERROR_NO_GLX_DISPLAY) {
+		glewStatus = GLEW_OK;		// EGL context: the OpenGL entry points are loaded, only GLX is missing
+	}
+#endif
+	if (GLEW_OK != glewStatus || !CreateOffscreenFramebuffer(width, height)) {
+		printf("Failed to initialize GLEW or the offscreen frame buffer!\n");
+		DestroyOffscreenContext();
+		StopAsyncLog();
+		return -1;
+	}
+	const char* renderer = (const char*)glGetString(GL_RENDERER);
+	printf("Renderer: %s\n", renderer);
+	printf("Rendering %d frames of %d x %d pixels offscreen.\n", numFrames, width, height);
+
+	my_setup_OpenGL();
+	my_setup_SceneData();
+	window_size_callback(NULL, width, height);
+	FinishTextureLoads();
+	phSetExactShaders(true);
+	if (benchmark) {
+		SetViewAndRotors(path.Evaluate(0));
+		for (int i = 0; i < WarmupFrames; i++) {
+			MyRenderScene();
+		}
+		glFinish();
+	}
+	LogTimelineEvent("Setup done");
+
+	if (options.ProfileFileName != 0) {
+		StartProfiler();
+	}
+	if (options.FileNamePattern[0] != 0) {
+		StartFrameCapture(options.FileNamePattern, width, height);
+	}
+	GLsync fences[FramesInFlight] = { 0 };
+	unsigned int queries[FramesInFlight];
+	unsigned long drawCalls[FramesInFlight];
+	glGenQueries(FramesInFlight, queries);
+	std::vector<std::chrono::steady_clock::time_point> frameStarts(numFrames + 1);
+	FlyThroughResults results;
+	results.Reset(numFrames);
+	// Frame i waits for frame i-FramesInFlight; the last FramesInFlight frames are waited for at the end.
+	for (int i = 0; i < numFrames + FramesInFlight; i++) {
+		int slot = i % FramesInFlight;
+		if (fences[slot] != 0) {
+			glClientWaitSync(fences[slot], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			glDeleteSync(fences[slot]);
+			fences[slot] = 0;
+			unsigned int triangles = 0;
+			glGetQueryObjectuiv(queries[slot], GL_QUERY_RESULT, &triangles);
+			results.SetFrameCounts(i - FramesInFlight, drawCalls[slot], triangles);
+		}
+		if (i >= numFrames) {
+			continue;
+		}
+		if (benchmark) {
+			SetViewAndRotors(path.Evaluate(i));
+		}
+		frameStarts[i] = std::chrono::steady_clock::now();
+		renderDrawCalls = 0;
+		glBeginQuery(GL_PRIMITIVES_GENERATED, queries[slot]);
+		MyRenderScene();
+		glEndQuery(GL_PRIMITIVES_GENERATED);
+		drawCalls[slot] = renderDrawCalls;
+		CaptureFrame();
+		fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+	frameStarts[numFrames] = std::chrono::steady_clock::now();
+	glDeleteQueries(FramesInFlight, queries);
+	StopFrameCapture();
+	if (options.ProfileFileName != 0) {
+		StopProfiler();
+		LogProfilerSummary(ProfileSummaryTopN);
+		WriteProfilerTrace(options.ProfileFileName);
+	}
+
+	double seconds = std::chrono::duration<double>(frameStarts[numFrames] - frameStarts[0]).count();
+	printf("%d frames in %.3f seconds (%.2f ms per frame).\n", numFrames, seconds,
+		   numFrames > 0 ? 1000.0 * seconds / numFrames : 0.0);
+	int exitCode = 0;
+	if (benchmark) {
+		for (int i = 0; i < numFrames; i++) {
+			double ms = std::chrono::duration<double, std::milli>(frameStarts[i + 1] - frameStarts[i]).count();
+			results.SetFrameTime(i, ms);
+		}
+		printf("Frame time: average %.2f ms, p50 %.2f ms, p95 %.2f ms, p99 %.2f ms.\n",
+			   results.AverageFrameTime(), results.FrameTimePercentile(50.0),
+			   results.FrameTimePercentile(95.0), results.FrameTimePercentile(99.0));
+		FILE* jsonFile = fopen(options.JsonFileName, "w");
+		if (jsonFile) {
+			results.WriteJson(jsonFile, options.BenchmarkPath[0] ? options.BenchmarkPath : "default",
+							  renderer ? renderer : "", width, height);
+			fclose(jsonFile);
+			printf("Benchmark results written to %s.\n", options.JsonFileName);
+		}
+		else {
+			fprintf(stderr, "Unable to open file: %s\n", options.JsonFileName);
+			exitCode = -1;
+		}
+	}
+
+	DeleteOffscreenFramebuffer();
+	DestroyOffscreenContext();
+	StopAsyncLog();
+	return exitCode;
+}
+
+// Command line options:
+//    -headless               Render offscreen, with no window (see RunHeadless)
+//    -size WIDTHxHEIGHT      Frame size for -headless (default 800x600)
+//    -frames N               Number of frames for -headless (default 100)
+//    -output PATTERN         File names for -headless frames, with one %d for the frame
+//                              number (default "frame%05d.qoi", or none for a
+//                              benchmark; "" writes no files)
+//    -benchmark [PATH]       Headless benchmark along a camera path file (FlyThrough.h),
+//                              or along the built-in path
+//    -json FILE              Benchmark results (default "benchmark.json")
+//    -profile FILE           Profile the -headless frames, and write the trace to FILE
+//    -recordpath FILE        Record the view and rotor speeds of every frame of an
+//                              interactive session, as a camera path for -benchmark
+int main(int argc, char** argv) {
+	StartAsyncLog();						// Messages from the callbacks are written by a background thread
+
+	HeadlessOptions options = { 0, 0, 100, 0, 0, "benchmark.json", 0 };
+	bool headless = false;
+	const char* recordPathFile = 0;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-headless") == 0) {
+			headless = true;
+		}
+		else if (strcmp(argv[i], "-size") == 0 && i + 1 < argc
+				 && sscanf(argv[i + 1], "%dx%d", &screenWidth, &screenHeight) == 2
+				 && screenWidth > 0 && screenHeight > 0) {
+			i++;
+		}
+		else if (strcmp(argv[i], "-frames") == 0 && i + 1 < argc) {
+			options.NumFrames = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "-output") == 0 && i + 1 < argc) {
+			options.FileNamePattern = argv[++i];
+			if (options.FileNamePattern[0] != 0 && !IsFrameFileNamePattern(options.FileNamePattern)) {
+				printf("-output %s: the pattern needs exactly one %%d for the frame number, and %%%% for a %%.\n",
+					   options.FileNamePattern);
+				StopAsyncLog();
+				return -1;
+			}
+		}
+		else if (strcmp(argv[i], "-benchmark") == 0) {
+			headless = true;
+			options.BenchmarkPath = (i + 1 < argc && argv[i + 1][0] != '-') ? argv[++i] : "";
+		}
+		else if (strcmp(argv[i], "-json") == 0 && i + 1 < argc) {
+			options.JsonFileName = argv[++i];
+		}
+		else if (strcmp(argv[i], "-profile") == 0 && i + 1 < argc) {
+			options.ProfileFileName = argv[++i];
+		}
+		else if (strcmp(argv[i], "-recordpath") == 0 && i + 1 < argc) {
+			recordPathFile = argv[++i];
+		}
+		else {
+			printf("Unknown option: %s\n", argv[i]);
+			printf("Options: -headless, -size WIDTHxHEIGHT, -frames N, -output PATTERN,\n"
+				   "         -benchmark [PATH], -json FILE, -profile FILE, -recordpath FILE\n");
+			StopAsyncLog();
+			return -1;
+		}
+	}
+	if (headless) {
+		options.Width = screenWidth;
+		options.Height = screenHeight;
+		if (options.FileNamePattern == 0) {
+			options.FileNamePattern = (options.BenchmarkPath != 0) ? "" : "frame%05d.qoi";
+		}
+		return RunHeadless(options);
+	}
+
 	glfwSetErrorCallback(error_callback);	// Supposed to be called in event of errors. (doesn't work?)
 	glfwInit();
 	//glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -490,15 +750,31 @@ int main() {
 	GLFWwindow* window = glfwCreateWindow(screenWidth, screenHeight, "Phong Demo", NULL, NULL);
 	if (window == NULL) {
 		printf("Failed to create GLFW window!\n");
+		StopAsyncLog();
 		return -1;
 	}
 	glfwMakeContextCurrent(window);
+	LogTimelineEvent("Window created");
 
 	if (GLEW_OK != glewInit()) {
 		printf("Failed to initialize GLEW!.\n");
+		StopAsyncLog();
 		return -1;
 	}
 
+	// Without parallel shader compiles in the driver, shaders are compiled on a worker
+	//    thread, using a hidden window whose context shares objects with the main window.
+	GLFWwindow* shaderWindow = NULL;
+	if (!parallel_shader_compile_supported()) {
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		shaderWindow = glfwCreateWindow(1, 1, "Shader compiler", NULL, window);
+		glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+		if (shaderWindow != NULL) {
+			start_shader_compile_thread(shaderWindow);
+		}
+	}
+	LogTimelineEvent("GLEW initialized");
+
 	// Print info of GPU and supported OpenGL version
 	printf("Renderer: %s\n", glGetString(GL_RENDERER));
 	printf("OpenGL version supported %s\n", glGetString(GL_VERSION));
@@ -520,6 +796,8 @@ int main() {
     printf("Press 'D' key (Diffuse) to toggle rendering Diffuse light.\n");
     printf("Press 'S' key (Specular) to toggle rendering Specular light.\n");
     printf("Press 'V' key (Viewer) to toggle using a local viewer.\n");
+    printf("Press 'I' key (profIle) to start or stop profiling; the trace goes to profile.json.\n");
+    printf("Press 'O' key (Output) to start or stop recording the frames to frameNNNNN.qoi files.\n");
     printf("Press ESCAPE to exit.\n");
 	
     setup_callbacks(window);
@@ -529,11 +807,25 @@ int main() {
 	my_setup_SceneData();
  	window_size_callback(window, screenWidth, screenHeight);
 
+    LogTimelineEvent("Setup done");
+
     // Loop while program is not terminated.
+	bool firstFrame = true;
+	FlyThroughPath recordedPath;
+	int frameNumber = 0;
 	while (!glfwWindowShouldClose(window)) {
 	
+		if (recordPathFile != 0) {
+			recordedPath.AddKey(GetViewAndRotors(frameNumber++));
+		}
 		MyRenderScene();				// Render into the current buffer
+		CaptureFrame();					// Does nothing unless recording
+		ProfilerFrameEnd();				// Does nothing unless profiling
 		glfwSwapBuffers(window);		// Displays what was just rendered (using double buffering).
+		if (firstFrame) {
+			LogTimelineEvent("First frame displayed");
+			firstFrame = false;
+		}
 
 		// Poll events (key presses, mouse events)
 		glfwWaitEventsTimeout(1.0/60.0);	    // Use this to animate at 60 frames/sec (timing is NOT reliable)
@@ -541,7 +833,14 @@ int main() {
 		// glfwPollEvents();					// Use this version when animating as fast as possible
 	}
 
+	if (recordPathFile != 0) {
+		recordedPath.Save(recordPathFile);
+	}
+	StopFrameCapture();
+	FinishTextureLoads();
+	stop_shader_compile_thread();
 	glfwTerminate();
+	StopAsyncLog();
 	return 0;
 }
 
@@ -583,7 +882,7 @@ bool check_for_opengl_errors() {
 			errNum = 7;
 			break;
 		}
-		printf("OpenGL ERROR: %s.\n", errNames[errNum]);
+		LogMessage(LogError, "OpenGL %s.", errNames[errNum]);
 	}
 	return (numErrors != 0);
 }
\ No newline at end of file
@@ -0,0 +1,202 @@
+// *******************************
+// FlyThrough.cpp
+//
+// Camera path files and benchmark statistics for FlyThrough.h.
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+// Allow the use of deprecated fopen() instead of fopen_s()
+#define _CRT_SECURE_NO_DEPRECATE
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#include "FlyThrough.h"
+#include "JsonWrite.h"
+#include "MathMisc.h"
+
+namespace {
+
+bool SameValues(const FlyThroughKey& a, const FlyThroughKey& b)
+{
+    return a.ViewAzimuth == b.ViewAzimuth && a.ViewDirection == b.ViewDirection
+        && a.ZextraDistance == b.ZextraDistance
+        && memcmp(a.SpinVelocity, b.SpinVelocity, sizeof(a.SpinVelocity)) == 0;
+}
+
+} // namespace
+
+bool FlyThroughPath::Load(const char* filename)
+{
+    FILE* infile = fopen(filename, "r");
+    if (!infile) {
+        fprintf(stderr, "Unable to open file: %s\n", filename);
+        return false;
+    }
+    Keys.clear();
+    char line[512];
+    int lineNumber = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), infile)) {
+        lineNumber++;
+        const char* p = line + strspn(line, " \t\r\n");
+        if (*p == 0 || *p == '#') {
+            continue;
+        }
+        FlyThroughKey key;
+        ok = sscanf(p, "%d %lf %lf %lf %lf %lf %lf %lf", &key.Frame, &key.ViewAzimuth, &key.ViewDirection,
+                    &key.ZextraDistance, &key.SpinVelocity[0], &key.SpinVelocity[1],
+                    &key.SpinVelocity[2], &key.SpinVelocity[3]) == 8
+             && key.Frame >= (Keys.empty() ? 0 : Keys.back().Frame + 1);
+        if (ok) {
+            Keys.push_back(key);
+        }
+    }
+    fclose(infile);
+    if (!ok || Keys.empty()) {
+        fprintf(stderr, "Bad camera path, line %d: %s\n"
+                "   (Each line needs an increasing frame number and seven values.)\n", lineNumber, filename);
+        Keys.clear();
+        return false;
+    }
+    return true;
+}
+
+bool FlyThroughPath::Save(const char* filename) const
+{
+    FILE* outfile = fopen(filename, "w");
+    if (!outfile) {
+        fprintf(stderr, "Unable to open file: %s\n", filename);
+        return false;
+    }
+    fprintf(outfile, "# frame  azimuth  direction  zExtra  spin0  spin1  spin2  spin3\n");
+    for (size_t i = 0; i < Keys.size(); i++) {
+        const FlyThroughKey& k = Keys[i];
+        fprintf(outfile, "%d %.17g %.17g %.17g %.17g %.17g %.17g %.17g\n", k.Frame, k.ViewAzimuth, k.ViewDirection,
+                k.ZextraDistance, k.SpinVelocity[0], k.SpinVelocity[1], k.SpinVelocity[2], k.SpinVelocity[3]);
+    }
+    if (fclose(outfile) != 0) {
+        fprintf(stderr, "Error writing file: %s\n", filename);
+        return false;
+    }
+    return true;
+}
+
+void FlyThroughPath::SetDefault()
+{
+    // Direction steps of about 2.1 radians, less than PI, so the orbit goes all the way around.
+    static const FlyThroughKey defaultKeys[] = {
+        {   0, 0.25,  0.0,    0.0,  { 0.0, 0.0, 0.0, 0.0 } },
+        { 120, 0.60,  2.1,   -8.0,  { 4.0, 4.0, 4.0, 4.0 } },
+        { 240, 0.10, -2.1,   10.0,  { 9.0, 7.0, 9.0, 7.0 } },
+        { 360, 0.25,  0.0,    0.0,  { 0.0, 0.0, 0.0, 0.0 } },
+    };
+    Keys.assign(defaultKeys, defaultKeys + sizeof(defaultKeys) / sizeof(defaultKeys[0]));
+}
+
+void FlyThroughPath::AddKey(const FlyThroughKey& key)
+{
+    size_t n = Keys.size();
+    if (n >= 2 && SameValues(key, Keys[n - 1]) && SameValues(key, Keys[n - 2])) {
+        Keys[n - 1].Frame = key.Frame;
+        return;
+    }
+    Keys.push_back(key);
+}
+
+FlyThroughKey FlyThroughPath::Evaluate(int frame) const
+{
+    if (Keys.empty()) {
+        FlyThroughKey none = { frame, 0.0, 0.0, 0.0, { 0.0, 0.0, 0.0, 0.0 } };
+        return none;
+    }
+    if (frame <= Keys.front().Frame) {
+        return Keys.front();
+    }
+    if (frame >= Keys.back().Frame) {
+        return Keys.back();
+    }
+    size_t i = 1;
+    while (Keys[i].Frame <= frame) {
+        i++;
+    }
+    const FlyThroughKey& a = Keys[i - 1];
+    const FlyThroughKey& b = Keys[i];
+    double t = (double)(frame - a.Frame) / (double)(b.Frame - a.Frame);
+    FlyThroughKey key;
+    key.Frame = frame;
+    key.ViewAzimuth = a.ViewAzimuth + t * (b.ViewAzimuth - a.ViewAzimuth);
+    key.ZextraDistance = a.ZextraDistance + t * (b.ZextraDistance - a.ZextraDistance);
+    double turn = b.ViewDirection - a.ViewDirection;
+    turn -= PI2 * floor((turn + PI) / PI2);                  // Into [-PI, PI)
+    key.ViewDirection = a.ViewDirection + t * turn;
+    key.ViewDirection -= PI2 * floor((key.ViewDirection + PI) / PI2);
+    for (int j = 0; j < 4; j++) {
+        key.SpinVelocity[j] = a.SpinVelocity[j] + t * (b.SpinVelocity[j] - a.SpinVelocity[j]);
+    }
+    return key;
+}
+
+void FlyThroughResults::Reset(int numFrames)
+{
+    FrameTimes.assign(numFrames, 0.0);
+    DrawCalls.assign(numFrames, 0);
+    Triangles.assign(numFrames, 0);
+}
+
+void FlyThroughResults::SetFrameCounts(int frame, unsigned long drawCalls, unsigned long long triangles)
+{
+    DrawCalls[frame] = drawCalls;
+    Triangles[frame] = triangles;
+}
+
+double FlyThroughResults::FrameTimePercentile(double percent) const
+{
+    if (FrameTimes.empty()) {
+        return 0.0;
+    }
+    std::vector<double> sorted(FrameTimes);
+    size_t rank = (size_t)ceil(percent / 100.0 * sorted.size());
+    rank = std::min(std::max(rank, (size_t)1), sorted.size());
+    std::nth_element(sorted.begin(), sorted.begin() + (rank - 1), sorted.end());
+    return sorted[rank - 1];
+}
+
+double FlyThroughResults::AverageFrameTime() const
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < FrameTimes.size(); i++) {
+        sum += FrameTimes[i];
+    }
+    return FrameTimes.empty() ? 0.0 : sum / FrameTimes.size();
+}
+
+void FlyThroughResults::WriteJson(FILE* out, const char* pathName, const char* renderer, int width, int height) const
+{
+    double drawCalls = 0.0, triangles = 0.0;
+    unsigned long maxDrawCalls = 0;
+    unsigned long long maxTriangles = 0;
+    for (size_t i = 0; i < FrameTimes.size(); i++) {
+        drawCalls += DrawCalls[i];
+        triangles += (double)Triangles[i];
+        maxDrawCalls = std::max(maxDrawCalls, DrawCalls[i]);
+        maxTriangles = std::max(maxTriangles, Triangles[i]);
+    }
+    double n = FrameTimes.empty() ? 1.0 : (double)FrameTimes.size();
+    double maxTime = FrameTimes.empty() ? 0.0 : *std::max_element(FrameTimes.begin(), FrameTimes.end());
+
+    fprintf(out, "{\n  \"path\": ");
+    WriteJsonString(out, pathName);
+    fprintf(out, ",\n  \"renderer\": ");
+    WriteJsonString(out, renderer);
+    fprintf(out, ",\n  \"width\": %d,\n  \"height\": %d,\n  \"frames\": %d,\n", width, height, (int)FrameTimes.size());
+    fprintf(out, "  \"frameTimeMs\": { \"avg\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n",
+            AverageFrameTime(), FrameTimePercentile(50.0), FrameTimePercentile(95.0), FrameTimePercentile(99.0),
+            maxTime);
+    fprintf(out, "  \"drawCallsPerFrame\": { \"avg\": %.2f, \"max\": %lu },\n", drawCalls / n, maxDrawCalls);
+    fprintf(out, "  \"trianglesPerFrame\": { \"avg\": %.1f, \"max\": %llu }\n}\n", triangles / n, maxTriangles);
+}
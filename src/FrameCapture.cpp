@@ -0,0 +1,257 @@
+// *******************************
+// FrameCapture.cpp
+//
+// Pixel buffer ring and writer threads for FrameCapture.h.
+//
+// Each ring slot has a GL_PIXEL_PACK_BUFFER, a fence, and the number of
+//    the frame it holds.  A slot is reused FrameCaptureLatency frames after
+//    its readback: its fence has then (almost always) been signaled, and
+//    mapping the buffer is a plain memory copy.
+// The copied frames go into a queue, guarded by a mutex, and the writer
+//    threads take them from it.  The images are recycled through a free
+//    list, so recording does not allocate memory every frame.
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+// Use the static library (so glew32.dll is not needed):
+#define GLEW_STATIC
+#include <GL/glew.h> 
+
+#include <stdio.h>
+#include <string.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FrameCapture.h"
+#include "RgbImage.h"
+#include "AsyncLog.h"
+#include "Profiler.h"
+
+namespace {
+
+const int NumWriterThreads = 2;
+
+struct CaptureSlot {
+    unsigned int PackBuffer;
+    GLsync Fence;               // Zero if the slot holds no frame
+    int FrameNumber;
+};
+
+struct CapturedFrame {
+    RgbImage* Image;
+    int FrameNumber;
+};
+
+CaptureSlot captureRing[FrameCaptureLatency];
+bool captureRunning = false;
+std::string fileNamePattern;
+bool writeQoiFiles = false;         // QOI files if the pattern ends in ".qoi", otherwise BMP files
+int captureWidth = 0;
+int captureHeight = 0;
+int nextFrameNumber = 0;
+int numDroppedFrames = 0;
+
+std::mutex queueMutex;
+std::condition_variable queueChanged;
+std::deque<CapturedFrame> frameQueue;       // Frames waiting to be written
+std::vector<RgbImage*> freeImages;          // Images ready to be reused
+bool writersStopping = false;
+std::vector<std::thread> writerThreads;
+
+void WriterLoop()
+{
+    for (;;) {
+        CapturedFrame frame;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueChanged.wait(lock, [] { return !frameQueue.empty() || writersStopping; });
+            if (frameQueue.empty()) {
+                return;             // Stopping, and everything is written
+            }
+            frame = frameQueue.front();
+            frameQueue.pop_front();
+        }
+        char fileName[256];
+        snprintf(fileName, sizeof(fileName), fileNamePattern.c_str(), frame.FrameNumber);
+        if (writeQoiFiles) {
+            frame.Image->WriteQoiFile(fileName);
+        }
+        else {
+            frame.Image->WriteBmpFile(fileName);
+        }
+        std::lock_guard<std::mutex> lock(queueMutex);
+        freeImages.push_back(frame.Image);
+    }
+}
+
+// Copy a slot's frame out of its pixel buffer, and queue it for the writers.
+void RetireSlot(CaptureSlot& slot)
+{
+    glClientWaitSync(slot.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);   // Normally already signaled
+    glDeleteSync(slot.Fence);
+    slot.Fence = 0;
+
+    RgbImage* image = 0;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (frameQueue.size() >= (size_t)FrameCaptureMaxQueued) {
+            numDroppedFrames++;     // The writers are behind: drop this frame
+            return;
+        }
+        if (!freeImages.empty()) {
+            image = freeImages.back();
+            freeImages.pop_back();
+        }
+    }
+    if (image == 0) {
+        image = new RgbImage(captureHeight, captureWidth);
+    }
+
+    long numBytes = captureHeight * image->GetNumBytesPerRow();
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.PackBuffer);
+    const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, numBytes, GL_MAP_READ_BIT);
+    if (pixels != 0) {
+        memcpy((void*)image->ImageData(), pixels, numBytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    std::lock_guard<std::mutex> lock(queueMutex);
+    if (pixels == 0) {
+        freeImages.push_back(image);
+        numDroppedFrames++;
+        return;
+    }
+    CapturedFrame frame = { image, slot.FrameNumber };
+    frameQueue.push_back(frame);
+    queueChanged.notify_one();
+}
+
+} // namespace
+
+bool IsFrameFileNamePattern(const char* pattern)
+{
+    int numConversions = 0;
+    for (const char* p = pattern; *p != 0; p++) {
+        if (*p != '%') {
+            continue;
+        }
+        p++;
+        if (*p == '%') {
+            continue;
+        }
+        p += strspn(p, "-+ #0");
+        p += strspn(p, "0123456789");
+        if (*p == '.') {
+            p++;
+            p += strspn(p, "0123456789");
+        }
+        if (*p != 'd' && *p != 'i') {
+            return false;           // Another conversion, a '*' width, or a '%' at the end
+        }
+        numConversions++;
+    }
+    return numConversions == 1;
+}
+
+void StartFrameCapture(const char* pattern, int width, int height)
+{
+    if (!IsFrameFileNamePattern(pattern)) {
+        LogMessage(LogError, "Frame capture: %s is not a file name pattern with one %%d.", pattern);
+        return;
+    }
+    if (captureRunning) {
+        StopFrameCapture();
+    }
+    fileNamePattern = pattern;
+    writeQoiFiles = fileNamePattern.size() >= 4
+                    && fileNamePattern.compare(fileNamePattern.size() - 4, 4, ".qoi") == 0;
+    captureWidth = width;
+    captureHeight = height;
+    nextFrameNumber = 0;
+    numDroppedFrames = 0;
+
+    // Rows are padded to four bytes, as in RgbImage (and GL_PACK_ALIGNMENT's default).
+    GLsizeiptr numBytes = (GLsizeiptr)height * (((3 * width + 3) >> 2) << 2);
+    for (int i = 0; i < FrameCaptureLatency; i++) {
+        CaptureSlot& slot = captureRing[i];
+        glGenBuffers(1, &slot.PackBuffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.PackBuffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, numBytes, 0, GL_STREAM_READ);
+        slot.Fence = 0;
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    writersStopping = false;
+    for (int i = 0; i < NumWriterThreads; i++) {
+        writerThreads.push_back(std::thread(WriterLoop));
+    }
+    captureRunning = true;
+    LogMessage(LogInfo, "Frame capture started: %d x %d, to %s.", width, height, pattern);
+}
+
+void CaptureFrame()
+{
+    if (!captureRunning) {
+        return;
+    }
+    PROFILE_SCOPE("CaptureFrame");
+    CaptureSlot& slot = captureRing[nextFrameNumber % FrameCaptureLatency];
+    if (slot.Fence != 0) {
+        RetireSlot(slot);           // The frame from FrameCaptureLatency frames ago
+    }
+
+    int oldPackAlign;
+    glGetIntegerv(GL_PACK_ALIGNMENT, &oldPackAlign);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.PackBuffer);
+    glReadPixels(0, 0, captureWidth, captureHeight, GL_RGB, GL_UNSIGNED_BYTE, 0);   // Into the buffer: returns at once
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, oldPackAlign);
+    slot.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.FrameNumber = nextFrameNumber++;
+}
+
+void StopFrameCapture()
+{
+    if (!captureRunning) {
+        return;
+    }
+    // Retire the slots oldest first, so the frames are queued in order.
+    for (int i = 0; i < FrameCaptureLatency; i++) {
+        CaptureSlot& slot = captureRing[(nextFrameNumber + i) % FrameCaptureLatency];
+        if (slot.Fence != 0) {
+            RetireSlot(slot);
+        }
+        glDeleteBuffers(1, &slot.PackBuffer);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        writersStopping = true;
+    }
+    queueChanged.notify_all();
+    for (size_t i = 0; i < writerThreads.size(); i++) {
+        writerThreads[i].join();
+    }
+    writerThreads.clear();
+    for (size_t i = 0; i < freeImages.size(); i++) {
+        delete freeImages[i];
+    }
+    freeImages.clear();
+    captureRunning = false;
+    LogMessage(LogInfo, "Frame capture stopped: %d frames, %d dropped.", nextFrameNumber - numDroppedFrames,
+               numDroppedFrames);
+}
+
+bool FrameCaptureRunning()
+{
+    return captureRunning;
+}
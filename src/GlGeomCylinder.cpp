@@ -29,12 +29,19 @@
 #include "LinearR3.h"
 #include "MathMisc.h"
 #include "assert.h"
+#include <algorithm>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "GlGeomCylinder.h"
+#include "MeshOptimize.h"
+#include "RenderStats.h"
 
 void GlGeomCylinder::InitializeAttribLocations(
 	unsigned int pos_loc, unsigned int normal_loc, unsigned int texcoords_loc)
 {
+	WaitForRemesh();
 	posLoc = pos_loc;
 	normalLoc = normal_loc;
 	texcoordsLoc = texcoords_loc;
@@ -57,177 +64,222 @@ void GlGeomCylinder::InitializeAttribLocations(
         }
 	}
 
-	// Link the VBO and EBO to the VAO, and request OpenGL to
-	//   allocate memory for them.
+	// Enable the vertex attributes.  EndBuild() links the VBO and EBO to the VAO.
 	glBindVertexArray(theVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, theVBO);
-	glBufferData(GL_ARRAY_BUFFER, StrideVal() * GetNumVertices() * sizeof(float), 0, GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, theEBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, GetNumElements() * sizeof(unsigned int), 0, GL_STATIC_DRAW);
-	glVertexAttribPointer(posLoc, 3, GL_FLOAT, GL_FALSE, StrideVal() * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(posLoc);
 	if (UseNormals()) {
-		glVertexAttribPointer(normalLoc, 3, GL_FLOAT, GL_FALSE, StrideVal() * sizeof(float),
-                              (void*)(NormalOffset() * sizeof(float)));
 		glEnableVertexAttribArray(normalLoc);
 	}
 	if (UseTexCoords()) {
-		glVertexAttribPointer(texcoordsLoc, 2, GL_FLOAT, GL_FALSE, StrideVal() * sizeof(float),
-                              (void*)(TexOffset() * sizeof(float)));
 		glEnableVertexAttribArray(texcoordsLoc);
 	}
-    if (MultiDrawIndirectUsed()) {
-        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, theIBO);
-        glBufferData(GL_DRAW_INDIRECT_BUFFER, GetNumDraws()*sizeof(multiDrawData), 0, GL_STATIC_DRAW);
-    }
 
 	// Calculate and load the buffer data
+	requestedSlices = numSlices;
+	requestedStacks = numStacks;
+	requestedRings = numRings;
 	LoadBufferData();
 }
 
+// After InitializeAttribLocations(), the new mesh is built by a worker thread
+//    into the back buffers; the old mesh is rendered until PollRemesh() swaps them.
 void GlGeomCylinder::Remesh(int slices, int stacks, int rings)
 {
-    if (slices == numSlices && stacks == numStacks && rings == numRings) {
+	slices = ClampRange(slices, 3, 255);
+	stacks = ClampRange(stacks, 1, 255);
+	rings = ClampRange(rings, 1, 255);
+	if (slices == requestedSlices && stacks == requestedStacks && rings == requestedRings) {
 		return;
 	}
 
-	numSlices = ClampRange(slices, 3, 255);
-	numStacks = ClampRange(stacks, 1, 255);
-    numRings = ClampRange(rings, 1, 255);
+	requestedSlices = slices;
+	requestedStacks = stacks;
+	requestedRings = rings;
+	if (theVAO == 0) {
+		numSlices = slices;
+		numStacks = stacks;
+		numRings = rings;
+	}
+	else if (!remeshing) {
+		StartRemesh();
+	}
+	// Otherwise PollRemesh() starts the new remesh once the current one is swapped in.
+}
+
+void GlGeomCylinder::PollRemesh()
+{
+	if (!remeshing || !remeshDone.load(std::memory_order_acquire)) {
+		return;
+	}
+	remeshThread.join();
+	remeshing = false;
+	EndBuild();
+	if (requestedSlices != numSlices || requestedStacks != numStacks || requestedRings != numRings) {
+		StartRemesh();
+	}
+}
+
+void GlGeomCylinder::SetCompactFormat(bool compact)
+{
+	if (compact == compactFormat) {
+		return;
+	}
+	WaitForRemesh();
+	compactFormat = compact;
 	if (theVAO != 0) {
 		LoadBufferData();
 	}
 }
 
+void GlGeomCylinder::WaitForRemesh()
+{
+	if (remeshing) {
+		remeshThread.join();
+		remeshing = false;
+		EndBuild();
+	}
+	if (theVAO != 0 && (requestedSlices != numSlices || requestedStacks != numStacks || requestedRings != numRings)) {
+		numSlices = requestedSlices;
+		numStacks = requestedStacks;
+		numRings = requestedRings;
+		LoadBufferData();
+	}
+}
+
+void GlGeomCylinder::StartRemesh()
+{
+	numSlices = requestedSlices;
+	numStacks = requestedStacks;
+	numRings = requestedRings;
+	BeginBuild();
+	remeshDone.store(false, std::memory_order_relaxed);
+	remeshing = true;
+	remeshThread = std::thread([this]() {
+		BuildBufferData(backVertexData, backElementData);
+		remeshDone.store(true, std::memory_order_release);
+	});
+}
+
 
 // ******************************
 // Calculate and load all vertex attributes into the VBO.
 // Load all element indices into the EBO.
 // After this is called, the sphere is ready to be rendered.
-//   -- At the moment, only vertex position and normals are loaded.
+// Unlike Remesh(), this does all the work before returning.
 // ******************************
 void GlGeomCylinder::LoadBufferData() {
+    BeginBuild();
+    BuildBufferData(backVertexData, backElementData);
+    EndBuild();
+}
 
-    // Allocate memory for vertex positions, normals, texture coordinates, and multidraw commands.
-    float *tempStoref = new float[GetNumVertices() * StrideVal()];
-    
-    // Data is laid out: top face vertices, then bottom face vertices, then side vertices
-    const int bottomStart = (1 + (numSlices+1)*numRings)*StrideVal();
+// Allocate and map the back buffers for the mesh with numSlices, numStacks and numRings,
+//    so that it can be written straight into them (from any thread).  They are mapped
+//    through GL_COPY_WRITE_BUFFER, to leave the element buffer of the bound VAO alone.
+void GlGeomCylinder::BeginBuild()
+{
+    UpdateTrigTables();
+    if (backVBO == 0) {
+        glGenBuffers(2, &backVBO);
+    }
+    GLsizeiptr vertexBytes = VertexBytes();
+    GLsizeiptr elementBytes = ElementBytes();
+    glBindBuffer(GL_COPY_WRITE_BUFFER, backVBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, vertexBytes, 0, GL_STATIC_DRAW);     // The size may have changed
+    backVertexData = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, vertexBytes,
+                                      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, backEBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, elementBytes, 0, GL_STATIC_DRAW);
+    backElementData = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, elementBytes,
+                                       GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    backMapped = (backVertexData != 0 && backElementData != 0);
+    if (!backMapped) {
+        // No mapping: fill client memory, which EndBuild() uploads
+        UnmapBackBuffers();
+        vertexStore.resize(vertexBytes);
+        elementStore.resize(elementBytes);
+        backVertexData = vertexStore.data();
+        backElementData = elementStore.data();
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
 
-    // Set top and bottom center vertices
-    tempStoref[1] = 1.0;
-    tempStoref[0] = tempStoref[2] = 0.0;
-    tempStoref[bottomStart + 1] = -1.0;
-    tempStoref[bottomStart] = tempStoref[bottomStart + 2] = 0.0;
-    if (UseNormals()) {
-        tempStoref[4] = 1.0f;
-        tempStoref[3] = tempStoref[5] = 0.0;
-        tempStoref[bottomStart + 4] = -1.0f;
-        tempStoref[bottomStart + 3] = tempStoref[bottomStart + 5] = 0.0;
-    }
-    if (UseTexCoords()) {
-        int toff = TexOffset();
-        tempStoref[toff] = tempStoref[toff + 1] = 0.5f;
-        tempStoref[bottomStart + toff] = tempStoref[bottomStart + toff + 1] = 0.5f;
-    }
-
-    // Set all positions and normals, radial slice by radial slice.
-    int topIdx = StrideVal();
-    int bottomIdx = bottomStart + StrideVal();
-    for (int i = 0; i <= numSlices; i++) {
-        // Handle a slice of vertices.
-        // theta measures from the xz-plane, going counterclockwise viewed from above.
-        float theta = ((float)i)*(float)PI2 / (float)(numSlices);
-        float c = cos(theta);
-        float s = sinf(theta);
-        // Top & bottom face vertices, positions and normals
-        for (int j = 0; j < numRings; j++) {
-            float radius = (float)(j+1) / (float)numRings;
-            float sinRadius = s * radius;
-            float cosRadius = c * radius;
-            tempStoref[topIdx] = -sinRadius;        // x coordinate
-            tempStoref[bottomIdx] = sinRadius;    // x coordinate (negated, for outward facing downward)
-            tempStoref[topIdx + 1] = 1.0f;           // y coordinate
-            tempStoref[bottomIdx + 1] = -1.0f;       // y coordinate
-            tempStoref[topIdx + 2] = -cosRadius;        // z coordinate
-            tempStoref[bottomIdx + 2] = -cosRadius;     // z coordinate
-            if (UseNormals()) {
-                const int noff = NormalOffset();
-                tempStoref[topIdx + noff + 1] = 1.0f;
-                tempStoref[topIdx + noff] = tempStoref[topIdx + noff + 2] = 0.0f;
-                tempStoref[bottomIdx + noff + 1] = -1.0f;
-                tempStoref[bottomIdx + noff] = tempStoref[bottomIdx + noff + 2] = 0.0f;
-            }
-            if (UseTexCoords()) {
-                const int toff = TexOffset();
-                tempStoref[topIdx + toff] = -sinRadius * 0.5f + 0.5f;
-                tempStoref[topIdx + toff + 1] = -cosRadius*0.5f + 0.5f;
-                tempStoref[bottomIdx + toff] = sinRadius * 0.5f + 0.5f;
-                tempStoref[bottomIdx + toff + 1] = -cosRadius * 0.5f + 0.5f;
-            }
-            topIdx += StrideVal();
-            bottomIdx += StrideVal();
-        }
-        // Side vertices, positions and normals.
-        int sideIdx = 2 * bottomStart + i*(numStacks + 1)*StrideVal();    // Immediately after bottom comes the side
-        for (int j = 0; j <= numStacks; j++) {
-            float jFrac = (float)j / (float)numStacks;
-            tempStoref[sideIdx] = -s;
-            tempStoref[sideIdx + 1] = 1.0f - 2.0f*jFrac;
-            tempStoref[sideIdx + 2] = -c;
-            if (UseNormals()) {
-                tempStoref[sideIdx + NormalOffset()] = -s;
-                tempStoref[sideIdx + NormalOffset() + 1] = 0.0f;
-                tempStoref[sideIdx + NormalOffset() + 2] = -c;
-            }
-            if (UseTexCoords()) {
-                tempStoref[sideIdx + TexOffset()] = (i == numSlices) ? 1.0f : ((float)i) / (float)numSlices;   // s texture coordinate;
-                tempStoref[sideIdx + TexOffset() + 1] = 1.0f - jFrac;                        // t texture coordinate
-            }
-            sideIdx += StrideVal();
-        }
-        // Texture coordinates not yet assigned in this version of the code
+// Returns false if the contents of either mapped buffer were lost.
+bool GlGeomCylinder::UnmapBackBuffers()
+{
+    bool intact = true;
+    if (backVertexData != 0) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, backVBO);
+        intact = (glUnmapBuffer(GL_COPY_WRITE_BUFFER) == GL_TRUE) && intact;
+    }
+    if (backElementData != 0) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, backEBO);
+        intact = (glUnmapBuffer(GL_COPY_WRITE_BUFFER) == GL_TRUE) && intact;
     }
+    backVertexData = 0;
+    backElementData = 0;
+    return intact;
+}
+
+// Swap the filled back buffers with the VBO and EBO of the VAO, and set up the draws.
+void GlGeomCylinder::EndBuild()
+{
+    if (backMapped && !UnmapBackBuffers()) {
+        // The mapped contents were lost: fill client memory instead
+        backMapped = false;
+        vertexStore.resize(VertexBytes());
+        elementStore.resize(ElementBytes());
+        BuildBufferData(vertexStore.data(), elementStore.data());
+    }
+    if (!backMapped) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, backVBO);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, 0, vertexStore.size(), vertexStore.data());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, backEBO);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, 0, elementStore.size(), elementStore.data());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        std::vector<unsigned char>().swap(vertexStore);
+        std::vector<unsigned char>().swap(elementStore);
+        backVertexData = 0;
+        backElementData = 0;
+    }
+    std::swap(theVBO, backVBO);
+    std::swap(theEBO, backEBO);
+    drawnNumSlices = numSlices;
+
     glBindVertexArray(theVAO);
     glBindBuffer(GL_ARRAY_BUFFER, theVBO);
-    glBufferData(GL_ARRAY_BUFFER, StrideVal() * GetNumVertices() * sizeof(float), tempStoref, GL_STATIC_DRAW);
-
-    // Set the Element Array Buffer values.
-    unsigned int* tempStorei = (unsigned int*)tempStoref;     // Can reuse the same memory to hold our element indices array
-    // Set vertex indices for triangle strips from the top face, slice by slice
-    // Then, do the same for the bottom face.
-    unsigned int* toPtr = tempStorei;
-    for (int iFace = 0; iFace < 2; iFace++) {
-        // iFace = 0 or 1 for top or bottom face, respectively
-        unsigned int leftIdx = iFace * (1 + numRings * (numSlices + 1));
-        unsigned int firstLeftIdx = leftIdx;    // Current face's center vertex
-        unsigned int rightIdx = firstLeftIdx + 1 + numRings;
-        leftIdx++;                              // Skip center vertex
-        for (int i = 0; i < numSlices; i++) {
-            *(toPtr++) = firstLeftIdx;          // Center top or bottom vertex
-            for (int j = 0; j < numRings; j++) {
-                *(toPtr++) = leftIdx++;
-                *(toPtr++) = rightIdx++;
-            }
+    if (compactFormat) {
+        GLsizei stride = PackedVertexStride(UseNormals(), UseTexCoords());
+        glVertexAttribPointer(posLoc, 3, GL_SHORT, GL_TRUE, stride, (void*)0);
+        if (UseNormals()) {
+            glVertexAttribPointer(normalLoc, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+                                  (void*)(size_t)PackedNormalOffset());
+        }
+        if (UseTexCoords()) {
+            glVertexAttribPointer(texcoordsLoc, 2, GL_HALF_FLOAT, GL_FALSE, stride,
+                                  (void*)(size_t)PackedTexOffset(UseNormals()));
         }
     }
-
-    // Set vertex indices for triangle strips for the sides, slice by slice
-    const int sideStart = 2 * (1 + numRings*(numSlices+1));
-    unsigned int leftIdx = sideStart;
-    unsigned int rightIdx = sideStart + (numStacks + 1);
-    for (int i = 0; i < numSlices; i++) {
-        for (int j = 0; j <= numStacks; j++) {
-            *(toPtr++) = rightIdx++;
-            *(toPtr++) = leftIdx++;
+    else {
+        glVertexAttribPointer(posLoc, 3, GL_FLOAT, GL_FALSE, StrideVal() * sizeof(float), (void*)0);
+        if (UseNormals()) {
+            glVertexAttribPointer(normalLoc, 3, GL_FLOAT, GL_FALSE, StrideVal() * sizeof(float),
+                                  (void*)(NormalOffset() * sizeof(float)));
+        }
+        if (UseTexCoords()) {
+            glVertexAttribPointer(texcoordsLoc, 2, GL_FLOAT, GL_FALSE, StrideVal() * sizeof(float),
+                                  (void*)(TexOffset() * sizeof(float)));
         }
     }
-
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, theEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, GetNumElements()*sizeof(unsigned int), tempStorei, GL_STATIC_DRAW);
-	delete[] tempStoref;
 
-    if (MultiDrawIndirectUsed()) {
+    if (compactFormat) {
+        // Three glDrawElements ranges: the top face, the bottom face, and the side
+        drawnFaceElements = NumFaceElements();
+        drawnSideElements = NumSideElements();
+        drawnIndexType = ShortIndices() ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    }
+    else if (MultiDrawIndirectUsed()) {
         mdDataPtr = new multiDrawData[GetNumDraws()];   // Hold the multi-draw commands
         int ii = 0;
         int iC = 0;
@@ -255,6 +307,8 @@ void GlGeomCylinder::LoadBufferData() {
         mdDataPtr = 0;
     }
     else {
+        delete[] mdCounts;
+        delete[] mdIndices;
         mdCounts  = new GLsizei[3*numSlices];
         mdIndices = new GLvoid*[3*numSlices];
         int ii = 0;
@@ -274,6 +328,227 @@ void GlGeomCylinder::LoadBufferData() {
     glBindVertexArray(0);           // Good practice to unbind: helps with debugging if nothing else
 }
 
+
+// The sine and cosine of each slice angle, recomputed only when numSlices changes.
+void GlGeomCylinder::UpdateTrigTables()
+{
+    if ((int)sliceCos.size() == numSlices + 1) {
+        return;
+    }
+    sliceCos.resize(numSlices + 1);
+    sliceSin.resize(numSlices + 1);
+    for (int i = 0; i <= numSlices; i++) {
+        // theta measures from the xz-plane, going counterclockwise viewed from above.
+        float theta = ((float)i)*(float)PI2 / (float)(numSlices);
+        sliceCos[i] = cos(theta);
+        sliceSin[i] = sinf(theta);
+    }
+}
+
+long GlGeomCylinder::VertexBytes() const
+{
+    long stride = compactFormat ? PackedVertexStride(UseNormals(), UseTexCoords()) : StrideVal() * sizeof(float);
+    return stride * GetNumVertices();
+}
+
+void GlGeomCylinder::BuildBufferData(void* vertexData, void* elementData) const
+{
+    if (compactFormat) {
+        FillCompactBufferData(vertexData, elementData);
+    }
+    else {
+        FillBufferData((float*)vertexData, (unsigned int*)elementData);
+    }
+}
+
+// The compact format is converted from the triangle strips, built in client memory.
+//    The top face, bottom face and side are reordered by Tipsify separately, so
+//    that RenderTop(), RenderBase() and RenderSide() can each draw one range.
+void GlGeomCylinder::FillCompactBufferData(void* vertexData, void* elementData) const
+{
+    const int faceStripLength = 2 * numRings + 1;
+    const int sideStripLength = 2 * numStacks + 2;
+    std::vector<float> vertices(StrideVal() * GetNumVertices());
+    std::vector<unsigned int> strips(numSlices*(2 * faceStripLength + sideStripLength));
+    FillBufferData(vertices.data(), strips.data());
+
+    // Room for the largest part: the faces have more triangles than the side when numRings > numStacks
+    long maxPartElements = std::max(NumFaceElements(), NumSideElements());
+    std::vector<unsigned int> triangles(maxPartElements);
+    std::vector<unsigned int> ordered(maxPartElements);
+    const unsigned int* fromStrip = strips.data();
+    unsigned char* toElement = (unsigned char*)elementData;
+    size_t indexSize = ShortIndices() ? sizeof(unsigned short) : sizeof(unsigned int);
+    for (int part = 0; part < 3; part++) {
+        // part = 0, 1, 2 for the top face, bottom face, and side, respectively
+        int stripLength = (part < 2) ? faceStripLength : sideStripLength;
+        long numIndices = 0;
+        for (int i = 0; i < numSlices; i++, fromStrip += stripLength) {
+            numIndices += StripToTriangles(fromStrip, stripLength, triangles.data() + numIndices);
+        }
+        assert(numIndices == ((part < 2) ? NumFaceElements() : NumSideElements()));
+        TipsifyTriangles(triangles.data(), numIndices, GetNumVertices(), MeshVertexCacheSize, ordered.data());
+        CopyIndices(ordered.data(), numIndices, ShortIndices(), toElement);
+        toElement += numIndices * indexSize;
+    }
+
+    PackVertices(vertices.data(), GetNumVertices(), StrideVal(),
+                 UseNormals() ? NormalOffset() : -1, UseTexCoords() ? TexOffset() : -1, vertexData);
+}
+
+// Fill in all the vertices and elements, splitting large meshes by slices across threads.
+void GlGeomCylinder::FillBufferData(float* vertexData, unsigned int* elementData) const
+{
+    // Data is laid out: top face vertices, then bottom face vertices, then side vertices
+    // Set top and bottom center vertices
+    const int bottomStart = (1 + (numSlices+1)*numRings)*StrideVal();
+    for (int k = 0; k < 2; k++) {
+        float* toVert = vertexData + k*bottomStart;
+        float y = (k == 0) ? 1.0f : -1.0f;
+        toVert[0] = 0.0f;
+        toVert[1] = y;
+        toVert[2] = 0.0f;
+        if (UseNormals()) {
+            toVert[NormalOffset()] = 0.0f;
+            toVert[NormalOffset() + 1] = y;
+            toVert[NormalOffset() + 2] = 0.0f;
+        }
+        if (UseTexCoords()) {
+            toVert[TexOffset()] = 0.5f;
+            toVert[TexOffset() + 1] = 0.5f;
+        }
+    }
+
+    // Starting a thread only pays off with several thousand vertices to fill.
+    const int minVerticesPerThread = 8192;
+    int numThreads = (int)std::thread::hardware_concurrency();     // 0 if unknown
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+    int maxThreads = GetNumVertices() / minVerticesPerThread;
+    if (numThreads > maxThreads) {
+        numThreads = maxThreads > 1 ? maxThreads : 1;
+    }
+    int numVertexSlices = numSlices + 1;
+    std::vector<std::thread> threads;
+    for (int t = 1; t < numThreads; t++) {
+        threads.push_back(std::thread(&GlGeomCylinder::FillSlices, this, vertexData, elementData,
+                                      numVertexSlices*t / numThreads, numVertexSlices*(t + 1) / numThreads));
+    }
+    FillSlices(vertexData, elementData, 0, numVertexSlices / numThreads);
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+}
+
+// Fill in the top, bottom and side vertices of the slices firstSlice,...,endSlice-1
+//    (out of numSlices+1: the last repeats the first, with s texture coordinate 1),
+//    and the triangle strips starting at those slices.
+// The vertex data may be write-combined memory: each vertex is written in
+//    order, and nothing is read back.
+void GlGeomCylinder::FillSlices(float* vertexData, unsigned int* elementData, int firstSlice, int endSlice) const
+{
+    const int stride = StrideVal();
+    const bool useNormals = UseNormals();
+    const bool useTexCoords = UseTexCoords();
+    const int noff = NormalOffset();
+    const int toff = TexOffset();
+    const int bottomStartIdx = 1 + (numSlices + 1)*numRings;     // Index of the bottom center vertex
+    const int sideStartIdx = 2 * bottomStartIdx;
+    // The face vertices of a slice are the radii (0, +-1, -radius) rotated around the
+    //    y-axis, by theta for the top face and by -theta for the bottom face (its x
+    //    coordinate is negated, for outward facing downward).  The rotations are
+    //    structure of arrays passes, which vectorize.
+    std::vector<float> profileX(numRings, 0.0f), topY(numRings, 1.0f), bottomY(numRings, -1.0f), profileZ(numRings);
+    for (int j = 0; j < numRings; j++) {
+        profileZ[j] = -(float)(j + 1) / (float)numRings;
+    }
+    std::vector<float> topX(numRings), topZ(numRings), bottomX(numRings), bottomZ(numRings), ringY(numRings);
+    for (int i = firstSlice; i < endSlice; i++) {
+        // Handle a slice of vertices.
+        float c = sliceCos[i];
+        float s = sliceSin[i];
+        Matrix3x3T<float> rotateTop(c, 0.0f, -s, 0.0f, 1.0f, 0.0f, s, 0.0f, c);
+        Matrix3x3T<float> rotateBottom(c, 0.0f, s, 0.0f, 1.0f, 0.0f, -s, 0.0f, c);
+        rotateTop.Transform(profileX.data(), topY.data(), profileZ.data(),
+                            topX.data(), ringY.data(), topZ.data(), numRings);
+        rotateBottom.Transform(profileX.data(), bottomY.data(), profileZ.data(),
+                               bottomX.data(), ringY.data(), bottomZ.data(), numRings);
+        // Top & bottom face vertices, positions and normals
+        float* toTop = vertexData + (1 + i*numRings)*stride;
+        float* toBottom = toTop + bottomStartIdx*stride;
+        for (int j = 0; j < numRings; j++) {
+            toTop[0] = topX[j];             // x coordinate
+            toTop[1] = 1.0f;                // y coordinate
+            toTop[2] = topZ[j];             // z coordinate
+            toBottom[0] = bottomX[j];       // x coordinate
+            toBottom[1] = -1.0f;            // y coordinate
+            toBottom[2] = bottomZ[j];       // z coordinate
+            if (useNormals) {
+                toTop[noff] = 0.0f;
+                toTop[noff + 1] = 1.0f;
+                toTop[noff + 2] = 0.0f;
+                toBottom[noff] = 0.0f;
+                toBottom[noff + 1] = -1.0f;
+                toBottom[noff + 2] = 0.0f;
+            }
+            if (useTexCoords) {
+                toTop[toff] = topX[j] * 0.5f + 0.5f;
+                toTop[toff + 1] = topZ[j] * 0.5f + 0.5f;
+                toBottom[toff] = bottomX[j] * 0.5f + 0.5f;
+                toBottom[toff + 1] = bottomZ[j] * 0.5f + 0.5f;
+            }
+            toTop += stride;
+            toBottom += stride;
+        }
+        // Side vertices, positions and normals.
+        float sTex = (i == numSlices) ? 1.0f : ((float)i) / (float)numSlices;   // s texture coordinate
+        float* toSide = vertexData + (sideStartIdx + i*(numStacks + 1))*stride;
+        for (int j = 0; j <= numStacks; j++) {
+            float jFrac = (float)j / (float)numStacks;
+            toSide[0] = -s;
+            toSide[1] = 1.0f - 2.0f*jFrac;
+            toSide[2] = -c;
+            if (useNormals) {
+                toSide[noff] = -s;
+                toSide[noff + 1] = 0.0f;
+                toSide[noff + 2] = -c;
+            }
+            if (useTexCoords) {
+                toSide[toff] = sTex;
+                toSide[toff + 1] = 1.0f - jFrac;            // t texture coordinate
+            }
+            toSide += stride;
+        }
+    }
+
+    // Set vertex indices for triangle strips from the top face, then the bottom face,
+    //    then the sides; each has one strip per slice.
+    const int faceStripLength = 2 * numRings + 1;
+    const int sideStripLength = 2 * numStacks + 2;
+    for (int i = firstSlice; i < endSlice && i < numSlices; i++) {
+        for (int iFace = 0; iFace < 2; iFace++) {
+            // iFace = 0 or 1 for top or bottom face, respectively
+            unsigned int* toPtr = elementData + (iFace*numSlices + i)*faceStripLength;
+            unsigned int centerIdx = iFace * bottomStartIdx;    // Current face's center vertex
+            unsigned int leftIdx = centerIdx + 1 + i*numRings;
+            unsigned int rightIdx = leftIdx + numRings;
+            *(toPtr++) = centerIdx;
+            for (int j = 0; j < numRings; j++) {
+                *(toPtr++) = leftIdx++;
+                *(toPtr++) = rightIdx++;
+            }
+        }
+        unsigned int* toPtr = elementData + 2*numSlices*faceStripLength + i*sideStripLength;
+        unsigned int leftIdx = sideStartIdx + i*(numStacks + 1);
+        unsigned int rightIdx = leftIdx + (numStacks + 1);
+        for (int j = 0; j <= numStacks; j++) {
+            *(toPtr++) = rightIdx++;
+            *(toPtr++) = leftIdx++;
+        }
+    }
+}
+
 // **********************************************
 // This routine does the rendering.
 // If the sphere's VAO, VBO, EBO need to be loaded, it does this first.
@@ -282,18 +557,26 @@ void GlGeomCylinder::LoadBufferData() {
 void GlGeomCylinder::Render()
 {
     assert(AssertReadyToRender());
-    if (MultiDrawIndirectUsed()) {
+    PollRemesh();
+    if (compactFormat) {
+        glBindVertexArray(theVAO);
+        glDrawElements(GL_TRIANGLES, 2 * drawnFaceElements + drawnSideElements, drawnIndexType, (void*)0);
+        CountDrawCall();
+    }
+    else if (MultiDrawIndirectUsed()) {
         check_for_opengl_errors();
         glBindVertexArray(theVAO);
         glBindBuffer(GL_DRAW_INDIRECT_BUFFER, theIBO);
         check_for_opengl_errors();
         //glMultiDrawElementsIndirect(GL_TRIANGLE_STRIP, GL_UNSIGNED_INT, (void*)0, GetNumDraws(), 0);
         glDrawElementsIndirect(GL_TRIANGLE_STRIP, GL_UNSIGNED_INT, (void*)0);
+        CountDrawCall();
         check_for_opengl_errors();
     }
     else {
         glBindVertexArray(theVAO);
-        glMultiDrawElements(GL_TRIANGLE_STRIP, mdCounts, GL_UNSIGNED_INT, mdIndices, GetNumDraws());
+        glMultiDrawElements(GL_TRIANGLE_STRIP, mdCounts, GL_UNSIGNED_INT, mdIndices, 3 * drawnNumSlices);
+        CountDrawCall();
     }
     glBindVertexArray(0);           // Good practice to unbind: helps with debugging if nothing else
  }
@@ -301,29 +584,50 @@ void GlGeomCylinder::Render()
 void GlGeomCylinder::RenderTop()
 {
     assert(AssertReadyToRender());
+    PollRemesh();
     assert(!MultiDrawIndirectUsed());           // MultiDrawIndirectUsed: Not implemented successfully yet!
     glBindVertexArray(theVAO);
-    glMultiDrawElements(GL_TRIANGLE_STRIP, mdCounts, GL_UNSIGNED_INT, mdIndices, GetNumDrawsFace());
+    if (compactFormat) {
+        glDrawElements(GL_TRIANGLES, drawnFaceElements, drawnIndexType, (void*)0);
+    }
+    else {
+        glMultiDrawElements(GL_TRIANGLE_STRIP, mdCounts, GL_UNSIGNED_INT, mdIndices, drawnNumSlices);
+    }
+    CountDrawCall();
     glBindVertexArray(0);           // Good practice to unbind: helps with debugging if nothing else
 }
 
 void GlGeomCylinder::RenderBase()
 {
     assert(AssertReadyToRender());
+    PollRemesh();
     assert(!MultiDrawIndirectUsed());           // MultiDrawIndirectUsed: Not implemented successfully yet!
     glBindVertexArray(theVAO);
-    int d = GetNumDrawsFace();
-    glMultiDrawElements(GL_TRIANGLE_STRIP, mdCounts+d, GL_UNSIGNED_INT, mdIndices+d, d);
+    int d = drawnNumSlices;
+    if (compactFormat) {
+        glDrawElements(GL_TRIANGLES, drawnFaceElements, drawnIndexType, IndexOffset(drawnFaceElements));
+    }
+    else {
+        glMultiDrawElements(GL_TRIANGLE_STRIP, mdCounts+d, GL_UNSIGNED_INT, mdIndices+d, d);
+    }
+    CountDrawCall();
     glBindVertexArray(0);           // Good practice to unbind: helps with debugging if nothing else
 }
 
 void GlGeomCylinder::RenderSide()
 {
     assert(AssertReadyToRender());
+    PollRemesh();
     assert(!MultiDrawIndirectUsed());           // MultiDrawIndirectUsed: Not implemented successfully yet!
     glBindVertexArray(theVAO);
-    int d = GetNumDrawsFace();
-    glMultiDrawElements(GL_TRIANGLE_STRIP, mdCounts + 2*d, GL_UNSIGNED_INT, mdIndices + 2*d, d);
+    int d = drawnNumSlices;
+    if (compactFormat) {
+        glDrawElements(GL_TRIANGLES, drawnSideElements, drawnIndexType, IndexOffset(2 * drawnFaceElements));
+    }
+    else {
+        glMultiDrawElements(GL_TRIANGLE_STRIP, mdCounts + 2*d, GL_UNSIGNED_INT, mdIndices + 2*d, d);
+    }
+    CountDrawCall();
     glBindVertexArray(0);           // Good practice to unbind: helps with debugging if nothing else
 }
 
@@ -28,22 +28,27 @@
 #include "LinearR3.h"
 #include "MathMisc.h"
 #include "assert.h"
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "GlGeomSphere.h"
+#include "MeshOptimize.h"
+#include "RenderStats.h"
 
 void GlGeomSphere::InitializeAttribLocations(
 	unsigned int pos_loc, unsigned int normal_loc, unsigned int texcoords_loc)
 {
+	WaitForRemesh();
 	posLoc = pos_loc;
 	normalLoc = normal_loc;
 	texcoordsLoc = texcoords_loc;
 
 	// Decide what values to use for numSlices and numStacks
 	// Default value is 6.  
-	// Minimum value is 3.
-    // Maximum value is 255 -- Allows use of unsigned shorts for elements.
-	numSlices = (numSlices == 0 ? 6 : ClampRange(numSlices, 3, 255));
-	numStacks = (numStacks == 0 ? 6 : ClampRange(numStacks, 2, 255));
+	// Otherwise clamped to the range in GlGeomSphere.h, as in Remesh().
+	numSlices = (numSlices == 0 ? 6 : ClampRange(numSlices, GlGeomSphereMinSlices, GlGeomSphereMaxSlicesStacks));
+	numStacks = (numStacks == 0 ? 6 : ClampRange(numStacks, GlGeomSphereMinStacks, GlGeomSphereMaxSlicesStacks));
 
  	// Generate Vertex Array Object and Buffer Objects, not already done.
 	if (theVAO == 0) {
@@ -52,125 +57,382 @@ void GlGeomSphere::InitializeAttribLocations(
 		glGenBuffers(1, &theEBO);
 	}
 
-	// Link the VBO and EBO to the VAO, and request OpenGL to
-	//   allocate memory for them.
+	// Enable the vertex attributes.  EndBuild() links the VBO and EBO to the VAO.
 	glBindVertexArray(theVAO);
-	glBindBuffer(GL_ARRAY_BUFFER, theVBO);
-	glBufferData(GL_ARRAY_BUFFER, StrideVal() * GetNumVertices() * sizeof(float), 0, GL_STATIC_DRAW);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, theEBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, GetNumElements() * sizeof(unsigned short), 0, GL_STATIC_DRAW);
-	glVertexAttribPointer(posLoc, 3, GL_FLOAT, GL_FALSE, StrideVal() * sizeof(float), (void*)0);
 	glEnableVertexAttribArray(posLoc);
 	if (UseNormals()) {
-		glVertexAttribPointer(normalLoc, 3, GL_FLOAT, GL_FALSE, StrideVal() * sizeof(float), 
-                              (void*)(NormalOffset() * sizeof(float)));
 		glEnableVertexAttribArray(normalLoc);
 	}
 	if (UseTexCoords()) {
-		glVertexAttribPointer(texcoordsLoc, 2, GL_FLOAT, GL_FALSE, StrideVal() * sizeof(float), 
-                              (void*)(TexOffset() * sizeof(float)));
 		glEnableVertexAttribArray(texcoordsLoc);
 	}
 
 	// Calculate the buffer data
+	requestedSlices = numSlices;
+	requestedStacks = numStacks;
 	LoadBufferData();
 }
 
+// Once the sphere is initialized, the new mesh is built on a worker thread, and
+//    Render() keeps drawing the old mesh until the new one is ready.
 void GlGeomSphere::Remesh(int slices, int stacks)
 {
-	if (slices == numSlices && stacks == numStacks) {
+	slices = ClampRange(slices, GlGeomSphereMinSlices, GlGeomSphereMaxSlicesStacks);
+	stacks = ClampRange(stacks, GlGeomSphereMinStacks, GlGeomSphereMaxSlicesStacks);
+	if (slices == requestedSlices && stacks == requestedStacks) {
 		return;
 	}
 
-	numSlices = ClampRange(slices, 3, 255);
-	numStacks = ClampRange(stacks, 3, 255);
+	requestedSlices = slices;
+	requestedStacks = stacks;
+	if (theVAO == 0) {
+		numSlices = slices;
+		numStacks = stacks;
+	}
+	else if (!remeshing) {
+		StartRemesh();
+	}
+	// Otherwise, PollRemesh() starts it when the current remesh is done.
+}
+
+// Swap in the new mesh if the worker thread has finished it.
+void GlGeomSphere::PollRemesh()
+{
+	if (!remeshing || !remeshDone.load(std::memory_order_acquire)) {
+		return;
+	}
+	remeshThread.join();
+	remeshing = false;
+	EndBuild();
+	if (requestedSlices != numSlices || requestedStacks != numStacks) {
+		StartRemesh();          // Remesh() was called again in the meantime
+	}
+}
+
+void GlGeomSphere::SetCompactFormat(bool compact)
+{
+	if (compact == compactFormat) {
+		return;
+	}
+	WaitForRemesh();
+	compactFormat = compact;
 	if (theVAO != 0) {
 		LoadBufferData();
 	}
 }
 
+void GlGeomSphere::WaitForRemesh()
+{
+	if (remeshing) {
+		remeshThread.join();
+		remeshing = false;
+		EndBuild();
+	}
+	if (theVAO != 0 && (requestedSlices != numSlices || requestedStacks != numStacks)) {
+		numSlices = requestedSlices;
+		numStacks = requestedStacks;
+		LoadBufferData();
+	}
+}
+
+void GlGeomSphere::StartRemesh()
+{
+	numSlices = requestedSlices;
+	numStacks = requestedStacks;
+	BeginBuild();
+	remeshDone.store(false, std::memory_order_relaxed);
+	remeshing = true;
+	remeshThread = std::thread([this]() {
+		BuildBufferData(backVertexData, backElementData);
+		remeshDone.store(true, std::memory_order_release);
+	});
+}
 
 // ******************************
 // Calculate and load all vertex attributes into the VBO.
 // Load all element indices into the EBO.
 // After this is called, the sphere is ready to be rendered.
+// This is the synchronous version of StartRemesh() and PollRemesh().
 // ******************************
 void GlGeomSphere::LoadBufferData() {
+    BeginBuild();
+    BuildBufferData(backVertexData, backElementData);
+    EndBuild();
+}
+
+// Get the back buffers ready for the mesh with numSlices and numStacks.
+//    The data is written straight into the mapped buffers, with no temporary copy.
+//    They are bound to GL_COPY_WRITE_BUFFER, which is not part of the VAO state.
+void GlGeomSphere::BeginBuild()
+{
+    UpdateTrigTables();
+    if (backVBO == 0) {
+        glGenBuffers(2, &backVBO);
+    }
+    GLsizeiptr vertexBytes = VertexBytes();
+    GLsizeiptr elementBytes = ElementBytes();
+    glBindBuffer(GL_COPY_WRITE_BUFFER, backVBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, vertexBytes, 0, GL_STATIC_DRAW);     // The size may have changed
+    backVertexData = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, vertexBytes,
+                                      GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, backEBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, elementBytes, 0, GL_STATIC_DRAW);
+    backElementData = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, elementBytes,
+                                       GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    backMapped = (backVertexData != 0 && backElementData != 0);
+    if (!backMapped) {
+        // Could not map the buffers: build in client memory, and upload in EndBuild()
+        UnmapBackBuffers();
+        vertexStore.resize(vertexBytes);
+        elementStore.resize(elementBytes);
+        backVertexData = vertexStore.data();
+        backElementData = elementStore.data();
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+// Returns false if the contents of a mapped buffer were lost.
+bool GlGeomSphere::UnmapBackBuffers()
+{
+    bool intact = true;
+    if (backVertexData != 0) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, backVBO);
+        intact = (glUnmapBuffer(GL_COPY_WRITE_BUFFER) == GL_TRUE) && intact;
+    }
+    if (backElementData != 0) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, backEBO);
+        intact = (glUnmapBuffer(GL_COPY_WRITE_BUFFER) == GL_TRUE) && intact;
+    }
+    backVertexData = 0;
+    backElementData = 0;
+    return intact;
+}
+
+// The back buffers are filled in: make them the buffers of the VAO,
+//    and keep the old ones for the next remesh.
+void GlGeomSphere::EndBuild()
+{
+    if (backMapped && !UnmapBackBuffers()) {
+        // The mapped contents were lost: build them again in client memory
+        backMapped = false;
+        vertexStore.resize(VertexBytes());
+        elementStore.resize(ElementBytes());
+        BuildBufferData(vertexStore.data(), elementStore.data());
+    }
+    if (!backMapped) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, backVBO);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, 0, vertexStore.size(), vertexStore.data());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, backEBO);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, 0, elementStore.size(), elementStore.data());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        std::vector<unsigned char>().swap(vertexStore);
+        std::vector<unsigned char>().swap(elementStore);
+        backVertexData = 0;
+        backElementData = 0;
+    }
+    std::swap(theVBO, backVBO);
+    std::swap(theEBO, backEBO);
+    drawnNumElements = GetNumElements();
+
+    glBindVertexArray(theVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, theVBO);
+    if (compactFormat) {
+        GLsizei stride = PackedVertexStride(UseNormals(), UseTexCoords());
+        glVertexAttribPointer(posLoc, 3, GL_SHORT, GL_TRUE, stride, (void*)0);
+        if (UseNormals()) {
+            glVertexAttribPointer(normalLoc, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride,
+                                  (void*)(size_t)PackedNormalOffset());
+        }
+        if (UseTexCoords()) {
+            glVertexAttribPointer(texcoordsLoc, 2, GL_HALF_FLOAT, GL_FALSE, stride,
+                                  (void*)(size_t)PackedTexOffset(UseNormals()));
+        }
+    }
+    else {
+        glVertexAttribPointer(posLoc, 3, GL_FLOAT, GL_FALSE, StrideVal() * sizeof(float), (void*)0);
+        if (UseNormals()) {
+            glVertexAttribPointer(normalLoc, 3, GL_FLOAT, GL_FALSE, StrideVal() * sizeof(float),
+                                  (void*)(NormalOffset() * sizeof(float)));
+        }
+        if (UseTexCoords()) {
+            glVertexAttribPointer(texcoordsLoc, 2, GL_FLOAT, GL_FALSE, StrideVal() * sizeof(float),
+                                  (void*)(TexOffset() * sizeof(float)));
+        }
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, theEBO);
+    glBindVertexArray(0);           // Good practice to unbind: helps with debugging if nothing else
+}
+
+// The sines and cosines of the slice and stack angles are only recomputed
+//    when the resolution changes.  (A table of size n+1 belongs to resolution n.)
+void GlGeomSphere::UpdateTrigTables()
+{
+    if ((int)sliceCos.size() != numSlices + 1) {
+        sliceCos.resize(numSlices + 1);
+        sliceSin.resize(numSlices + 1);
+        for (int i = 0; i <= numSlices; i++) {
+            // theta measures from the xz-plane, going counterclockwise viewed from above.
+            float theta = ((float)(i%numSlices))*(float)PI2 / (float)(numSlices);
+            sliceCos[i] = cos(theta);
+            sliceSin[i] = sinf(theta);
+        }
+    }
+    if ((int)stackCos.size() != numStacks + 1) {
+        stackCos.resize(numStacks + 1);
+        stackSin.resize(numStacks + 1);
+        for (int j = 0; j <= numStacks; j++) {
+            float phi = (((float)j) / (float)(numStacks)) * (float)PI;
+            stackCos[j] = cosf(phi);
+            stackSin[j] = sinf(phi);
+        }
+    }
+}
+
+long GlGeomSphere::VertexBytes() const
+{
+    long stride = compactFormat ? PackedVertexStride(UseNormals(), UseTexCoords()) : StrideVal()*sizeof(float);
+    return stride*GetNumVertices();
+}
+
+void GlGeomSphere::BuildBufferData(void* vertexData, void* elementData) const
+{
+    if (compactFormat) {
+        FillCompactBufferData(vertexData, elementData);
+    }
+    else {
+        FillBufferData((float*)vertexData, (unsigned short*)elementData);
+    }
+}
+
+// The compact format is converted from the usual one, built in client memory:
+//    each strip becomes a triangle list, and Tipsify reorders all the triangles.
+//    The indices always fit in unsigned shorts, as there are at most 255 slices and stacks.
+void GlGeomSphere::FillCompactBufferData(void* vertexData, void* elementData) const
+{
+    const int stripLength = 2*numStacks + 1;        // Including the primitive restart
+    std::vector<float> vertices(StrideVal()*GetNumVertices());
+    std::vector<unsigned short> strips(numSlices*stripLength);
+    FillBufferData(vertices.data(), strips.data());
+
+    std::vector<unsigned int> triangles(GetNumElements());
+    long numIndices = 0;
+    for (int i = 0; i < numSlices; i++) {
+        numIndices += StripToTriangles(strips.data() + i*stripLength, stripLength - 1, triangles.data() + numIndices);
+    }
+    assert(numIndices == GetNumElements());
+    std::vector<unsigned int> ordered(numIndices);
+    TipsifyTriangles(triangles.data(), numIndices, GetNumVertices(), MeshVertexCacheSize, ordered.data());
 
-    // Allocate memory for vertex positions, normals, and texture coordinates.
-    float *tempStoref = new float[GetNumVertices() * StrideVal()];
-    
+    CopyIndices(ordered.data(), numIndices, true, elementData);
+    PackVertices(vertices.data(), GetNumVertices(), StrideVal(),
+                 UseNormals() ? NormalOffset() : -1, UseTexCoords() ? TexOffset() : -1, vertexData);
+}
+
+// Fill in all the vertices and elements.  Large meshes are split into
+//    ranges of slices, one per thread.
+void GlGeomSphere::FillBufferData(float* vertexData, unsigned short* elementData) const
+{
     // Set North pole and South pole positions and normals.
     // The north pole is on the positive y-axis.
-    tempStoref[1] = 1.0f;       // North pole, y position
-    tempStoref[0] = tempStoref[2] = 0.0f;
-    int s = 3;
-    if ( UseNormals() ) {
-        tempStoref[s+1] = 1.0f;       // North pole, normal, y component.
-        tempStoref[s] = tempStoref[s + 2] = 0.0f;
-        s += 3;
-     }
-    if (UseTexCoords()) {
-        tempStoref[s] = 0.5f;           // s texture coordinate, North pole
-        tempStoref[s + 1] = 1.0f;       // t texture coordinate
-        s += 2;
-    }
-    tempStoref[s + 1] = -1.0f;       // South pole, y position
-    tempStoref[s] = tempStoref[s + 2] = 0.0f;
-    s += 3;
-    if (UseNormals()) {
-        tempStoref[s + 1] = -1.0f;       // South pole, normal, y component.
-        tempStoref[s] = tempStoref[s + 2] = 0.0f;
-        s += 3;
-    }
-    if (UseTexCoords()) {
-        tempStoref[s] = 0.5f;           // s texture coordinate, South pole
-        tempStoref[s + 1] = 0.0f;       // t texture coordinate
-        s += 2;
-    }
-
-    // Set the positions and normals for the rest of the vertices
-    for (int i = 0; i <= numSlices; i++) {
+    const float poles[2][8] = {
+        { 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.5f, 1.0f },     // North pole: position, normal, s,t
+        { 0.0f, -1.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.5f, 0.0f },   // South pole
+    };
+    float* toVert = vertexData;
+    for (int k = 0; k < 2; k++) {
+        toVert[0] = poles[k][0];
+        toVert[1] = poles[k][1];
+        toVert[2] = poles[k][2];
+        if (UseNormals()) {
+            toVert[NormalOffset()] = poles[k][3];
+            toVert[NormalOffset() + 1] = poles[k][4];
+            toVert[NormalOffset() + 2] = poles[k][5];
+        }
+        if (UseTexCoords()) {
+            toVert[TexOffset()] = poles[k][6];
+            toVert[TexOffset() + 1] = poles[k][7];
+        }
+        toVert += StrideVal();
+    }
+
+    // Below this many vertices per thread, starting a thread costs more than it saves.
+    const int minVerticesPerThread = 8192;
+    int numThreads = (int)std::thread::hardware_concurrency();     // 0 if unknown
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+    int maxThreads = GetNumVertices() / minVerticesPerThread;
+    if (numThreads > maxThreads) {
+        numThreads = maxThreads > 1 ? maxThreads : 1;
+    }
+    int numVertexSlices = numSlices + 1;
+    std::vector<std::thread> threads;
+    for (int t = 1; t < numThreads; t++) {
+        threads.push_back(std::thread(&GlGeomSphere::FillSlices, this, vertexData, elementData,
+                                      numVertexSlices*t / numThreads, numVertexSlices*(t + 1) / numThreads));
+    }
+    FillSlices(vertexData, elementData, 0, numVertexSlices / numThreads);
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+}
+
+// Fill in the vertices of the slices firstSlice,...,endSlice-1 (out of
+//    numSlices+1, as the first slice is repeated with s texture coordinate 1),
+//    and the triangle strips starting at those slices.
+// The vertex data may be write-combined memory, so it is written in order
+//    and never read back.
+void GlGeomSphere::FillSlices(float* vertexData, unsigned short* elementData, int firstSlice, int endSlice) const
+{
+    const int stride = StrideVal();
+    const bool useNormals = UseNormals();
+    const bool useTexCoords = UseTexCoords();
+    const int noff = NormalOffset();
+    const int toff = TexOffset();
+    // The vertices of a slice are the profile (0, cos(phi), -sin(phi)) rotated by theta
+    //    around the y-axis.  The rotation is a structure of arrays pass over the profile,
+    //    which vectorizes; the interleaving loop below then only copies.
+    const int numRing = numStacks - 1;
+    std::vector<float> profileX(numRing, 0.0f), profileY(numRing), profileZ(numRing);
+    for (int j = 1; j < numStacks; j++) {
+        profileY[j - 1] = stackCos[j];
+        profileZ[j - 1] = -stackSin[j];
+    }
+    std::vector<float> sliceX(numRing), sliceY(numRing), sliceZ(numRing);
+    float* toVert = vertexData + (2 + firstSlice*numRing)*stride;
+    for (int i = firstSlice; i < endSlice; i++) {
         // Handle a slice of vertices.
-        // theta measures from the xz-plane, going counterclockwise viewed from above.
-        float theta = ((float)(i%numSlices))*(float)PI2 / (float)(numSlices);
-        float costheta = cos(theta);
-        float sintheta = sinf(theta);
+        float costheta = sliceCos[i];
+        float sintheta = sliceSin[i];
+        Matrix3x3T<float> rotate(costheta, 0.0f, -sintheta, 0.0f, 1.0f, 0.0f, sintheta, 0.0f, costheta);
+        rotate.Transform(profileX.data(), profileY.data(), profileZ.data(),
+                         sliceX.data(), sliceY.data(), sliceZ.data(), numRing);
+        float sTex = (i == numSlices) ? 1.0f : ((float)i) / (float)numSlices;   // s texture coordinate
         for (int j = 1; j < numStacks; j++) {
-            float fracJ = ((float)j) / (float)(numStacks);
-            float phi = fracJ * (float)PI;
-            float cosphi = cosf(phi);
-            float sinphi = sinf(phi);
-            float tTex = 1.0f - fracJ;                // Use for spherical coordinates
-            // float tTex = cosphi * 0.5f + 0.5f;         // Use for cylindrical texture coordinates
-            tempStoref[s] = -sintheta*sinphi;       // Position, x coordinate            
-            tempStoref[s + 1] = cosphi;            // Position, y coordinate
-            tempStoref[s + 2] = -costheta*sinphi;   // Position, z coordinate
-            s += 3;
-            if (UseNormals()) {
-                tempStoref[s] = tempStoref[s - 3];     // Normal, x coordinate
-                tempStoref[s + 1] = tempStoref[s - 2]; // Normal, y coordinate
-                tempStoref[s + 2] = tempStoref[s - 1]; // Normal, z coordinate
-                s += 3;
+            float x = sliceX[j - 1];
+            float y = sliceY[j - 1];
+            float z = sliceZ[j - 1];
+            toVert[0] = x;                  // Position
+            toVert[1] = y;
+            toVert[2] = z;
+            if (useNormals) {
+                toVert[noff] = x;           // Normal
+                toVert[noff + 1] = y;
+                toVert[noff + 2] = z;
             }
-            if (UseTexCoords()) {
-                float tTex = 1.0f - fracJ;                // Use for spherical coordinates
-                // float tTex = cosphi * 0.5 + 0.5;         // Use for cylindrical texture coordinates
-                tempStoref[s] = (i==numSlices) ? 1.0f : ((float)i) / (float)numSlices;   // s texture coordinate
-                tempStoref[s + 1] = tTex;                                                // t texture coordinate
-                s += 2;
+            if (useTexCoords) {
+                float fracJ = ((float)j) / (float)(numStacks);
+                toVert[toff] = sTex;
+                toVert[toff + 1] = 1.0f - fracJ;        // Use for spherical coordinates
+                // toVert[toff + 1] = y * 0.5f + 0.5f;     // Use for cylindrical texture coordinates
             }
+            toVert += stride;
         }
     }
-    glBindVertexArray(theVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, theVBO);
-    glBufferData(GL_ARRAY_BUFFER, StrideVal()*GetNumVertices()*sizeof(float), tempStoref, GL_STATIC_DRAW);
 
-    unsigned short* tempStorei = (unsigned short*)tempStoref;     // Can reuse the same memory to hold our element indices array
-    unsigned short* toPtr = tempStorei;                // Load up data sequentially
-    // Load all the data for the EBO.
-    for (int i = 0; i < numSlices; i++) {
-        // Handle a slice of vertices.
+    // The elements: one triangle strip per slice.
+    unsigned short* toPtr = elementData + firstSlice*(2 * numStacks + 1);
+    for (int i = firstSlice; i < endSlice && i < numSlices; i++) {
         unsigned short leftSideIdx = (i + 1)*(numStacks - 1) + 2;    // First vertex index in slice i
         unsigned short rightSideIdx = i*(numStacks - 1) + 2;         // First vertex index in slice i+1
         *(toPtr++) = 0;                                     // Index for North Pole
@@ -178,14 +440,9 @@ void GlGeomSphere::LoadBufferData() {
             *(toPtr++) = rightSideIdx++;                     // Triangle strip vertex on the left
             *(toPtr++) = leftSideIdx++;                    // Triangle strip vertex on the right
         }
-		*(toPtr++) = 1;										// Index for the South Pole
-		*(toPtr++) = PrimRestartIndex;                         // Indicate the end of this triangle strip.
+        *(toPtr++) = 1;                                     // Index for the South Pole
+        *(toPtr++) = PrimRestartIndex;                         // Indicate the end of this triangle strip.
     }
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, theEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, GetNumElements()*sizeof(unsigned short), tempStorei, GL_STATIC_DRAW);
-
-	delete[] tempStoref;
-    glBindVertexArray(0);           // Good practice to unbind: helps with debugging if nothing else
 }
 
 // **********************************************
@@ -198,10 +455,19 @@ void GlGeomSphere::Render()
     if (theVAO == 0) {
         assert(false && "GlGeomSphere::InitializeAttribLocations must be called before rendering!");
     }
+    PollRemesh();
+    if (compactFormat) {
+        glBindVertexArray(theVAO);
+        glDrawElements(GL_TRIANGLES, (GLsizei)drawnNumElements, GL_UNSIGNED_SHORT, 0);
+        CountDrawCall();
+        glBindVertexArray(0);
+        return;
+    }
     glEnable(GL_PRIMITIVE_RESTART);
     glPrimitiveRestartIndex(PrimRestartIndex);
     glBindVertexArray(theVAO);
-	glDrawElements(GL_TRIANGLE_STRIP, (GLsizei)GetNumElements(), GL_UNSIGNED_SHORT, 0);
+	glDrawElements(GL_TRIANGLE_STRIP, (GLsizei)drawnNumElements, GL_UNSIGNED_SHORT, 0);
+	CountDrawCall();
 	glDisable(GL_PRIMITIVE_RESTART);     // Not clear that there is any reason to disable (maybe for performance?)
     glBindVertexArray(0);           // Good practice to unbind: helps with debugging if nothing else
 }
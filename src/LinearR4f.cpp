@@ -0,0 +1,470 @@
+// *******************************
+// LinearR4f.cpp
+//
+// Products, inverses, point transforms and rotations for LinearMapR4f,
+//    and the structure of arrays batch transforms.
+//    See LinearR4f.h.
+//
+// With SSE each column is held in one register, and a product column
+//    is a sum of the left hand columns scaled by broadcast entries of
+//    the right hand column.
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+#include "LinearR4f.h"
+#include "LinearR4.h"
+
+#include <assert.h>
+
+LinearMapR4f& LinearMapR4f::Set(const LinearMapR4& A)
+{
+    A.DumpByColumns(m);
+    return *this;
+}
+
+void LinearMapR4f::Get(LinearMapR4& A) const
+{
+    A.Set(m[0], m[1], m[2], m[3], m[4], m[5], m[6], m[7],
+          m[8], m[9], m[10], m[11], m[12], m[13], m[14], m[15]);
+}
+
+LinearMapR4f& LinearMapR4f::Set_glTranslate(const VectorR3& translation)
+{
+    return Set_glTranslate((float)translation.x, (float)translation.y, (float)translation.z);
+}
+
+LinearMapR4f& LinearMapR4f::Mult_glTranslate(const VectorR3& translation)
+{
+    return Mult_glTranslate((float)translation.x, (float)translation.y, (float)translation.z);
+}
+
+#ifdef LINEAR_R4F_SSE
+
+namespace {
+
+// A times the column vector (x,y,z,w) held in v
+inline __m128 MultColumn(__m128 a0, __m128 a1, __m128 a2, __m128 a3, __m128 v)
+{
+    __m128 r = _mm_mul_ps(a0, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+    r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+    r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+    return _mm_add_ps(r, _mm_mul_ps(a3, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3))));
+}
+
+// A times (x,y,z,0)
+inline __m128 MultColumn3(__m128 a0, __m128 a1, __m128 a2, __m128 v)
+{
+    __m128 r = _mm_mul_ps(a0, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+    r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+    return _mm_add_ps(r, _mm_mul_ps(a2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+}
+
+// Cross product of the xyz parts; the w entry of the result is zero when both w entries are.
+inline __m128 Cross3(__m128 a, __m128 b)
+{
+    __m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 c = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+    return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+// Sum of the four entries, in every entry
+inline __m128 HorizontalSum(__m128 v)
+{
+    v = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+
+// Products of 2x2 blocks, each held as (a11, a12, a21, a22).
+//   Used by the inverse: A*B, adj(A)*B and A*adj(B).
+inline __m128 Mat2Mul(__m128 a, __m128 b)
+{
+    return _mm_add_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 3, 0))),
+                      _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)),
+                                 _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+inline __m128 Mat2AdjMul(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 3, 3)), b),
+                      _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 1, 1)),
+                                 _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2))));
+}
+
+inline __m128 Mat2MulAdj(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 3, 0, 3))),
+                      _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)),
+                                 _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+} // namespace
+
+LinearMapR4f operator*(const LinearMapR4f& A, const LinearMapR4f& B)
+{
+    __m128 a0 = _mm_load_ps(A.m);
+    __m128 a1 = _mm_load_ps(A.m + 4);
+    __m128 a2 = _mm_load_ps(A.m + 8);
+    __m128 a3 = _mm_load_ps(A.m + 12);
+    LinearMapR4f result;
+    for (int j = 0; j < 16; j += 4) {
+        _mm_store_ps(result.m + j, MultColumn(a0, a1, a2, a3, _mm_load_ps(B.m + j)));
+    }
+    return result;
+}
+
+// The first three columns of B end in 0 and the last in 1,
+//   which saves four of the sixteen broadcast products.
+void MultiplyAffine(const LinearMapR4f& A, const LinearMapR4f& B, LinearMapR4f& result)
+{
+    assert(B.IsAffine());
+    __m128 a0 = _mm_load_ps(A.m);
+    __m128 a1 = _mm_load_ps(A.m + 4);
+    __m128 a2 = _mm_load_ps(A.m + 8);
+    __m128 a3 = _mm_load_ps(A.m + 12);
+    __m128 r0 = MultColumn3(a0, a1, a2, _mm_load_ps(B.m));
+    __m128 r1 = MultColumn3(a0, a1, a2, _mm_load_ps(B.m + 4));
+    __m128 r2 = MultColumn3(a0, a1, a2, _mm_load_ps(B.m + 8));
+    __m128 r3 = _mm_add_ps(a3, MultColumn3(a0, a1, a2, _mm_load_ps(B.m + 12)));
+    _mm_store_ps(result.m, r0);         // result may be A or B
+    _mm_store_ps(result.m + 4, r1);
+    _mm_store_ps(result.m + 8, r2);
+    _mm_store_ps(result.m + 12, r3);
+}
+
+// Block inverse with 2x2 sub-matrices.  It works on the transpose
+//   (the columns are read as rows), which is fine since the inverse
+//   of the transpose is the transpose of the inverse.
+LinearMapR4f LinearMapR4f::Inverse() const
+{
+    __m128 c0 = _mm_load_ps(m);
+    __m128 c1 = _mm_load_ps(m + 4);
+    __m128 c2 = _mm_load_ps(m + 8);
+    __m128 c3 = _mm_load_ps(m + 12);
+
+    // The four 2x2 blocks  | A B |
+    //                      | C D |
+    __m128 A = _mm_movelh_ps(c0, c1);
+    __m128 B = _mm_movehl_ps(c1, c0);
+    __m128 C = _mm_movelh_ps(c2, c3);
+    __m128 D = _mm_movehl_ps(c3, c2);
+
+    // Their determinants, as (|A|, |B|, |C|, |D|)
+    __m128 detSub = _mm_sub_ps(
+        _mm_mul_ps(_mm_shuffle_ps(c0, c2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(c1, c3, _MM_SHUFFLE(3, 1, 3, 1))),
+        _mm_mul_ps(_mm_shuffle_ps(c0, c2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(c1, c3, _MM_SHUFFLE(2, 0, 2, 0))));
+    __m128 detA = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(0, 0, 0, 0));
+    __m128 detB = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(1, 1, 1, 1));
+    __m128 detC = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(2, 2, 2, 2));
+    __m128 detD = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(3, 3, 3, 3));
+
+    // The inverse is 1/|M| times the adjugates of the blocks X, Y, Z, W below.
+    __m128 D_C = Mat2AdjMul(D, C);
+    __m128 A_B = Mat2AdjMul(A, B);
+    __m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), Mat2Mul(B, D_C));
+    __m128 W = _mm_sub_ps(_mm_mul_ps(detA, D), Mat2Mul(C, A_B));
+    __m128 Y = _mm_sub_ps(_mm_mul_ps(detB, C), Mat2MulAdj(D, A_B));
+    __m128 Z = _mm_sub_ps(_mm_mul_ps(detC, B), Mat2MulAdj(A, D_C));
+
+    // |M| = |A||D| + |B||C| - trace(adj(A) B adj(D) C)
+    __m128 detM = _mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC));
+    __m128 tr = HorizontalSum(_mm_mul_ps(A_B, _mm_shuffle_ps(D_C, D_C, _MM_SHUFFLE(3, 1, 2, 0))));
+    detM = _mm_sub_ps(detM, tr);
+    assert(_mm_cvtss_f32(detM) != 0.0f);
+    __m128 rDetM = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+    X = _mm_mul_ps(X, rDetM);
+    Y = _mm_mul_ps(Y, rDetM);
+    Z = _mm_mul_ps(Z, rDetM);
+    W = _mm_mul_ps(W, rDetM);
+
+    // Take the adjugates while storing
+    LinearMapR4f result;
+    _mm_store_ps(result.m, _mm_shuffle_ps(X, Y, _MM_SHUFFLE(1, 3, 1, 3)));
+    _mm_store_ps(result.m + 4, _mm_shuffle_ps(X, Y, _MM_SHUFFLE(0, 2, 0, 2)));
+    _mm_store_ps(result.m + 8, _mm_shuffle_ps(Z, W, _MM_SHUFFLE(1, 3, 1, 3)));
+    _mm_store_ps(result.m + 12, _mm_shuffle_ps(Z, W, _MM_SHUFFLE(0, 2, 0, 2)));
+    return result;
+}
+
+// For M = | R t |, the inverse is | R^-1  -R^-1 t |.
+//         | 0 1 |                 |  0        1    |
+//   The rows of R^-1 are the cross products of pairs of columns of R,
+//   divided by the determinant of R.
+LinearMapR4f LinearMapR4f::InverseAffine() const
+{
+    assert(IsAffine());
+    __m128 c0 = _mm_load_ps(m);
+    __m128 c1 = _mm_load_ps(m + 4);
+    __m128 c2 = _mm_load_ps(m + 8);
+    __m128 t = _mm_load_ps(m + 12);
+    __m128 row0 = Cross3(c1, c2);
+    __m128 row1 = Cross3(c2, c0);
+    __m128 row2 = Cross3(c0, c1);
+    __m128 det = HorizontalSum(_mm_mul_ps(c0, row0));
+    assert(_mm_cvtss_f32(det) != 0.0f);
+    __m128 rDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+    row0 = _mm_mul_ps(row0, rDet);
+    row1 = _mm_mul_ps(row1, rDet);
+    row2 = _mm_mul_ps(row2, rDet);
+    __m128 row3 = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+
+    // -R^-1 t, computed from the rows before they are transposed
+    __m128 tx = HorizontalSum(_mm_mul_ps(row0, t));
+    __m128 ty = HorizontalSum(_mm_mul_ps(row1, t));
+    __m128 tz = HorizontalSum(_mm_mul_ps(row2, t));
+    __m128 newT = _mm_sub_ps(row3, _mm_movelh_ps(_mm_unpacklo_ps(tx, ty), _mm_unpacklo_ps(tz, _mm_setzero_ps())));
+
+    _MM_TRANSPOSE4_PS(row0, row1, row2, row3);
+    LinearMapR4f result;
+    _mm_store_ps(result.m, row0);
+    _mm_store_ps(result.m + 4, row1);
+    _mm_store_ps(result.m + 8, row2);
+    _mm_store_ps(result.m + 12, newT);
+    return result;
+}
+
+void LinearMapR4f::TransformPoints(const float* in, float* out, long count) const
+{
+    __m128 c0 = _mm_load_ps(m);
+    __m128 c1 = _mm_load_ps(m + 4);
+    __m128 c2 = _mm_load_ps(m + 8);
+    __m128 c3 = _mm_load_ps(m + 12);
+    for (long i = 0; i < count; i++, in += 3, out += 3) {
+        __m128 r = _mm_add_ps(c3, _mm_mul_ps(c0, _mm_set1_ps(in[0])));
+        r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(in[1])));
+        r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(in[2])));
+        _mm_storel_pi((__m64*)out, r);      // x and y
+        _mm_store_ss(out + 2, _mm_movehl_ps(r, r));
+    }
+}
+
+// Only the first three columns change: they are multiplied by the 3x3 rotation.
+LinearMapR4f& LinearMapR4f::Mult_glRotate(float costheta, float sintheta, float x, float y, float z)
+{
+    LinearMapR4f rot;
+    rot.Set_glRotate(costheta, sintheta, x, y, z);
+    __m128 a0 = _mm_load_ps(m);
+    __m128 a1 = _mm_load_ps(m + 4);
+    __m128 a2 = _mm_load_ps(m + 8);
+    _mm_store_ps(m, MultColumn3(a0, a1, a2, _mm_load_ps(rot.m)));
+    _mm_store_ps(m + 4, MultColumn3(a0, a1, a2, _mm_load_ps(rot.m + 4)));
+    _mm_store_ps(m + 8, MultColumn3(a0, a1, a2, _mm_load_ps(rot.m + 8)));
+    return *this;
+}
+
+#else   // No SSE: plain C++, and the inverse goes through LinearMapR4
+
+LinearMapR4f operator*(const LinearMapR4f& A, const LinearMapR4f& B)
+{
+    LinearMapR4f result;
+    for (int j = 0; j < 4; j++) {
+        for (int i = 0; i < 4; i++) {
+            result.m[4 * j + i] = A.m[i] * B.m[4 * j] + A.m[4 + i] * B.m[4 * j + 1]
+                                + A.m[8 + i] * B.m[4 * j + 2] + A.m[12 + i] * B.m[4 * j + 3];
+        }
+    }
+    return result;
+}
+
+void MultiplyAffine(const LinearMapR4f& A, const LinearMapR4f& B, LinearMapR4f& result)
+{
+    assert(B.IsAffine());
+    result = A * B;
+}
+
+LinearMapR4f LinearMapR4f::Inverse() const
+{
+    LinearMapR4 A;
+    Get(A);
+    return LinearMapR4f(A.Inverse());
+}
+
+LinearMapR4f LinearMapR4f::InverseAffine() const
+{
+    return Inverse();
+}
+
+void LinearMapR4f::TransformPoints(const float* in, float* out, long count) const
+{
+    for (long i = 0; i < count; i++, in += 3, out += 3) {
+        float x = in[0], y = in[1], z = in[2];
+        out[0] = m[0] * x + m[4] * y + m[8] * z + m[12];
+        out[1] = m[1] * x + m[5] * y + m[9] * z + m[13];
+        out[2] = m[2] * x + m[6] * y + m[10] * z + m[14];
+    }
+}
+
+LinearMapR4f& LinearMapR4f::Mult_glRotate(float costheta, float sintheta, float x, float y, float z)
+{
+    LinearMapR4f rot;
+    rot.Set_glRotate(costheta, sintheta, x, y, z);
+    (*this) *= rot;
+    return *this;
+}
+
+#endif  // LINEAR_R4F_SSE
+
+// Same as LinearMapR4::Set_glRotate()
+LinearMapR4f& LinearMapR4f::Set_glRotate(float costheta, float sintheta, float x, float y, float z)
+{
+    float normSq = x * x + y * y + z * z;
+    assert(normSq > 0.0f);
+    float normInv = 1.0f / sqrtf(normSq);
+    x *= normInv;
+    y *= normInv;
+    z *= normInv;
+    float omC = 1.0f - costheta;
+    float omCx = omC * x;
+    float omCy = omC * y;
+    float omCz = omC * z;
+    m[0] = omCx * x + costheta;
+    m[1] = omCx * y + sintheta * z;
+    m[2] = omCx * z - sintheta * y;
+    m[4] = omCy * x - sintheta * z;
+    m[5] = omCy * y + costheta;
+    m[6] = omCy * z + sintheta * x;
+    m[8] = omCz * x + sintheta * y;
+    m[9] = omCz * y - sintheta * x;
+    m[10] = omCz * z + costheta;
+    m[3] = m[7] = m[11] = m[12] = m[13] = m[14] = 0.0f;
+    m[15] = 1.0f;
+    return *this;
+}
+
+// ******************************************************
+// * Structure of arrays transforms                     *
+// * * * * * * * * * * * * * * * * * * * * * * * * * * **
+
+namespace {
+
+// Rows 0, 1 and 2 of the matrix m times (x,y,z,w) for each point.
+//    With SSE, each row entry is broadcast and four points are done at once.
+void TransformSoA(const float* m, float w, const float* x, const float* y, const float* z,
+                  float* outX, float* outY, float* outZ, long count)
+{
+    float tx = m[12] * w;
+    float ty = m[13] * w;
+    float tz = m[14] * w;
+    long i = 0;
+#ifdef LINEAR_R4F_SSE
+    __m128 a11 = _mm_set1_ps(m[0]), a12 = _mm_set1_ps(m[4]), a13 = _mm_set1_ps(m[8]), a14 = _mm_set1_ps(tx);
+    __m128 a21 = _mm_set1_ps(m[1]), a22 = _mm_set1_ps(m[5]), a23 = _mm_set1_ps(m[9]), a24 = _mm_set1_ps(ty);
+    __m128 a31 = _mm_set1_ps(m[2]), a32 = _mm_set1_ps(m[6]), a33 = _mm_set1_ps(m[10]), a34 = _mm_set1_ps(tz);
+    for (; i + 4 <= count; i += 4) {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 vz = _mm_loadu_ps(z + i);
+        __m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a11, vx), _mm_mul_ps(a12, vy)), _mm_add_ps(_mm_mul_ps(a13, vz), a14));
+        __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a21, vx), _mm_mul_ps(a22, vy)), _mm_add_ps(_mm_mul_ps(a23, vz), a24));
+        __m128 rz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a31, vx), _mm_mul_ps(a32, vy)), _mm_add_ps(_mm_mul_ps(a33, vz), a34));
+        _mm_storeu_ps(outX + i, rx);
+        _mm_storeu_ps(outY + i, ry);
+        _mm_storeu_ps(outZ + i, rz);
+    }
+#endif
+    for (; i < count; i++) {
+        float px = x[i], py = y[i], pz = z[i];
+        outX[i] = m[0] * px + m[4] * py + m[8] * pz + tx;
+        outY[i] = m[1] * px + m[5] * py + m[9] * pz + ty;
+        outZ[i] = m[2] * px + m[6] * py + m[10] * pz + tz;
+    }
+}
+
+} // namespace
+
+void LinearMapR4f::TransformPointsSoA(const float* x, const float* y, const float* z,
+                                      float* outX, float* outY, float* outZ, long count) const
+{
+    TransformSoA(m, 1.0f, x, y, z, outX, outY, outZ, count);
+}
+
+void LinearMapR4f::TransformVectorsSoA(const float* x, const float* y, const float* z,
+                                       float* outX, float* outY, float* outZ, long count) const
+{
+    TransformSoA(m, 0.0f, x, y, z, outX, outY, outZ, count);
+}
+
+// With SSE, each point is transformed with the columns of its own matrix, as in
+//    TransformPoints(), and the results for four points are transposed into
+//    four x's, four y's and four z's.
+void TransformPointsSoA(const LinearMapR4f* A, const float* x, const float* y, const float* z,
+                        float* outX, float* outY, float* outZ, long count)
+{
+    long i = 0;
+#ifdef LINEAR_R4F_SSE
+    for (; i + 4 <= count; i += 4) {
+        __m128 r[4];
+        for (int k = 0; k < 4; k++) {
+            const float* m = A[i + k].m;
+            __m128 c = _mm_add_ps(_mm_load_ps(m + 12), _mm_mul_ps(_mm_load_ps(m), _mm_set1_ps(x[i + k])));
+            c = _mm_add_ps(c, _mm_mul_ps(_mm_load_ps(m + 4), _mm_set1_ps(y[i + k])));
+            r[k] = _mm_add_ps(c, _mm_mul_ps(_mm_load_ps(m + 8), _mm_set1_ps(z[i + k])));
+        }
+        _MM_TRANSPOSE4_PS(r[0], r[1], r[2], r[3]);
+        _mm_storeu_ps(outX + i, r[0]);
+        _mm_storeu_ps(outY + i, r[1]);
+        _mm_storeu_ps(outZ + i, r[2]);
+    }
+#endif
+    for (; i < count; i++) {
+        const float* m = A[i].m;
+        float px = x[i], py = y[i], pz = z[i];
+        outX[i] = m[0] * px + m[4] * py + m[8] * pz + m[12];
+        outY[i] = m[1] * px + m[5] * py + m[9] * pz + m[13];
+        outZ[i] = m[2] * px + m[6] * py + m[10] * pz + m[14];
+    }
+}
+
+// ******************************************************
+// * AffineMapR4f class                                 *
+// * * * * * * * * * * * * * * * * * * * * * * * * * * **
+
+AffineMapR4f& AffineMapR4f::Set(const LinearMapR4& A)
+{
+    assert(A.IsAffine());
+    M.Set(A);
+    M.m[3] = M.m[7] = M.m[11] = 0.0f;
+    M.m[15] = 1.0f;
+    return *this;
+}
+
+AffineMapR4f AffineMapR4f::Inverse() const
+{
+    AffineMapR4f result;
+    result.M = M.InverseAffine();
+    return result;
+}
+
+// The columns of R^T are the rows of R.  No divide, no determinant.
+AffineMapR4f AffineMapR4f::RigidInverse() const
+{
+    AffineMapR4f result;
+#ifdef LINEAR_R4F_SSE
+    __m128 c0 = _mm_load_ps(M.m);
+    __m128 c1 = _mm_load_ps(M.m + 4);
+    __m128 c2 = _mm_load_ps(M.m + 8);
+    __m128 c3 = _mm_setzero_ps();
+    __m128 t = _mm_load_ps(M.m + 12);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    __m128 newT = _mm_mul_ps(c0, _mm_shuffle_ps(t, t, _MM_SHUFFLE(0, 0, 0, 0)));
+    newT = _mm_add_ps(newT, _mm_mul_ps(c1, _mm_shuffle_ps(t, t, _MM_SHUFFLE(1, 1, 1, 1))));
+    newT = _mm_add_ps(newT, _mm_mul_ps(c2, _mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 2, 2, 2))));
+    _mm_store_ps(result.M.m, c0);
+    _mm_store_ps(result.M.m + 4, c1);
+    _mm_store_ps(result.M.m + 8, c2);
+    _mm_store_ps(result.M.m + 12, _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), newT));
+#else
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            result.M.m[4 * j + i] = M.m[4 * i + j];
+        }
+    }
+    for (int i = 0; i < 3; i++) {
+        result.M.m[12 + i] = -(M.m[4 * i] * M.m[12] + M.m[4 * i + 1] * M.m[13] + M.m[4 * i + 2] * M.m[14]);
+    }
+#endif
+    return result;
+}
@@ -0,0 +1,304 @@
+// *******************************
+// MeshOptimize.cpp
+//
+// Tipsify vertex cache ordering, and packing into the compact vertex
+//    format.  See MeshOptimize.h.
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+#include "MeshOptimize.h"
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+namespace {
+
+template<class T>
+long StripToTrianglesT(const T* strip, long length, unsigned int* triangles)
+{
+    long n = 0;
+    for (long k = 2; k < length; k++) {
+        unsigned int a = strip[k - 2];
+        unsigned int b = strip[k - 1];
+        unsigned int c = strip[k];
+        if (a == b || b == c || a == c) {
+            continue;
+        }
+        if (k & 1) {        // Odd triangles of a strip have the reverse order
+            unsigned int t = a;
+            a = b;
+            b = t;
+        }
+        triangles[n++] = a;
+        triangles[n++] = b;
+        triangles[n++] = c;
+    }
+    return n;
+}
+
+// Tipsify's state: the vertex-triangle adjacency, the live triangle counts,
+//    and the cache time stamps.
+class Tipsifier {
+public:
+    Tipsifier(const unsigned int* triangles, long numIndices, long numVertices, int cacheSize);
+    void Run(unsigned int* out);
+
+private:
+    long NextVertex() const;
+    long SkipDeadEnd();
+
+    const unsigned int* indices;
+    long numTriangles;
+    long numVertices;
+    int cacheSize;
+
+    std::vector<long> adjacencyStart;       // Triangles of vertex v: adjacencyStart[v] ... adjacencyStart[v+1]-1
+    std::vector<long> adjacency;
+    std::vector<int> liveTriangles;
+    std::vector<long> cacheTime;
+    std::vector<char> emitted;
+    std::vector<long> deadEnd;              // A stack of recently used vertices
+    std::vector<long> candidates;
+    long time;
+    long scanVertex;                        // Vertices below this have no live triangles
+};
+
+Tipsifier::Tipsifier(const unsigned int* triangles, long numIndices, long numVerts, int cacheSz)
+    : indices(triangles), numTriangles(numIndices / 3), numVertices(numVerts), cacheSize(cacheSz)
+{
+    liveTriangles.assign(numVertices, 0);
+    for (long i = 0; i < 3 * numTriangles; i++) {
+        liveTriangles[indices[i]]++;
+    }
+    adjacencyStart.resize(numVertices + 1);
+    adjacencyStart[0] = 0;
+    for (long v = 0; v < numVertices; v++) {
+        adjacencyStart[v + 1] = adjacencyStart[v] + liveTriangles[v];
+    }
+    adjacency.resize(3 * numTriangles);
+    std::vector<long> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (long i = 0; i < 3 * numTriangles; i++) {
+        adjacency[fill[indices[i]]++] = i / 3;
+    }
+    cacheTime.assign(numVertices, 0);
+    emitted.assign(numTriangles, 0);
+    time = cacheSize + 1;
+    scanVertex = 0;
+}
+
+void Tipsifier::Run(unsigned int* out)
+{
+    long n = 0;
+    long fanning = SkipDeadEnd();
+    while (fanning >= 0) {
+        // Emit all the remaining triangles around the fanning vertex
+        candidates.clear();
+        for (long a = adjacencyStart[fanning]; a < adjacencyStart[fanning + 1]; a++) {
+            long t = adjacency[a];
+            if (emitted[t]) {
+                continue;
+            }
+            emitted[t] = 1;
+            for (int j = 0; j < 3; j++) {
+                long v = indices[3 * t + j];
+                out[n++] = (unsigned int)v;
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                liveTriangles[v]--;
+                if (time - cacheTime[v] > cacheSize) {
+                    cacheTime[v] = time++;
+                }
+            }
+        }
+        fanning = NextVertex();
+        if (fanning < 0) {
+            fanning = SkipDeadEnd();
+        }
+    }
+}
+
+// The candidate which will still be in the cache after its remaining triangles
+//    are emitted, and has been in it the longest.
+long Tipsifier::NextVertex() const
+{
+    long best = -1;
+    long bestPriority = -1;
+    for (long v : candidates) {
+        if (liveTriangles[v] <= 0) {
+            continue;
+        }
+        long priority = 0;
+        if (time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize) {
+            priority = time - cacheTime[v];
+        }
+        if (priority > bestPriority) {
+            bestPriority = priority;
+            best = v;
+        }
+    }
+    return best;
+}
+
+long Tipsifier::SkipDeadEnd()
+{
+    while (!deadEnd.empty()) {
+        long v = deadEnd.back();
+        deadEnd.pop_back();
+        if (liveTriangles[v] > 0) {
+            return v;
+        }
+    }
+    for (; scanVertex < numVertices; scanVertex++) {
+        if (liveTriangles[scanVertex] > 0) {
+            return scanVertex;
+        }
+    }
+    return -1;
+}
+
+inline short PackSnorm16(float x)
+{
+    x = (x < -1.0f) ? -1.0f : ((x > 1.0f) ? 1.0f : x);
+    return (short)lrintf(x * 32767.0f);
+}
+
+inline unsigned int PackSnorm10(float x)
+{
+    x = (x < -1.0f) ? -1.0f : ((x > 1.0f) ? 1.0f : x);
+    return (unsigned int)lrintf(x * 511.0f) & 0x3ff;
+}
+
+} // namespace
+
+long StripToTriangles(const unsigned short* strip, long length, unsigned int* triangles)
+{
+    return StripToTrianglesT(strip, length, triangles);
+}
+
+long StripToTriangles(const unsigned int* strip, long length, unsigned int* triangles)
+{
+    return StripToTrianglesT(strip, length, triangles);
+}
+
+void TipsifyTriangles(const unsigned int* triangles, long numIndices, long numVertices,
+                      int cacheSize, unsigned int* out)
+{
+    Tipsifier tipsifier(triangles, numIndices, numVertices, cacheSize);
+    tipsifier.Run(out);
+}
+
+double AverageCacheMissRatio(const unsigned int* triangles, long numIndices, int cacheSize)
+{
+    if (numIndices < 3) {
+        return 0.0;
+    }
+    std::vector<unsigned int> cache(cacheSize, ~0u);     // A FIFO, oldest at cache[next]
+    int next = 0;
+    long misses = 0;
+    for (long i = 0; i < numIndices; i++) {
+        unsigned int v = triangles[i];
+        bool hit = false;
+        for (int j = 0; j < cacheSize; j++) {
+            if (cache[j] == v) {
+                hit = true;
+                break;
+            }
+        }
+        if (!hit) {
+            misses++;
+            cache[next] = v;
+            next = (next + 1) % cacheSize;
+        }
+    }
+    return (double)misses / (double)(numIndices / 3);
+}
+
+int PackedVertexStride(bool normals, bool texCoords)
+{
+    return 4 * sizeof(short) + (normals ? sizeof(unsigned int) : 0) + (texCoords ? 2 * sizeof(unsigned short) : 0);
+}
+
+int PackedNormalOffset()
+{
+    return 4 * sizeof(short);
+}
+
+int PackedTexOffset(bool normals)
+{
+    return 4 * sizeof(short) + (normals ? sizeof(unsigned int) : 0);
+}
+
+void PackVertices(const float* vertices, long numVertices, int stride, int normalOffset, int texOffset,
+                  void* packed)
+{
+    int packedStride = PackedVertexStride(normalOffset >= 0, texOffset >= 0);
+    int packedTexOffset = PackedTexOffset(normalOffset >= 0);
+    unsigned char* to = (unsigned char*)packed;
+    for (long i = 0; i < numVertices; i++, vertices += stride, to += packedStride) {
+        short position[4] = { PackSnorm16(vertices[0]), PackSnorm16(vertices[1]), PackSnorm16(vertices[2]), 0 };
+        memcpy(to, position, sizeof(position));
+        if (normalOffset >= 0) {
+            const float* n = vertices + normalOffset;
+            unsigned int normal = PackSnorm10x3(n[0], n[1], n[2]);
+            memcpy(to + PackedNormalOffset(), &normal, sizeof(normal));
+        }
+        if (texOffset >= 0) {
+            unsigned short texCoords[2] = { FloatToHalf(vertices[texOffset]), FloatToHalf(vertices[texOffset + 1]) };
+            memcpy(to + packedTexOffset, texCoords, sizeof(texCoords));
+        }
+    }
+}
+
+void CopyIndices(const unsigned int* indices, long count, bool shortIndices, void* out)
+{
+    if (!shortIndices) {
+        memcpy(out, indices, count * sizeof(unsigned int));
+        return;
+    }
+    unsigned short* to = (unsigned short*)out;
+    for (long i = 0; i < count; i++) {
+        to[i] = (unsigned short)indices[i];
+    }
+}
+
+unsigned short FloatToHalf(float x)
+{
+    unsigned int f;
+    memcpy(&f, &x, sizeof(f));
+    unsigned int sign = (f >> 16) & 0x8000;
+    unsigned int mantissa = f & 0x7fffff;
+    int exponent = (int)((f >> 23) & 0xff) - 127 + 15;
+    if (exponent >= 31) {
+        bool isNaN = ((f >> 23) & 0xff) == 0xff && mantissa != 0;
+        return (unsigned short)(sign | 0x7c00 | (isNaN ? 0x200 : 0));     // Infinity or NaN
+    }
+    if (exponent <= 0) {
+        if (exponent < -10) {
+            return (unsigned short)sign;            // Underflows to zero
+        }
+        mantissa |= 0x800000;
+        int shift = 14 - exponent;
+        unsigned int half = mantissa >> shift;
+        unsigned int rest = mantissa & ((1u << shift) - 1);
+        unsigned int halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1))) {
+            half++;
+        }
+        return (unsigned short)(sign | half);       // Subnormal
+    }
+    unsigned int half = ((unsigned int)exponent << 10) | (mantissa >> 13);
+    unsigned int rest = mantissa & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+        half++;         // A carry into the exponent is still correct
+    }
+    return (unsigned short)(sign | half);
+}
+
+unsigned int PackSnorm10x3(float x, float y, float z)
+{
+    return PackSnorm10(x) | (PackSnorm10(y) << 10) | (PackSnorm10(z) << 20);
+}
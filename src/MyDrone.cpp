@@ -13,6 +13,7 @@
 
 #include "LinearR3.h"		// Adjust path as needed.
 #include "LinearR4.h"		// Adjust path as needed.
+#include "LinearR4f.h"
 #include "MathMisc.h"       // Adjust path as needed
 
 #include "ShaderBuild.h"
@@ -26,6 +27,7 @@
 #include "MyDrone.h"
 #include "DrawScene.h"
 #include "EulerMethod.h"
+#include "Profiler.h"
 
 // These objects take care of generating and loading VAO's, VBO's and EBO's,
 //    rendering spheres for the moon, earch and sun
@@ -33,11 +35,21 @@ GlGeomSphere mySphere;
 GlGeomCylinder myCylinder;
 
 //extern const int NumTextures;
-extern unsigned int TextureNames[NumTextures];     // Texture names generated by OpenGL
 extern const char* TextureFiles[NumTextures];
 extern GlGeomSphere texSphere;
 extern GlGeomCylinder texCylinder;
 
+// Cosines and sines of the constant angles in MyRenderDrone(), computed once.
+//   The rotations by PIhalves use (0, +-1) directly.
+const float cosPIfourths = (float)cos(PIfourths);
+const float sinPIfourths = (float)sin(PIfourths);
+const float armCosSin[4][2] = {     // cos and sin of (i - 0.5) * PIhalves
+	{ (float)cos(-0.5 * PIhalves), (float)sin(-0.5 * PIhalves) },
+	{ (float)cos(0.5 * PIhalves), (float)sin(0.5 * PIhalves) },
+	{ (float)cos(1.5 * PIhalves), (float)sin(1.5 * PIhalves) },
+	{ (float)cos(2.5 * PIhalves), (float)sin(2.5 * PIhalves) },
+};
+
 // **********************
 // This sets up geometries needed for the "Initial" (the 3-D alphabet letter)
 //  It is called only once.
@@ -62,6 +74,7 @@ void MyRemeshGeometries() {
 // Render the drone
 // ************
 void MyRenderDrone() {
+    PROFILE_SCOPE("MyRenderDrone");
     // Compute the animation factor.
     //    THIS IS SPECIFIC TO THE ANIMATION IN THE DEMO.
     //    FOR PROJECT 3 YOU MAY DO SOMETHING DIFFERENT, FOR INSTANCE, SIMILAR TO WHAT SolarProg.cpp DID.
@@ -82,69 +95,58 @@ void MyRenderDrone() {
 
 	EulerMethod(centerOfGravityMatrix, currentVelocity, currentAngularVelocity, animateIncrement);
 
-	LinearMapR4 centerOfGravityMatrix = viewMatrix;
+	phUseProgram(true);                 // Every part of the drone is textured
+	// All the matrices are affine, and every rotation is about a coordinate axis.
+	AffineMapR4f centerOfGravityMatrix(viewMatrix);
 	glVertexAttrib3f(aColor_loc, 0.8f, 0.8f, 0.8f);
-	LinearMapR4 centerPosMatrix = centerOfGravityMatrix;
-	centerPosMatrix.Mult_glRotate(PIfourths, 0.0, 1.0, 0.0);
+	AffineMapR4f centerPosMatrix = centerOfGravityMatrix;
+	centerPosMatrix.Mult_glRotateY(cosPIfourths, sinPIfourths);
 	centerPosMatrix.Mult_glTranslate(0.0, -centerOfGravityHeight, 0.0);
-	LinearMapR4 centerSphereMartix = centerPosMatrix;
+	AffineMapR4f centerSphereMartix = centerPosMatrix;
 	centerSphereMartix.Mult_glScale(centerSphereRadius, centerSphereRadius, centerSphereRadius);
-	centerSphereMartix.DumpByColumns(matEntries);
-	glUniformMatrix4fv(modelviewMatLocation, 1, false, matEntries);
-	glBindTexture(GL_TEXTURE_2D, TextureNames[2]);     // Choose rough wood image texture
-	glUniform1i(applyTextureLocation, true);           // Enable applying the texture!
+	glUniformMatrix4fv(modelviewMatLocation, 1, false, centerSphereMartix.Data());
+	phSetTextureLayer(2);                             // Choose rough wood image texture
 	texSphere.Render();                                 // Render the sphere
-	glUniform1i(applyTextureLocation, false);           // Turn off applying texture!
 	for (int i = 0; i < 4; i++) {
 		glVertexAttrib3f(aColor_loc, 0.0f, 0.8f, 1.0f);
-		LinearMapR4 frameMatrix = centerPosMatrix;
-		frameMatrix.Mult_glRotate((i - 0.5) * PIhalves, 0.0, 1.0, 0.0);
-		frameMatrix.Mult_glRotate(PIhalves, 0.0, 0.0, 1.0);
+		AffineMapR4f frameMatrix = centerPosMatrix;
+		frameMatrix.Mult_glRotateY(armCosSin[i][0], armCosSin[i][1]);   // (i - 0.5) * PIhalves
+		frameMatrix.Mult_glRotateZ(0.0f, 1.0f);                         // PIhalves
 		frameMatrix.Mult_glTranslate(0.0, centerSphereRadius, 0.0);
-		LinearMapR4 connectPosMatrix = frameMatrix;
+		AffineMapR4f connectPosMatrix = frameMatrix;
 		connectPosMatrix.Mult_glTranslate(0.0, frameLength + connectSphereRadius, 0.0);
 		frameMatrix.Mult_glScale(frameRadius, frameLength / 2.0, frameRadius);
 		frameMatrix.Mult_glTranslate(0.0, 1.0, 0.0);
-		frameMatrix.DumpByColumns(matEntries);
-		glUniformMatrix4fv(modelviewMatLocation, 1, false, matEntries);
-		glBindTexture(GL_TEXTURE_2D, TextureNames[3]);     // Choose rough wood image texture
-		glUniform1i(applyTextureLocation, true);           // Enable applying the texture!
+		glUniformMatrix4fv(modelviewMatLocation, 1, false, frameMatrix.Data());
+		phSetTextureLayer(3);                             // Choose rough wood image texture
 		texCylinder.RenderSide();                             // Render the sphere side
-		glBindTexture(GL_TEXTURE_2D, TextureNames[3]);     // Choose star image texture
+		phSetTextureLayer(3);                             // Choose star image texture
 		texCylinder.RenderTop();                              // RENDER THIS WITH A TEXTURE MAP
 		texCylinder.RenderBase();                             // RENDER THIS WITH A TEXTURE MAP
-		LinearMapR4 connectSphereMatrix = connectPosMatrix;
+		AffineMapR4f connectSphereMatrix = connectPosMatrix;
 		connectSphereMatrix.Mult_glScale(connectSphereRadius, connectSphereRadius, connectSphereRadius);
-		connectSphereMatrix.DumpByColumns(matEntries);
-		glUniformMatrix4fv(modelviewMatLocation, 1, false, matEntries);
-		glBindTexture(GL_TEXTURE_2D, TextureNames[2]);     // Choose rough wood image texture
-		glUniform1i(applyTextureLocation, true);           // Enable applying the texture!
+		glUniformMatrix4fv(modelviewMatLocation, 1, false, connectSphereMatrix.Data());
+		phSetTextureLayer(2);                             // Choose rough wood image texture
 		texSphere.Render();                                 // Render the sphere
-		glUniform1i(applyTextureLocation, false);           // Turn off applying texture!
-		LinearMapR4 axleBottomMatrix = connectPosMatrix;
-		axleBottomMatrix.Mult_glRotate(-PIhalves, 0.0, 0.0, 1.0);
+		AffineMapR4f axleBottomMatrix = connectPosMatrix;
+		axleBottomMatrix.Mult_glRotateZ(0.0f, -1.0f);                   // -PIhalves
 		axleBottomMatrix.Mult_glTranslate(0.0, connectSphereRadius, 0.0);
-		LinearMapR4 bladePosMatrix = axleBottomMatrix;
+		AffineMapR4f bladePosMatrix = axleBottomMatrix;
 		bladePosMatrix.Mult_glTranslate(0.0, axleHeight, 0.0);
 		axleBottomMatrix.Mult_glScale(axleRadius / 1.0, axleHeight / 2.0, axleRadius / 1.0);
 		axleBottomMatrix.Mult_glTranslate(0.0, 1.0, 0.0);
-		axleBottomMatrix.DumpByColumns(matEntries);
-		glUniformMatrix4fv(modelviewMatLocation, 1, false, matEntries);
-		glBindTexture(GL_TEXTURE_2D, TextureNames[3]);     // Choose rough wood image texture
-		glUniform1i(applyTextureLocation, true);           // Enable applying the texture!
+		glUniformMatrix4fv(modelviewMatLocation, 1, false, axleBottomMatrix.Data());
+		phSetTextureLayer(3);                             // Choose rough wood image texture
 		texCylinder.RenderSide();                             // Render the sphere side
-		glBindTexture(GL_TEXTURE_2D, TextureNames[3]);     // Choose star image texture
+		phSetTextureLayer(3);                             // Choose star image texture
 		texCylinder.RenderTop();                              // RENDER THIS WITH A TEXTURE MAP
 		texCylinder.RenderBase();                             // RENDER THIS WITH A TEXTURE MAP
 		glVertexAttrib3f(aColor_loc, 1.0f-0.1*i, 0.4f+0.2*i, 1.0f-0.3*i);
-		LinearMapR4 bladeMatrix = bladePosMatrix;
-		bladeMatrix.Mult_glRotate(currentPhase[i], 0.0, 1.0, 0.0);
+		AffineMapR4f bladeMatrix = bladePosMatrix;
+		bladeMatrix.Mult_glRotateY(currentPhase[i]);
 		bladeMatrix.Mult_glScale(bladeLength, bladeHeight, bladeWidth);
-		bladeMatrix.DumpByColumns(matEntries);
-		glUniformMatrix4fv(modelviewMatLocation, 1, false, matEntries);
-		glBindTexture(GL_TEXTURE_2D, TextureNames[4]);     // Choose rough wood image texture
-		glUniform1i(applyTextureLocation, true);           // Enable applying the texture!
+		glUniformMatrix4fv(modelviewMatLocation, 1, false, bladeMatrix.Data());
+		phSetTextureLayer(4);                             // Choose rough wood image texture
 		texSphere.Render();                                 // Render the sphere
-		glUniform1i(applyTextureLocation, false);           // Turn off applying texture!
 	}
 }
@@ -15,6 +15,7 @@
 
 #include "LinearR3.h"
 #include "LinearR4.h"
+#include "LinearR4f.h"
 #include "MathMisc.h"
 
 #include "ShaderBuild.h"
@@ -22,10 +23,13 @@
 #include "MyGeometries.h"
 #include "FinalProj.h"
 #include "PhongData.h"
-#include "RgbImage.h"
+#include "TextureArchive.h"
+#include "TextureLoader.h"
 #include "GlGeomCylinder.h"
 #include "GlGeomSphere.h"
 #include "DrawScene.h"
+#include "RenderStats.h"
+#include "Profiler.h"
 
 // **********************************
 // Material to underlie a texture map.
@@ -49,7 +53,7 @@ unsigned int myEBO[NumObjects];  // a Element Array Buffer Object - holds an arr
 // Information for loading textures
 // **************************
 //const int NumTextures = 5;
-unsigned int TextureNames[NumTextures];     // Texture names generated by OpenGL
+unsigned int TextureArrayName;              // Texture array name generated by OpenGL
 const char* TextureFiles[NumTextures] = {
 	"sky.bmp",
 	"grassland.bmp",
@@ -69,7 +73,11 @@ GlGeomCylinder texCylinder(4, 4, 4);
 // ********************************************
 
 inline string ResourceFilePath(const char* sFilePath) {
+#ifdef _WIN32
 	return "data\\" + string(sFilePath);
+#else
+	return "data/" + string(sFilePath);
+#endif
 }
 void SetupForTextures()
 {
@@ -80,41 +88,41 @@ void SetupForTextures()
     materialUnderTexture.DiffuseColor.Set(0.5, 0.5, 0.5);       // Increase or decrease to adjust brightness
     materialUnderTexture.SpecularExponent = 40.0;
 
-    // Load texture maps
-    RgbImage texMap;
-
-    glUseProgram(phShaderPhongPhong);
+    // Load texture maps, as the layers of a single texture array, so that drawing
+    //    never needs to bind another texture: the shaders take the layer as a vertex attribute.
+    // Textures found in the texture archive (made by tools/TexturePack with -size 1024)
+    //    are uploaded at once, with their precomputed mipmaps, straight from the mapped file.
+    // The other files are decoded by worker threads; until a layer's image has been
+    //    uploaded (by PollTextureLoads), it is mid-gray.
     glActiveTexture(GL_TEXTURE0);
-    glGenTextures(NumTextures, TextureNames);
+    glGenTextures(1, &TextureArrayName);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, TextureArrayName);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+    // Set best quality filtering.  Mipmaps come from the archive, or are made when the image is loaded.
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);  // Requires that mipmaps be generated
+    // You may also try GL_LINEAR_MIPMAP_NEAREST -- try looking at the wall from a 30 degree angle, and look for sweeping transitions.
+    AllocateTextureArray(TextureArrayName, NumTextures, TextureLayerSize);
+
+    TextureArchive archive;
+    archive.Open(ResourceFilePath("textures.pack").c_str());
+    string texturePaths[NumTextures];
+    int loadLayers[NumTextures];
+    int numToLoad = 0;
     for (int i = 0; i < NumTextures; i++) {
-        texMap.LoadBmpFile(ResourceFilePath(TextureFiles[i]).c_str());            // Read i-th texture from the i-th file.
-        glBindTexture(GL_TEXTURE_2D, TextureNames[i]);  // Bind (select) the i-th OpenGL texture
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-        // Set best quality filtering.   Also see below for disabling mipmaps.
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);  // Requires that mipmaps be generated (see below)
-        // You may also try GL_LINEAR_MIPMAP_NEAREST -- try looking at the wall from a 30 degree angle, and look for sweeping transitions.
-
-        // Store the texture into the OpenGL texture named TextureNames[i]
-        int textureWidth = texMap.GetNumCols();
-        int textureHeight = texMap.GetNumRows();
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, textureWidth, textureHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, texMap.ImageData());
-#if 1
-        // Use mipmaps  (Best!)
-        glGenerateMipmap(GL_TEXTURE_2D);
-#else
-        // Don't use mipmaps.  Try moving away from the brick wall a great distance
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-#endif
-
+        int archiveIndex = archive.FindTexture(TextureFiles[i]);
+        if (archiveIndex < 0
+            || !archive.UploadLayer(archiveIndex, TextureArrayName, i, TextureLayerSize, TextureArrayCompressed())) {
+            texturePaths[numToLoad] = ResourceFilePath(TextureFiles[i]);
+            loadLayers[numToLoad++] = i;
+        }
     }
+    archive.Close();            // OpenGL has its own copy of the images
+    StartTextureLayerLoads(texturePaths, TextureArrayName, loadLayers, numToLoad, TextureLayerSize);
 
-    // Make sure that the phShaderPhongPhong uses the GL_TEXTURE_0 texture.
-    glUseProgram(phShaderPhongPhong);
-    glUniform1i(glGetUniformLocation(phShaderPhongPhong, "theTextureMap"), 0);
+    // The shader programs that apply a texture use the GL_TEXTURE_0 texture.
     glActiveTexture(GL_TEXTURE0);
 	
 }
@@ -131,6 +139,9 @@ void SetupForTextures()
 // **********************
 void MySetupSurfaces() {
 
+    // Packed vertices and cache-ordered triangle lists: half the vertex fetch bandwidth
+    texSphere.SetCompactFormat(true);
+    texCylinder.SetCompactFormat(true);
     texSphere.InitializeAttribLocations(vertPos_loc, vertNormal_loc, vertTexCoords_loc);
     texCylinder.InitializeAttribLocations(vertPos_loc, vertNormal_loc, vertTexCoords_loc);
 
@@ -213,31 +224,31 @@ void MyRemeshGeometries()
 // **********************************************
 
 void MyRenderGeometries() {
+    PROFILE_SCOPE("MyRenderGeometries");
+    phUseProgram(true);                             // The wall and floor are both textured
+    glBindTexture(GL_TEXTURE_2D_ARRAY, TextureArrayName);   // The only texture binding for the whole scene
+    LinearMapR4f modelviewMat(viewMatrix);          // The wall and floor use the view matrix as is
     // ******
     // Render the Back Wall
     // ******
     glBindVertexArray(myVAO[iWall]);                // Select the back wall VAO (Vertex Array Object)
     materialUnderTexture.LoadIntoShaders();         // Use the bright underlying color
-    viewMatrix.DumpByColumns(matEntries);           // Apply the model view matrix
-    glUniformMatrix4fv(modelviewMatLocation, 1, false, matEntries);
-    glBindTexture(GL_TEXTURE_2D, TextureNames[0]);     // Choose Brick wall texture
-    glUniform1i(applyTextureLocation, true);           // Enable applying the texture!
+    glUniformMatrix4fv(modelviewMatLocation, 1, false, modelviewMat.Data());    // Apply the model view matrix
+    phSetTextureLayer(0);                           // Choose Brick wall texture
     // Draw the wall as a single triangle strip
     glDrawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_INT, (void*)0);    
-    glUniform1i(applyTextureLocation, false);           // Turn off applying texture!
+    CountDrawCall();
 
     // ************ 
     // Render the floor
     //  YOU MUST WRITE THIS. IT WILL BE SIMILAR TO THE BACK WALL ABOVE
 	glBindVertexArray(myVAO[iFloor]);                // Select the floor VAO (Vertex Array Object)
 	materialUnderTexture.LoadIntoShaders();         // Use the bright underlying color
-	viewMatrix.DumpByColumns(matEntries);           // Apply the model view matrix
-	glUniformMatrix4fv(modelviewMatLocation, 1, false, matEntries);
-	glBindTexture(GL_TEXTURE_2D, TextureNames[1]);     // Choose Brick wall texture
-	glUniform1i(applyTextureLocation, true);           // Enable applying the texture!
+	glUniformMatrix4fv(modelviewMatLocation, 1, false, modelviewMat.Data());    // Apply the model view matrix
+	phSetTextureLayer(1);                           // Choose Brick wall texture
 													   // Draw the floor as a single triangle strip
 	glDrawElements(GL_TRIANGLE_STRIP, 4, GL_UNSIGNED_INT, (void*)0);
-	glUniform1i(applyTextureLocation, false);           // Turn off applying texture!
+	CountDrawCall();
 	    
     check_for_opengl_errors();      // Watch the console window for error messages!
 }
@@ -0,0 +1,194 @@
+// *******************************
+// Offscreen.cpp
+//
+// Window-less OpenGL contexts and the frame buffer object for Offscreen.h.
+//
+// The EGL display comes from the EGL_MESA_platform_surfaceless platform
+//    when it is available: it needs no display server, nor even a GPU
+//    device.  Otherwise the default display is used.  Either way, the
+//    context is made current with no surface (EGL_KHR_surfaceless_context).
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+// Use the static library (so glew32.dll is not needed):
+#define GLEW_STATIC
+#include <GL/glew.h> 
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Offscreen.h"
+
+#if defined(__linux__)
+#define OFFSCREEN_USE_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#else
+#include <GLFW/glfw3.h>
+#endif
+
+namespace {
+
+unsigned int offscreenFramebuffer = 0;
+unsigned int offscreenColorBuffer = 0;
+unsigned int offscreenDepthBuffer = 0;
+
+#ifdef OFFSCREEN_USE_EGL
+EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+EGLContext eglContext = EGL_NO_CONTEXT;
+
+bool HasEglExtension(EGLDisplay display, const char* name)
+{
+    const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (extensions == 0) {
+        return false;
+    }
+    size_t len = strlen(name);
+    for (const char* p = strstr(extensions, name); p != 0; p = strstr(p + len, name)) {
+        if ((p == extensions || p[-1] == ' ') && (p[len] == ' ' || p[len] == 0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+EGLDisplay GetEglDisplay()
+{
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+    if (HasEglExtension(EGL_NO_DISPLAY, "EGL_MESA_platform_surfaceless")) {
+        PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+            (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay != 0) {
+            EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, 0);
+            if (display != EGL_NO_DISPLAY) {
+                return display;
+            }
+        }
+    }
+#endif
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+#else
+GLFWwindow* hiddenWindow = 0;
+#endif
+
+} // namespace
+
+#ifdef OFFSCREEN_USE_EGL
+
+bool CreateOffscreenContext()
+{
+    eglDisplay = GetEglDisplay();
+    EGLint major, minor;
+    if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &major, &minor)) {
+        fprintf(stderr, "Unable to initialize EGL (error 0x%x).\n", eglGetError());
+        return false;
+    }
+    if (!HasEglExtension(eglDisplay, "EGL_KHR_surfaceless_context") || !eglBindAPI(EGL_OPENGL_API)) {
+        fprintf(stderr, "EGL %d.%d does not support surfaceless OpenGL contexts.\n", major, minor);
+        DestroyOffscreenContext();
+        return false;
+    }
+
+    // No surface is ever made, so any configuration with OpenGL will do.
+    EGLConfig config = 0;
+    EGLint numConfigs = 0;
+    const EGLint configAttribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    eglChooseConfig(eglDisplay, configAttribs, &config, 1, &numConfigs);
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3, EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE };
+    eglContext = eglCreateContext(eglDisplay, numConfigs > 0 ? config : 0, EGL_NO_CONTEXT, contextAttribs);
+    if (eglContext == EGL_NO_CONTEXT
+        || !eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext)) {
+        fprintf(stderr, "Unable to create an OpenGL 3.3 context with EGL (error 0x%x).\n", eglGetError());
+        DestroyOffscreenContext();
+        return false;
+    }
+    return true;
+}
+
+void DestroyOffscreenContext()
+{
+    if (eglDisplay == EGL_NO_DISPLAY) {
+        return;
+    }
+    eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (eglContext != EGL_NO_CONTEXT) {
+        eglDestroyContext(eglDisplay, eglContext);
+        eglContext = EGL_NO_CONTEXT;
+    }
+    eglTerminate(eglDisplay);
+    eglDisplay = EGL_NO_DISPLAY;
+}
+
+#else
+
+bool CreateOffscreenContext()
+{
+    if (!glfwInit()) {
+        fprintf(stderr, "Unable to initialize GLFW.\n");
+        return false;
+    }
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    hiddenWindow = glfwCreateWindow(1, 1, "Offscreen", NULL, NULL);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+    if (hiddenWindow == NULL) {
+        fprintf(stderr, "Unable to create a hidden GLFW window.\n");
+        glfwTerminate();
+        return false;
+    }
+    glfwMakeContextCurrent(hiddenWindow);
+    return true;
+}
+
+void DestroyOffscreenContext()
+{
+    if (hiddenWindow != NULL) {
+        glfwDestroyWindow(hiddenWindow);
+        hiddenWindow = NULL;
+        glfwTerminate();
+    }
+}
+
+#endif
+
+bool CreateOffscreenFramebuffer(int width, int height)
+{
+    glGenRenderbuffers(1, &offscreenColorBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, offscreenColorBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenRenderbuffers(1, &offscreenDepthBuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, offscreenDepthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glGenFramebuffers(1, &offscreenFramebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, offscreenFramebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreenColorBuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, offscreenDepthBuffer);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "Offscreen frame buffer of %d x %d pixels is not complete (status 0x%x).\n",
+                width, height, status);
+        DeleteOffscreenFramebuffer();
+        return false;
+    }
+    // The frame buffer object has no back buffer: draw and read color attachment 0.
+    glDrawBuffer(GL_COLOR_ATTACHMENT0);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    return true;
+}
+
+void DeleteOffscreenFramebuffer()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glDeleteFramebuffers(1, &offscreenFramebuffer);
+    glDeleteRenderbuffers(1, &offscreenColorBuffer);
+    glDeleteRenderbuffers(1, &offscreenDepthBuffer);
+    offscreenFramebuffer = offscreenColorBuffer = offscreenDepthBuffer = 0;
+}
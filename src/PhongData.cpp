@@ -6,11 +6,12 @@
 #include "PhongData.h"
 #include "EduPhong.h"
 #include "LinearR4.h"
+#include "LinearR4f.h"
 #include "GlGeomSphere.h"
 #include "ShaderBuild.h"
+#include "Profiler.h"
 
 extern unsigned int modelviewMatLocation;
-extern unsigned int applyTextureLocation;
 
 extern phGlobal globalPhongData;
 
@@ -132,16 +133,17 @@ void MySetupMaterials()
 // Use the light's diffuse color as the emissive color
 // Use the light's position as the sphere's position
 void MyRenderSpheresForLights() {
-   float matEntries[16];	// Holds 16 floats (since cannot load doubles into a shader that uses floats)
+   PROFILE_SCOPE("MyRenderSpheresForLights");
    phMaterial myEmissiveMaterial;
+   LinearMapR4f viewMat(viewMatrix);       // Floats, since cannot load doubles into a shader that uses floats
 
+   phUseProgram(false);
    for (int i = 0; i < 3; i++) {
         if (myLights[i].IsEnabled) {
-            LinearMapR4 modelviewMat = viewMatrix;
-            modelviewMat.Mult_glTranslate(myLightPositions[i].x, myLightPositions[i].y,myLightPositions[i].z);
-            modelviewMat.Mult_glScale(0.2);
-            modelviewMat.DumpByColumns(matEntries);
-            glUniformMatrix4fv(modelviewMatLocation, 1, false, matEntries);
+            LinearMapR4f modelviewMat = viewMat;
+            modelviewMat.Mult_glTranslate(myLightPositions[i]);
+            modelviewMat.Mult_glScale(0.2f);
+            glUniformMatrix4fv(modelviewMatLocation, 1, false, modelviewMat.Data());
             myEmissiveMaterial.EmissiveColor = myLights[i].DiffuseColor;
             myEmissiveMaterial.LoadIntoShaders();
             myLightSphere.Render();
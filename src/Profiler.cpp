@@ -0,0 +1,238 @@
+// *******************************
+// Profiler.cpp
+//
+// Per-thread timing buffers, trace output and summaries for Profiler.h.
+//
+// Each thread that times a scope gets a ProfileBuffer, made the first time
+//    and kept in a list (the only place a lock is taken).  The thread is
+//    the only writer of its buffer: it fills in an event, then publishes
+//    it by storing the new count with release order.  Readers load the
+//    count with acquire order, and read only the events below it.
+// Buffers are never freed, so a thread may end while its timings are kept.
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+// Allow the use of deprecated fopen() instead of fopen_s()
+#define _CRT_SECURE_NO_DEPRECATE
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Profiler.h"
+#include "AsyncLog.h"
+#include "JsonWrite.h"
+
+std::atomic<bool> profilerEnabled(false);
+
+namespace {
+
+typedef std::chrono::steady_clock ProfileClock;
+
+struct ProfileEvent {
+    const char* Name;
+    long long StartTick;
+    long long Ticks;
+    long long SelfTicks;
+};
+
+struct ProfileBuffer {
+    ProfileEvent* Events;               // ProfileEventsPerThread of them
+    std::atomic<int> NumEvents;
+    std::atomic<unsigned int> NumDropped;
+    int ThreadIndex;
+    int NumSummarized;                  // Events already in a summary (only used by LogProfilerSummary)
+};
+
+std::mutex buffersMutex;
+std::vector<ProfileBuffer*> profileBuffers;
+thread_local ProfileBuffer* threadBuffer = nullptr;
+thread_local ProfileScope* threadScope = nullptr;     // Innermost open scope of this thread
+
+long long profileStartTick = 0;
+long long lastSummaryTick = 0;
+
+inline long long NowTicks()
+{
+    return ProfileClock::now().time_since_epoch().count();
+}
+
+inline double TicksToMicroseconds(long long ticks)
+{
+    return ticks * (1.0e6 * ProfileClock::period::num / ProfileClock::period::den);
+}
+
+ProfileBuffer* MakeThreadBuffer()
+{
+    ProfileBuffer* buffer = new ProfileBuffer;
+    buffer->Events = new ProfileEvent[ProfileEventsPerThread];
+    buffer->NumEvents.store(0);
+    buffer->NumDropped.store(0);
+    buffer->NumSummarized = 0;
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    buffer->ThreadIndex = (int)profileBuffers.size();
+    profileBuffers.push_back(buffer);
+    return buffer;
+}
+
+} // namespace
+
+void ProfileScope::Begin(const char* name)
+{
+    Name = name;
+    ChildTicks = 0;
+    Parent = threadScope;
+    threadScope = this;
+    StartTick = NowTicks();
+}
+
+void ProfileScope::End()
+{
+    long long ticks = NowTicks() - StartTick;
+    threadScope = Parent;
+    if (Parent != nullptr) {
+        Parent->ChildTicks += ticks;
+    }
+
+    ProfileBuffer* buffer = threadBuffer;
+    if (buffer == nullptr) {
+        buffer = threadBuffer = MakeThreadBuffer();
+    }
+    int n = buffer->NumEvents.load(std::memory_order_relaxed);
+    if (n >= ProfileEventsPerThread) {
+        buffer->NumDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ProfileEvent& event = buffer->Events[n];
+    event.Name = Name;
+    event.StartTick = StartTick;
+    event.Ticks = ticks;
+    event.SelfTicks = ticks - ChildTicks;
+    buffer->NumEvents.store(n + 1, std::memory_order_release);     // Publish
+}
+
+void StartProfiler()
+{
+    {
+        // Other threads must not be timing scopes while the buffers are reset
+        //    (or a stale timing may be left in).  Only the render thread's
+        //    scopes are normally timed, and this is called from it.
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        for (size_t i = 0; i < profileBuffers.size(); i++) {
+            profileBuffers[i]->NumEvents.store(0);
+            profileBuffers[i]->NumDropped.store(0);
+            profileBuffers[i]->NumSummarized = 0;
+        }
+    }
+    profileStartTick = lastSummaryTick = NowTicks();
+    profilerEnabled.store(true);
+}
+
+void StopProfiler()
+{
+    profilerEnabled.store(false);
+}
+
+bool ProfilerRunning()
+{
+    return profilerEnabled.load(std::memory_order_relaxed);
+}
+
+bool WriteProfilerTrace(const char* filename)
+{
+    FILE* out = fopen(filename, "w");
+    if (!out) {
+        fprintf(stderr, "Unable to open file: %s\n", filename);
+        return false;
+    }
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    unsigned int numDropped = 0;
+    std::lock_guard<std::mutex> lock(buffersMutex);
+    for (size_t b = 0; b < profileBuffers.size(); b++) {
+        const ProfileBuffer* buffer = profileBuffers[b];
+        int n = buffer->NumEvents.load(std::memory_order_acquire);
+        numDropped += buffer->NumDropped.load();
+        if (n == 0) {
+            continue;
+        }
+        fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"Thread %d\"}}",
+                first ? "" : ",\n", buffer->ThreadIndex, buffer->ThreadIndex);
+        first = false;
+        for (int i = 0; i < n; i++) {
+            const ProfileEvent& e = buffer->Events[i];
+            fprintf(out, ",\n{\"name\":");
+            WriteJsonString(out, e.Name);
+            fprintf(out, ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}", buffer->ThreadIndex,
+                    TicksToMicroseconds(e.StartTick - profileStartTick), TicksToMicroseconds(e.Ticks));
+        }
+    }
+    fprintf(out, "\n]}\n");
+    if (fclose(out) != 0) {
+        fprintf(stderr, "Error writing file: %s\n", filename);
+        return false;
+    }
+    if (numDropped > 0) {
+        LogMessage(LogWarning, "Profiler: %u timings dropped (buffers full).", numDropped);
+    }
+    return true;
+}
+
+void LogProfilerSummary(int topN)
+{
+    struct ScopeTotals {
+        long long Ticks = 0;
+        long long SelfTicks = 0;
+        int Calls = 0;
+    };
+    // Keyed by the name's text: the same literal may have several addresses.
+    std::map<std::string, ScopeTotals> totals;
+    long long now = NowTicks();
+    {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        for (size_t b = 0; b < profileBuffers.size(); b++) {
+            ProfileBuffer* buffer = profileBuffers[b];
+            int n = buffer->NumEvents.load(std::memory_order_acquire);
+            for (int i = buffer->NumSummarized; i < n; i++) {
+                const ProfileEvent& e = buffer->Events[i];
+                ScopeTotals& t = totals[e.Name];
+                t.Ticks += e.Ticks;
+                t.SelfTicks += e.SelfTicks;
+                t.Calls++;
+            }
+            buffer->NumSummarized = n;
+        }
+    }
+    std::vector<std::pair<std::string, ScopeTotals> > sorted(totals.begin(), totals.end());
+    std::sort(sorted.begin(), sorted.end(),
+              [](const std::pair<std::string, ScopeTotals>& a, const std::pair<std::string, ScopeTotals>& b) {
+                  return a.second.SelfTicks > b.second.SelfTicks;
+              });
+
+    double periodMs = TicksToMicroseconds(now - lastSummaryTick) * 1.0e-3;
+    lastSummaryTick = now;
+    LogMessage(LogInfo, "Profile of the last %.0f ms (top scopes by self time):", periodMs);
+    for (int i = 0; i < topN && i < (int)sorted.size(); i++) {
+        const ScopeTotals& t = sorted[i].second;
+        LogMessage(LogInfo, "  %-28s %7d calls %10.3f ms self %10.3f ms total %5.1f%%", sorted[i].first.c_str(),
+                   t.Calls, TicksToMicroseconds(t.SelfTicks) * 1.0e-3, TicksToMicroseconds(t.Ticks) * 1.0e-3,
+                   periodMs > 0.0 ? 100.0 * TicksToMicroseconds(t.SelfTicks) * 1.0e-3 / periodMs : 0.0);
+    }
+}
+
+void ProfilerFrameEnd()
+{
+    if (!profilerEnabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    if (TicksToMicroseconds(NowTicks() - lastSummaryTick) >= 1.0e6) {
+        LogProfilerSummary(ProfileSummaryTopN);
+    }
+}
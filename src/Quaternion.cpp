@@ -0,0 +1,165 @@
+// *******************************
+// Quaternion.cpp
+//
+// Conversions, exponential and logarithm maps, and interpolation for
+//    Quaternion.  See Quaternion.h.
+//
+// Slerp computes the angle with atan2() rather than acos(), which loses
+//    precision near 0 and PI, and needs only sin() and cos() of t*theta:
+//    sin((1-t)*theta) = sin(theta)*cos(t*theta) - cos(theta)*sin(t*theta).
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+#include "Quaternion.h"
+
+namespace {
+
+// Below this sin(theta), Slerp() is Nlerp(): the two differ by O(theta^3).
+const double SlerpMinSin = 1.0e-6;
+
+// Slerp from q0 to q1 (both unit), along the shorter arc.
+inline Quaternion SlerpUnit(const Quaternion& q0, const Quaternion& q1, double t)
+{
+    double cosTheta = q0 ^ q1;
+    double sign = 1.0;
+    if (cosTheta < 0.0) {
+        cosTheta = -cosTheta;
+        sign = -1.0;
+    }
+    double sinThetaSq = 1.0 - cosTheta*cosTheta;
+    double sinTheta = sinThetaSq > 0.0 ? sqrt(sinThetaSq) : 0.0;
+    if (sinTheta < SlerpMinSin) {
+        return Nlerp(q0, q1, t);
+    }
+    double tTheta = t * atan2(sinTheta, cosTheta);
+    double c1 = sin(tTheta) / sinTheta;
+    double c0 = cos(tTheta) - cosTheta * c1;
+    c1 *= sign;
+    return Quaternion(c0*q0.x + c1*q1.x, c0*q0.y + c1*q1.y, c0*q0.z + c1*q1.z, c0*q0.w + c1*q1.w);
+}
+
+// No branches, so that the batch loop can be vectorized.
+inline Quaternion NlerpUnit(const Quaternion& q0, const Quaternion& q1, double t)
+{
+    double c1 = ((q0 ^ q1) < 0.0) ? -t : t;
+    double c0 = 1.0 - t;
+    Quaternion q(c0*q0.x + c1*q1.x, c0*q0.y + c1*q1.y, c0*q0.z + c1*q1.z, c0*q0.w + c1*q1.w);
+    return q *= 1.0 / sqrt(q.NormSq());
+}
+
+// The 3x3 rotation matrix of q, by columns, as in LinearMapR4::Set_glRotate(q).
+inline void QuaternionToMatrix(const Quaternion& q, double* r)
+{
+    double s = 2.0 / q.NormSq();
+    double xs = q.x*s, ys = q.y*s, zs = q.z*s;
+    double wx = q.w*xs, wy = q.w*ys, wz = q.w*zs;
+    double xx = q.x*xs, xy = q.x*ys, xz = q.x*zs;
+    double yy = q.y*ys, yz = q.y*zs, zz = q.z*zs;
+    r[0] = 1.0 - (yy + zz);
+    r[1] = xy + wz;
+    r[2] = xz - wy;
+    r[3] = xy - wz;
+    r[4] = 1.0 - (xx + zz);
+    r[5] = yz + wx;
+    r[6] = xz + wy;
+    r[7] = yz - wx;
+    r[8] = 1.0 - (xx + yy);
+}
+
+} // namespace
+
+// R must be a rotation.  Uses the largest of |w|, |x|, |y|, |z| as the
+//    divisor, which keeps the conversion accurate for every angle.
+Quaternion& Quaternion::Set(const Matrix3x3& R)
+{
+    double trace = R.m11 + R.m22 + R.m33;
+    if (trace > 0.0) {
+        double s = 0.5 / sqrt(trace + 1.0);
+        return Set((R.m32 - R.m23)*s, (R.m13 - R.m31)*s, (R.m21 - R.m12)*s, 0.25 / s);
+    }
+    else if (R.m11 >= R.m22 && R.m11 >= R.m33) {
+        double s = 0.5 / sqrt(1.0 + R.m11 - R.m22 - R.m33);
+        return Set(0.25 / s, (R.m12 + R.m21)*s, (R.m13 + R.m31)*s, (R.m32 - R.m23)*s);
+    }
+    else if (R.m22 >= R.m33) {
+        double s = 0.5 / sqrt(1.0 + R.m22 - R.m11 - R.m33);
+        return Set((R.m12 + R.m21)*s, 0.25 / s, (R.m23 + R.m32)*s, (R.m13 - R.m31)*s);
+    }
+    else {
+        double s = 0.5 / sqrt(1.0 + R.m33 - R.m11 - R.m22);
+        return Set((R.m13 + R.m31)*s, (R.m23 + R.m32)*s, 0.25 / s, (R.m21 - R.m12)*s);
+    }
+}
+
+double Quaternion::Angle() const
+{
+    return 2.0 * atan2(sqrt(x*x + y*y + z*z), fabs(w));
+}
+
+Quaternion Exp(const VectorR3& v)
+{
+    double theta = v.Norm();
+    double thetaSq = theta * theta;
+    double sinc = (thetaSq < 1.0e-8) ? 1.0 - thetaSq * (1.0 / 6.0) : sin(theta) / theta;
+    return Quaternion(v.x*sinc, v.y*sinc, v.z*sinc, cos(theta));
+}
+
+VectorR3 Log(const Quaternion& q)
+{
+    double s = sqrt(q.x*q.x + q.y*q.y + q.z*q.z);
+    if (s == 0.0) {
+        return VectorR3(0.0, 0.0, 0.0);
+    }
+    double f = atan2(s, q.w) / s;
+    return VectorR3(q.x*f, q.y*f, q.z*f);
+}
+
+Quaternion Slerp(const Quaternion& q0, const Quaternion& q1, double t)
+{
+    return SlerpUnit(q0, q1, t);
+}
+
+Quaternion Nlerp(const Quaternion& q0, const Quaternion& q1, double t)
+{
+    return NlerpUnit(q0, q1, t);
+}
+
+void Slerp(const Quaternion* q0, const Quaternion* q1, double t, Quaternion* out, long count)
+{
+    for (long i = 0; i < count; i++) {
+        out[i] = SlerpUnit(q0[i], q1[i], t);
+    }
+}
+
+void Nlerp(const Quaternion* q0, const Quaternion* q1, double t, Quaternion* out, long count)
+{
+    for (long i = 0; i < count; i++) {
+        out[i] = NlerpUnit(q0[i], q1[i], t);
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, const Quaternion& q)
+{
+    return os << "<" << q.x << "," << q.y << "," << q.z << "; " << q.w << ">";
+}
+
+// The rotation matrix of q, with no trig functions.  q need not be a
+//    unit quaternion: it is scaled by 2/NormSq().
+RotationMapR3& RotationMapR3::Set(const Quaternion& q)
+{
+    double r[9];
+    QuaternionToMatrix(q, r);
+    Matrix3x3::Set(r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7], r[8]);
+    return *this;
+}
+
+RigidMapR3& RigidMapR3::SetRotationPart(const Quaternion& q)
+{
+    double r[9];
+    QuaternionToMatrix(q, r);
+    Matrix3x4::Set3x3(r[0], r[1], r[2], r[3], r[4], r[5], r[6], r[7], r[8]);
+    return *this;
+}
@@ -23,6 +23,11 @@
 #define _CRT_SECURE_NO_DEPRECATE
 
 #include "RgbImage.h"
+#include <math.h>
+#include <string.h>
+#include <functional>
+#include <thread>
+#include <vector>
 
 #ifndef RGBIMAGE_DONT_USE_OPENGL
 #include <windows.h>
@@ -42,6 +47,10 @@ RgbImage::RgbImage( int numRows, int numCols )
  *  Read into memory an RGB image from an uncompressed BMP file.
  *  Return true for success, false for failure.  Error code is available
  *     with a separate call.
+ *  The rows of a 24 bit BMP file are laid out exactly as in ImagePtr
+ *     (bottom to top, padded to a multiple of four bytes), so the pixel
+ *     data is read with a single fread(), and then swizzled in place
+ *     from BGR to RGB order.
  *  Author: Sam Buss December 2001.
  **********************************************************************/
 
@@ -56,26 +65,22 @@ bool RgbImage::LoadBmpFile( const char* filename )
 	}
 
 	bool fileFormatOK = false;
-	int bChar = fgetc( infile );
-	int mChar = fgetc( infile );
-	if ( bChar=='B' && mChar=='M' ) {			// If starts with "BM" for "BitMap"
-		skipChars(infile, 4 + 2 + 2);			// Skip 3 fields (size of file and two reserved fields)
-		int offset = readLong(infile);			// Offset to the bitmap table
-		int headerSize = readLong(infile);		// Size of the Bitmap header
-		NumCols = readLong( infile );
-		NumRows = readLong( infile );
-		skipChars( infile, 2 );					// Skip one field (number of color planes)
-		int bitsPerPixel = readShort( infile );
-		int bytesRead = 30;						// 2 + 4 + 2 + 2 + 4 + 4 + 4 + 4 + 2 + 2
+	unsigned char header[34];					// File header, and the start of the info header
+	if ( fread( header, 1, sizeof(header), infile )==sizeof(header)
+			&& header[0]=='B' && header[1]=='M' ) {	// If starts with "BM" for "BitMap"
+		long offset = getLong( header+10 );		// Offset to the bitmap table
+		long headerSize = getLong( header+14 );	// Size of the Bitmap header
+		NumCols = getLong( header+18 );
+		NumRows = getLong( header+22 );
+		int bitsPerPixel = getShort( header+28 );	// (Skipped the number of color planes)
 		int compressionMethod = BI_RGB;
 		if (headerSize >= 40) {
-			compressionMethod = readLong(infile);
-			bytesRead += 4;
+			compressionMethod = getLong( header+30 );
 		}
-		skipChars(infile, offset - bytesRead);
 
 		if ( NumCols>0 && NumCols<=100000 && NumRows>0 && NumRows<=100000  
-			&& bitsPerPixel==24 && compressionMethod == BI_RGB && !feof(infile) ) {
+			&& bitsPerPixel==24 && compressionMethod == BI_RGB 
+			&& offset>=30 && fseek( infile, offset, SEEK_SET )==0 ) {
 			fileFormatOK = true;
 		}
 	}
@@ -89,24 +94,11 @@ bool RgbImage::LoadBmpFile( const char* filename )
 
 	// Allocate memory
     if (!AllocateImageData(NumRows, NumCols)) {
+		fclose( infile );
         return false;
     }
-	unsigned char* cPtr = ImagePtr;
-	for ( int i=0; i<NumRows; i++ ) {
-		int j;
-		for ( j=0; j<NumCols; j++ ) {
-			*(cPtr+2) = fgetc( infile );	// Blue color value
-			*(cPtr+1) = fgetc( infile );	// Green color value
-			*cPtr = fgetc( infile );		// Red color value
-			cPtr += 3;
-		}
-		int k=3*NumCols;					// Num bytes already read
-		for ( ; k<GetNumBytesPerRow(); k++ ) {
-			fgetc( infile );				// Read and ignore padding;
-			*(cPtr++) = 0;
-		}
-	}
-	if ( feof( infile ) ) {
+	size_t numBytes = (size_t)NumRows*GetNumBytesPerRow();
+	if ( fread( ImagePtr, 1, numBytes, infile ) != numBytes ) {
 		fprintf( stderr, "Premature end of file: %s.\n", filename );
 		Reset();
 		ErrorCode = ReadError;
@@ -114,47 +106,93 @@ bool RgbImage::LoadBmpFile( const char* filename )
 		return false;
 	}
 	fclose( infile );	// Close the file
+
+	unsigned char* rowPtr = ImagePtr;
+	for ( int i=0; i<NumRows; i++ ) {
+		SwapRedBlue( rowPtr, NumCols );
+		for ( int k=3*NumCols; k<GetNumBytesPerRow(); k++ ) {
+			rowPtr[k] = 0;					// Clear the padding
+		}
+		rowPtr += GetNumBytesPerRow();
+	}
 	return true;
 }
 
-short RgbImage::readShort( FILE* infile )
+// Get little endian integers from a buffer
+long RgbImage::getLong( const unsigned char* bytes )
 {
-	// read a 16 bit integer
-	unsigned char lowByte, hiByte;
-	lowByte = fgetc(infile);			// Read the low order byte (little endian form)
-	hiByte = fgetc(infile);			// Read the high order byte
-
-	// Pack together
-	short ret = hiByte;
-	ret <<= 8;
-	ret |= lowByte;
-	return ret;
+	return (long)((unsigned long)bytes[0] | ((unsigned long)bytes[1]<<8)
+				  | ((unsigned long)bytes[2]<<16) | ((unsigned long)bytes[3]<<24));
 }
 
-long RgbImage::readLong( FILE* infile )
-{  
-	// Read in 32 bit integer
-	unsigned char byte0, byte1, byte2, byte3;
-	byte0 = fgetc(infile);			// Read bytes, low order to high order
-	byte1 = fgetc(infile);
-	byte2 = fgetc(infile);
-	byte3 = fgetc(infile);
-
-	// Pack together
-	long ret = byte3;
-	ret <<= 8;
-	ret |= byte2;
-	ret <<= 8;
-	ret |= byte1;
-	ret <<= 8;
-	ret |= byte0;
-	return ret;
+short RgbImage::getShort( const unsigned char* bytes )
+{
+	return (short)(bytes[0] | (bytes[1]<<8));
 }
 
-void RgbImage::skipChars( FILE* infile, int numChars )
+// SwapRedBlue exchanges the first and third bytes of each three byte pixel,
+//    converting between BGR (as in BMP files) and RGB.
+// With SSSE3, PSHUFB swaps four pixels (12 bytes) at a time: each 16 byte
+//    load is shuffled in its first 12 bytes, and its last 4 bytes are stored
+//    back unchanged (they are overwritten with the next block).
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define RGBIMAGE_SSSE3
+#define RGBIMAGE_TARGET_SSSE3
+static bool CpuHasSsse3()
 {
-	for ( int i=0; i<numChars; i++ ) {
-		fgetc( infile );
+	int info[4];
+	__cpuid( info, 1 );
+	return (info[2] & (1<<9)) != 0;
+}
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define RGBIMAGE_SSSE3
+#define RGBIMAGE_TARGET_SSSE3 __attribute__((target("ssse3")))
+static bool CpuHasSsse3()
+{
+	return __builtin_cpu_supports( "ssse3" );
+}
+#endif
+
+#ifdef RGBIMAGE_SSSE3
+RGBIMAGE_TARGET_SSSE3
+static long SwapRedBlueSsse3( unsigned char* pixels, long numBytes )
+{
+	const __m128i swap = _mm_setr_epi8( 2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 12, 13, 14, 15 );
+	long j = 0;
+	for ( ; j+52<=numBytes; j+=48 ) {		// 16 pixels per iteration
+		__m128i a = _mm_loadu_si128( (const __m128i*)(pixels+j) );
+		__m128i b = _mm_loadu_si128( (const __m128i*)(pixels+j+12) );
+		__m128i c = _mm_loadu_si128( (const __m128i*)(pixels+j+24) );
+		__m128i d = _mm_loadu_si128( (const __m128i*)(pixels+j+36) );
+		_mm_storeu_si128( (__m128i*)(pixels+j), _mm_shuffle_epi8( a, swap ) );		// Stored in order, so the
+		_mm_storeu_si128( (__m128i*)(pixels+j+12), _mm_shuffle_epi8( b, swap ) );	//   unchanged last 4 bytes
+		_mm_storeu_si128( (__m128i*)(pixels+j+24), _mm_shuffle_epi8( c, swap ) );	//   are overwritten by the
+		_mm_storeu_si128( (__m128i*)(pixels+j+36), _mm_shuffle_epi8( d, swap ) );	//   next block
+	}
+	for ( ; j+16<=numBytes; j+=12 ) {
+		__m128i a = _mm_loadu_si128( (const __m128i*)(pixels+j) );
+		_mm_storeu_si128( (__m128i*)(pixels+j), _mm_shuffle_epi8( a, swap ) );
+	}
+	return j;								// Number of bytes done
+}
+#endif
+
+void RgbImage::SwapRedBlue( unsigned char* pixels, long numPixels )
+{
+	long numBytes = 3*numPixels;
+	long j = 0;
+#ifdef RGBIMAGE_SSSE3
+	static const bool hasSsse3 = CpuHasSsse3();
+	if ( hasSsse3 ) {
+		j = SwapRedBlueSsse3( pixels, numBytes );
+	}
+#endif
+	for ( ; j<numBytes; j+=3 ) {
+		unsigned char t = pixels[j];
+		pixels[j] = pixels[j+2];
+		pixels[j+2] = t;
 	}
 }
 
@@ -163,84 +201,306 @@ void RgbImage::skipChars( FILE* infile, int numChars )
  *  Write an RGB image to an uncompressed BMP file.
  *  Return true for success, false for failure.  Error code is available
  *     with a separate call.
+ *  The header is written with one fwrite(), and then each row (swizzled
+ *     to BGR order in a buffer) with one fwrite().
  *  Author: Sam Buss, January 2003.
  **********************************************************************/
 
 bool RgbImage::WriteBmpFile( const char* filename )
 {
-	FILE* outfile = fopen( filename, "wb" );		// Open for reading binary data
+	FILE* outfile = fopen( filename, "wb" );		// Open for writing binary data
 	if ( !outfile ) {
 		fprintf(stderr, "Unable to open file: %s\n", filename);
 		ErrorCode = OpenError;
 		return false;
 	}
 
-	fputc('B',outfile);
-	fputc('M',outfile);
-	int rowLen = GetNumBytesPerRow();
-	writeLong( 40+14+NumRows*rowLen, outfile );	// Length of file
-	writeShort( 0, outfile );					// Reserved for future use
-	writeShort( 0, outfile );
-	writeLong( 40+14, outfile );				// Offset to pixel data
-	writeLong( 40, outfile );					// header length
-	writeLong( NumCols, outfile );				// width in pixels
-	writeLong( NumRows, outfile );				// height in pixels (pos for bottom up)
-	writeShort( 1, outfile );		// number of planes
-	writeShort( 24, outfile );		// bits per pixel
-	writeLong( 0, outfile );		// no compression
-	writeLong( 0, outfile );		// not used if no compression
-	writeLong( 0, outfile );		// Pixels per meter
-	writeLong( 0, outfile );		// Pixels per meter
-	writeLong( 0, outfile );		// unused for 24 bits/pixel
-	writeLong( 0, outfile );		// unused for 24 bits/pixel
-
-	// Now write out the pixel data:
-	unsigned char* cPtr = ImagePtr;
-	for ( int i=0; i<NumRows; i++ ) {
-		// Write out i-th row's data
-		int j;
-		for ( j=0; j<NumCols; j++ ) {
-			fputc( *(cPtr+2), outfile);		// Blue color value
-			fputc( *(cPtr+1), outfile);		// Blue color value
-			fputc( *(cPtr+0), outfile);		// Blue color value
-			cPtr+=3;
-		}
-		// Pad row to word boundary
-		int k=3*NumCols;					// Num bytes already read
-		for ( ; k<GetNumBytesPerRow(); k++ ) {
-			fputc( 0, outfile );				// Read and ignore padding;
-			cPtr++;
-		}
+	unsigned char header[54] = { 'B', 'M' };	// Other bytes start as zero
+	long rowLen = GetNumBytesPerRow();
+	putLong( 40+14+NumRows*rowLen, header+2 );	// Length of file
+	putLong( 40+14, header+10 );				// Offset to pixel data
+	putLong( 40, header+14 );					// header length
+	putLong( NumCols, header+18 );				// width in pixels
+	putLong( NumRows, header+22 );				// height in pixels (pos for bottom up)
+	putShort( 1, header+26 );		// number of planes
+	putShort( 24, header+28 );		// bits per pixel
+	// No compression, and the remaining fields are unused for 24 bits/pixel
+	bool writeOK = fwrite( header, 1, sizeof(header), outfile )==sizeof(header);
+
+	// Now write out the pixel data, BGR ordered, rows padded to word boundaries
+	unsigned char* rowBuffer = new unsigned char[rowLen];
+	for ( long i=0; i<NumRows && writeOK; i++ ) {
+		memcpy( rowBuffer, ImagePtr+i*rowLen, rowLen );
+		SwapRedBlue( rowBuffer, NumCols );
+		writeOK = fwrite( rowBuffer, 1, rowLen, outfile )==(size_t)rowLen;
 	}
+	delete[] rowBuffer;
 
-	fclose( outfile );	// Close the file
+	if ( fclose( outfile )!=0 || !writeOK ) {	// Close the file
+		fprintf(stderr, "Error writing file: %s\n", filename);
+		ErrorCode = WriteError;
+		return false;
+	}
 	return true;
 }
 
-void RgbImage::writeLong( long data, FILE* outfile )
+// Put little endian integers into a buffer
+void RgbImage::putLong( long data, unsigned char* bytes )
 {  
-	// Read in 32 bit integer
-	unsigned char byte0, byte1, byte2, byte3;
-	byte0 = (unsigned char)(data&0x000000ff);		// Write bytes, low order to high order
-	byte1 = (unsigned char)((data>>8)&0x000000ff);
-	byte2 = (unsigned char)((data>>16)&0x000000ff);
-	byte3 = (unsigned char)((data>>24)&0x000000ff);
-
-	fputc( byte0, outfile );
-	fputc( byte1, outfile );
-	fputc( byte2, outfile );
-	fputc( byte3, outfile );
+	bytes[0] = (unsigned char)(data&0x000000ff);		// Low order to high order
+	bytes[1] = (unsigned char)((data>>8)&0x000000ff);
+	bytes[2] = (unsigned char)((data>>16)&0x000000ff);
+	bytes[3] = (unsigned char)((data>>24)&0x000000ff);
 }
 
-void RgbImage::writeShort( short data, FILE* outfile )
+void RgbImage::putShort( short data, unsigned char* bytes )
 {  
-	// Read in 32 bit integer
-	unsigned char byte0, byte1;
-	byte0 = data&0x000000ff;		// Write bytes, low order to high order
-	byte1 = (data>>8)&0x000000ff;
+	bytes[0] = data&0x000000ff;		// Low order to high order
+	bytes[1] = (data>>8)&0x000000ff;
+}
+
+/* ********************************************************************
+ *  LoadQoiFile and WriteQoiFile
+ *  Read and write the QOI lossless format.  Each pixel is coded, relative
+ *     to the previous pixel, as one of: a run of repeats, an index into a
+ *     64 entry table of recently seen colors (hashed), a small difference,
+ *     a "luma" difference (green, and red and blue relative to green),
+ *     or the full RGB value.
+ *  QOI rows are top to bottom, so the rows of ImagePtr are visited in
+ *     reverse.  The file is streamed through a QoiBufferSize buffer, so
+ *     there is one fread() or fwrite() per 64K bytes.
+ *  Four channel (RGBA) files are also read, and the alpha discarded.
+ **********************************************************************/
+
+static const long QoiBufferSize = 1<<16;
+static const long QoiHeaderSize = 14;
+static const long QoiMaxPixels = 400000000;		// The reference decoder's limit: the image data stays under 2GB
+
+static const unsigned char QoiOpIndex = 0x00;		// 00xxxxxx
+static const unsigned char QoiOpDiff = 0x40;		// 01xxxxxx
+static const unsigned char QoiOpLuma = 0x80;		// 10xxxxxx
+static const unsigned char QoiOpRun = 0xc0;			// 11xxxxxx
+static const unsigned char QoiOpRgb = 0xfe;
+static const unsigned char QoiOpRgba = 0xff;
+static const unsigned char QoiEndMarker[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+static inline int QoiHash( unsigned char r, unsigned char g, unsigned char b, unsigned char a )
+{
+	return ( r*3 + g*5 + b*7 + a*11 ) & 63;
+}
+
+bool RgbImage::LoadQoiFile( const char* filename )
+{
+	Reset();
+	FILE* infile = fopen( filename, "rb" );		// Open for reading binary data
+	if ( !infile ) {
+		fprintf(stderr, "Unable to open file: %s\n", filename);
+		ErrorCode = OpenError;
+		return false;
+	}
+
+	unsigned char header[QoiHeaderSize];
+	long numCols = 0, numRows = 0;
+	if ( fread( header, 1, QoiHeaderSize, infile )==(size_t)QoiHeaderSize
+			&& memcmp( header, "qoif", 4 )==0 && (header[12]==3 || header[12]==4) ) {
+		numCols = getLongBigEndian( header+4 );
+		numRows = getLongBigEndian( header+8 );
+	}
+	if ( numCols<=0 || numRows<=0 || (long long)numCols*numRows>QoiMaxPixels ) {
+		ErrorCode = FileFormatError;
+		fprintf(stderr, "Not a valid QOI file: %s.\n", filename);
+		fclose ( infile );
+		return false;
+	}
+	if ( !AllocateImageData( numRows, numCols ) ) {
+		fclose( infile );
+		return false;
+	}
+
+	// The buffer has room past its end, so that an operation cut off at the
+	//   end of a (corrupt) file reads zeros instead of garbage.
+	unsigned char* buffer = new unsigned char[QoiBufferSize+8];
+	long pos = 0;			// Next byte to decode in buffer
+	long len = 0;			// Number of bytes in buffer
+	bool atEof = false;
+	unsigned char index[64][4];
+	memset( index, 0, sizeof(index) );
+	unsigned char r = 0, g = 0, b = 0, a = 255;
+	int run = 0;
+	bool readOK = true;
+	for ( long i=NumRows-1; i>=0 && readOK; i-- ) {
+		unsigned char* p = ImagePtr + i*GetNumBytesPerRow();
+		for ( long j=0; j<NumCols; j++, p+=3 ) {
+			if ( run>0 ) {
+				run--;
+			}
+			else {
+				if ( len-pos<5 && !atEof ) {	// Refill: an operation is at most 5 bytes
+					memmove( buffer, buffer+pos, len-pos );
+					len -= pos;
+					pos = 0;
+					len += (long)fread( buffer+len, 1, QoiBufferSize-len, infile );
+					atEof = ( len<QoiBufferSize );
+					memset( buffer+len, 0, 8 );
+				}
+				if ( pos>=len ) {
+					readOK = false;
+					break;
+				}
+				unsigned char b1 = buffer[pos++];
+				if ( b1==QoiOpRgb ) {
+					r = buffer[pos]; g = buffer[pos+1]; b = buffer[pos+2];
+					pos += 3;
+				}
+				else if ( b1==QoiOpRgba ) {
+					r = buffer[pos]; g = buffer[pos+1]; b = buffer[pos+2]; a = buffer[pos+3];
+					pos += 4;
+				}
+				else if ( (b1&0xc0)==QoiOpIndex ) {
+					r = index[b1][0]; g = index[b1][1]; b = index[b1][2]; a = index[b1][3];
+				}
+				else if ( (b1&0xc0)==QoiOpDiff ) {
+					r += ((b1>>4)&3) - 2;
+					g += ((b1>>2)&3) - 2;
+					b += (b1&3) - 2;
+				}
+				else if ( (b1&0xc0)==QoiOpLuma ) {
+					unsigned char b2 = buffer[pos++];
+					int dg = (b1&0x3f) - 32;
+					r += dg - 8 + ((b2>>4)&0x0f);
+					g += dg;
+					b += dg - 8 + (b2&0x0f);
+				}
+				else {
+					run = b1&0x3f;		// Run of run+1 pixels, including this one
+				}
+				unsigned char* entry = index[QoiHash( r, g, b, a )];
+				entry[0] = r; entry[1] = g; entry[2] = b; entry[3] = a;
+			}
+			p[0] = r;
+			p[1] = g;
+			p[2] = b;
+		}
+		for ( long k=3*NumCols; k<GetNumBytesPerRow(); k++ ) {
+			ImagePtr[i*GetNumBytesPerRow()+k] = 0;		// Clear the padding
+		}
+	}
+	delete[] buffer;
+	fclose( infile );
+	if ( !readOK ) {
+		fprintf( stderr, "Premature end of file: %s.\n", filename );
+		Reset();
+		ErrorCode = ReadError;
+		return false;
+	}
+	return true;
+}
+
+bool RgbImage::WriteQoiFile( const char* filename )
+{
+	FILE* outfile = fopen( filename, "wb" );		// Open for writing binary data
+	if ( !outfile ) {
+		fprintf(stderr, "Unable to open file: %s\n", filename);
+		ErrorCode = OpenError;
+		return false;
+	}
+
+	unsigned char* buffer = new unsigned char[QoiBufferSize];
+	memcpy( buffer, "qoif", 4 );
+	putLongBigEndian( NumCols, buffer+4 );
+	putLongBigEndian( NumRows, buffer+8 );
+	buffer[12] = 3;				// RGB
+	buffer[13] = 0;				// sRGB
+	long len = QoiHeaderSize;
+
+	unsigned int index[64];		// Colors packed as r | g<<8 | b<<16 | a<<24
+	memset( index, 0, sizeof(index) );
+	unsigned char pr = 0, pg = 0, pb = 0;	// Previous pixel (alpha is always 255)
+	int run = 0;
+	bool writeOK = true;
+	for ( long i=NumRows-1; i>=0 && writeOK; i-- ) {
+		const unsigned char* p = ImagePtr + i*GetNumBytesPerRow();
+		for ( long j=0; j<NumCols; j++, p+=3 ) {
+			if ( len>QoiBufferSize-8 ) {		// Room for a run and an RGB operation
+				writeOK = fwrite( buffer, 1, len, outfile )==(size_t)len;
+				len = 0;
+			}
+			unsigned char r = p[0], g = p[1], b = p[2];
+			if ( r==pr && g==pg && b==pb ) {
+				if ( ++run==62 ) {
+					buffer[len++] = QoiOpRun | (run-1);
+					run = 0;
+				}
+				continue;
+			}
+			if ( run>0 ) {
+				buffer[len++] = QoiOpRun | (run-1);
+				run = 0;
+			}
+			unsigned int packed = r | (g<<8) | (b<<16) | 0xff000000u;
+			int h = QoiHash( r, g, b, 255 );
+			if ( index[h]==packed ) {
+				buffer[len++] = QoiOpIndex | h;
+			}
+			else {
+				index[h] = packed;
+				int dr = (signed char)(r-pr);
+				int dg = (signed char)(g-pg);
+				int db = (signed char)(b-pb);
+				int drg = dr-dg;
+				int dbg = db-dg;
+				if ( dr>=-2 && dr<=1 && dg>=-2 && dg<=1 && db>=-2 && db<=1 ) {
+					buffer[len++] = QoiOpDiff | ((dr+2)<<4) | ((dg+2)<<2) | (db+2);
+				}
+				else if ( dg>=-32 && dg<=31 && drg>=-8 && drg<=7 && dbg>=-8 && dbg<=7 ) {
+					buffer[len++] = QoiOpLuma | (dg+32);
+					buffer[len++] = ((drg+8)<<4) | (dbg+8);
+				}
+				else {
+					buffer[len++] = QoiOpRgb;
+					buffer[len++] = r;
+					buffer[len++] = g;
+					buffer[len++] = b;
+				}
+			}
+			pr = r;
+			pg = g;
+			pb = b;
+		}
+	}
+	if ( run>0 ) {
+		buffer[len++] = QoiOpRun | (run-1);
+	}
+	if ( writeOK && len>QoiBufferSize-8 ) {
+		writeOK = fwrite( buffer, 1, len, outfile )==(size_t)len;
+		len = 0;
+	}
+	memcpy( buffer+len, QoiEndMarker, 8 );
+	len += 8;
+	writeOK = writeOK && fwrite( buffer, 1, len, outfile )==(size_t)len;
+	delete[] buffer;
+
+	if ( fclose( outfile )!=0 || !writeOK ) {	// Close the file
+		fprintf(stderr, "Error writing file: %s\n", filename);
+		ErrorCode = WriteError;
+		return false;
+	}
+	return true;
+}
 
-	fputc( byte0, outfile );
-	fputc( byte1, outfile );
+// Big endian integers, as in QOI files
+long RgbImage::getLongBigEndian( const unsigned char* bytes )
+{
+	return (long)(((unsigned long)bytes[0]<<24) | ((unsigned long)bytes[1]<<16)
+				  | ((unsigned long)bytes[2]<<8) | (unsigned long)bytes[3]);
+}
+
+void RgbImage::putLongBigEndian( long data, unsigned char* bytes )
+{
+	bytes[0] = (unsigned char)((data>>24)&0x000000ff);	// High order to low order
+	bytes[1] = (unsigned char)((data>>16)&0x000000ff);
+	bytes[2] = (unsigned char)((data>>8)&0x000000ff);
+	bytes[3] = (unsigned char)(data&0x000000ff);
 }
 
 
@@ -295,6 +555,228 @@ bool RgbImage::AllocateImageData(int numRows, int numCols)
 }
 
 
+/* ********************************************************************
+ *  Downsample
+ *  Output pixel (i,j) is centered between source pixels 2i and 2i+1
+ *     (and 2j and 2j+1).  It is the weighted sum of source rows 2i-1 to 2i+2
+ *     and columns 2j-1 to 2j+2, with weights 1,3,3,1 in each direction,
+ *     clamping at the edges of the image.
+ *  Each output row is made in two passes.  The vertical pass sums four
+ *     source rows into 16 bit values.  The horizontal pass filters that
+ *     row at full resolution (so that SIMD code can work on consecutive
+ *     values, despite the three interleaved colors), and every second
+ *     pixel is kept.  All sums are exact, so SIMD and scalar code agree.
+ **********************************************************************/
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP>=2)
+#define RGBIMAGE_SSE2
+#include <emmintrin.h>
+#endif
+
+// sums[m] = a[m] + 3*(b[m]+c[m]) + d[m], for m < n.
+static void VerticalSums( const unsigned char* a, const unsigned char* b, const unsigned char* c,
+						  const unsigned char* d, unsigned short* sums, long n )
+{
+	long m = 0;
+#ifdef RGBIMAGE_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	for ( ; m+16<=n; m+=16 ) {
+		__m128i va = _mm_loadu_si128( (const __m128i*)(a+m) );
+		__m128i vb = _mm_loadu_si128( (const __m128i*)(b+m) );
+		__m128i vc = _mm_loadu_si128( (const __m128i*)(c+m) );
+		__m128i vd = _mm_loadu_si128( (const __m128i*)(d+m) );
+		__m128i mid = _mm_add_epi16( _mm_unpacklo_epi8( vb, zero ), _mm_unpacklo_epi8( vc, zero ) );
+		__m128i lo = _mm_add_epi16( _mm_add_epi16( _mm_unpacklo_epi8( va, zero ), _mm_unpacklo_epi8( vd, zero ) ),
+									_mm_add_epi16( mid, _mm_slli_epi16( mid, 1 ) ) );
+		mid = _mm_add_epi16( _mm_unpackhi_epi8( vb, zero ), _mm_unpackhi_epi8( vc, zero ) );
+		__m128i hi = _mm_add_epi16( _mm_add_epi16( _mm_unpackhi_epi8( va, zero ), _mm_unpackhi_epi8( vd, zero ) ),
+									_mm_add_epi16( mid, _mm_slli_epi16( mid, 1 ) ) );
+		_mm_storeu_si128( (__m128i*)(sums+m), lo );
+		_mm_storeu_si128( (__m128i*)(sums+m+8), hi );
+	}
+#endif
+	for ( ; m<n; m++ ) {
+		sums[m] = (unsigned short)(a[m] + 3*(b[m]+c[m]) + d[m]);
+	}
+}
+
+// out[m] = (sums[m-3] + 3*(sums[m]+sums[m+3]) + sums[m+6] + 32) / 64, for m < n.
+//    The SIMD loop may read up to 16 values past sums[n+6].
+static void HorizontalSums( const unsigned short* sums, unsigned char* out, long n )
+{
+	long m = 0;
+#ifdef RGBIMAGE_SSE2
+	const __m128i round = _mm_set1_epi16( 32 );
+	for ( ; m<n; m+=8 ) {
+		__m128i left = _mm_loadu_si128( (const __m128i*)(sums+m-3) );
+		__m128i mid = _mm_add_epi16( _mm_loadu_si128( (const __m128i*)(sums+m) ),
+									 _mm_loadu_si128( (const __m128i*)(sums+m+3) ) );
+		__m128i right = _mm_loadu_si128( (const __m128i*)(sums+m+6) );
+		__m128i total = _mm_add_epi16( _mm_add_epi16( left, right ), _mm_add_epi16( mid, _mm_slli_epi16( mid, 1 ) ) );
+		total = _mm_srli_epi16( _mm_add_epi16( total, round ), 6 );		// At most 8*8*255, so no overflow
+		_mm_storel_epi64( (__m128i*)(out+m), _mm_packus_epi16( total, total ) );
+	}
+#endif
+	for ( ; m<n; m++ ) {
+		out[m] = (unsigned char)((sums[m-3] + 3*(sums[m]+sums[m+3]) + sums[m+6] + 32) >> 6);
+	}
+}
+
+void RgbImage::DownsampleRows( RgbImage& halfImage, long firstRow, long endRow ) const
+{
+	long n = 3*NumCols;
+	long halfCols = halfImage.NumCols;
+	long numFiltered = 3*(2*halfCols-1);	// Only up to the last pixel that is kept
+	// The vertically filtered row, with a copy of the first pixel before it and
+	//   of the last pixel twice after it, and slack for the SIMD loads.
+	unsigned short* sumsBuffer = new unsigned short[n+3+6+24];
+	unsigned short* rowSums = sumsBuffer+3;
+	for ( long k=n+6; k<n+6+24; k++ ) {
+		rowSums[k] = 0;
+	}
+	unsigned char* filtered = new unsigned char[numFiltered+8];
+	for ( long i=firstRow; i<endRow; i++ ) {
+		const unsigned char* srcRows[4];
+		for ( int k=0; k<4; k++ ) {
+			srcRows[k] = GetRgbPixel( ClampIndex( 2*i-1+k, NumRows ), 0 );
+		}
+		VerticalSums( srcRows[0], srcRows[1], srcRows[2], srcRows[3], rowSums, n );
+		for ( int c=0; c<3; c++ ) {
+			rowSums[c-3] = rowSums[c];
+			rowSums[n+c] = rowSums[n-3+c];
+			rowSums[n+3+c] = rowSums[n-3+c];
+		}
+		HorizontalSums( rowSums, filtered, numFiltered );
+
+		unsigned char* dst = halfImage.GetRgbPixel( i, 0 );
+		const unsigned char* src = filtered;
+		for ( long j=0; j<halfCols; j++ ) {
+			*(dst++) = src[0];
+			*(dst++) = src[1];
+			*(dst++) = src[2];
+			src += 6;
+		}
+		for ( long k=3*halfCols; k<halfImage.GetNumBytesPerRow(); k++ ) {
+			*(dst++) = 0;
+		}
+	}
+	delete[] filtered;
+	delete[] sumsBuffer;
+}
+
+bool RgbImage::Downsample( RgbImage& halfImage, int numThreads ) const
+{
+	assert( &halfImage != this );
+	long halfRows = NumRows>1 ? NumRows/2 : 1;
+	long halfCols = NumCols>1 ? NumCols/2 : 1;
+	halfImage.Reset();
+	if ( !halfImage.AllocateImageData( halfRows, halfCols ) ) {
+		return false;
+	}
+
+	// Give each thread at least 64K output pixels: below that, starting a thread costs more than it saves.
+	if ( numThreads<=0 ) {
+		numThreads = (int)std::thread::hardware_concurrency();
+		if ( numThreads<1 ) {
+			numThreads = 1;         // hardware_concurrency() is 0 when it is not known
+		}
+	}
+	long maxThreads = (halfRows*halfCols) >> 16;
+	if ( numThreads>maxThreads ) {
+		numThreads = maxThreads>1 ? (int)maxThreads : 1;
+	}
+	std::vector<std::thread> threads;
+	for ( int t=1; t<numThreads; t++ ) {
+		threads.push_back( std::thread( &RgbImage::DownsampleRows, this, std::ref(halfImage),
+										halfRows*t/numThreads, halfRows*(t+1)/numThreads ) );
+	}
+	DownsampleRows( halfImage, 0, halfRows/numThreads );
+	for ( size_t t=0; t<threads.size(); t++ ) {
+		threads[t].join();
+	}
+	return true;
+}
+
+int RgbImage::BuildMipmaps( RgbImage* levels, int maxLevels, int numThreads ) const
+{
+	const RgbImage* previous = this;
+	int numLevels = 0;
+	while ( numLevels<maxLevels && (previous->NumRows>1 || previous->NumCols>1) ) {
+		if ( !previous->Downsample( levels[numLevels], numThreads ) ) {
+			break;
+		}
+		previous = &levels[numLevels++];
+	}
+	return numLevels;
+}
+
+int RgbImage::NumMipmapLevels( long numRows, long numCols )
+{
+	long size = numRows>numCols ? numRows : numCols;
+	int numLevels = 1;
+	while ( size>1 ) {
+		size >>= 1;
+		numLevels++;
+	}
+	return numLevels;
+}
+
+/* ********************************************************************
+ *  Resize
+ *  Output pixel (i,j) samples the source at the point matching its center,
+ *     ((i+0.5)*NumRows/numRows - 0.5, (j+0.5)*NumCols/numCols - 0.5),
+ *     interpolating the four nearest pixels (clamped at the edges).
+ *  Bilinear interpolation aliases when shrinking by a factor of two or
+ *     more, so the image is first halved, with Downsample, until it is not.
+ **********************************************************************/
+
+bool RgbImage::Resize( RgbImage& resized, long numRows, long numCols, int numThreads ) const
+{
+	assert( &resized != this && numRows>0 && numCols>0 );
+	if ( NumRows>=2*numRows || NumCols>=2*numCols ) {
+		RgbImage half;
+		return Downsample( half, numThreads ) && half.Resize( resized, numRows, numCols, numThreads );
+	}
+	resized.Reset();
+	if ( !resized.AllocateImageData( numRows, numCols ) ) {
+		return false;
+	}
+
+	// Source columns and weights (in 1/256ths) are the same for every row
+	long* srcCols = new long[2*numCols];
+	int* colWeights = new int[numCols];
+	for ( long j=0; j<numCols; j++ ) {
+		double x = (j+0.5)*NumCols/numCols - 0.5;
+		long x0 = (long)floor( x );
+		colWeights[j] = (int)((x-x0)*256.0 + 0.5);
+		srcCols[2*j] = 3*ClampIndex( x0, NumCols );
+		srcCols[2*j+1] = 3*ClampIndex( x0+1, NumCols );
+	}
+	for ( long i=0; i<numRows; i++ ) {
+		double y = (i+0.5)*NumRows/numRows - 0.5;
+		long y0 = (long)floor( y );
+		int wy = (int)((y-y0)*256.0 + 0.5);
+		const unsigned char* row0 = GetRgbPixel( ClampIndex( y0, NumRows ), 0 );
+		const unsigned char* row1 = GetRgbPixel( ClampIndex( y0+1, NumRows ), 0 );
+		unsigned char* dst = resized.GetRgbPixel( i, 0 );
+		for ( long j=0; j<numCols; j++ ) {
+			long c0 = srcCols[2*j], c1 = srcCols[2*j+1];
+			int wx = colWeights[j];
+			for ( int c=0; c<3; c++ ) {
+				int top = (256-wx)*row0[c0+c] + wx*row0[c1+c];
+				int bottom = (256-wx)*row1[c0+c] + wx*row1[c1+c];
+				*(dst++) = (unsigned char)(((256-wy)*top + wy*bottom + (1<<15)) >> 16);
+			}
+		}
+		for ( long k=3*numCols; k<resized.GetNumBytesPerRow(); k++ ) {
+			*(dst++) = 0;
+		}
+	}
+	delete[] colWeights;
+	delete[] srcCols;
+	return true;
+}
+
 // Bitmap file format  (24 bit/pixel form)		BITMAPFILEHEADER
 // Header (14 bytes)
 //	 2 bytes: "BM"
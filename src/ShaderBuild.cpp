@@ -25,11 +25,22 @@
 #pragma comment(lib,"glew32s.lib")
 #pragma comment(lib,"glew32.lib")
 
+// Allow the use of deprecated fopen() instead of fopen_s()
+#define _CRT_SECURE_NO_DEPRECATE
+
 #define GLEW_STATIC
 #include <GL/glew.h> 
 #include <GLFW/glfw3.h>
 
 #include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "ShaderBuild.h"
 
@@ -74,34 +85,362 @@ const char *fragmentShader_ColorOnly =
  * Check for compilation and linkage errors (Highly recommended!)
  * Returns the "shaderProgram"
  */
+static unsigned int build_shader_program(const char* vertexShaderSource, const char* fragmentShaderSource,
+                                         bool binaryRetrievable);
+static unsigned int start_program_link(const char* vertexShaderSource, const char* fragmentShaderSource,
+                                       bool binaryRetrievable);
+static bool check_program_build(unsigned int shaderProgram);
+
 unsigned int setup_shader_vertfrag( const char* vertexShaderSource, const char* fragmentShaderSource ) {
+	return build_shader_program(vertexShaderSource, fragmentShaderSource, false);
+}
+
+static unsigned int build_shader_program(const char* vertexShaderSource, const char* fragmentShaderSource,
+                                         bool binaryRetrievable) {
+	unsigned int shaderProgram = start_program_link(vertexShaderSource, fragmentShaderSource, binaryRetrievable);
+	check_program_build(shaderProgram);
+	return shaderProgram;		// Return the compiled shaders as a single shader program.
+}
+
+// Compile both shaders and link them, without waiting for the results.
+//   With GL_KHR_parallel_shader_compile the driver does the work in the background.
+static unsigned int start_program_link(const char* vertexShaderSource, const char* fragmentShaderSource,
+                                       bool binaryRetrievable) {
 	// vertex shader
 	unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
 	glShaderSource(vertexShader, 1, &vertexShaderSource, NULL);
 	glCompileShader(vertexShader);
-	check_compilation_shader(vertexShader);
 
 	// fragment shader
 	unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
 	glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL);
 	glCompileShader(fragmentShader);
-	check_compilation_shader(fragmentShader);
 
 	// link shaders
 	unsigned int shaderProgram = glCreateProgram();
 	glAttachShader(shaderProgram, vertexShader);
 	glAttachShader(shaderProgram, fragmentShader);
+	if (binaryRetrievable) {
+		glProgramParameteri(shaderProgram, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
 	glLinkProgram(shaderProgram);
-	check_link_status(shaderProgram);
+	return shaderProgram;
+}
 
-	// Deallocate shaders since we do not need to use these for other shader programs.
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
+// Check for compilation and linkage errors (this waits for them to finish),
+//   and deallocate the shaders since we do not need to use these for other shader programs.
+static bool check_program_build(unsigned int shaderProgram) {
+	GLuint shaders[2];
+	int numShaders = 0;
+	glGetAttachedShaders(shaderProgram, 2, &numShaders, shaders);
+	for (int i = 0; i < numShaders; i++) {
+		check_compilation_shader(shaders[i]);
+	}
+	bool linked = (check_link_status(shaderProgram) != 0);
+	for (int i = 0; i < numShaders; i++) {
+		glDetachShader(shaderProgram, shaders[i]);
+		glDeleteShader(shaders[i]);
+	}
+	return linked;
+}
 
-	return shaderProgram;		// Return the compiled shaders as a single shader program.
+// *****************************
+// Program binary cache.
+// A cache file holds:
+//    4 bytes: "SBC1"
+//    8 bytes: key, a hash of the shader source and the driver's identification strings
+//    4 bytes: binary format (as returned by glGetProgramBinary)
+//    4 bytes: length of the binary in bytes
+//    the program binary
+// *****************************
+
+bool shaderBinaryCacheEnabled = true;
+
+static const char shaderCacheMagic[4] = { 'S', 'B', 'C', '1' };
+
+// 64 bit FNV-1a hash, continued from "hash".
+static unsigned long long hash_string(unsigned long long hash, const char* str) {
+	if (str != 0) {
+		for (const unsigned char* p = (const unsigned char*)str; *p != 0; p++) {
+			hash ^= *p;
+			hash *= 0x100000001b3ULL;
+		}
+	}
+	hash ^= 0xff;			// Separator, so that "ab"+"c" differs from "a"+"bc"
+	hash *= 0x100000001b3ULL;
+	return hash;
+}
 
+static unsigned long long shader_cache_key(const char* vertexShaderSource, const char* fragmentShaderSource) {
+	unsigned long long hash = 0xcbf29ce484222325ULL;
+	hash = hash_string(hash, vertexShaderSource);
+	hash = hash_string(hash, fragmentShaderSource);
+	hash = hash_string(hash, (const char*)glGetString(GL_VENDOR));
+	hash = hash_string(hash, (const char*)glGetString(GL_RENDERER));
+	hash = hash_string(hash, (const char*)glGetString(GL_VERSION));
+	return hash;
 }
 
+static bool program_binary_supported() {
+	if (!GLEW_ARB_get_program_binary) {
+		return false;
+	}
+	int numFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+	return numFormats > 0;
+}
+
+// Returns the program, or 0 if the cache file is missing, stale, or rejected by the driver.
+static unsigned int load_cached_program(const char* cacheFileName, unsigned long long key) {
+	FILE* infile = fopen(cacheFileName, "rb");
+	if (!infile) {
+		return 0;
+	}
+	char magic[4];
+	unsigned long long fileKey;
+	unsigned int binaryFormat, length;
+	bool headerOK = fread(magic, 1, 4, infile) == 4 && memcmp(magic, shaderCacheMagic, 4) == 0
+		&& fread(&fileKey, sizeof(fileKey), 1, infile) == 1 && fileKey == key
+		&& fread(&binaryFormat, sizeof(binaryFormat), 1, infile) == 1
+		&& fread(&length, sizeof(length), 1, infile) == 1 && length > 0;
+	if (!headerOK) {
+		fclose(infile);
+		return 0;
+	}
+	char* binary = new char[length];
+	bool readOK = (fread(binary, 1, length, infile) == length);
+	fclose(infile);
+
+	unsigned int shaderProgram = 0;
+	if (readOK) {
+		shaderProgram = glCreateProgram();
+		glProgramBinary(shaderProgram, binaryFormat, binary, length);
+		int success;
+		glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+		if (!success) {
+			glDeleteProgram(shaderProgram);		// Driver rejected the binary: fall back to compiling
+			shaderProgram = 0;
+		}
+	}
+	delete[] binary;
+	return shaderProgram;
+}
+
+static void save_cached_program(const char* cacheFileName, unsigned long long key, unsigned int shaderProgram) {
+	int length = 0;
+	glGetProgramiv(shaderProgram, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		return;
+	}
+	char* binary = new char[length];
+	GLenum binaryFormat;
+	glGetProgramBinary(shaderProgram, length, &length, &binaryFormat, binary);
+	FILE* outfile = fopen(cacheFileName, "wb");
+	if (outfile) {
+		unsigned int format = binaryFormat;
+		unsigned int len = length;
+		fwrite(shaderCacheMagic, 1, 4, outfile);
+		fwrite(&key, sizeof(key), 1, outfile);
+		fwrite(&format, sizeof(format), 1, outfile);
+		fwrite(&len, sizeof(len), 1, outfile);
+		fwrite(binary, 1, length, outfile);
+		fclose(outfile);
+	}
+	delete[] binary;
+}
+
+unsigned int setup_shader_vertfrag_cached(const char* vertexShaderSource, const char* fragmentShaderSource,
+                                          const char* cacheFileName) {
+	if (!shaderBinaryCacheEnabled || !program_binary_supported()) {
+		return setup_shader_vertfrag(vertexShaderSource, fragmentShaderSource);
+	}
+	unsigned long long key = shader_cache_key(vertexShaderSource, fragmentShaderSource);
+	unsigned int shaderProgram = load_cached_program(cacheFileName, key);
+	if (shaderProgram != 0) {
+		return shaderProgram;
+	}
+	shaderProgram = start_program_link(vertexShaderSource, fragmentShaderSource, true);
+	if (check_program_build(shaderProgram)) {
+		save_cached_program(cacheFileName, key, shaderProgram);
+	}
+	return shaderProgram;
+}
+
+// *****************************
+// Asynchronous builds.
+// One of three ways is used, chosen when the first build is started:
+//   - With GL_KHR_parallel_shader_compile (or GL_ARB_parallel_shader_compile),
+//     the shaders are compiled and linked by the driver's own threads,
+//     and GL_COMPLETION_STATUS_KHR tells when they are done.
+//   - Otherwise, if start_shader_compile_thread() was called, a worker thread
+//     builds the programs in an OpenGL context shared with the main window.
+//   - Otherwise, the program is built at once by start_shader_vertfrag().
+// *****************************
+
+enum ShaderBuildMode { BuildNotChosen, BuildParallelExtension, BuildWorkerThread, BuildImmediate };
+
+struct ShaderBuild {
+	std::string VertexSource;
+	std::string FragmentSource;
+	std::string CacheFileName;
+	unsigned long long CacheKey;
+	bool SaveToCache;					// Save the binary once linked (parallel extension only)
+	unsigned int Program;
+	std::atomic<bool> Done;				// Set when Program is ready to be checked and used
+	bool Finished;						// finish_shader_vertfrag() has been called
+};
+
+static ShaderBuildMode shaderBuildMode = BuildNotChosen;
+static std::vector<ShaderBuild*> shaderBuilds;		// Indexed by build number; only used by the main thread
+
+static GLFWwindow* compileThreadWindow = 0;
+static std::thread compileThread;
+static std::mutex compileMutex;
+static std::condition_variable compileQueued;		// Signaled when a build is queued, or on shutdown
+static std::condition_variable compileDone;			// Signaled when a build is done
+static std::deque<ShaderBuild*> compileQueue;
+static bool compileThreadStop = false;
+
+bool parallel_shader_compile_supported() {
+	return GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+}
+
+static void compile_thread_loop() {
+	glfwMakeContextCurrent(compileThreadWindow);
+	for (;;) {
+		ShaderBuild* build;
+		{
+			std::unique_lock<std::mutex> lock(compileMutex);
+			compileQueued.wait(lock, [] { return compileThreadStop || !compileQueue.empty(); });
+			if (compileQueue.empty()) {
+				break;			// Stopping, and nothing left to do
+			}
+			build = compileQueue.front();
+			compileQueue.pop_front();
+		}
+		build->Program = setup_shader_vertfrag_cached(build->VertexSource.c_str(), build->FragmentSource.c_str(),
+		                                              build->CacheFileName.c_str());
+		glFinish();			// Make the program complete before the main context uses it
+		{
+			std::lock_guard<std::mutex> lock(compileMutex);
+			build->Done.store(true);
+		}
+		compileDone.notify_all();
+	}
+	glfwMakeContextCurrent(NULL);
+}
+
+void start_shader_compile_thread(GLFWwindow* sharedContextWindow) {
+	if (compileThread.joinable()) {
+		return;
+	}
+	compileThreadWindow = sharedContextWindow;
+	compileThreadStop = false;
+	compileThread = std::thread(compile_thread_loop);
+}
+
+void stop_shader_compile_thread() {
+	if (!compileThread.joinable()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(compileMutex);
+		compileThreadStop = true;
+		compileQueue.clear();		// Builds not yet started are abandoned
+	}
+	compileQueued.notify_all();
+	compileThread.join();
+}
+
+int start_shader_vertfrag(const char* vertexShaderSource, const char* fragmentShaderSource,
+                          const char* cacheFileName) {
+	if (shaderBuildMode == BuildNotChosen) {
+		if (parallel_shader_compile_supported()) {
+			shaderBuildMode = BuildParallelExtension;
+			if (GLEW_KHR_parallel_shader_compile) {		// Let the driver use as many threads as it likes
+				glMaxShaderCompilerThreadsKHR(0xffffffff);
+			}
+			else {
+				glMaxShaderCompilerThreadsARB(0xffffffff);
+			}
+		}
+		else {
+			shaderBuildMode = compileThread.joinable() ? BuildWorkerThread : BuildImmediate;
+		}
+	}
+
+	ShaderBuild* build = new ShaderBuild;
+	build->VertexSource = vertexShaderSource;
+	build->FragmentSource = fragmentShaderSource;
+	build->CacheFileName = cacheFileName;
+	build->CacheKey = 0;
+	build->SaveToCache = false;
+	build->Program = 0;
+	build->Done.store(false);
+	build->Finished = false;
+	shaderBuilds.push_back(build);
+
+	switch (shaderBuildMode) {
+	case BuildParallelExtension:
+		if (shaderBinaryCacheEnabled && program_binary_supported()) {
+			build->CacheKey = shader_cache_key(vertexShaderSource, fragmentShaderSource);
+			build->Program = load_cached_program(cacheFileName, build->CacheKey);
+			build->SaveToCache = (build->Program == 0);
+		}
+		if (build->Program == 0) {
+			build->Program = start_program_link(vertexShaderSource, fragmentShaderSource, build->SaveToCache);
+		}
+		break;
+	case BuildWorkerThread:
+		{
+			std::lock_guard<std::mutex> lock(compileMutex);
+			compileQueue.push_back(build);
+		}
+		compileQueued.notify_one();
+		break;
+	default:
+		build->Program = setup_shader_vertfrag_cached(vertexShaderSource, fragmentShaderSource, cacheFileName);
+		build->Done.store(true);
+		break;
+	}
+	return (int)shaderBuilds.size() - 1;
+}
+
+bool is_shader_build_done(int buildNumber) {
+	ShaderBuild* build = shaderBuilds[buildNumber];
+	if (build->Finished || build->Done.load()) {
+		return true;
+	}
+	if (shaderBuildMode == BuildParallelExtension) {
+		int completed = GL_FALSE;
+		glGetProgramiv(build->Program, GL_COMPLETION_STATUS_KHR, &completed);
+		return completed != GL_FALSE;
+	}
+	return false;
+}
+
+unsigned int finish_shader_vertfrag(int buildNumber) {
+	ShaderBuild* build = shaderBuilds[buildNumber];
+	if (build->Finished) {
+		return build->Program;
+	}
+	if (shaderBuildMode == BuildParallelExtension) {
+		if (!build->Done.load()) {
+			bool linked = check_program_build(build->Program);		// Waits if still compiling
+			if (linked && build->SaveToCache) {
+				save_cached_program(build->CacheFileName.c_str(), build->CacheKey, build->Program);
+			}
+		}
+	}
+	else if (shaderBuildMode == BuildWorkerThread) {
+		std::unique_lock<std::mutex> lock(compileMutex);
+		compileDone.wait(lock, [build] { return build->Done.load(); });
+	}
+	build->Finished = true;
+	build->VertexSource.clear();		// The sources are no longer needed
+	build->FragmentSource.clear();
+	return build->Program;
+}
 
 /*
  * Check for compile errors for a shader.
@@ -0,0 +1,244 @@
+// *******************************
+// TextureArchive.cpp
+//
+// Memory mapping and uploading for texture archives (TextureArchive.h).
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+// Use the static library (so glew32.dll is not needed):
+#define GLEW_STATIC
+#include <GL/glew.h> 
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "TextureArchive.h"
+#include "BlockCompress.h"
+#include "RgbImage.h"
+
+// The bytes glTexImage2D() (or glCompressedTexImage2D()) reads for a level: the
+//    rows, padded to RowAlignment, of the pixel size of the format.
+static uint64_t UploadSize(const TextureArchiveEntry& entry, int level)
+{
+    uint64_t width = entry.LevelWidth[level], height = entry.LevelHeight[level];
+    if (entry.Format == TextureArchiveBC1) {
+        return BlockCompressedSize(BlockBC1, (long)width, (long)height);
+    }
+    uint64_t rowBytes = width * ((entry.Format == GL_RGBA) ? 4 : 3);
+    rowBytes = (rowBytes + entry.RowAlignment - 1) / entry.RowAlignment * entry.RowAlignment;
+    return rowBytes * height;
+}
+
+TextureArchive::TextureArchive() :
+    Data(0), Size(0), NumTextures(0), Entries(0), MappingHandle(0)
+{}
+
+TextureArchive::~TextureArchive()
+{
+    Close();
+}
+
+bool TextureArchive::Open(const char* fileName)
+{
+    Close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;               // No archive: not an error
+    }
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);              // The mapping keeps the file open
+    if (mapping == NULL) {
+        fprintf(stderr, "TextureArchive: Unable to map %s.\n", fileName);
+        return false;
+    }
+    Data = (const unsigned char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (Data == 0) {
+        CloseHandle(mapping);
+        fprintf(stderr, "TextureArchive: Unable to map %s.\n", fileName);
+        return false;
+    }
+    MappingHandle = mapping;
+    Size = (uint64_t)fileSize.QuadPart;
+#else
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) {
+        return false;               // No archive: not an error
+    }
+    struct stat fileStat;
+    void* mapped = MAP_FAILED;
+    if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+        mapped = mmap(0, fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);                      // The mapping keeps the file open
+    if (mapped == MAP_FAILED) {
+        fprintf(stderr, "TextureArchive: Unable to map %s.\n", fileName);
+        return false;
+    }
+    madvise(mapped, fileStat.st_size, MADV_SEQUENTIAL);
+    Data = (const unsigned char*)mapped;
+    Size = (uint64_t)fileStat.st_size;
+#endif
+
+    // Check the header and the directory
+    const TextureArchiveHeader* header = (const TextureArchiveHeader*)Data;
+    bool headerOK = Size >= sizeof(TextureArchiveHeader)
+        && memcmp(header->Magic, TextureArchiveMagic, sizeof(TextureArchiveMagic)) == 0
+        && header->EntrySize == sizeof(TextureArchiveEntry)
+        && header->FileSize == Size
+        && sizeof(TextureArchiveHeader) + (uint64_t)header->NumTextures * sizeof(TextureArchiveEntry) <= Size;
+    if (headerOK) {
+        NumTextures = header->NumTextures;
+        Entries = (const TextureArchiveEntry*)(Data + sizeof(TextureArchiveHeader));
+        for (int i = 0; i < NumTextures && headerOK; i++) {
+            const TextureArchiveEntry& entry = Entries[i];
+            headerOK = entry.NumLevels >= 1 && entry.NumLevels <= TextureArchiveMaxLevels
+                && entry.Name[TextureArchiveNameLength - 1] == 0
+                && (entry.Format == TextureArchiveBC1 ? entry.BytesPerPixel == 0
+                    : entry.Format == GL_RGB ? entry.BytesPerPixel == 3
+                    : entry.Format == GL_RGBA && entry.BytesPerPixel == 4);
+            if (entry.Format != TextureArchiveBC1) {
+                // LevelSize() divides by it, and glPixelStorei() accepts only these
+                uint32_t align = entry.RowAlignment;
+                headerOK = headerOK && (align == 1 || align == 2 || align == 4 || align == 8);
+            }
+            for (uint32_t level = 0; level < entry.NumLevels && headerOK; level++) {
+                // The dimension limit keeps LevelSize() from overflowing
+                uint32_t width = entry.LevelWidth[level], height = entry.LevelHeight[level];
+                headerOK = width >= 1 && width <= TextureArchiveMaxSize && height >= 1 && height <= TextureArchiveMaxSize;
+                uint64_t levelSize = headerOK ? LevelSize(entry, level) : 0;
+                headerOK = headerOK && levelSize >= UploadSize(entry, level)
+                    && entry.LevelOffset[level] <= Size && levelSize <= Size - entry.LevelOffset[level];
+            }
+        }
+    }
+    if (!headerOK) {
+        fprintf(stderr, "TextureArchive: %s is not a valid texture archive.\n", fileName);
+        Close();
+        return false;
+    }
+    return true;
+}
+
+void TextureArchive::Close()
+{
+    if (Data != 0) {
+#ifdef _WIN32
+        UnmapViewOfFile(Data);
+        CloseHandle((HANDLE)MappingHandle);
+#else
+        munmap((void*)Data, Size);
+#endif
+    }
+    Data = 0;
+    Size = 0;
+    NumTextures = 0;
+    Entries = 0;
+    MappingHandle = 0;
+}
+
+int TextureArchive::FindTexture(const char* name) const
+{
+    for (int i = 0; i < NumTextures; i++) {
+        if (strcmp(Entries[i].Name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+uint64_t TextureArchive::LevelSize(const TextureArchiveEntry& entry, int level)
+{
+    if (entry.Format == TextureArchiveBC1) {
+        return BlockCompressedSize(BlockBC1, entry.LevelWidth[level], entry.LevelHeight[level]);
+    }
+    uint64_t rowBytes = (uint64_t)entry.LevelWidth[level] * entry.BytesPerPixel;
+    rowBytes = (rowBytes + entry.RowAlignment - 1) / entry.RowAlignment * entry.RowAlignment;
+    return rowBytes * entry.LevelHeight[level];
+}
+
+void TextureArchive::Upload(int i, unsigned int textureName) const
+{
+    const TextureArchiveEntry& entry = Entries[i];
+    if (entry.Format == TextureArchiveBC1) {
+        UploadCompressed(entry, textureName);
+        return;
+    }
+    int oldUnpackAlign;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &oldUnpackAlign);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, entry.RowAlignment);
+    GLint internalFormat = (entry.Format == GL_RGBA) ? GL_RGBA8 : GL_RGB8;
+
+    glBindTexture(GL_TEXTURE_2D, textureName);
+    for (uint32_t level = 0; level < entry.NumLevels; level++) {
+        glTexImage2D(GL_TEXTURE_2D, level, internalFormat, entry.LevelWidth[level], entry.LevelHeight[level], 0,
+                     entry.Format, GL_UNSIGNED_BYTE, Data + entry.LevelOffset[level]);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, entry.NumLevels - 1);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, oldUnpackAlign);
+}
+
+void TextureArchive::UploadCompressed(const TextureArchiveEntry& entry, unsigned int textureName) const
+{
+    glBindTexture(GL_TEXTURE_2D, textureName);
+    for (uint32_t level = 0; level < entry.NumLevels; level++) {
+        long width = entry.LevelWidth[level], height = entry.LevelHeight[level];
+        const unsigned char* blocks = Data + entry.LevelOffset[level];
+        if (GLEW_EXT_texture_compression_s3tc) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, width, height, 0,
+                                   (GLsizei)LevelSize(entry, level), blocks);
+        }
+        else {
+            // No S3TC: decompress. RgbImage rows are padded to four bytes, the default GL_UNPACK_ALIGNMENT.
+            RgbImage image(height, width);
+            DecodeBlocks(BlockBC1, blocks, image);
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image.ImageData());
+        }
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, entry.NumLevels - 1);
+}
+
+bool TextureArchive::UploadLayer(int i, unsigned int arrayName, int layer, int layerSize, bool compressed) const
+{
+    const TextureArchiveEntry& entry = Entries[i];
+    if (entry.LevelWidth[0] != (uint32_t)layerSize || entry.LevelHeight[0] != (uint32_t)layerSize
+        || entry.NumLevels != (uint32_t)RgbImage::NumMipmapLevels(layerSize, layerSize)
+        || (entry.Format == TextureArchiveBC1) != compressed || (!compressed && entry.Format != GL_RGB)) {
+        return false;
+    }
+    int oldUnpackAlign;
+    glGetIntegerv(GL_UNPACK_ALIGNMENT, &oldUnpackAlign);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, entry.RowAlignment);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, arrayName);
+    for (uint32_t level = 0; level < entry.NumLevels; level++) {
+        const unsigned char* data = Data + entry.LevelOffset[level];
+        if (compressed) {
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, entry.LevelWidth[level],
+                                      entry.LevelHeight[level], 1, GL_COMPRESSED_RGB_S3TC_DXT1_EXT,
+                                      (GLsizei)LevelSize(entry, level), data);
+        }
+        else {
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, entry.LevelWidth[level], entry.LevelHeight[level], 1,
+                            GL_RGB, GL_UNSIGNED_BYTE, data);
+        }
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, oldUnpackAlign);
+    return true;
+}
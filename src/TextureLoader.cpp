@@ -0,0 +1,285 @@
+// *******************************
+// TextureLoader.cpp
+//
+// Worker threads and pixel buffer uploads for TextureLoader.h.
+//
+// Each file has a slot.  A worker thread claims the next slot, decodes
+//    the file, resizes it to the layer size, and marks it decoded.  The main
+//    thread copies decoded images into a pixel buffer object (orphaned for
+//    each upload, so it never waits for the previous one) and calls
+//    glTexSubImage3D from it, which lets the driver transfer the data asynchronously.
+// The worker thread also makes the whole mipmap chain (RgbImage::BuildMipmaps),
+//    and compresses it if textures are compressed; all the levels are
+//    uploaded together from the pixel buffer.
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+// Use the static library (so glew32.dll is not needed):
+#define GLEW_STATIC
+#include <GL/glew.h> 
+
+#include <string.h>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "TextureLoader.h"
+#include "RgbImage.h"
+#include "BlockCompress.h"
+#include "AsyncLog.h"
+#include "Profiler.h"
+
+bool textureCompressionEnabled = true;
+
+namespace {
+
+enum SlotState { SlotWaiting, SlotDecoding, SlotDecoded, SlotFailed, SlotDone };
+
+const int MaxTextureLevels = 16;            // Enough for 32768 x 32768 textures
+
+struct TextureSlot {
+    std::string FileName;
+    unsigned int ArrayName;                 // The texture array
+    int Layer;
+    int LayerSize;
+    RgbImage Levels[MaxTextureLevels];      // The image, then its mipmaps
+    int NumLevels;
+    std::vector<unsigned char> Blocks;      // All the compressed mipmap levels, if compressing
+    std::atomic<int> State;
+};
+
+// The decode threads read this vector, so it only changes while none are running.
+//    The slots are freed when every one is done.
+std::vector<std::unique_ptr<TextureSlot>> textureSlots;
+std::atomic<int> nextSlot(0);               // Next slot for a worker thread to decode
+std::vector<std::thread> decodeThreads;
+int numOutstanding = 0;                     // Slots not yet uploaded (or failed)
+unsigned int uploadPBO = 0;
+bool compressTextures = false;              // Set when loads start with none outstanding (AddTextureSlot)
+
+long LevelSize(const RgbImage& level)
+{
+    return compressTextures ? BlockCompressedSize(BlockBC1, level.GetNumCols(), level.GetNumRows())
+                            : level.GetNumRows() * level.GetNumBytesPerRow();
+}
+
+// Compress all the mipmap levels into slot->Blocks.
+void CompressMipmaps(TextureSlot* slot)
+{
+    for (int i = 0; i < slot->NumLevels; i++) {
+        size_t offset = slot->Blocks.size();
+        slot->Blocks.resize(offset + LevelSize(slot->Levels[i]));
+        EncodeBlocks(BlockBC1, slot->Levels[i], slot->Blocks.data() + offset);
+    }
+}
+
+void DecodeLoop()
+{
+    for (;;) {
+        int i = nextSlot.fetch_add(1);
+        if (i >= (int)textureSlots.size()) {
+            return;
+        }
+        TextureSlot* slot = textureSlots[i].get();
+        slot->State.store(SlotDecoding);
+        // The decode threads already use every core: each one downsamples on its own thread.
+        RgbImage image;
+        bool loaded = image.LoadBmpFile(slot->FileName.c_str())
+            && image.Resize(slot->Levels[0], slot->LayerSize, slot->LayerSize, 1);
+        if (loaded) {
+            slot->NumLevels = 1 + slot->Levels[0].BuildMipmaps(slot->Levels + 1, MaxTextureLevels - 1, 1);
+            if (compressTextures) {
+                CompressMipmaps(slot);
+            }
+        }
+        slot->State.store(loaded ? SlotDecoded : SlotFailed, std::memory_order_release);
+    }
+}
+
+void UploadTexture(TextureSlot* slot)
+{
+    GLsizeiptr numBytes = 0;
+    for (int i = 0; i < slot->NumLevels; i++) {
+        numBytes += LevelSize(slot->Levels[i]);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploadPBO);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, numBytes, 0, GL_STREAM_DRAW);     // Orphan the previous upload's storage
+    unsigned char* mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, numBytes,
+                                                             GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped != 0) {
+        if (compressTextures) {
+            memcpy(mapped, slot->Blocks.data(), numBytes);
+        }
+        else {
+            unsigned char* dst = mapped;
+            for (int i = 0; i < slot->NumLevels; i++) {
+                memcpy(dst, slot->Levels[i].ImageData(), LevelSize(slot->Levels[i]));
+                dst += LevelSize(slot->Levels[i]);
+            }
+        }
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+    else {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);     // Could not map: upload from client memory
+    }
+
+    // RgbImage rows are padded to four bytes, which is the default GL_UNPACK_ALIGNMENT.
+    glBindTexture(GL_TEXTURE_2D_ARRAY, slot->ArrayName);
+    size_t offset = 0;                      // Offset into the pixel buffer
+    for (int i = 0; i < slot->NumLevels; i++) {
+        const RgbImage& level = slot->Levels[i];
+        GLsizei width = level.GetNumCols(), height = level.GetNumRows();
+        GLsizei levelSize = LevelSize(level);
+        if (compressTextures) {
+            const void* blocks = mapped ? (const void*)offset : slot->Blocks.data() + offset;
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, slot->Layer, width, height, 1,
+                                      GL_COMPRESSED_RGB_S3TC_DXT1_EXT, levelSize, blocks);
+        }
+        else {
+            const void* pixels = mapped ? (const void*)offset : level.ImageData();
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, i, 0, 0, slot->Layer, width, height, 1, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+        }
+        offset += levelSize;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+void JoinDecodeThreads()
+{
+    for (size_t i = 0; i < decodeThreads.size(); i++) {
+        decodeThreads[i].join();
+    }
+    decodeThreads.clear();
+    nextSlot.store((int)textureSlots.size());   // Each thread claimed one slot past the end as it finished
+}
+
+void StartDecodeThreads()
+{
+    int numThreads = (int)std::thread::hardware_concurrency() - 1;     // Leave a core for the main thread
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+    int numToDecode = (int)textureSlots.size() - nextSlot.load();
+    if (numThreads > numToDecode) {
+        numThreads = numToDecode;
+    }
+    for (int i = 0; i < numThreads; i++) {
+        decodeThreads.push_back(std::thread(DecodeLoop));
+    }
+}
+
+void AddTextureSlot(const std::string& fileName, unsigned int arrayName, int layer, int layerSize)
+{
+    if (uploadPBO == 0) {
+        glGenBuffers(1, &uploadPBO);
+    }
+    if (numOutstanding == 0) {
+        compressTextures = TextureArrayCompressed();
+    }
+    TextureSlot* slot = new TextureSlot;
+    textureSlots.push_back(std::unique_ptr<TextureSlot>(slot));
+    slot->FileName = fileName;
+    slot->ArrayName = arrayName;
+    slot->Layer = layer;
+    slot->LayerSize = layerSize;
+    slot->NumLevels = 0;
+    slot->State.store(SlotWaiting);
+    numOutstanding++;
+}
+
+} // namespace
+
+bool TextureArrayCompressed()
+{
+    return textureCompressionEnabled && GLEW_EXT_texture_compression_s3tc;
+}
+
+void AllocateTextureArray(unsigned int arrayName, int numLayers, int layerSize)
+{
+    bool compressed = TextureArrayCompressed();
+    RgbImage gray(layerSize, layerSize);
+    memset((void*)gray.ImageData(), 128, layerSize * gray.GetNumBytesPerRow());
+    std::vector<unsigned char> grayBlocks;
+    if (compressed) {
+        grayBlocks.resize(BlockCompressedSize(BlockBC1, layerSize, layerSize));
+        EncodeBlocks(BlockBC1, gray, grayBlocks.data());     // Every block is the same, so any prefix will do
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, arrayName);
+    int numLevels = RgbImage::NumMipmapLevels(layerSize, layerSize);
+    for (int level = 0; level < numLevels; level++) {
+        int size = layerSize >> level;
+        if (compressed) {
+            GLsizei levelSize = BlockCompressedSize(BlockBC1, size, size);
+            glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_COMPRESSED_RGB_S3TC_DXT1_EXT, size, size, numLayers,
+                                   0, levelSize * numLayers, 0);
+            for (int layer = 0; layer < numLayers; layer++) {
+                glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, size, size, 1,
+                                          GL_COMPRESSED_RGB_S3TC_DXT1_EXT, levelSize, grayBlocks.data());
+            }
+        }
+        else {
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGB8, size, size, numLayers, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
+            for (int layer = 0; layer < numLayers; layer++) {
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, size, size, 1,
+                                GL_RGB, GL_UNSIGNED_BYTE, gray.ImageData());
+            }
+        }
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, numLevels - 1);
+}
+
+void StartTextureLayerLoads(const std::string* fileNames, unsigned int arrayName, const int* layers,
+                            int numFiles, int layerSize)
+{
+    JoinDecodeThreads();            // An earlier batch must finish decoding before textureSlots grows
+    for (int i = 0; i < numFiles; i++) {
+        AddTextureSlot(fileNames[i], arrayName, layers[i], layerSize);
+    }
+    StartDecodeThreads();
+}
+
+int PollTextureLoads(int maxUploads)
+{
+    if (numOutstanding == 0) {
+        return 0;
+    }
+    PROFILE_SCOPE("PollTextureLoads");
+    int numUploaded = 0;
+    for (size_t i = 0; i < textureSlots.size() && numUploaded < maxUploads; i++) {
+        TextureSlot* slot = textureSlots[i].get();
+        int state = slot->State.load(std::memory_order_acquire);
+        if (state == SlotDecoded) {
+            UploadTexture(slot);
+            for (int level = 0; level < slot->NumLevels; level++) {
+                slot->Levels[level].Reset();            // Free the decoded images
+            }
+            std::vector<unsigned char>().swap(slot->Blocks);
+            numUploaded++;
+            LogMessage(LogInfo, "Texture %s loaded.", slot->FileName.c_str());
+        }
+        else if (state != SlotFailed) {
+            continue;                       // Still decoding (or done earlier)
+        }
+        slot->State.store(SlotDone);
+        numOutstanding--;
+    }
+    if (numOutstanding == 0) {
+        JoinDecodeThreads();
+        textureSlots.clear();
+        nextSlot.store(0);
+        LogTimelineEvent("All textures uploaded");
+    }
+    return numOutstanding;
+}
+
+void FinishTextureLoads()
+{
+    while (PollTextureLoads(1 << 30) > 0) {
+        std::this_thread::yield();
+    }
+}
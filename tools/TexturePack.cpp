@@ -0,0 +1,166 @@
+// *******************************
+// TexturePack.cpp
+//
+// Offline packer for texture archives (see TextureArchive.h).
+//    Loads each BMP file, computes its whole mipmap chain with
+//    RgbImage::BuildMipmaps(), and writes every level into one archive,
+//    rows padded to four bytes and each level starting on a page boundary.
+//    At run time the archive is memory mapped and uploaded as is.
+// With -bc1, every level is compressed to BC1 (see BlockCompress.h).
+// With -size N, every texture is resized to N x N, to fit the layers of
+//    the scene's texture array (see SetupForTextures in MyGeometries.cpp).
+//
+// Build (from the project directory), for instance:
+//    cl /O2 /EHsc /Iinclude /DRGBIMAGE_DONT_USE_OPENGL tools\TexturePack.cpp src\BlockCompress.cpp src\RgbImage.cpp
+//    g++ -O2 -Iinclude -DRGBIMAGE_DONT_USE_OPENGL tools/TexturePack.cpp src/BlockCompress.cpp src/RgbImage.cpp
+// Run:
+//    TexturePack [-bc1] [-size N] output.pack file1.bmp file2.bmp ...
+//    For this project:  TexturePack -size 1024 data/textures.pack data/*.bmp
+//
+// Software is "as-is" and carries no warranty. It may be used without
+//  restriction, but if you modify it, please change the filenames to
+//  prevent confusion between different versions.
+// *******************************
+
+// Allow the use of deprecated fopen() instead of fopen_s()
+#define _CRT_SECURE_NO_DEPRECATE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "BlockCompress.h"
+#include "RgbImage.h"
+#include "TextureArchive.h"
+
+const unsigned int GlRgb = 0x1907;      // GL_RGB (no OpenGL headers are needed here)
+
+static uint64_t AlignUp(uint64_t x)
+{
+    return (x + TextureArchiveDataAlignment - 1) & ~(uint64_t)(TextureArchiveDataAlignment - 1);
+}
+
+// The name a texture is looked up by: the file name without its directory.
+static const char* LeafName(const char* path)
+{
+    const char* leaf = path;
+    for (const char* p = path; *p; p++) {
+        if (*p == '/' || *p == '\\' || *p == ':') {
+            leaf = p + 1;
+        }
+    }
+    return leaf;
+}
+
+int main(int argc, char** argv)
+{
+    bool compress = false;
+    long size = 0;              // Resize to size x size, unless zero
+    while (argc > 1 && argv[1][0] == '-') {
+        if (strcmp(argv[1], "-bc1") == 0) {
+            compress = true;
+        }
+        else if (strcmp(argv[1], "-size") == 0 && argc > 2) {
+            size = atol(argv[2]);
+            argc--;
+            argv++;
+        }
+        else {
+            argc = 0;           // Print the usage
+            break;
+        }
+        argc--;
+        argv++;
+    }
+    if (argc < 3 || size < 0) {
+        fprintf(stderr, "Usage: TexturePack [-bc1] [-size N] output.pack file1.bmp file2.bmp ...\n");
+        return 1;
+    }
+    const char* outName = argv[1];
+    int numTextures = argc - 2;
+    std::vector<unsigned char> blocks;
+
+    TextureArchiveHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.Magic, TextureArchiveMagic, sizeof(header.Magic));
+    header.NumTextures = numTextures;
+    header.EntrySize = sizeof(TextureArchiveEntry);
+    std::vector<TextureArchiveEntry> entries(numTextures);
+    memset(entries.data(), 0, numTextures * sizeof(TextureArchiveEntry));
+
+    FILE* outfile = fopen(outName, "wb");
+    if (!outfile) {
+        fprintf(stderr, "TexturePack: Unable to open %s for writing.\n", outName);
+        return 1;
+    }
+    // The directory is written last, once the offsets are known.
+    uint64_t offset = AlignUp(sizeof(TextureArchiveHeader) + numTextures * sizeof(TextureArchiveEntry));
+    static const unsigned char zeros[TextureArchiveDataAlignment] = { 0 };
+
+    for (int t = 0; t < numTextures; t++) {
+        const char* leaf = LeafName(argv[t + 2]);
+        TextureArchiveEntry& entry = entries[t];
+        if (strlen(leaf) >= TextureArchiveNameLength) {
+            fprintf(stderr, "TexturePack: The name %s is too long.\n", leaf);
+            fclose(outfile);
+            return 1;
+        }
+        strcpy(entry.Name, leaf);
+        entry.Format = compress ? TextureArchiveBC1 : GlRgb;
+        entry.BytesPerPixel = compress ? 0 : 3;
+        entry.RowAlignment = 4;     // Rows of an RgbImage are already padded to four bytes
+
+        RgbImage level[TextureArchiveMaxLevels];
+        RgbImage file;
+        bool loaded = (size > 0) ? file.LoadBmpFile(argv[t + 2]) && file.Resize(level[0], size, size)
+                                 : level[0].LoadBmpFile(argv[t + 2]);
+        if (!loaded) {
+            fclose(outfile);
+            return 1;
+        }
+        entry.NumLevels = 1 + level[0].BuildMipmaps(level + 1, TextureArchiveMaxLevels - 1);
+        uint64_t textureBytes = 0;
+        for (uint32_t i = 0; i < entry.NumLevels; i++) {
+            const RgbImage& image = level[i];
+            long numBytes = image.GetNumRows() * image.GetNumBytesPerRow();
+            const void* data = image.ImageData();
+            if (compress) {
+                numBytes = BlockCompressedSize(BlockBC1, image.GetNumCols(), image.GetNumRows());
+                blocks.resize(numBytes);
+                EncodeBlocks(BlockBC1, image, blocks.data());
+                data = blocks.data();
+            }
+            fseek(outfile, (long)offset, SEEK_SET);
+            if (fwrite(data, 1, numBytes, outfile) != (size_t)numBytes) {
+                fprintf(stderr, "TexturePack: Error writing %s.\n", outName);
+                fclose(outfile);
+                return 1;
+            }
+            entry.LevelWidth[i] = image.GetNumCols();
+            entry.LevelHeight[i] = image.GetNumRows();
+            entry.LevelOffset[i] = offset;
+            offset = AlignUp(offset + numBytes);
+            textureBytes += numBytes;
+        }
+        printf("%-24s %5u x %-5u %2u levels %10.2f MB\n", entry.Name, entry.LevelWidth[0], entry.LevelHeight[0],
+               entry.NumLevels, textureBytes / 1.0e6);
+    }
+
+    // Pad the last level to a full page, then write the header and the directory.
+    fseek(outfile, 0, SEEK_END);
+    long end = ftell(outfile);
+    fwrite(zeros, 1, (size_t)(AlignUp(end) - end), outfile);
+    header.FileSize = AlignUp(end);
+    fseek(outfile, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, outfile);
+    fwrite(entries.data(), sizeof(TextureArchiveEntry), numTextures, outfile);
+    if (ferror(outfile)) {
+        fprintf(stderr, "TexturePack: Error writing %s.\n", outName);
+        fclose(outfile);
+        return 1;
+    }
+    fclose(outfile);
+    printf("Wrote %s: %d textures, %.2f MB.\n", outName, numTextures, header.FileSize / 1.0e6);
+    return 0;
+}